@@ -1,5 +1,8 @@
 layout (location = 0) in vec3 aPos;
 
+// the mesh's center and half extent, to expand quantized positions with
+layout (location = 1) in vec4 aPositionBounds;
+
 out vec3 worldPos;
 
 uniform mat4 projection;
@@ -7,6 +10,6 @@ uniform mat4 view;
 
 void main()
 {
-    worldPos = aPos;  
+    worldPos = aPositionBounds.xyz + aPos * aPositionBounds.w;
     gl_Position =  projection * view * vec4(worldPos, 1.0);
 }
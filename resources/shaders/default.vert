@@ -4,6 +4,12 @@ layout (location = 2) in vec2 aTexCoord;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec4 aColor;
 
+// per-instance index into the object data, streamed by the renderer
+layout (location = 5) in uint aInstanceObjectIndex;
+
+// the mesh's center and half extent, to expand quantized positions with
+layout (location = 6) in vec4 aPositionBounds;
+
 #include "camera.glsl"
 
 out VS_OUT {
@@ -14,18 +20,35 @@ out VS_OUT {
     vec4 color;
 } vs_out;
 
-uniform mat4 model;
-uniform mat4 normalMatrix;
 uniform vec4 uvTilingOffset;
 
+// every visible object's transform then normal matrix, one column per texel
+uniform samplerBuffer uObjectData;
+
+mat4 fetchMatrix(int texel)
+{
+    return mat4(
+        texelFetch(uObjectData, texel),
+        texelFetch(uObjectData, texel + 1),
+        texelFetch(uObjectData, texel + 2),
+        texelFetch(uObjectData, texel + 3)
+    );
+}
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    int texel = int(aInstanceObjectIndex) * 8;
+    mat4 model = fetchMatrix(texel);
+    mat4 normalMatrix = fetchMatrix(texel + 4);
+
+    vec3 position = aPositionBounds.xyz + aPos * aPositionBounds.w;
+
+    gl_Position = projection * view * model * vec4(position, 1.0);
 
     vs_out.texCoord = aTexCoord * uvTilingOffset.xy + uvTilingOffset.zw;
 
     // transform our position and normal into world space
-    vs_out.fragPos = vec3(model * vec4(aPos, 1.0));
+    vs_out.fragPos = vec3(model * vec4(position, 1.0));
     vs_out.normal = vec3(normalMatrix * vec4(aNormal, 1.0));
     vs_out.tangent = vec3(normalMatrix * vec4(aTangent, 1.0));
 
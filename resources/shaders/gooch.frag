@@ -17,8 +17,10 @@ vec3 lit(vec3 L, vec3 N, vec3 V);
 #include "camera.glsl"
 #include "lights.glsl"
 
-uniform vec3 coolColor;
-uniform vec3 warmColor;
+layout (std140) uniform GoochMaterial {
+    vec3 coolColor;
+    vec3 warmColor;
+}; // total size with std140 layout: 32 bytes
 
 void main()
 {
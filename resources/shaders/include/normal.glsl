@@ -11,10 +11,11 @@ vec3 calcNormal(vec3 wsNormal, vec3 wsTangent, sampler2D texNormal, vec2 texCoor
     vec3 bitangent = cross(tangent, normal);
     mat3 tbn = mat3(tangent, bitangent, normal);
 
-    // obtain normal from normal map in range [0,1]
-    vec3 retrievedNormal = texture(texNormal, texCoord).rgb;
-    // transform normal vector to range [-1,1]
-    retrievedNormal = retrievedNormal * 2.0 - 1.0;
+    // obtain x and y from the normal map in range [0,1], and transform them
+    // to range [-1,1]. Block compressed normal maps only keep these two, so z
+    // is rebuilt from them, the normal being unit length.
+    vec2 retrievedXY = texture(texNormal, texCoord).rg * 2.0 - 1.0;
+    vec3 retrievedNormal = vec3(retrievedXY, sqrt(max(1.0 - dot(retrievedXY, retrievedXY), 0.0)));
 
     // transform our tangent-space sampled normal vector into world-space
     vec3 newNormal = tbn * retrievedNormal;
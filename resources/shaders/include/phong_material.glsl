@@ -1,12 +1,12 @@
-struct Material {
+// material parameters, uploaded once per material, see PhongMaterial.cpp
+layout (std140) uniform PhongMaterial {
     vec4 diffuse;
     vec3 specular;
     float shininess;
+} material; // total size with std140 layout: 32 bytes
 
 #ifdef MATERIAL_TEXTURES
-    sampler2D diffuseMap;
-    sampler2D specularMap;
-    sampler2D normalMap;
+uniform sampler2D diffuseMap;
+uniform sampler2D specularMap;
+uniform sampler2D normalMap;
 #endif
-};
-uniform Material material;
@@ -10,42 +10,42 @@ uniform samplerCube prefilteredEnvMap;
 uniform sampler2D brdfLUT;
 #endif
 
-struct PhysicalMaterialUniforms {
+// material parameters, uploaded once per material, see PBRMaterial.cpp
+layout (std140) uniform PhysicalMaterialParameters {
     vec3 albedo;
     float metallic;
+    vec3 emissive;
     float roughness;
     float ao;
-    vec3 emissive;
+} uMaterial; // total size with std140 layout: 48 bytes
 
 #ifdef TEX_ALBEDO
-    sampler2D albedoMap;
+uniform sampler2D albedoMap;
 #endif
 
 #ifdef TEX_NORMAL
-    sampler2D normalMap;
+uniform sampler2D normalMap;
 #endif
 
 #ifdef TEX_METALLIC_ROUGHNESS
-    sampler2D metallicRoughnessMap;
+uniform sampler2D metallicRoughnessMap;
 #else
     #ifdef TEX_METALLIC
-        sampler2D metallicMap;
+    uniform sampler2D metallicMap;
     #endif
 
     #ifdef TEX_ROUGHNESS
-        sampler2D roughnessMap;
+    uniform sampler2D roughnessMap;
     #endif
 #endif
 
 #ifdef TEX_AO
-    sampler2D aoMap;
+uniform sampler2D aoMap;
 #endif
 
 #ifdef TEX_EMISSIVE
-    sampler2D emissiveMap;
+uniform sampler2D emissiveMap;
 #endif
-};
-uniform PhysicalMaterialUniforms uMaterial;
 
 // our material definition used for lighting calculations
 
@@ -74,39 +74,39 @@ PhysicalMaterial getMaterialProps(
     material.emissive = uMaterial.emissive;
 
 #ifdef TEX_ALBEDO
-    vec3 albedoSample = texture(uMaterial.albedoMap, texCoord).rgb;
+    vec3 albedoSample = texture(albedoMap, texCoord).rgb;
     material.albedo *= albedoSample;
 #endif
 
 #ifdef TEX_NORMAL
-    material.worldNormal = calcNormal(normal, tangent, uMaterial.normalMap, texCoord);
+    material.worldNormal = calcNormal(normal, tangent, normalMap, texCoord);
 #else
     material.worldNormal = normal;
 #endif
 
 #ifdef TEX_METALLIC_ROUGHNESS
-    vec3 metallicRoughnessSample = texture(uMaterial.metallicRoughnessMap, texCoord).rgb;
+    vec3 metallicRoughnessSample = texture(metallicRoughnessMap, texCoord).rgb;
     material.metallic *= metallicRoughnessSample.b;
     material.roughness *= metallicRoughnessSample.g;
 #else
     #ifdef TEX_METALLIC
-        float metallicSample = texture(uMaterial.metallicMap, texCoord).r;
+        float metallicSample = texture(metallicMap, texCoord).r;
         material.metallic *= metallicSample;
     #endif
     
     #ifdef TEX_ROUGHNESS
-        float roughnessSample = texture(uMaterial.roughnessMap, texCoord).r;
+        float roughnessSample = texture(roughnessMap, texCoord).r;
         material.roughness *= roughnessSample;
     #endif
 #endif
 
 #ifdef TEX_AO
-    float aoSample = texture(uMaterial.aoMap, texCoord).r;
+    float aoSample = texture(aoMap, texCoord).r;
     material.ao *= aoSample;
 #endif
 
 #ifdef TEX_EMISSIVE
-    vec3 emissiveSample = texture(uMaterial.emissiveMap, texCoord).rgb;
+    vec3 emissiveSample = texture(emissiveMap, texCoord).rgb;
     material.emissive *= emissiveSample;
 #endif
 
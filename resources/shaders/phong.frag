@@ -16,7 +16,7 @@ void main()
 {
     vec3 V = normalize(viewPos.xyz - fs_in.fragPos);
 #ifdef MATERIAL_TEXTURES
-    vec3 N = calcNormal(fs_in.normal, fs_in.tangent, material.normalMap, fs_in.texCoord);
+    vec3 N = calcNormal(fs_in.normal, fs_in.tangent, normalMap, fs_in.texCoord);
 #else
     vec3 N = normalize(fs_in.normal);
 #endif
@@ -26,8 +26,8 @@ void main()
 
     vec3 ambient = globalAmbient.rgb;
 #ifdef MATERIAL_TEXTURES
-    vec4 diffuse = vec4(totalLighting.diffuse, 1) * material.diffuse * texture(material.diffuseMap, fs_in.texCoord);
-    vec3 specular = totalLighting.specular * material.specular * texture(material.specularMap, fs_in.texCoord).rgb;
+    vec4 diffuse = vec4(totalLighting.diffuse, 1) * material.diffuse * texture(diffuseMap, fs_in.texCoord);
+    vec3 specular = totalLighting.specular * material.specular * texture(specularMap, fs_in.texCoord).rgb;
 #else
     vec4 diffuse = vec4(totalLighting.diffuse, 1) * material.diffuse;
     vec3 specular = totalLighting.specular * material.specular;
@@ -1,10 +1,14 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoord;
 
+// the mesh's center and half extent, to expand quantized positions with
+layout (location = 2) in vec4 aPositionBounds;
+
 out vec2 texCoord;
 
 void main()
 {
-    gl_Position = vec4(aPos.xy, 0.0, 1.0);
+    vec3 position = aPositionBounds.xyz + aPos * aPositionBounds.w;
+    gl_Position = vec4(position.xy, 0.0, 1.0);
     texCoord = aTexCoord;
 }
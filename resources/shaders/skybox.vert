@@ -1,5 +1,8 @@
 layout (location = 0) in vec3 aPos;
 
+// the mesh's center and half extent, to expand quantized positions with
+layout (location = 1) in vec4 aPositionBounds;
+
 out vec3 texCoord;
 
 uniform mat4 projection;
@@ -7,7 +10,7 @@ uniform mat4 view;
 
 void main()
 {
-    texCoord = aPos;
-    vec4 pos = projection * view * vec4(aPos, 1.0);
+    texCoord = aPositionBounds.xyz + aPos * aPositionBounds.w;
+    vec4 pos = projection * view * vec4(texCoord, 1.0);
     gl_Position = pos.xyww; // set z component to w so depth equals 1.0 
 }
@@ -1,6 +1,8 @@
 out vec4 FragColor;
 
-uniform vec4 color;
+layout (std140) uniform UnlitMaterial {
+    vec4 color;
+}; // total size with std140 layout: 16 bytes
 
 void main()
 {
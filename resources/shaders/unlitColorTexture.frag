@@ -8,7 +8,9 @@ in VS_OUT {
     vec4 color;
 } fs_in;
 
-uniform vec4 color;
+layout (std140) uniform UnlitMaterial {
+    vec4 color;
+}; // total size with std140 layout: 16 bytes
 uniform sampler2D tex;
 uniform vec2 uvTiling;
 uniform vec2 uvOffset;
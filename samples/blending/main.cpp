@@ -41,11 +41,11 @@ void loadScene(SceneController& sc) {
 
     // transparent objects
 
-    ModelNode* m1 = new ModelNode(new Model(new Mesh(new Cube(0.5f), new UnlitMaterial(glm::vec4(1), false, Resources::GetTexture("window.png", true)))));
+    ModelNode* m1 = new ModelNode(new Model(new Mesh(new Cube(0.5f), new UnlitMaterial(glm::vec4(1), false, Resources::AcquireTexture("window.png", true)))));
     // m1->Rotate(180, 0, 0);
     sc.AddNode(m1);
 
-    ModelNode* m2 = new ModelNode(new Model(new Mesh(new Quad(0.5f), new UnlitMaterial(glm::vec4(1), false, Resources::GetTexture("window.png", true)))));
+    ModelNode* m2 = new ModelNode(new Model(new Mesh(new Quad(0.5f), new UnlitMaterial(glm::vec4(1), false, Resources::AcquireTexture("window.png", true)))));
     m2->Translate(0.75f, 0.25f, 2);
     m2->Rotate(180, 0, 0);
     sc.AddNode(m2);
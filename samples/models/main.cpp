@@ -58,32 +58,29 @@ void loadScene(SceneController& sc) {
     helmet->Translate(0, 0, 0);
     sc.AddNode(helmet);
 
-    Model* diceModel = Resources::GetModel("Dice.fbx", false);
-    diceModel->GetMeshes()[0]->SetMaterial(new PhongMaterial(
+    ModelNode* dice = new ModelNode(Resources::GetModel("Dice.fbx", false));
+    dice->SetMaterialOverride(0, new PhongMaterial(
         glm::vec4(1), glm::vec4(1), 128,
-        Resources::GetTexture("Dice_Diffuse.png", true),
-        Resources::GetTexture("Dice_SpecularGlossiness.png", false),
-        Resources::GetTexture("Dice_Normal.png", false)
+        Resources::AcquireTexture("Dice_Diffuse.png", true),
+        Resources::AcquireTexture("Dice_SpecularGlossiness.png", false),
+        Resources::AcquireTexture("Dice_Normal.png", false)
     ));
-
-    ModelNode* dice = new ModelNode(diceModel);
     dice->Translate(2, 0, 0);
     dice->Scale(0.5f);
     sc.AddNode(dice);
 
-    Model* cerberusModel = Resources::GetModel("Cerberus_LP.fbx", false);
-    cerberusModel->GetMeshes()[0]->SetMaterial(new PBRMaterial(
+    ModelNode* cerberus = new ModelNode(Resources::GetModel("Cerberus_LP.fbx", false));
+    cerberus->SetMaterialOverride(0, new PBRMaterial(
         true,
         glm::vec3(1),
         1, 1, 1,
         glm::vec3(0),
-        Resources::GetTexture("Cerberus_A.png", true),
-        Resources::GetTexture("Cerberus_N.png", false),
+        Resources::AcquireTexture("Cerberus_A.png", true),
+        Resources::AcquireTexture("Cerberus_N.png", false),
         nullptr, nullptr,
-        Resources::GetTexture("Cerberus_RM.png", false),
-        Resources::GetTexture("Cerberus_AO.png", false)
+        Resources::AcquireTexture("Cerberus_RM.png", false),
+        Resources::AcquireTexture("Cerberus_AO.png", false)
     ));
-    ModelNode* cerberus = new ModelNode(cerberusModel);
     cerberus->Translate(-1.8, 0, -0.8);
     cerberus->Rotate(-90, 0, 0);
     cerberus->Scale(0.02f);
@@ -113,12 +113,12 @@ void loadScene(SceneController& sc) {
         glm::vec3(1),
         1, 1, 1,
         glm::vec3(0),
-        Resources::GetTexture("old-middle-eastern-wall_albedo.png", true),
-        Resources::GetTexture("old-middle-eastern-wall_normal-ogl.png", false),
+        Resources::AcquireTexture("old-middle-eastern-wall_albedo.png", true),
+        Resources::AcquireTexture("old-middle-eastern-wall_normal-ogl.png", false),
         nullptr,
         nullptr,
-        Resources::GetTexture("old-middle-eastern-wall_metallic-roughness.png", false),
-        Resources::GetTexture("old-middle-eastern-wall_ao.png", false),
+        Resources::AcquireTexture("old-middle-eastern-wall_metallic-roughness.png", false),
+        Resources::AcquireTexture("old-middle-eastern-wall_ao.png", false),
         nullptr,
         glm::vec2(2.0f)
     );
@@ -127,32 +127,32 @@ void loadScene(SceneController& sc) {
         glm::vec3(1),
         1, 1, 1,
         glm::vec3(0),
-        Resources::GetTexture("gold-scuffed_basecolor.png", true),
-        Resources::GetTexture("gold-scuffed_normal.png", false),
-        Resources::GetTexture("gold-scuffed_metallic.png", false),
-        Resources::GetTexture("gold-scuffed_roughness.png", false)
+        Resources::AcquireTexture("gold-scuffed_basecolor.png", true),
+        Resources::AcquireTexture("gold-scuffed_normal.png", false),
+        Resources::AcquireTexture("gold-scuffed_metallic.png", false),
+        Resources::AcquireTexture("gold-scuffed_roughness.png", false)
     );
     Material* rustedIronMat = new PBRMaterial(
         true,
         glm::vec3(1),
         1, 1, 1,
         glm::vec3(0),
-        Resources::GetTexture("rustediron2_basecolor.png", true),
-        Resources::GetTexture("rustediron2_normal.png", false),
-        Resources::GetTexture("rustediron2_metallic.png", false),
-        Resources::GetTexture("rustediron2_roughness.png", false)
+        Resources::AcquireTexture("rustediron2_basecolor.png", true),
+        Resources::AcquireTexture("rustediron2_normal.png", false),
+        Resources::AcquireTexture("rustediron2_metallic.png", false),
+        Resources::AcquireTexture("rustediron2_roughness.png", false)
     );
     Material* plasticMat = new PBRMaterial(
         true,
         glm::vec3(0.0, 0.5, 1.0),
         1, 1, 1,
         glm::vec3(0),
-        Resources::GetTexture("scuffed-plastic-alb.png", true),
-        Resources::GetTexture("scuffed-plastic-normal.png", false),
-        Resources::GetTexture("scuffed-plastic-metal.png", false),
-        Resources::GetTexture("scuffed-plastic-rough.png", false),
+        Resources::AcquireTexture("scuffed-plastic-alb.png", true),
+        Resources::AcquireTexture("scuffed-plastic-normal.png", false),
+        Resources::AcquireTexture("scuffed-plastic-metal.png", false),
+        Resources::AcquireTexture("scuffed-plastic-rough.png", false),
         nullptr,
-        Resources::GetTexture("scuffed-plastic-ao.png", false)
+        Resources::AcquireTexture("scuffed-plastic-ao.png", false)
     );
 
     ModelNode* sphere1 = new ModelNode(new Model(new Mesh(new Sphere(0.5f), stoneMat)));
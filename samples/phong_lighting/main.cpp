@@ -70,9 +70,9 @@ void loadScene(SceneController& sc) {
 
     ModelNode* floor = new ModelNode(new Model(new Mesh(new Quad(0.5f), new PhongMaterial(
         { 1, 1, 1, 1 }, { 1, 1, 1 }, 64,
-        Resources::GetTexture("brick_DIFF.jpg", true),
+        Resources::AcquireTexture("brick_DIFF.jpg", true),
         nullptr,
-        Resources::GetTexture("brick_NRM.jpg", false),
+        Resources::AcquireTexture("brick_NRM.jpg", false),
         glm::vec2(4)))));
     floor->Translate(0, -2, 0);
     floor->Rotate(-90, 0, 0);
@@ -82,8 +82,8 @@ void loadScene(SceneController& sc) {
     ModelNode* crate = new ModelNode(new Model(new Mesh(new Cube(0.5f),
         new PhongMaterial(
             { 1, 1, 1, 1 }, { 1, 1, 1 }, 128,
-            Resources::GetTexture("crate_DIFF.jpg", true),
-            Resources::GetTexture("crate_SPEC.jpg", false)))));
+            Resources::AcquireTexture("crate_DIFF.jpg", true),
+            Resources::AcquireTexture("crate_SPEC.jpg", false)))));
     crate->Translate(-1, -1, 3);
     sc.AddNode(crate);
 
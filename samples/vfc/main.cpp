@@ -37,12 +37,14 @@ void loadScene(SceneController& sc) {
     float halfH = h / 2.0f;
     float halfD = d / 2.0f;
 
-    // add a bunch of cubes in a 3d grid to test VFC
+    // add a bunch of cubes in a 3d grid to test VFC, all sharing one copy of the cube
+
+    SharedGeometry cube = Resources::GetGeometry(GeometryDescriptor::Cube(0.5f));
 
     for(int x = -floorf(halfW); x < ceilf(halfW); x++) {
         for(int y = -floorf(halfH); y < ceilf(halfH); y++) {
             for(int z = -floorf(halfD); z < ceilf(halfD); z++) {
-                ModelNode* model = new ModelNode(new Model(new Mesh(new Cube(0.5f), new UnlitMaterial())));
+                ModelNode* model = new ModelNode(new Model(new Mesh(cube, new UnlitMaterial())));
                 model->SetPosition(x * spacing, y * spacing, z * spacing);
                 model->SetScale(0.5f);
                 sc.AddNode(model);
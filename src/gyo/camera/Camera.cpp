@@ -9,6 +9,7 @@
  */
 
 #include <gyo/camera/Camera.h>
+#include <gyo/renderer/RenderState.h>
 
 #include <glad/glad.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -43,17 +44,15 @@ Camera::Camera(glm::mat4 projection) {
     glBufferData(GL_UNIFORM_BUFFER, bufferSize, NULL, GL_STREAM_DRAW);
     glCheckError();
 
-    // link the range of the entire buffer to binding point 0
-    glBindBufferRange(GL_UNIFORM_BUFFER, 0, uboMatrices, 0, bufferSize);
-    glCheckError();
-
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     glCheckError();
+
+    // link the entire buffer to binding point 0
+    RenderState::BindUniformBuffer(0, uboMatrices);
 }
 
 Camera::~Camera() {
-    glDeleteBuffers(1, &uboMatrices);
-    glCheckError();
+    RenderState::DeleteBuffer(uboMatrices);
 }
 
 void Camera::UpdateViewMatrixUniform(const glm::mat4& view, const glm::vec3& viewPos) {
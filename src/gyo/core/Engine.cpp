@@ -3,6 +3,8 @@
 #include <GLFW/glfw3.h>
 
 #include <gyo/core/Engine.h>
+#include <gyo/core/ThreadPool.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/renderer/Renderer.h>
 #include <gyo/scene/SceneController.h>
 #include <gyo/resources/Resources.h>
@@ -91,21 +93,31 @@ Engine::Engine(unsigned int ptWidth, unsigned int ptHeight, unsigned int msaaSam
 
     // finally, initialize our core Gyokuro classes
 
-    Resources::Initialize();
+    threadPool = new ThreadPool();
+
+    Resources::Initialize(threadPool);
 
     renderer = new Renderer(pxWidth, pxHeight, msaaSamples, xscale);
-    sceneController = new SceneController(renderer, pxWidth, pxHeight);
+    sceneController = new SceneController(renderer, threadPool, pxWidth, pxHeight);
 
     isRunning = true;
 }
 
 Engine::~Engine() {
-    Resources::Dispose();
+    // finish any decode in flight before its loader is disposed
+    delete threadPool;
+    threadPool = nullptr;
 
-    // clean up
+    // clean up, the scene first since its materials hold texture handles
     delete sceneController;
+
+    Resources::Dispose();
+
     delete renderer;
 
+    // after every mesh has released its geometry
+    GeometryPool::Dispose();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -129,6 +141,10 @@ void Engine::Frame() {
     // input
     processInput(window, dt);
 
+    // finish what's been loading in the background, and make room for it
+    Resources::ProcessUploads(UPLOAD_BUDGET_MS);
+    Resources::TrimToBudget();
+
     // CPU update
     sceneController->Update(dt);
 
@@ -137,6 +153,9 @@ void Engine::Frame() {
     sceneController->Render();
     gpuTimer.EndQuery();
 
+    // let go of cached models and materials the scene no longer uses
+    Resources::ReleaseUnused();
+
     // query our gpu time, and update our cpu time
     renderer->stats.gpuMs.PushSample(gpuTimer.lastGPUMs);
     currentTimeSec = glfwGetTime();
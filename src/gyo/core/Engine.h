@@ -9,10 +9,14 @@ namespace gyo {
 
 class SceneController;
 class Renderer;
+class ThreadPool;
 
 class Engine {
 public:
     static Engine* Instance;
+
+    // how long each frame may spend uploading background loads
+    static constexpr double UPLOAD_BUDGET_MS = 2.0;
     
 public:
     Engine(unsigned int ptWidth = 0, unsigned int ptHeight = 0, unsigned int msaaSamples = 4U);
@@ -23,11 +27,13 @@ public:
     void ShutDown() { isRunning = false; }
 
     SceneController& sc() { return *sceneController; }
+    ThreadPool& GetThreadPool() { return *threadPool; }
 
 private:
     GLFWwindow* window;
     Renderer* renderer;
     SceneController* sceneController;
+    ThreadPool* threadPool;
 
     bool isRunning = false;
 
@@ -0,0 +1,141 @@
+
+#include <gyo/core/ThreadPool.h>
+#include <gyo/utilities/Log.h>
+
+#include <algorithm>
+
+namespace gyo {
+
+ThreadPool::ThreadPool(int threadCount) {
+    if(threadCount < 0) {
+        int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        threadCount = std::max(0, hardwareThreads - 1);
+    }
+
+    workers.reserve(threadCount);
+    for(int i = 0; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+
+    LOGI("Thread pool started with %d workers", threadCount);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        isShuttingDown = true;
+    }
+    workAvailable.notify_all();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void ThreadPool::ParallelFor(int jobCount, const std::function<void(int)>& job) {
+    if(jobCount <= 0) {
+        return;
+    }
+
+    // not worth waking anyone up for
+    if(workers.empty() || jobCount == 1) {
+        for(int i = 0; i < jobCount; i++) {
+            job(i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        batchJob = &job;
+        batchJobCount = jobCount;
+        batchGeneration++;
+        nextJob = 0;
+    }
+    workAvailable.notify_all();
+
+    // help out while the workers run
+    RunJobs(job, jobCount);
+
+    // wait until every worker has left the batch, so job can't dangle
+    std::unique_lock<std::mutex> lock(mutex);
+    workFinished.wait(lock, [this] { return activeWorkers == 0; });
+
+    batchJob = nullptr;
+    batchJobCount = 0;
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+    if(workers.empty()) {
+        task();
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    unsigned int lastGeneration = 0;
+
+    while(true) {
+        const std::function<void(int)>* job = nullptr;
+        int jobCount = 0;
+        std::function<void()> task;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] {
+                return isShuttingDown || batchGeneration != lastGeneration || !tasks.empty();
+            });
+
+            if(isShuttingDown) {
+                return;
+            }
+
+            // a batch blocks the main thread, so it comes before any task
+            if(batchGeneration != lastGeneration) {
+                lastGeneration = batchGeneration;
+
+                // we woke up after the batch was already finished
+                if(batchJob == nullptr) {
+                    continue;
+                }
+
+                job = batchJob;
+                jobCount = batchJobCount;
+                activeWorkers++;
+            }
+            else {
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+        }
+
+        if(task) {
+            task();
+            continue;
+        }
+
+        RunJobs(*job, jobCount);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            activeWorkers--;
+        }
+        workFinished.notify_one();
+    }
+}
+
+void ThreadPool::RunJobs(const std::function<void(int)>& job, int jobCount) {
+    // claim jobs one at a time until the batch runs dry
+    for(int i = nextJob.fetch_add(1); i < jobCount; i = nextJob.fetch_add(1)) {
+        job(i);
+    }
+}
+
+} // namespace gyo
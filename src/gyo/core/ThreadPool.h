@@ -0,0 +1,71 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * A fixed set of worker threads for splitting CPU work into chunks. The
+ * calling thread always takes part in the work, so a pool with no workers
+ * simply runs everything inline. Nothing submitted here may touch the GL
+ * context; that stays on the main thread.
+ */
+class ThreadPool {
+public:
+    /**
+     * threadCount is the number of workers to spawn. Pass -1 to use one less
+     * than the hardware concurrency, leaving a core for the main thread.
+     */
+    ThreadPool(int threadCount = -1);
+    ~ThreadPool();
+
+    // workers plus the calling thread
+    int GetConcurrency() const { return static_cast<int>(workers.size()) + 1; }
+
+    /**
+     * Runs job(i) for every i in [0, jobCount), and blocks until all of them
+     * have finished. Jobs may run in any order, on any thread.
+     */
+    void ParallelFor(int jobCount, const std::function<void(int)>& job);
+
+    /**
+     * Queues a task to run in the background on the next free worker, and
+     * returns straight away. Batches from ParallelFor are picked up first.
+     * With no workers the task runs inline. Tasks still queued when the pool
+     * is destroyed are dropped, though running ones are finished.
+     */
+    void Submit(std::function<void()> task);
+
+private:
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+
+    // the current batch, guarded by mutex
+    const std::function<void(int)>* batchJob = nullptr;
+    int batchJobCount = 0;
+    unsigned int batchGeneration = 0;
+    int activeWorkers = 0;
+    bool isShuttingDown = false;
+
+    // background tasks, guarded by mutex
+    std::deque<std::function<void()>> tasks;
+
+    std::atomic<int> nextJob = 0;
+
+    void WorkerLoop();
+    void RunJobs(const std::function<void(int)>& job, int jobCount);
+};
+
+} // namespace gyo
+
+#endif // THREAD_POOL_H
@@ -5,6 +5,7 @@
 #include <gyo/resources/Resources.h>
 
 #include <glad/glad.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 
 namespace gyo {
@@ -25,8 +26,7 @@ AABBWireframe::AABBWireframe(const AABB& aabb, glm::vec4 color) {
     // generate and bind VAO
     glGenVertexArrays(1, &VAO);
     glCheckError();
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
 
     // generate and bind VBO
     glGenBuffers(1, &VBO);
@@ -51,22 +51,18 @@ AABBWireframe::AABBWireframe(const AABB& aabb, glm::vec4 color) {
     glCheckError();
 
     // unbind
-    glBindVertexArray(0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
 
     // create shader
-    shader = Resources::GetShader("wireframe.vert", "solidColor.frag");
+    shader = Resources::GetShader("wireframe.vert", "wireframe.frag");
     shader->Use();
     shader->SetUniformBlockBinding("Camera", 0);
 }
 
 AABBWireframe::~AABBWireframe() {
-    glDeleteVertexArrays(1, &VAO);
-    glCheckError();
-    glDeleteBuffers(1, &VBO);
-    glCheckError();
-    glDeleteBuffers(1, &EBO);
-    glCheckError();
+    RenderState::DeleteVertexArray(VAO);
+    RenderState::DeleteBuffer(VBO);
+    RenderState::DeleteBuffer(EBO);
 
     shader = nullptr;
 }
@@ -97,12 +93,10 @@ void AABBWireframe::Draw() const {
     shader->Use();
     shader->SetVec4("color", color);
 
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
     glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, 0); // 12 lines
     glCheckError();
-    glBindVertexArray(0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
 }
 
 } // namespace gyo
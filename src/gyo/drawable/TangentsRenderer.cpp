@@ -4,6 +4,7 @@
 #include <gyo/shading/Shader.h>
 
 #include <glad/glad.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 
 namespace gyo {
@@ -28,8 +29,7 @@ TangentsRenderer::TangentsRenderer(Geometry& geometry, float lineLength) : lineL
     glCheckError();
     
     // bind Vertex Array Object first
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
     
     // copy our vertices array in a buffer
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -55,8 +55,7 @@ TangentsRenderer::TangentsRenderer(Geometry& geometry, float lineLength) : lineL
     glCheckError();
 
     // clean up and unbind
-    glBindVertexArray(0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glCheckError();
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -70,10 +69,8 @@ TangentsRenderer::TangentsRenderer(Geometry& geometry, float lineLength) : lineL
 }
 
 TangentsRenderer::~TangentsRenderer() {
-    glDeleteVertexArrays(1, &VAO);
-    glCheckError();
-    glDeleteBuffers(1, &VBO);
-    glCheckError();
+    RenderState::DeleteVertexArray(VAO);
+    RenderState::DeleteBuffer(VBO);
 
     shader = nullptr;
 }
@@ -87,13 +84,11 @@ void TangentsRenderer::Update(const glm::mat4& modelMatrix, const glm::mat4& nor
 void TangentsRenderer::Draw() const {
     shader->Use();
 
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
     // draw points, and let the geometry shader draw the lines
     glDrawArrays(GL_POINTS, 0, vertexCount);
     glCheckError();
-    glBindVertexArray(0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
 }
 
 } // namespace gyo
@@ -0,0 +1,77 @@
+
+#include <gyo/geometry/GeometryDescriptor.h>
+#include <gyo/geometry/Cube.h>
+#include <gyo/geometry/InvertedCube.h>
+#include <gyo/geometry/Pyramid.h>
+#include <gyo/geometry/Quad.h>
+#include <gyo/geometry/Sphere.h>
+#include <gyo/geometry/Torus.h>
+#include <gyo/utilities/Hash.h>
+
+namespace gyo {
+
+GeometryDescriptor GeometryDescriptor::Cube(float halfSize) {
+    return { GeometryShape::CUBE, { halfSize } };
+}
+
+GeometryDescriptor GeometryDescriptor::InvertedCube() {
+    return { GeometryShape::INVERTED_CUBE, {} };
+}
+
+GeometryDescriptor GeometryDescriptor::Pyramid(float halfBase, float height) {
+    return { GeometryShape::PYRAMID, { halfBase, height } };
+}
+
+GeometryDescriptor GeometryDescriptor::Quad(float halfSize) {
+    return { GeometryShape::QUAD, { halfSize } };
+}
+
+GeometryDescriptor GeometryDescriptor::Sphere(float radius, int stacks, int slices) {
+    return { GeometryShape::SPHERE, { radius, static_cast<float>(stacks), static_cast<float>(slices) } };
+}
+
+GeometryDescriptor GeometryDescriptor::Torus(float majorRadius, float minorRadius, int majorSegments, int minorSegments) {
+    return { GeometryShape::TORUS, { majorRadius, minorRadius, static_cast<float>(majorSegments), static_cast<float>(minorSegments) } };
+}
+
+uint64_t GeometryDescriptor::GetKey() const {
+    // tagged so a descriptor's key can't be mistaken for a hash of vertex data
+    static const char TAG[] = "GeometryDescriptor";
+
+    uint64_t key = hash_bytes(TAG, sizeof(TAG));
+    key = hash_bytes(&shape, sizeof(shape), key);
+    key = hash_bytes(params, sizeof(params), key);
+
+    return key;
+}
+
+Geometry* GeometryDescriptor::Generate() const {
+    Geometry* geometry = nullptr;
+
+    switch(shape) {
+        case GeometryShape::CUBE:
+            geometry = new gyo::Cube(params[0]);
+            break;
+        case GeometryShape::INVERTED_CUBE:
+            geometry = new gyo::InvertedCube();
+            break;
+        case GeometryShape::PYRAMID:
+            geometry = new gyo::Pyramid(params[0], params[1]);
+            break;
+        case GeometryShape::QUAD:
+            geometry = new gyo::Quad(params[0]);
+            break;
+        case GeometryShape::SPHERE:
+            geometry = new gyo::Sphere(params[0], static_cast<int>(params[1]), static_cast<int>(params[2]));
+            break;
+        case GeometryShape::TORUS:
+            geometry = new gyo::Torus(params[0], params[1], static_cast<int>(params[2]), static_cast<int>(params[3]));
+            break;
+    }
+
+    geometry->ComputeTangents();
+
+    return geometry;
+}
+
+} // namespace gyo
@@ -0,0 +1,44 @@
+#ifndef GEOMETRY_DESCRIPTOR_H
+#define GEOMETRY_DESCRIPTOR_H
+
+#include <cstdint>
+
+namespace gyo {
+
+struct Geometry;
+
+enum class GeometryShape {
+    CUBE = 0,
+    INVERTED_CUBE = 1,
+    PYRAMID = 2,
+    QUAD = 3,
+    SPHERE = 4,
+    TORUS = 5
+};
+
+/**
+ * A procedural shape and the parameters it's generated from. Shapes with the
+ * same descriptor are identical, so they only need generating and uploading
+ * once, see Resources::GetGeometry.
+ */
+struct GeometryDescriptor {
+    GeometryShape shape = GeometryShape::CUBE;
+    float params[4] = {};   // in the order of the shape's constructor
+
+    static GeometryDescriptor Cube(float halfSize = 1.0f);
+    static GeometryDescriptor InvertedCube();
+    static GeometryDescriptor Pyramid(float halfBase = 0.5f, float height = 1.0f);
+    static GeometryDescriptor Quad(float halfSize = 1.0f);
+    static GeometryDescriptor Sphere(float radius = 1.0f, int stacks = 32, int slices = 32);
+    static GeometryDescriptor Torus(float majorRadius = 0.5f, float minorRadius = 0.2f, int majorSegments = 32, int minorSegments = 32);
+
+    // equal descriptors have equal keys
+    uint64_t GetKey() const;
+
+    // a new copy of the shape, with its tangents
+    Geometry* Generate() const;
+};
+
+} // namespace gyo
+
+#endif // GEOMETRY_DESCRIPTOR_H
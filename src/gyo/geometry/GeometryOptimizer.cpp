@@ -0,0 +1,370 @@
+
+#include <gyo/geometry/GeometryOptimizer.h>
+#include <gyo/geometry/Geometry.h>
+#include <gyo/utilities/Log.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace gyo {
+
+static const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+/**
+ * A FIFO post-transform cache, tracked by the time each vertex entered it.
+ * Hits don't refresh a vertex, as in the hardware we model.
+ */
+class FifoCacheSim {
+public:
+    FifoCacheSim(size_t vertexCount, unsigned int cacheSize) :
+        timestamps(vertexCount, 0U), cacheSize(cacheSize), time(cacheSize + 1) {}
+
+    // returns whether the vertex had to be transformed
+    bool Access(unsigned int v) {
+        if(time - timestamps[v] > cacheSize) {
+            timestamps[v] = time++;
+            return true;
+        }
+
+        return false;
+    }
+
+    void Flush() { time += cacheSize + 1; }
+
+private:
+    std::vector<unsigned int> timestamps;
+    unsigned int cacheSize;
+    unsigned int time;
+};
+
+VertexCacheStats GeometryOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize) {
+    VertexCacheStats stats;
+    if(indices.empty() || vertexCount == 0) {
+        return stats;
+    }
+
+    FifoCacheSim cache(vertexCount, cacheSize);
+
+    size_t misses = 0;
+    for(unsigned int index : indices) {
+        misses += cache.Access(index);
+    }
+
+    stats.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+    stats.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+
+    return stats;
+}
+
+void GeometryOptimizer::Optimize(Geometry& geometry) {
+    const size_t vertexCount = geometry.positions.size();
+
+    if(vertexCount == 0 || geometry.indices.size() < 3 || geometry.indices.size() % 3 != 0) {
+        return;
+    }
+
+    VertexCacheStats before = AnalyzeVertexCache(geometry.indices, vertexCount);
+
+    size_t clusterCount = OptimizeVertexCacheAndOverdraw(geometry);
+    OptimizeVertexFetch(geometry);
+
+    VertexCacheStats after = AnalyzeVertexCache(geometry.indices, vertexCount);
+
+    LOGD("Optimized %zu triangles into %zu clusters, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+        geometry.indices.size() / 3, clusterCount, before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+size_t GeometryOptimizer::OptimizeVertexCacheAndOverdraw(Geometry& geometry) {
+    return ReorderTriangles(geometry.indices, geometry.positions.size(), [&geometry](unsigned int v) {
+        return geometry.positions[v];
+    });
+}
+
+size_t GeometryOptimizer::OptimizeVertexCacheAndOverdraw(std::vector<unsigned int>& indices,
+    const unsigned char* positions, size_t positionStride, size_t vertexCount) {
+    if(vertexCount == 0 || indices.size() < 3 || indices.size() % 3 != 0) {
+        return 0;
+    }
+
+    VertexCacheStats before = AnalyzeVertexCache(indices, vertexCount);
+
+    size_t clusterCount = ReorderTriangles(indices, vertexCount, [positions, positionStride](unsigned int v) {
+        glm::vec3 position;
+        std::memcpy(&position, positions + v * positionStride, sizeof(position));
+        return position;
+    });
+
+    VertexCacheStats after = AnalyzeVertexCache(indices, vertexCount);
+
+    LOGD("Optimized %zu triangles in place into %zu clusters, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+        indices.size() / 3, clusterCount, before.acmr, after.acmr, before.atvr, after.atvr);
+
+    return clusterCount;
+}
+
+template<typename GetPosition>
+size_t GeometryOptimizer::ReorderTriangles(std::vector<unsigned int>& indices, size_t vertexCount, const GetPosition& getPosition) {
+    const size_t triangleCount = indices.size() / 3;
+
+    // build the triangles adjacent to each vertex, and how many of them are
+    // still to be emitted
+
+    std::vector<unsigned int> liveCounts(vertexCount, 0U);
+    for(unsigned int index : indices) {
+        liveCounts[index]++;
+    }
+
+    std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0U);
+    std::partial_sum(liveCounts.begin(), liveCounts.end(), adjacencyOffsets.begin() + 1);
+
+    std::vector<unsigned int> adjacency(indices.size());
+    {
+        std::vector<unsigned int> cursors(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); i++) {
+            adjacency[cursors[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    // Tipsify: fan around a vertex, emitting all its remaining triangles,
+    // then move to whichever just-used vertex will still be in the cache
+    // once its own triangles are emitted
+
+    std::vector<unsigned int> order;
+    order.reserve(triangleCount);
+
+    std::vector<size_t> clusterStarts = { 0 };
+
+    std::vector<bool> isEmitted(triangleCount, false);
+    std::vector<unsigned int> cacheTimes(vertexCount, 0U);
+    unsigned int time = CACHE_SIZE + 1;
+
+    std::vector<unsigned int> deadEnds;
+    std::vector<unsigned int> candidates;
+    unsigned int scanCursor = 0;
+
+    // when stuck, go back to a recently used vertex, or else the next unused one
+    auto skipDeadEnd = [&]() -> unsigned int {
+        while(!deadEnds.empty()) {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if(liveCounts[v] > 0) {
+                return v;
+            }
+        }
+
+        while(scanCursor < vertexCount) {
+            if(liveCounts[scanCursor] > 0) {
+                return scanCursor;
+            }
+            scanCursor++;
+        }
+
+        return INVALID_INDEX;
+    };
+
+    unsigned int fanning = skipDeadEnd();
+
+    while(fanning != INVALID_INDEX) {
+        candidates.clear();
+
+        for(unsigned int a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; a++) {
+            unsigned int t = adjacency[a];
+            if(isEmitted[t]) {
+                continue;
+            }
+
+            isEmitted[t] = true;
+            order.push_back(t);
+
+            for(int k = 0; k < 3; k++) {
+                unsigned int v = indices[t * 3 + k];
+
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveCounts[v]--;
+
+                if(time - cacheTimes[v] > CACHE_SIZE) {
+                    cacheTimes[v] = time++;
+                }
+            }
+        }
+
+        unsigned int next = INVALID_INDEX;
+        int bestPriority = -1;
+
+        for(unsigned int v : candidates) {
+            if(liveCounts[v] == 0) {
+                continue;
+            }
+
+            // prefer the oldest vertex that'll survive fanning around it
+            int priority = 0;
+            if(time - cacheTimes[v] + 2 * liveCounts[v] <= CACHE_SIZE) {
+                priority = static_cast<int>(time - cacheTimes[v]);
+            }
+
+            if(priority > bestPriority) {
+                bestPriority = priority;
+                next = v;
+            }
+        }
+
+        if(next == INVALID_INDEX) {
+            next = skipDeadEnd();
+
+            // a jump starts a new cluster, as the cache is cold again
+            if(next != INVALID_INDEX && order.size() < triangleCount) {
+                clusterStarts.push_back(order.size());
+            }
+        }
+
+        fanning = next;
+    }
+
+    clusterStarts.push_back(order.size());
+
+    // split the clusters further wherever the triangles so far already hit
+    // the cache about as well as the whole cluster does
+
+    std::vector<size_t> softStarts;
+    FifoCacheSim cache(vertexCount, CACHE_SIZE);
+
+    for(size_t c = 0; c + 1 < clusterStarts.size(); c++) {
+        const size_t begin = clusterStarts[c];
+        const size_t end = clusterStarts[c + 1];
+
+        cache.Flush();
+        size_t clusterMisses = 0;
+        for(size_t i = begin; i < end; i++) {
+            for(int k = 0; k < 3; k++) {
+                clusterMisses += cache.Access(indices[order[i] * 3 + k]);
+            }
+        }
+
+        const float threshold = OVERDRAW_THRESHOLD * clusterMisses / static_cast<float>(end - begin);
+
+        cache.Flush();
+        softStarts.push_back(begin);
+
+        size_t start = begin;
+        size_t misses = 0;
+        for(size_t i = begin; i < end; i++) {
+            for(int k = 0; k < 3; k++) {
+                misses += cache.Access(indices[order[i] * 3 + k]);
+            }
+
+            if(i + 1 < end && misses / static_cast<float>(i - start + 1) <= threshold) {
+                start = i + 1;
+                misses = 0;
+                softStarts.push_back(start);
+                cache.Flush();
+            }
+        }
+    }
+
+    softStarts.push_back(order.size());
+
+    // sort the clusters by how far out they face from the mesh's centre, so
+    // the outermost are drawn first and occlude the rest
+
+    glm::vec3 meshCentroid(0.0f);
+    for(size_t v = 0; v < vertexCount; v++) {
+        meshCentroid += getPosition(static_cast<unsigned int>(v));
+    }
+    meshCentroid = meshCentroid / static_cast<float>(vertexCount);
+
+    const size_t clusterCount = softStarts.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+
+    for(size_t c = 0; c < clusterCount; c++) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+
+        for(size_t i = softStarts[c]; i < softStarts[c + 1]; i++) {
+            const glm::vec3 p0 = getPosition(indices[order[i] * 3 + 0]);
+            const glm::vec3 p1 = getPosition(indices[order[i] * 3 + 1]);
+            const glm::vec3 p2 = getPosition(indices[order[i] * 3 + 2]);
+
+            // the cross product's length is twice the triangle's area
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float a = glm::length(n);
+
+            centroid += (p0 + p1 + p2) * (a / 3.0f);
+            normal += n;
+            area += a;
+        }
+
+        if(area > 0.0f) {
+            centroid = centroid / area;
+        }
+
+        float normalLength = glm::length(normal);
+        sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+    }
+
+    std::vector<size_t> clusterOrder(clusterCount);
+    std::iota(clusterOrder.begin(), clusterOrder.end(), 0);
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKeys](size_t a, size_t b) {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    // write out the new index order
+
+    std::vector<unsigned int> newIndices;
+    newIndices.reserve(indices.size());
+
+    for(size_t c : clusterOrder) {
+        for(size_t i = softStarts[c]; i < softStarts[c + 1]; i++) {
+            const unsigned int t = order[i];
+            newIndices.push_back(indices[t * 3 + 0]);
+            newIndices.push_back(indices[t * 3 + 1]);
+            newIndices.push_back(indices[t * 3 + 2]);
+        }
+    }
+
+    indices = std::move(newIndices);
+
+    return clusterCount;
+}
+
+void GeometryOptimizer::OptimizeVertexFetch(Geometry& geometry) {
+    const size_t vertexCount = geometry.positions.size();
+
+    // number vertices by first use, leaving any unused ones at the end
+    std::vector<unsigned int> remap(vertexCount, INVALID_INDEX);
+    unsigned int nextVertex = 0;
+
+    for(unsigned int& index : geometry.indices) {
+        if(remap[index] == INVALID_INDEX) {
+            remap[index] = nextVertex++;
+        }
+        index = remap[index];
+    }
+
+    for(unsigned int& newIndex : remap) {
+        if(newIndex == INVALID_INDEX) {
+            newIndex = nextVertex++;
+        }
+    }
+
+    auto remapStream = [&remap, vertexCount](auto& stream) {
+        if(stream.size() != vertexCount) {
+            return;
+        }
+
+        std::remove_reference_t<decltype(stream)> remapped(vertexCount);
+        for(size_t v = 0; v < vertexCount; v++) {
+            remapped[remap[v]] = stream[v];
+        }
+        stream = std::move(remapped);
+    };
+
+    remapStream(geometry.positions);
+    remapStream(geometry.normals);
+    remapStream(geometry.texCoords);
+    remapStream(geometry.tangents);
+}
+
+} // namespace gyo
@@ -0,0 +1,70 @@
+#ifndef GEOMETRY_OPTIMIZER_H
+#define GEOMETRY_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+namespace gyo {
+
+struct Geometry;
+
+/**
+ * How well an index order uses a FIFO post-transform vertex cache
+ */
+struct VertexCacheStats {
+    float acmr = 0.0f;  // average cache miss ratio, vertex shader runs per triangle
+    float atvr = 0.0f;  // average transform to vertex ratio, shader runs per vertex. 1 is ideal.
+};
+
+/**
+ * Reorders triangles and vertices at import time so the GPU transforms and
+ * fetches fewer vertices, without changing what's drawn.
+ */
+class GeometryOptimizer {
+public:
+    // the FIFO cache size we optimize for
+    static const unsigned int CACHE_SIZE = 16;
+
+    // how much worse than its cluster's ACMR a run of triangles may be to
+    // start a new cluster, trading cache hits for overdraw sorting
+    static constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+    /**
+     * Runs every pass below in order, logging the cache stats before and after
+     */
+    static void Optimize(Geometry& geometry);
+
+    /**
+     * Reorders triangles for vertex cache locality with Tipsify, then sorts
+     * clusters of them front to back as seen from outside the mesh, so
+     * nearer surfaces tend to be drawn first. Returns the cluster count.
+     * Adapted from Sander, Nehab & Barczak, "Fast Triangle Reordering for Vertex
+     * Locality and Reduced Overdraw", SIGGRAPH 2007
+     */
+    static size_t OptimizeVertexCacheAndOverdraw(Geometry& geometry);
+
+    /**
+     * Same as above, for indices into vertices that stay where they are, e.g.
+     * uploaded in place from a file, with positions read at the given stride.
+     * Logs the cache stats before and after, as Optimize does.
+     */
+    static size_t OptimizeVertexCacheAndOverdraw(std::vector<unsigned int>& indices,
+        const unsigned char* positions, size_t positionStride, size_t vertexCount);
+
+    /**
+     * Renumbers vertices in the order the indices first use them, so vertex
+     * fetches walk forward through memory
+     */
+    static void OptimizeVertexFetch(Geometry& geometry);
+
+    static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE);
+
+private:
+    // Tipsify and the overdraw sort, wherever the positions are
+    template<typename GetPosition>
+    static size_t ReorderTriangles(std::vector<unsigned int>& indices, size_t vertexCount, const GetPosition& getPosition);
+};
+
+} // namespace gyo
+
+#endif // GEOMETRY_OPTIMIZER_H
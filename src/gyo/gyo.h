@@ -5,6 +5,7 @@
 #include <gyo/drawable/TangentsRenderer.h>
 
 #include <gyo/geometry/Cube.h>
+#include <gyo/geometry/GeometryDescriptor.h>
 #include <gyo/geometry/Pyramid.h>
 #include <gyo/geometry/Quad.h>
 #include <gyo/geometry/Sphere.h>
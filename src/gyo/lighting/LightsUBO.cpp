@@ -18,6 +18,7 @@
 #include <gyo/lighting/PointLight.h>
 #include <gyo/lighting/SpotLight.h>
 #include <gyo/scene/SceneController.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
 
@@ -38,17 +39,15 @@ LightsUBO::LightsUBO() {
     glBufferData(GL_UNIFORM_BUFFER, bufferSize, NULL, GL_DYNAMIC_DRAW);
     glCheckError();
 
-    // link the range of the entire buffer to binding point 0
-    glBindBufferRange(GL_UNIFORM_BUFFER, 1, uboLights, 0, bufferSize);
-    glCheckError();
-
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
     glCheckError();
+
+    // link the entire buffer to binding point 1
+    RenderState::BindUniformBuffer(1, uboLights);
 }
 
 LightsUBO::~LightsUBO() {
-    glDeleteBuffers(1, &uboLights);
-    glCheckError();
+    RenderState::DeleteBuffer(uboLights);
 }
 
 void LightsUBO::UpdateValues(glm::vec3 ambient, const std::vector<LightNode*>& lights) {
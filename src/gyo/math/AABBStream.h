@@ -0,0 +1,45 @@
+#ifndef AABB_STREAM_H
+#define AABB_STREAM_H
+
+#include <gyo/math/AABB.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * Structure-of-arrays AABB storage, so batches of boxes can be loaded
+ * straight into SIMD registers. Each stream is padded past the end so a
+ * kernel may always load a full batch.
+ */
+struct AABBStream {
+    static const int PADDING = 8; // widest batch of our kernels
+
+    std::vector<float> minX, minY, minZ;
+    std::vector<float> maxX, maxY, maxZ;
+
+    // plane-coherency, the index of the last plane each box failed at
+    std::vector<uint8_t> lastFailedPlane;
+
+    int size = 0;
+
+    void Resize(int count) {
+        size = count;
+
+        const size_t padded = count + PADDING;
+        minX.assign(padded, 0.0f); minY.assign(padded, 0.0f); minZ.assign(padded, 0.0f);
+        maxX.assign(padded, 0.0f); maxY.assign(padded, 0.0f); maxZ.assign(padded, 0.0f);
+
+        lastFailedPlane.assign(padded, 0);
+    }
+
+    void Set(int i, const AABB& bounds) {
+        minX[i] = bounds.min.x; minY[i] = bounds.min.y; minZ[i] = bounds.min.z;
+        maxX[i] = bounds.max.x; maxY[i] = bounds.max.y; maxZ[i] = bounds.max.z;
+    }
+};
+
+} // namespace gyo
+
+#endif // AABB_STREAM_H
@@ -159,6 +159,65 @@ struct Frustum {
 
         return intersects ? FrustumTestResult::INTERSECTING : FrustumTestResult::INSIDE;
     }
+
+    /**
+     * Same as above, except the n- and p-vertices are selected straight from
+     * the bounds, and only the planes set in planeMask are tested. Any plane
+     * the AABB is found to be fully inside of is cleared from the mask, so the
+     * children of a bounding volume hierarchy node can skip it entirely.
+     */
+    FrustumTestResult TestAABBIntersection(
+        const AABB& bounds,
+        const std::array<std::pair<int, int>, 6>& frustumLUT,
+        unsigned int* planeMask) const
+    {
+        bool intersects = false;
+
+        for(int i = 0; i < 6; i++) {
+            const unsigned int planeBit = 1U << i;
+            if((*planeMask & planeBit) == 0) {
+                continue;
+            }
+
+            const Plane& plane = planes[i];
+
+            // determine the n-vertex relative to the plane normal
+            const int n = frustumLUT[i].first;
+            glm::vec3 vn(
+                (n & 1) ? bounds.max.x : bounds.min.x,
+                (n & 2) ? bounds.max.y : bounds.min.y,
+                (n & 4) ? bounds.max.z : bounds.min.z
+            );
+
+            // test the n-vertex
+            float a = glm::dot(plane.normal, vn) + plane.distance;
+            if (a < 0) {
+                // if the n-vertex is outside, the box is outside
+                return FrustumTestResult::OUTSIDE;
+            }
+
+            // determine the p-vertex relative to the plane normal
+            const int p = frustumLUT[i].second;
+            glm::vec3 vp(
+                (p & 1) ? bounds.max.x : bounds.min.x,
+                (p & 2) ? bounds.max.y : bounds.min.y,
+                (p & 4) ? bounds.max.z : bounds.min.z
+            );
+
+            // test the p-vertex
+            float b = glm::dot(plane.normal, vp) + plane.distance;
+            if (b < 0) {
+                // if p-vertex is inside, we might be intersecting
+                intersects = true;
+            }
+            else {
+                // fully inside this plane; anything contained needn't test it
+                *planeMask &= ~planeBit;
+            }
+        }
+
+        return intersects ? FrustumTestResult::INTERSECTING : FrustumTestResult::INSIDE;
+    }
 };
 
 } // namespace gyo
@@ -0,0 +1,126 @@
+
+#include <gyo/math/FrustumKernel.h>
+#include <gyo/math/Frustum.h>
+#include <gyo/math/AABBStream.h>
+
+#include <bit>
+
+#if defined(GYO_USE_AVX2)
+    #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #define GYO_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace gyo {
+
+/**
+ * A plane with its n-vertex streams already selected from the sign of its
+ * normal, so the inner loop is branch free
+ */
+struct KernelPlane {
+    float nx, ny, nz, d;
+    const float* xs;
+    const float* ys;
+    const float* zs;
+};
+
+/**
+ * Returns a lane bitmask of the boxes starting at i whose n-vertex lies
+ * behind the plane, which means the box is outside
+ */
+static inline unsigned int OutsideLanes(const KernelPlane& p, int i) {
+#if defined(GYO_USE_AVX2)
+    __m256 dist = _mm256_add_ps(
+        _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(p.nx), _mm256_loadu_ps(p.xs + i)),
+            _mm256_mul_ps(_mm256_set1_ps(p.ny), _mm256_loadu_ps(p.ys + i))),
+        _mm256_add_ps(
+            _mm256_mul_ps(_mm256_set1_ps(p.nz), _mm256_loadu_ps(p.zs + i)),
+            _mm256_set1_ps(p.d)));
+
+    return _mm256_movemask_ps(_mm256_cmp_ps(dist, _mm256_setzero_ps(), _CMP_LT_OQ));
+#elif defined(GYO_USE_SSE2)
+    __m128 dist = _mm_add_ps(
+        _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(p.nx), _mm_loadu_ps(p.xs + i)),
+            _mm_mul_ps(_mm_set1_ps(p.ny), _mm_loadu_ps(p.ys + i))),
+        _mm_add_ps(
+            _mm_mul_ps(_mm_set1_ps(p.nz), _mm_loadu_ps(p.zs + i)),
+            _mm_set1_ps(p.d)));
+
+    return _mm_movemask_ps(_mm_cmplt_ps(dist, _mm_setzero_ps()));
+#else
+    unsigned int mask = 0;
+    for(int lane = 0; lane < FrustumKernel::BATCH_SIZE; lane++) {
+        float dist = p.nx * p.xs[i + lane] + p.ny * p.ys[i + lane] + p.nz * p.zs[i + lane] + p.d;
+        mask |= (dist < 0.0f ? 1U : 0U) << lane;
+    }
+    return mask;
+#endif
+}
+
+void FrustumKernel::TestAABBs(
+    const Frustum& frustum,
+    AABBStream& boxes,
+    int first,
+    int count,
+    unsigned int planeMask,
+    uint32_t* visibility,
+    int visibilityOffset)
+{
+    KernelPlane planes[6];
+
+    for(int i = 0; i < 6; i++) {
+        const Plane& plane = frustum.planes[i];
+
+        planes[i] = {
+            plane.normal.x, plane.normal.y, plane.normal.z, plane.distance,
+            plane.normal.x > 0 ? boxes.maxX.data() : boxes.minX.data(),
+            plane.normal.y > 0 ? boxes.maxY.data() : boxes.minY.data(),
+            plane.normal.z > 0 ? boxes.maxZ.data() : boxes.minZ.data()
+        };
+    }
+
+    const int end = first + count;
+
+    for(int b = first; b < end; b += BATCH_SIZE) {
+        // lanes past the end of the range read padding, mask them out
+        const int lanes = end - b < BATCH_SIZE ? end - b : BATCH_SIZE;
+        const unsigned int laneMask = (1U << lanes) - 1;
+
+        unsigned int outside = 0;
+
+        // start testing at the last frustum plane this batch failed at
+        const int start = boxes.lastFailedPlane[b];
+
+        for(int d = 0; d < 6; d++) {
+            int i = (d + start) % 6;
+            if((planeMask & (1U << i)) == 0) {
+                continue;
+            }
+
+            unsigned int rejected = OutsideLanes(planes[i], b) & laneMask & ~outside;
+            if(rejected == 0) {
+                continue;
+            }
+
+            // update the last failed plane of each newly rejected box
+            for(unsigned int m = rejected; m != 0; m &= m - 1) {
+                boxes.lastFailedPlane[b + std::countr_zero(m)] = static_cast<uint8_t>(i);
+            }
+
+            outside |= rejected;
+            if(outside == laneMask) {
+                break;
+            }
+        }
+
+        for(unsigned int m = laneMask & ~outside; m != 0; m &= m - 1) {
+            int index = b + std::countr_zero(m) - visibilityOffset;
+            visibility[index >> 5] |= 1U << (index & 31);
+        }
+    }
+}
+
+} // namespace gyo
@@ -0,0 +1,43 @@
+#ifndef FRUSTUM_KERNEL_H
+#define FRUSTUM_KERNEL_H
+
+#include <cstdint>
+
+namespace gyo {
+
+struct Frustum;
+struct AABBStream;
+
+/**
+ * Batched AABB frustum culling over SoA bounds. Tests 8 boxes per iteration
+ * when built with GYO_USE_AVX2, 4 with SSE2, and falls back to scalar code
+ * on everything else.
+ */
+class FrustumKernel {
+public:
+#if defined(GYO_USE_AVX2)
+    static const int BATCH_SIZE = 8;
+#else
+    static const int BATCH_SIZE = 4;
+#endif
+
+    /**
+     * Tests the boxes [first, first + count) against the planes set in
+     * planeMask, setting bit (i - visibilityOffset) of the visibility bitmask
+     * for every box i that isn't outside. Each batch starts testing at the
+     * plane its first box last failed at (plane-coherency), and stops once
+     * every box is rejected.
+     */
+    static void TestAABBs(
+        const Frustum& frustum,
+        AABBStream& boxes,
+        int first,
+        int count,
+        unsigned int planeMask,
+        uint32_t* visibility,
+        int visibilityOffset = 0);
+};
+
+} // namespace gyo
+
+#endif // FRUSTUM_KERNEL_H
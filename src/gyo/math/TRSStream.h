@@ -0,0 +1,51 @@
+#ifndef TRS_STREAM_H
+#define TRS_STREAM_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <vector>
+
+namespace gyo {
+
+/**
+ * Structure-of-arrays translation, rotation, and scale storage, so batches of
+ * transforms can be composed in SIMD registers. Like AABBStream, each stream
+ * is padded past the end so a kernel may always load a full batch.
+ */
+struct TRSStream {
+    static const int PADDING = 8;
+
+    std::vector<float> px, py, pz;
+    std::vector<float> qx, qy, qz, qw;
+    std::vector<float> sx, sy, sz;
+
+    int size = 0;
+
+    void Clear() {
+        size = 0;
+    }
+
+    void Push(const glm::vec3& position, const glm::fquat& rotation, const glm::vec3& scale) {
+        if(static_cast<int>(px.size()) < size + PADDING) {
+            Reserve((size + PADDING) * 2);
+        }
+
+        px[size] = position.x; py[size] = position.y; pz[size] = position.z;
+        qx[size] = rotation.x; qy[size] = rotation.y; qz[size] = rotation.z; qw[size] = rotation.w;
+        sx[size] = scale.x; sy[size] = scale.y; sz[size] = scale.z;
+
+        size++;
+    }
+
+private:
+    void Reserve(size_t capacity) {
+        px.resize(capacity, 0.0f); py.resize(capacity, 0.0f); pz.resize(capacity, 0.0f);
+        qx.resize(capacity, 0.0f); qy.resize(capacity, 0.0f); qz.resize(capacity, 0.0f); qw.resize(capacity, 1.0f);
+        sx.resize(capacity, 1.0f); sy.resize(capacity, 1.0f); sz.resize(capacity, 1.0f);
+    }
+};
+
+} // namespace gyo
+
+#endif // TRS_STREAM_H
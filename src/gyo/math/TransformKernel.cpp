@@ -0,0 +1,262 @@
+
+#include <gyo/math/TransformKernel.h>
+#include <gyo/math/TRSStream.h>
+#include <gyo/math/AABB.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+    #define GYO_TRANSFORM_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace gyo {
+
+void TransformKernel::ComposeTRS(const TRSStream& trs, glm::mat4* const* out) {
+#if defined(GYO_TRANSFORM_SSE2)
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for(int b = 0; b < trs.size; b += 4) {
+        __m128 x = _mm_loadu_ps(trs.qx.data() + b);
+        __m128 y = _mm_loadu_ps(trs.qy.data() + b);
+        __m128 z = _mm_loadu_ps(trs.qz.data() + b);
+        __m128 w = _mm_loadu_ps(trs.qw.data() + b);
+
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 sx = _mm_loadu_ps(trs.sx.data() + b);
+        __m128 sy = _mm_loadu_ps(trs.sy.data() + b);
+        __m128 sz = _mm_loadu_ps(trs.sz.data() + b);
+
+        // the rotation matrix columns, each scaled by its axis scale
+        __m128 c0x = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        __m128 c0y = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        __m128 c0z = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+
+        __m128 c1x = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        __m128 c1y = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        __m128 c1z = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+
+        __m128 c2x = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        __m128 c2y = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        __m128 c2z = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+
+        __m128 c3x = _mm_loadu_ps(trs.px.data() + b);
+        __m128 c3y = _mm_loadu_ps(trs.py.data() + b);
+        __m128 c3z = _mm_loadu_ps(trs.pz.data() + b);
+
+        // transpose from SoA lanes into one column per matrix
+        __m128 c0w = zero, c1w = zero, c2w = zero, c3w = one;
+        _MM_TRANSPOSE4_PS(c0x, c0y, c0z, c0w);
+        _MM_TRANSPOSE4_PS(c1x, c1y, c1z, c1w);
+        _MM_TRANSPOSE4_PS(c2x, c2y, c2z, c2w);
+        _MM_TRANSPOSE4_PS(c3x, c3y, c3z, c3w);
+
+        const __m128 columns[4][4] = {
+            { c0x, c1x, c2x, c3x },
+            { c0y, c1y, c2y, c3y },
+            { c0z, c1z, c2z, c3z },
+            { c0w, c1w, c2w, c3w },
+        };
+
+        const int lanes = trs.size - b < 4 ? trs.size - b : 4;
+        for(int l = 0; l < lanes; l++) {
+            float* m = &(*out[b + l])[0][0];
+            _mm_storeu_ps(m + 0, columns[l][0]);
+            _mm_storeu_ps(m + 4, columns[l][1]);
+            _mm_storeu_ps(m + 8, columns[l][2]);
+            _mm_storeu_ps(m + 12, columns[l][3]);
+        }
+    }
+#else
+    for(int i = 0; i < trs.size; i++) {
+        glm::fquat rotation(trs.qw[i], trs.qx[i], trs.qy[i], trs.qz[i]);
+        glm::mat3 r = glm::mat3_cast(rotation);
+
+        glm::mat4& m = *out[i];
+        m[0] = glm::vec4(r[0] * trs.sx[i], 0.0f);
+        m[1] = glm::vec4(r[1] * trs.sy[i], 0.0f);
+        m[2] = glm::vec4(r[2] * trs.sz[i], 0.0f);
+        m[3] = glm::vec4(trs.px[i], trs.py[i], trs.pz[i], 1.0f);
+    }
+#endif
+}
+
+void TransformKernel::Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#if defined(GYO_TRANSFORM_SSE2)
+    const float* pa = &a[0][0];
+    const float* pb = &b[0][0];
+
+    __m128 a0 = _mm_loadu_ps(pa + 0);
+    __m128 a1 = _mm_loadu_ps(pa + 4);
+    __m128 a2 = _mm_loadu_ps(pa + 8);
+    __m128 a3 = _mm_loadu_ps(pa + 12);
+
+    // each column of the result is a's columns weighted by b's column
+    __m128 r[4];
+    for(int j = 0; j < 4; j++) {
+        const float* bj = pb + j * 4;
+        r[j] = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(a0, _mm_set1_ps(bj[0])), _mm_mul_ps(a1, _mm_set1_ps(bj[1]))),
+            _mm_add_ps(_mm_mul_ps(a2, _mm_set1_ps(bj[2])), _mm_mul_ps(a3, _mm_set1_ps(bj[3]))));
+    }
+
+    float* po = &out[0][0];
+    _mm_storeu_ps(po + 0, r[0]);
+    _mm_storeu_ps(po + 4, r[1]);
+    _mm_storeu_ps(po + 8, r[2]);
+    _mm_storeu_ps(po + 12, r[3]);
+#else
+    out = a * b;
+#endif
+}
+
+void TransformKernel::NormalMatrix(const glm::mat4& m, bool hasOrthogonalAxes, glm::mat4& out) {
+    if(!hasOrthogonalAxes) {
+        out = glm::transpose(glm::inverse(m));
+        return;
+    }
+
+    // with orthogonal axes m = Q * D, so the inverse transpose is m * D^-2
+    const glm::vec3 t = glm::vec3(m[3]);
+
+    glm::mat4 result;
+    for(int i = 0; i < 3; i++) {
+        const glm::vec3 axis = glm::vec3(m[i]);
+        const float lengthSq = glm::dot(axis, axis);
+        const float invLengthSq = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;
+
+        // the bottom row is the transposed inverse translation
+        result[i] = glm::vec4(axis * invLengthSq, -glm::dot(axis, t) * invLengthSq);
+    }
+    result[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+    out = result;
+}
+
+void TransformKernel::TransformAABB(const AABB& bounds, const glm::mat4& m, AABB& out) {
+    // transform the center, and project the extents onto each axis
+#if defined(GYO_TRANSFORM_SSE2)
+    const float* pm = &m[0][0];
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    __m128 m0 = _mm_loadu_ps(pm + 0);
+    __m128 m1 = _mm_loadu_ps(pm + 4);
+    __m128 m2 = _mm_loadu_ps(pm + 8);
+    __m128 m3 = _mm_loadu_ps(pm + 12);
+
+    const glm::vec3 c = (bounds.min + bounds.max) * 0.5f;
+    const glm::vec3 e = (bounds.max - bounds.min) * 0.5f;
+
+    __m128 center = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(m0, _mm_set1_ps(c.x)), _mm_mul_ps(m1, _mm_set1_ps(c.y))),
+        _mm_add_ps(_mm_mul_ps(m2, _mm_set1_ps(c.z)), m3));
+
+    __m128 extent = _mm_add_ps(
+        _mm_add_ps(
+            _mm_mul_ps(_mm_andnot_ps(signMask, m0), _mm_set1_ps(e.x)),
+            _mm_mul_ps(_mm_andnot_ps(signMask, m1), _mm_set1_ps(e.y))),
+        _mm_mul_ps(_mm_andnot_ps(signMask, m2), _mm_set1_ps(e.z)));
+
+    float newMin[4];
+    float newMax[4];
+    _mm_storeu_ps(newMin, _mm_sub_ps(center, extent));
+    _mm_storeu_ps(newMax, _mm_add_ps(center, extent));
+
+    out.min = glm::vec3(newMin[0], newMin[1], newMin[2]);
+    out.max = glm::vec3(newMax[0], newMax[1], newMax[2]);
+#else
+    const glm::vec3 c = (bounds.min + bounds.max) * 0.5f;
+    const glm::vec3 e = (bounds.max - bounds.min) * 0.5f;
+
+    const glm::vec3 center = glm::vec3(m * glm::vec4(c, 1.0f));
+    const glm::vec3 extent =
+        glm::abs(glm::vec3(m[0])) * e.x +
+        glm::abs(glm::vec3(m[1])) * e.y +
+        glm::abs(glm::vec3(m[2])) * e.z;
+
+    out.min = center - extent;
+    out.max = center + extent;
+#endif
+}
+
+void TransformKernel::TransformAABBs(int count, const AABB* const* bounds, const glm::mat4* const* transforms, AABB* const* out) {
+    int b = 0;
+
+#if defined(GYO_TRANSFORM_SSE2)
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+
+    // 4 boxes at a time, each lane holding one box and its matrix
+    for(; b + 4 <= count; b += 4) {
+        const AABB& a0 = *bounds[b];
+        const AABB& a1 = *bounds[b + 1];
+        const AABB& a2 = *bounds[b + 2];
+        const AABB& a3 = *bounds[b + 3];
+
+        __m128 minX = _mm_setr_ps(a0.min.x, a1.min.x, a2.min.x, a3.min.x);
+        __m128 minY = _mm_setr_ps(a0.min.y, a1.min.y, a2.min.y, a3.min.y);
+        __m128 minZ = _mm_setr_ps(a0.min.z, a1.min.z, a2.min.z, a3.min.z);
+        __m128 maxX = _mm_setr_ps(a0.max.x, a1.max.x, a2.max.x, a3.max.x);
+        __m128 maxY = _mm_setr_ps(a0.max.y, a1.max.y, a2.max.y, a3.max.y);
+        __m128 maxZ = _mm_setr_ps(a0.max.z, a1.max.z, a2.max.z, a3.max.z);
+
+        const __m128 c[3] = {
+            _mm_mul_ps(_mm_add_ps(minX, maxX), half),
+            _mm_mul_ps(_mm_add_ps(minY, maxY), half),
+            _mm_mul_ps(_mm_add_ps(minZ, maxZ), half)
+        };
+        const __m128 e[3] = {
+            _mm_mul_ps(_mm_sub_ps(maxX, minX), half),
+            _mm_mul_ps(_mm_sub_ps(maxY, minY), half),
+            _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half)
+        };
+
+        // transpose each column of the 4 matrices into x, y and z lanes
+        __m128 columns[4][3];
+        for(int j = 0; j < 4; j++) {
+            __m128 r0 = _mm_loadu_ps(&(*transforms[b])[j][0]);
+            __m128 r1 = _mm_loadu_ps(&(*transforms[b + 1])[j][0]);
+            __m128 r2 = _mm_loadu_ps(&(*transforms[b + 2])[j][0]);
+            __m128 r3 = _mm_loadu_ps(&(*transforms[b + 3])[j][0]);
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            columns[j][0] = r0;
+            columns[j][1] = r1;
+            columns[j][2] = r2;
+        }
+
+        // transform the centers, and project the extents onto each axis
+        float newMin[3][4];
+        float newMax[3][4];
+        for(int k = 0; k < 3; k++) {
+            __m128 center = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(columns[0][k], c[0]), _mm_mul_ps(columns[1][k], c[1])),
+                _mm_add_ps(_mm_mul_ps(columns[2][k], c[2]), columns[3][k]));
+
+            __m128 extent = _mm_add_ps(
+                _mm_add_ps(
+                    _mm_mul_ps(_mm_andnot_ps(signMask, columns[0][k]), e[0]),
+                    _mm_mul_ps(_mm_andnot_ps(signMask, columns[1][k]), e[1])),
+                _mm_mul_ps(_mm_andnot_ps(signMask, columns[2][k]), e[2]));
+
+            _mm_storeu_ps(newMin[k], _mm_sub_ps(center, extent));
+            _mm_storeu_ps(newMax[k], _mm_add_ps(center, extent));
+        }
+
+        for(int l = 0; l < 4; l++) {
+            out[b + l]->min = glm::vec3(newMin[0][l], newMin[1][l], newMin[2][l]);
+            out[b + l]->max = glm::vec3(newMax[0][l], newMax[1][l], newMax[2][l]);
+        }
+    }
+#endif
+
+    // whatever doesn't fill a batch, or everything without SSE2
+    for(; b < count; b++) {
+        TransformAABB(*bounds[b], *transforms[b], *out[b]);
+    }
+}
+
+} // namespace gyo
@@ -0,0 +1,51 @@
+#ifndef TRANSFORM_KERNEL_H
+#define TRANSFORM_KERNEL_H
+
+#include <glm/glm.hpp>
+
+namespace gyo {
+
+struct AABB;
+struct TRSStream;
+
+/**
+ * Batched transform math for the scene graph. Uses SSE2 where available,
+ * and falls back to scalar code on everything else.
+ */
+class TransformKernel {
+public:
+    /**
+     * Composes translate * rotate * scale for every entry of the stream,
+     * 4 at a time, writing each into the matrix its out pointer points at
+     */
+    static void ComposeTRS(const TRSStream& trs, glm::mat4* const* out);
+
+    /**
+     * out = a * b, for affine matrices. out may alias either input.
+     */
+    static void Multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out);
+
+    /**
+     * The inverse transpose of an affine matrix. When the axes of m are known
+     * to be orthogonal (no shear, i.e. every ancestor has a uniform scale),
+     * it's just each axis divided by its squared length, with no inverse.
+     */
+    static void NormalMatrix(const glm::mat4& m, bool hasOrthogonalAxes, glm::mat4& out);
+
+    /**
+     * Transforms an AABB by an affine matrix, producing the tight AABB around
+     * the result without transforming all 8 corners.
+     * Adapted from Jim Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems, 1990
+     */
+    static void TransformAABB(const AABB& bounds, const glm::mat4& m, AABB& out);
+
+    /**
+     * Same as above, for count boxes at once, 4 at a time with the boxes and
+     * matrices transposed into SoA lanes. out may alias bounds.
+     */
+    static void TransformAABBs(int count, const AABB* const* bounds, const glm::mat4* const* transforms, AABB* const* out);
+};
+
+} // namespace gyo
+
+#endif // TRANSFORM_KERNEL_H
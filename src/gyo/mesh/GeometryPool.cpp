@@ -0,0 +1,629 @@
+
+#include <gyo/mesh/GeometryPool.h>
+#include <gyo/geometry/Geometry.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/shading/ShaderSemantics.h>
+#include <gyo/utilities/Clock.h>
+#include <gyo/utilities/GetError.h>
+#include <gyo/utilities/Hash.h>
+#include <gyo/utilities/Log.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace gyo {
+
+GeometryPool* GeometryPool::pool = nullptr;
+
+#if defined(GYO_QUANTIZE_VERTICES)
+const VertexStream GeometryPool::STREAMS[STREAM_COUNT] = {
+    { SEMANTIC_POSITION,  3, GL_SHORT,              GL_TRUE,  4 * sizeof(int16_t) },
+    { SEMANTIC_NORMAL,    4, GL_INT_2_10_10_10_REV, GL_TRUE,  sizeof(uint32_t) },
+    { SEMANTIC_TEXCOORD0, 2, GL_HALF_FLOAT,         GL_FALSE, 2 * sizeof(uint16_t) },
+    { SEMANTIC_TANGENT,   4, GL_INT_2_10_10_10_REV, GL_TRUE,  sizeof(uint32_t) }
+};
+#else
+const VertexStream GeometryPool::STREAMS[STREAM_COUNT] = {
+    { SEMANTIC_POSITION,  3, GL_FLOAT,              GL_FALSE, 3 * sizeof(float) },
+    { SEMANTIC_NORMAL,    3, GL_FLOAT,              GL_FALSE, 3 * sizeof(float) },
+    { SEMANTIC_TEXCOORD0, 2, GL_FLOAT,              GL_FALSE, 2 * sizeof(float) },
+    { SEMANTIC_TANGENT,   3, GL_FLOAT,              GL_FALSE, 3 * sizeof(float) }
+};
+#endif
+
+// a value in [-1, 1] as a 16-bit signed normalized integer
+static int16_t PackSnorm16(float f) {
+    return static_cast<int16_t>(std::round(glm::clamp(f, -1.0f, 1.0f) * 32767.0f));
+}
+
+/**
+ * Finds the center and largest half extent of the first count positions,
+ * which quantized positions are stored relative to
+ */
+static void ComputePositionBounds(const VertexStreamSource& src, unsigned int count, float bounds[4]) {
+    const size_t available = src.data != nullptr ? std::min<size_t>(src.count, count) : 0;
+    if(available == 0) {
+        return;
+    }
+
+    const unsigned char* in = static_cast<const unsigned char*>(src.data);
+
+    glm::vec3 min(FLT_MAX);
+    glm::vec3 max(-FLT_MAX);
+    for(size_t v = 0; v < available; v++) {
+        glm::vec3 position;
+        std::memcpy(&position, in + v * src.stride, sizeof(position));
+        min = glm::min(min, position);
+        max = glm::max(max, position);
+    }
+
+    const glm::vec3 center = (min + max) * 0.5f;
+    const glm::vec3 halfSize = (max - min) * 0.5f;
+    const float halfExtent = glm::max(halfSize.x, glm::max(halfSize.y, halfSize.z));
+
+    bounds[0] = center.x;
+    bounds[1] = center.y;
+    bounds[2] = center.z;
+    bounds[3] = halfExtent > 0.0f ? halfExtent : 1.0f;
+}
+
+/**
+ * Writes the first count elements of a stream's source into dst in the
+ * stream's format, zeroing any the source doesn't have. Positions are
+ * quantized relative to bounds.
+ */
+static void EncodeStream(const VertexStream& stream, const VertexStreamSource& src, unsigned int count, const float bounds[4], unsigned char* dst) {
+    const size_t available = src.data != nullptr ? std::min<size_t>(src.count, count) : 0;
+    const unsigned char* in = static_cast<const unsigned char*>(src.data);
+
+    if(stream.type == GL_FLOAT) {
+        for(size_t v = 0; v < available; v++) {
+            std::memcpy(dst + v * stream.stride, in + v * src.stride, stream.stride);
+        }
+    }
+    else if(stream.type == GL_SHORT) {
+        // w only pads each element to 8 bytes, the attribute reads 3 components
+        const glm::vec3 center(bounds[0], bounds[1], bounds[2]);
+        const float scale = 1.0f / bounds[3];
+
+        int16_t* packed = reinterpret_cast<int16_t*>(dst);
+        for(size_t v = 0; v < available; v++) {
+            glm::vec3 value;
+            std::memcpy(&value, in + v * src.stride, sizeof(value));
+            value = (value - center) * scale;
+            packed[v * 4 + 0] = PackSnorm16(value.x);
+            packed[v * 4 + 1] = PackSnorm16(value.y);
+            packed[v * 4 + 2] = PackSnorm16(value.z);
+            packed[v * 4 + 3] = 0;
+        }
+    }
+    else if(stream.type == GL_INT_2_10_10_10_REV) {
+        uint32_t* packed = reinterpret_cast<uint32_t*>(dst);
+        for(size_t v = 0; v < available; v++) {
+            glm::vec3 value;
+            std::memcpy(&value, in + v * src.stride, sizeof(value));
+            packed[v] = glm::packSnorm3x10_1x2(glm::vec4(value, 0.0f));
+        }
+    }
+    else {
+        uint32_t* packed = reinterpret_cast<uint32_t*>(dst);
+        for(size_t v = 0; v < available; v++) {
+            glm::vec2 value;
+            std::memcpy(&value, in + v * src.stride, sizeof(value));
+            packed[v] = glm::packHalf2x16(value);
+        }
+    }
+
+    std::memset(dst + available * stream.stride, 0, (count - available) * stream.stride);
+}
+
+// reads any glTF style index type
+static unsigned int ReadIndex(const void* indices, GLenum type, size_t i) {
+    switch(type) {
+        case GL_UNSIGNED_BYTE:  return static_cast<const uint8_t*>(indices)[i];
+        case GL_UNSIGNED_SHORT: return static_cast<const uint16_t*>(indices)[i];
+        default:                return static_cast<const uint32_t*>(indices)[i];
+    }
+}
+
+uint64_t VertexLayout::GetKey() const {
+    uint64_t key = FNV1A_64_OFFSET;
+    for(const VertexAttributeEntry& attribute : attributes) {
+        key = hash_bytes(&attribute.semantic, sizeof(attribute.semantic), key);
+        key = hash_bytes(&attribute.index, sizeof(attribute.index), key);
+    }
+    key = hash_bytes(&instanceObjectIndexLocation, sizeof(instanceObjectIndexLocation), key);
+    key = hash_bytes(&positionBoundsLocation, sizeof(positionBoundsLocation), key);
+
+    return key;
+}
+
+// RangeAllocator
+
+void RangeAllocator::Reset(unsigned int capacity) {
+    this->capacity = capacity;
+    freeRanges.clear();
+    if(capacity > 0) {
+        freeRanges.push_back({ 0U, capacity });
+    }
+}
+
+unsigned int RangeAllocator::Allocate(unsigned int count) {
+    if(count == 0) {
+        return 0U;
+    }
+
+    for(size_t i = 0; i < freeRanges.size(); i++) {
+        Range& range = freeRanges[i];
+        if(range.count < count) {
+            continue;
+        }
+
+        unsigned int offset = range.offset;
+        range.offset += count;
+        range.count -= count;
+
+        if(range.count == 0) {
+            freeRanges.erase(freeRanges.begin() + i);
+        }
+
+        return offset;
+    }
+
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::Free(unsigned int offset, unsigned int count) {
+    if(count == 0) {
+        return;
+    }
+
+    // find the first free range after this one
+    size_t i = 0;
+    while(i < freeRanges.size() && freeRanges[i].offset < offset) {
+        i++;
+    }
+
+    const bool mergesPrevious = i > 0 && freeRanges[i - 1].offset + freeRanges[i - 1].count == offset;
+    const bool mergesNext = i < freeRanges.size() && offset + count == freeRanges[i].offset;
+
+    if(mergesPrevious && mergesNext) {
+        freeRanges[i - 1].count += count + freeRanges[i].count;
+        freeRanges.erase(freeRanges.begin() + i);
+    }
+    else if(mergesPrevious) {
+        freeRanges[i - 1].count += count;
+    }
+    else if(mergesNext) {
+        freeRanges[i].offset = offset;
+        freeRanges[i].count += count;
+    }
+    else {
+        freeRanges.insert(freeRanges.begin() + i, { offset, count });
+    }
+}
+
+// GeometryPool
+
+GeometryPool* GeometryPool::Get() {
+    if(pool == nullptr) {
+        pool = new GeometryPool();
+    }
+
+    return pool;
+}
+
+void GeometryPool::Dispose() {
+    delete pool;
+    pool = nullptr;
+}
+
+GeometryPool::GeometryPool() {
+    for(int s = 0; s < STREAM_COUNT; s++) {
+        glGenBuffers(1, &streamBuffers[s]);
+        glCheckError();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, streamBuffers[s]);
+        glCheckError();
+        glBufferData(GL_COPY_WRITE_BUFFER, INITIAL_VERTEX_CAPACITY * STREAMS[s].stride, NULL, GL_STATIC_DRAW);
+        glCheckError();
+    }
+
+    glGenBuffers(1, &EBO);
+    glCheckError();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glCheckError();
+    glBufferData(GL_COPY_WRITE_BUFFER, INITIAL_INDEX_CAPACITY * sizeof(uint16_t), NULL, GL_STATIC_DRAW);
+    glCheckError();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glCheckError();
+
+    vertexRanges.Reset(INITIAL_VERTEX_CAPACITY);
+    indexRanges.Reset(INITIAL_INDEX_CAPACITY);
+}
+
+GeometryPool::~GeometryPool() {
+    for(auto& pair : vertexArrays) {
+        RenderState::DeleteVertexArray(pair.second->VAO);
+        delete pair.second;
+    }
+    vertexArrays.clear();
+
+    for(unsigned int& buffer : streamBuffers) {
+        RenderState::DeleteBuffer(buffer);
+    }
+    RenderState::DeleteBuffer(EBO);
+}
+
+const VertexArray* GeometryPool::GetVertexArray(const VertexLayout& layout) {
+    const uint64_t key = layout.GetKey();
+
+    auto it = vertexArrays.find(key);
+    if(it != vertexArrays.end()) {
+        return it->second;
+    }
+
+    VertexArray* vertexArray = new VertexArray();
+    vertexArray->layout = layout;
+    glGenVertexArrays(1, &vertexArray->VAO);
+    glCheckError();
+
+    LinkVertexArray(*vertexArray);
+    vertexArrays[key] = vertexArray;
+
+    LOGD("Created vertex array for a %zu attribute layout", layout.attributes.size());
+
+    return vertexArray;
+}
+
+void GeometryPool::LinkVertexArray(const VertexArray& vertexArray) const {
+    RenderState::BindVertexArray(vertexArray.VAO);
+
+    // the index buffer binding is part of the vertex array's state
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+    glCheckError();
+
+    // link each attribute to its semantic's stream
+    for(const VertexAttributeEntry& attribute : vertexArray.layout.attributes) {
+        int s = 0;
+        while(s < STREAM_COUNT && STREAMS[s].semantic != attribute.semantic) {
+            s++;
+        }
+
+        if(s == STREAM_COUNT) {
+            LOGE("Unsupported semantic type %u", attribute.semantic);
+            continue;
+        }
+
+        const VertexStream& stream = STREAMS[s];
+
+        glBindBuffer(GL_ARRAY_BUFFER, streamBuffers[s]);
+        glCheckError();
+        glEnableVertexAttribArray(attribute.index);
+        glCheckError();
+        glVertexAttribPointer(attribute.index, stream.size, stream.type, stream.normalized, stream.stride, (void*)0);
+        glCheckError();
+    }
+
+    // enable the per-instance object index, advancing once per instance. Its
+    // pointer is set at draw time, see SetInstanceAttributes.
+    if(vertexArray.layout.instanceObjectIndexLocation != -1) {
+        glEnableVertexAttribArray(vertexArray.layout.instanceObjectIndexLocation);
+        glCheckError();
+        glVertexAttribDivisor(vertexArray.layout.instanceObjectIndexLocation, 1);
+        glCheckError();
+    }
+
+    // clean up and unbind
+    RenderState::BindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glCheckError();
+}
+
+int GeometryPool::Allocate(const Geometry& geometry, uint64_t key) {
+    GeometrySource source;
+    source.streams[0] = { geometry.positions.data(), geometry.positions.size(), sizeof(glm::vec3) };
+    source.streams[1] = { geometry.normals.data(), geometry.normals.size(), sizeof(glm::vec3) };
+    source.streams[2] = { geometry.texCoords.data(), geometry.texCoords.size(), sizeof(glm::vec2) };
+    source.streams[3] = { geometry.tangents.data(), geometry.tangents.size(), sizeof(glm::vec3) };
+    source.vertexCount = geometry.positions.size();
+    source.indices = geometry.indices.data();
+    source.indexCount = geometry.indices.size();
+    source.indexType = GL_UNSIGNED_INT;
+
+    return Allocate(source, key);
+}
+
+int GeometryPool::Acquire(uint64_t key) {
+    auto it = sharedHandles.find(key);
+    if(it == sharedHandles.end()) {
+        return -1;
+    }
+
+    allocations[it->second].refCount++;
+    return it->second;
+}
+
+int GeometryPool::Allocate(const GeometrySource& source, uint64_t key) {
+    if(key != 0) {
+        int handle = Acquire(key);
+        if(handle != -1) {
+            return handle;
+        }
+    }
+
+    const unsigned int vertexCount = source.vertexCount;
+    const unsigned int indexCount = source.indexCount;
+
+    // indices are relative to the mesh, so small meshes only need 16 bits
+    const GLenum indexType = vertexCount <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    const unsigned int indexSlotCount = indexType == GL_UNSIGNED_SHORT ? (indexCount + 1) & ~1U : indexCount * 2;
+
+    unsigned int firstVertex = vertexRanges.Allocate(vertexCount);
+    unsigned int firstIndexSlot = indexRanges.Allocate(indexSlotCount);
+
+    if(firstVertex == RangeAllocator::INVALID_OFFSET || firstIndexSlot == RangeAllocator::INVALID_OFFSET) {
+        if(firstVertex != RangeAllocator::INVALID_OFFSET) {
+            vertexRanges.Free(firstVertex, vertexCount);
+        }
+        if(firstIndexSlot != RangeAllocator::INVALID_OFFSET) {
+            indexRanges.Free(firstIndexSlot, indexSlotCount);
+        }
+
+        // repacking leaves all the free space at the end, so only grow if
+        // that still isn't enough
+        unsigned int vertexCapacity = vertexRanges.GetCapacity();
+        while(vertexCapacity < liveVertexCount + vertexCount) {
+            vertexCapacity *= 2;
+        }
+        unsigned int indexCapacity = indexRanges.GetCapacity();
+        while(indexCapacity < liveIndexSlotCount + indexSlotCount) {
+            indexCapacity *= 2;
+        }
+
+        Repack(vertexCapacity, indexCapacity);
+
+        firstVertex = vertexRanges.Allocate(vertexCount);
+        firstIndexSlot = indexRanges.Allocate(indexSlotCount);
+    }
+
+    // upload through the copy target, so we don't disturb any bound vertex
+    // array. Streams already in our format go straight from the source, the
+    // rest are encoded on the heap first. Streams the source doesn't have, or
+    // has too few of, are zeroed so that every stream stays in step.
+
+    float positionBounds[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+    if(STREAMS[0].type != GL_FLOAT) {
+        ComputePositionBounds(source.streams[0], vertexCount, positionBounds);
+    }
+
+    std::vector<unsigned char> encoded;
+
+    for(int s = 0; s < STREAM_COUNT; s++) {
+        const VertexStream& stream = STREAMS[s];
+        const VertexStreamSource& streamSource = source.streams[s];
+
+        if(vertexCount == 0) {
+            break;
+        }
+
+        const void* data = streamSource.data;
+        const bool isInPlace = data != nullptr && stream.type == GL_FLOAT &&
+            streamSource.stride == stream.stride && streamSource.count >= vertexCount;
+
+        if(!isInPlace) {
+            encoded.resize(vertexCount * stream.stride);
+            EncodeStream(stream, streamSource, vertexCount, positionBounds, encoded.data());
+            data = encoded.data();
+        }
+
+        glBindBuffer(GL_COPY_WRITE_BUFFER, streamBuffers[s]);
+        glCheckError();
+        glBufferSubData(GL_COPY_WRITE_BUFFER, firstVertex * stream.stride, vertexCount * stream.stride, data);
+        glCheckError();
+    }
+
+    const size_t indexOffset = firstIndexSlot * sizeof(uint16_t);
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glCheckError();
+
+    if(source.indexType == indexType) {
+        const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexCount * indexSize, source.indices);
+        glCheckError();
+    }
+    else if(indexType == GL_UNSIGNED_SHORT) {
+        std::vector<uint16_t> shortIndices(indexCount);
+        for(size_t i = 0; i < indexCount; i++) {
+            shortIndices[i] = static_cast<uint16_t>(ReadIndex(source.indices, source.indexType, i));
+        }
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexCount * sizeof(uint16_t), shortIndices.data());
+        glCheckError();
+    }
+    else {
+        std::vector<uint32_t> longIndices(indexCount);
+        for(size_t i = 0; i < indexCount; i++) {
+            longIndices[i] = ReadIndex(source.indices, source.indexType, i);
+        }
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexOffset, indexCount * sizeof(uint32_t), longIndices.data());
+        glCheckError();
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glCheckError();
+
+    // reuse a freed handle if we have one
+    int handle;
+    if(!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+    }
+    else {
+        handle = static_cast<int>(allocations.size());
+        allocations.emplace_back();
+    }
+
+    allocations[handle] = { firstVertex, vertexCount, firstIndexSlot, indexSlotCount, indexCount, indexType, true, key, 1 };
+    std::memcpy(allocations[handle].positionBounds, positionBounds, sizeof(positionBounds));
+    if(key != 0) {
+        sharedHandles[key] = handle;
+    }
+
+    liveVertexCount += vertexCount;
+    liveIndexSlotCount += indexSlotCount;
+
+    return handle;
+}
+
+void GeometryPool::Free(int handle) {
+    if(handle < 0 || handle >= static_cast<int>(allocations.size()) || !allocations[handle].isLive) {
+        LOGW("Invalid geometry pool handle %d", handle);
+        return;
+    }
+
+    GeometryAllocation& allocation = allocations[handle];
+    if(--allocation.refCount > 0) {
+        return;
+    }
+
+    if(allocation.key != 0) {
+        sharedHandles.erase(allocation.key);
+    }
+
+    vertexRanges.Free(allocation.firstVertex, allocation.vertexCount);
+    indexRanges.Free(allocation.firstIndexSlot, allocation.indexSlotCount);
+
+    liveVertexCount -= allocation.vertexCount;
+    liveIndexSlotCount -= allocation.indexSlotCount;
+
+    allocation.isLive = false;
+    freeHandles.push_back(handle);
+}
+
+void GeometryPool::Compact() {
+    Repack(vertexRanges.GetCapacity(), indexRanges.GetCapacity());
+}
+
+void GeometryPool::Repack(unsigned int vertexCapacity, unsigned int indexCapacity) {
+    CLOCK(repack_geometry_pool);
+
+    unsigned int newStreamBuffers[STREAM_COUNT];
+    unsigned int newEBO;
+
+    for(int s = 0; s < STREAM_COUNT; s++) {
+        glGenBuffers(1, &newStreamBuffers[s]);
+        glCheckError();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newStreamBuffers[s]);
+        glCheckError();
+        glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * STREAMS[s].stride, NULL, GL_STATIC_DRAW);
+        glCheckError();
+    }
+
+    glGenBuffers(1, &newEBO);
+    glCheckError();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+    glCheckError();
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(uint16_t), NULL, GL_STATIC_DRAW);
+    glCheckError();
+
+    // copy each live allocation to the end of the last one. Indices are
+    // relative to their mesh, so only the offsets change.
+
+    unsigned int vertexCursor = 0U;
+    unsigned int indexCursor = 0U;
+
+    for(GeometryAllocation& allocation : allocations) {
+        if(!allocation.isLive) {
+            continue;
+        }
+
+        for(int s = 0; s < STREAM_COUNT; s++) {
+            const unsigned int stride = STREAMS[s].stride;
+
+            glBindBuffer(GL_COPY_READ_BUFFER, streamBuffers[s]);
+            glCheckError();
+            glBindBuffer(GL_COPY_WRITE_BUFFER, newStreamBuffers[s]);
+            glCheckError();
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                allocation.firstVertex * stride,
+                vertexCursor * stride,
+                allocation.vertexCount * stride);
+            glCheckError();
+        }
+
+        glBindBuffer(GL_COPY_READ_BUFFER, EBO);
+        glCheckError();
+        glBindBuffer(GL_COPY_WRITE_BUFFER, newEBO);
+        glCheckError();
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+            allocation.firstIndexSlot * sizeof(uint16_t),
+            indexCursor * sizeof(uint16_t),
+            allocation.indexSlotCount * sizeof(uint16_t));
+        glCheckError();
+
+        allocation.firstVertex = vertexCursor;
+        allocation.firstIndexSlot = indexCursor;
+        vertexCursor += allocation.vertexCount;
+        indexCursor += allocation.indexSlotCount;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glCheckError();
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    glCheckError();
+
+    for(int s = 0; s < STREAM_COUNT; s++) {
+        RenderState::DeleteBuffer(streamBuffers[s]);
+        streamBuffers[s] = newStreamBuffers[s];
+    }
+    RenderState::DeleteBuffer(EBO);
+    EBO = newEBO;
+
+    // everything live is now packed at the front
+    vertexRanges.Reset(vertexCapacity);
+    vertexRanges.Allocate(vertexCursor);
+    indexRanges.Reset(indexCapacity);
+    indexRanges.Allocate(indexCursor);
+
+    // point every cached vertex array at the new buffers
+    for(auto& pair : vertexArrays) {
+        LinkVertexArray(*pair.second);
+    }
+
+    LOGD("Repacked geometry pool: %u/%u vertices, %u/%u index slots",
+        vertexCursor, vertexCapacity, indexCursor, indexCapacity);
+}
+
+void GeometryPool::Bind(const VertexArray& vertexArray) {
+    RenderState::BindVertexArray(vertexArray.VAO);
+}
+
+void GeometryPool::Unbind() {
+    RenderState::BindVertexArray(0);
+}
+
+void GeometryPool::SetPositionBounds(const VertexArray& vertexArray, const GeometryAllocation& allocation) {
+    // a constant attribute rather than a uniform, so it reaches whichever
+    // shader is bound without looking anything up
+    if(vertexArray.layout.positionBoundsLocation != -1) {
+        glVertexAttrib4fv(vertexArray.layout.positionBoundsLocation, allocation.positionBounds);
+        glCheckError();
+    }
+}
+
+void GeometryPool::SetInstanceAttributes(const VertexArray& vertexArray, unsigned int instanceBuffer, size_t instanceOffset) {
+    // point the object indices at this batch's slice of the instance buffer.
+    // GL 3.3 has no base instance, so we move the pointer.
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glCheckError();
+    glVertexAttribIPointer(vertexArray.layout.instanceObjectIndexLocation, 1, GL_UNSIGNED_INT, sizeof(uint32_t), (void*)instanceOffset);
+    glCheckError();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glCheckError();
+}
+
+} // namespace gyo
@@ -0,0 +1,262 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace gyo {
+
+struct Geometry;
+
+/**
+ * How one semantic is stored in the pool. Each has its own tightly packed
+ * buffer, so every mesh uploads all of them once, whatever its material.
+ *
+ * When built with GYO_QUANTIZE_VERTICES, the default, each vertex takes 20
+ * bytes rather than 44. Positions are stored as 16-bit signed normalized
+ * integers relative to their mesh's bounds, normals and tangents as 10-bit
+ * ones in GL_INT_2_10_10_10_REV, and texture coordinates as half floats. The
+ * attribute fetch expands each back to floats, but shaders reading positions
+ * must still scale them by aPositionBounds, see GeometryAllocation.
+ */
+struct VertexStream {
+    unsigned int semantic;
+    GLint size;             // components
+    GLenum type;
+    GLboolean normalized;
+    unsigned int stride;    // in bytes
+};
+
+struct VertexAttributeEntry {
+    unsigned int semantic;
+    GLint index;            // i.e. location
+};
+
+/**
+ * The attributes a material's shader reads, and where. Meshes with the same
+ * layout share a vertex array.
+ */
+struct VertexLayout {
+    std::vector<VertexAttributeEntry> attributes;
+
+    // -1 if the shader doesn't read per-instance object indices
+    GLint instanceObjectIndexLocation = -1;
+
+    // -1 if the shader doesn't expand quantized positions
+    GLint positionBoundsLocation = -1;
+
+    uint64_t GetKey() const;
+};
+
+/**
+ * A vertex array binding the pool's streams to a layout
+ */
+struct VertexArray {
+    VertexLayout layout;
+    unsigned int VAO = 0;
+
+    // whether the layout reads per-instance object indices
+    bool IsInstanceable() const { return layout.instanceObjectIndexLocation != -1; }
+};
+
+/**
+ * Where to read one stream's elements from, as floats. Elements may be
+ * interleaved with other data, stride bytes apart.
+ */
+struct VertexStreamSource {
+    const void* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;      // in bytes
+};
+
+/**
+ * Geometry to copy into the pool, read in place. Streams are in the order of
+ * GeometryPool::STREAMS, i.e. positions, normals, texture coordinates and then
+ * tangents. Indices may be GL_UNSIGNED_BYTE, SHORT or INT.
+ */
+struct GeometrySource {
+    VertexStreamSource streams[4];
+    size_t vertexCount = 0;
+    const void* indices = nullptr;
+    size_t indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+};
+
+/**
+ * Where a mesh's vertices and indices live inside its pool. Indices are
+ * stored relative to the mesh, and offset by firstVertex when drawn.
+ *
+ * The index buffer is allocated in 16-bit slots. Meshes with at most 65536
+ * vertices store 16-bit indices, and everything else 32-bit ones in two slots
+ * each. Allocations are always an even number of slots, so 32-bit indices
+ * stay aligned.
+ *
+ * Quantized positions are relative to the mesh's bounds, which shaders read
+ * from the aPositionBounds attribute to expand them with
+ * center + position * halfExtent. Unquantized ones use an identity bounds.
+ */
+struct GeometryAllocation {
+    unsigned int firstVertex = 0U;
+    unsigned int vertexCount = 0U;
+    unsigned int firstIndexSlot = 0U;
+    unsigned int indexSlotCount = 0U;
+    unsigned int indexCount = 0U;
+    GLenum indexType = GL_UNSIGNED_INT;
+    bool isLive = false;
+
+    uint64_t key = 0;           // shared by this key, if not 0
+    int refCount = 0;
+
+    float positionBounds[4] = { 0.0f, 0.0f, 0.0f, 1.0f };    // center, then half extent
+
+    // in bytes from the start of the index buffer
+    size_t GetIndexOffset() const { return firstIndexSlot * sizeof(uint16_t); }
+};
+
+/**
+ * A first-fit free-list over a range of elements, with neighbouring free
+ * ranges merged as they're released.
+ */
+class RangeAllocator {
+public:
+    static const unsigned int INVALID_OFFSET = 0xFFFFFFFF;
+
+    void Reset(unsigned int capacity);
+
+    // returns INVALID_OFFSET if no free range is big enough
+    unsigned int Allocate(unsigned int count);
+    void Free(unsigned int offset, unsigned int count);
+
+    const unsigned int& GetCapacity() const { return capacity; }
+
+private:
+    struct Range {
+        unsigned int offset;
+        unsigned int count;
+    };
+
+    unsigned int capacity = 0U;
+    std::vector<Range> freeRanges = {}; // sorted by offset
+};
+
+/**
+ * Sub-allocates the vertices and indices of every mesh from one set of vertex
+ * streams and one large index buffer. Meshes keep a handle to their
+ * allocation, and are drawn with glDrawElementsBaseVertex.
+ *
+ * The streams don't depend on any shader, so changing a mesh's material only
+ * looks up the vertex array for its new layout, which is created once and
+ * cached.
+ *
+ * Allocations made with a key, e.g. a hash of their content, are shared:
+ * allocating the same key again only adds a reference, and the allocation
+ * is released once every reference has been freed.
+ *
+ * Freeing leaves holes behind. When an allocation doesn't fit, every live
+ * allocation is repacked in order into new buffers, which are doubled in
+ * size only if compacting alone won't make room. Handles stay valid, but
+ * their offsets move.
+ */
+class GeometryPool {
+public:
+    static const unsigned int INITIAL_VERTEX_CAPACITY = 1U << 16;
+    static const unsigned int INITIAL_INDEX_CAPACITY = 1U << 19;   // in 16-bit slots
+
+    static const int STREAM_COUNT = 4;
+    static const VertexStream STREAMS[STREAM_COUNT];
+
+    /**
+     * Returns the shared pool, creating it if needed
+     */
+    static GeometryPool* Get();
+
+    /**
+     * Deletes the pool. Call after all meshes have been deleted.
+     */
+    static void Dispose();
+
+    /**
+     * Copies every stream of the geometry, and its indices, into the pool,
+     * returning a handle to their allocation. Missing streams are zeroed.
+     * Given a key that's already allocated, nothing is copied and that
+     * allocation's handle is returned instead.
+     */
+    int Allocate(const Geometry& geometry, uint64_t key = 0);
+
+    /**
+     * Same as above, but reading from wherever the source points. Streams
+     * already tightly packed in our format are uploaded without a copy.
+     */
+    int Allocate(const GeometrySource& source, uint64_t key = 0);
+
+    // adds a reference to the allocation with key, or returns -1 if there's none
+    int Acquire(uint64_t key);
+
+    // releases a reference, freeing the allocation with the last one
+    void Free(int handle);
+
+    const GeometryAllocation& GetAllocation(int handle) const { return allocations[handle]; }
+
+    /**
+     * Returns the vertex array for the layout, creating it on first use
+     */
+    const VertexArray* GetVertexArray(const VertexLayout& layout);
+
+    /**
+     * Repacks every live allocation to the front of the buffers
+     */
+    void Compact();
+
+    static void Bind(const VertexArray& vertexArray);
+    static void Unbind();
+
+    /**
+     * Sets the allocation's position bounds on the layout's aPositionBounds
+     * attribute, if it reads one
+     */
+    static void SetPositionBounds(const VertexArray& vertexArray, const GeometryAllocation& allocation);
+
+    /**
+     * Points the per-instance object index attribute at instanceOffset bytes
+     * into instanceBuffer. Expects the vertex array to be bound.
+     */
+    static void SetInstanceAttributes(const VertexArray& vertexArray, unsigned int instanceBuffer, size_t instanceOffset);
+
+private:
+    static GeometryPool* pool;
+
+    unsigned int streamBuffers[STREAM_COUNT] = {};
+    unsigned int EBO = 0;
+
+    std::map<uint64_t, VertexArray*> vertexArrays = {};
+
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+
+    std::vector<GeometryAllocation> allocations = {};
+    std::vector<int> freeHandles = {};
+    std::unordered_map<uint64_t, int> sharedHandles = {};   // by key
+    unsigned int liveVertexCount = 0U;
+    unsigned int liveIndexSlotCount = 0U;
+
+    GeometryPool();
+    ~GeometryPool();
+
+    /**
+     * Moves every live allocation, in handle order, into new buffers of the
+     * given capacities
+     */
+    void Repack(unsigned int vertexCapacity, unsigned int indexCapacity);
+
+    // points a vertex array's attributes at our current buffers
+    void LinkVertexArray(const VertexArray& vertexArray) const;
+};
+
+} // namespace gyo
+
+#endif // GEOMETRY_POOL_H
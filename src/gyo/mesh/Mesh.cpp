@@ -2,10 +2,11 @@
 #include <map>
 
 #include <gyo/mesh/Mesh.h>
-#include <gyo/mesh/Vertex.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/geometry/Geometry.h>
 #include <gyo/shading/Material.h>
 #include <gyo/shading/ShaderSemantics.h>
+#include <gyo/utilities/Hash.h>
 #include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
 
@@ -13,203 +14,139 @@
 
 namespace gyo {
 
-struct VertexAttributeEntry {
-    unsigned int semantic;
-    GLint index;            // i.e. location
-    GLint size;             // in float values, not bytes
-    unsigned long offset;   // in float values, not bytes
-};
-
+uint32_t Mesh::bindingVersion = 0;
 
 Mesh::Mesh(Geometry* geometry, Material* material) {
     this->geometry = geometry;
     this->material = material;
+    if(material != nullptr) {
+        material->AddRef();
+    }
 
     // only compute the tangents if they haven't already been
     if(geometry->tangents.empty()) {
         this->geometry->ComputeTangents();
     }
 
-    Initialize();
+    // the key first, since the pool shares by it
+    ComputeGeometryKey();
+    UploadGeometry();
+    UpdateVertexArray();
     ComputeBounds();
 
     indexCount = this->geometry->indices.size();
     numTris = indexCount / 3;
 }
 
-void Mesh::Initialize() {
-    if(VAO != 0) {
-        return;
+Mesh::Mesh(const GeometrySource& source, const AABB& bounds, uint64_t geometryKey, Material* material) {
+    this->material = material;
+    if(material != nullptr) {
+        material->AddRef();
     }
+    this->bounds = bounds;
+    this->geometryKey = geometryKey;
 
-    // create the vertex/index buffers and vertex array object
-    glGenVertexArrays(1, &VAO);
-    glCheckError();
-    glGenBuffers(1, &VBO);
-    glCheckError();
-    glGenBuffers(1, &EBO);
-    glCheckError();
-    
-    // bind Vertex Array Object first
-    glBindVertexArray(VAO);
-    glCheckError();
-    
-    // copy our vertices array in a buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glCheckError();
-    glBufferData(GL_ARRAY_BUFFER, 0, NULL, GL_STATIC_DRAW); // set to 0 initially; computed in ComputeVertexArrayBuffer
-    glCheckError();
+    pool = GeometryPool::Get();
+    poolHandle = pool->Allocate(source, geometryKey);
+    UpdateVertexArray();
 
-    // copy our indices
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glCheckError();
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, geometry->indices.size() * sizeof(unsigned int), &geometry->indices[0], GL_STATIC_DRAW);
-    glCheckError();
+    indexCount = source.indexCount;
+    numTris = indexCount / 3;
+}
 
-    // clean up and unbind
-    glBindVertexArray(0);
-    glCheckError();
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glCheckError();
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glCheckError();
+Mesh::Mesh(const SharedGeometry& geometry, Material* material) {
+    this->material = material;
+    if(material != nullptr) {
+        material->AddRef();
+    }
+    this->bounds = geometry.bounds;
+    this->geometryKey = geometry.key;
 
-    // compute and set our vertex array buffer
-    ComputeVertexArrayBuffer();
-}
+    indexCount = geometry.indexCount;
+    numTris = indexCount / 3;
 
-void Mesh::ComputeVertexArrayBuffer() {
-    if(VAO == 0) {
-        LOGW("Cannot set vertex array buffer without vertex array object");
+    pool = GeometryPool::Get();
+    poolHandle = pool->Acquire(geometry.key);
+    if(poolHandle == -1) {
+        LOGE("Shared geometry has already been released");
+        pool = nullptr;
         return;
     }
 
+    UpdateVertexArray();
+}
+
+void Mesh::UploadGeometry() {
+    // every stream goes into the pool once, whatever our material reads, and
+    // only once for every mesh with the same content
+    pool = GeometryPool::Get();
+    poolHandle = pool->Allocate(*geometry, geometryKey);
+}
+
+void Mesh::UpdateVertexArray() {
+    vertexArray = nullptr;
+
     if(material == nullptr) {
         LOGW("Cannot initialize mesh; missing material");
         return;
     }
 
+    // nothing to draw without our geometry
+    if(pool == nullptr) {
+        return;
+    }
+
+    vertexArray = FindVertexArray(material);
+}
+
+const VertexArray* Mesh::FindVertexArray(Material* material) {
     if(!material->ValidateShaderAttributes()) {
         LOGE("Invalid shader attributes and declared semantics");
-        return;
+        return nullptr;
     }
 
     const Shader& shader = material->GetShader();
     const std::map<std::string, AttributeInfo>& shaderAttributes = shader.GetAttributes();
 
-    // gather our vertex array entries
+    // gather where the shader reads each semantic
 
-    unsigned int vertexCount = geometry->positions.size();
-    unsigned int floatsPerVertex = 0U;
-    unsigned long bytesPerVertex = 0UL;
+    VertexLayout layout;
 
     auto declaredAttributes = material->GetShaderSemantics();
-    std::vector<VertexAttributeEntry> attributes;
-    attributes.reserve(declaredAttributes.size());
+    layout.attributes.reserve(declaredAttributes.size());
 
     for(auto& pair : declaredAttributes) {
-        std::string name = pair.first;
-        unsigned int semantic = pair.second;
-
-        auto shaderAttribute = shaderAttributes.at(name);
-        auto attributeSizeDesc = SEMANTIC_TO_GLSIZE.at(semantic);
-
-        attributes.push_back({
-            semantic,
-            shaderAttribute.location,
-            attributeSizeDesc.first,
-            floatsPerVertex
-        });
-        
-        floatsPerVertex += attributeSizeDesc.first;
-        bytesPerVertex += attributeSizeDesc.first * attributeSizeDesc.second;
+        layout.attributes.push_back({ pair.second, shaderAttributes.at(pair.first).location });
     }
 
-    // generate our vertex array
-
-    unsigned int vertexArrayLength = vertexCount * floatsPerVertex;
-    float vertexArray[vertexArrayLength];
-    for(const VertexAttributeEntry& attribute : attributes) {
-        for(int v = 0; v < vertexCount; v++) {
-            int i0 = v * floatsPerVertex + attribute.offset;
-            int i1 = i0 + 1;
-            int i2 = i0 + 2;
-            int i3 = i0 + 3;
-            
-            switch(attribute.semantic) {
-                case SEMANTIC_POSITION:
-                    vertexArray[i0] = geometry->positions[v].x;
-                    vertexArray[i1] = geometry->positions[v].y;
-                    vertexArray[i2] = geometry->positions[v].z;
-                    break;
-
-                case SEMANTIC_NORMAL:
-                    vertexArray[i0] = geometry->normals[v].x;
-                    vertexArray[i1] = geometry->normals[v].y;
-                    vertexArray[i2] = geometry->normals[v].z;
-                    break;
-
-                case SEMANTIC_TEXCOORD0:
-                    vertexArray[i0] = geometry->texCoords[v].x;
-                    vertexArray[i1] = geometry->texCoords[v].y;
-                    break;
-
-                case SEMANTIC_TANGENT:
-                    vertexArray[i0] = geometry->tangents[v].x;
-                    vertexArray[i1] = geometry->tangents[v].y;
-                    vertexArray[i2] = geometry->tangents[v].z;
-                    break;
-
-                // Currently unsupported; get this from the shader?
-                // case SEMANTIC_COLOR:
-                //     vertexArray[i0] = geometry->colors[v].r;
-                //     vertexArray[i1] = geometry->colors[v].g;
-                //     vertexArray[i2] = geometry->colors[v].b;
-                //     vertexArray[i3] = geometry->colors[v].a;
-                //     break;
-
-                default:
-                    LOGE("Unsupported semantic type %u", attribute.semantic);
-                    break;
-            }
-        }
+    auto objectIndexIt = shaderAttributes.find(INSTANCE_ATTRIBUTE_OBJECT_INDEX);
+    if(objectIndexIt != shaderAttributes.end()) {
+        layout.instanceObjectIndexLocation = objectIndexIt->second.location;
     }
 
-    // bind Vertex Array Object first
-    glBindVertexArray(VAO);
-    glCheckError();
-
-    // disable all attributes in case we're rebuilding
-    for (GLuint i = 0; i < SEMANTIC_COLOR; ++i) {
-        glDisableVertexAttribArray(i);
+    auto positionBoundsIt = shaderAttributes.find(ATTRIBUTE_POSITION_BOUNDS);
+    if(positionBoundsIt != shaderAttributes.end()) {
+        layout.positionBoundsLocation = positionBoundsIt->second.location;
     }
-
-    // generate the vertex buffer object in case we're not rebuilding
-    if(VBO == 0) {
-        glGenBuffers(1, &VBO);
-        glCheckError();
+    else if(GeometryPool::STREAMS[0].type != GL_FLOAT) {
+        for(const VertexAttributeEntry& attribute : layout.attributes) {
+            if(attribute.semantic == SEMANTIC_POSITION) {
+                LOGW("Shader doesn't read %s, so its quantized positions won't be expanded", ATTRIBUTE_POSITION_BOUNDS);
+            }
+        }
     }
 
-    // copy our vertices array in a buffer
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glCheckError();
-    
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertexArray), &vertexArray, GL_STATIC_DRAW);
-    glCheckError();
+    return GeometryPool::Get()->GetVertexArray(layout);
+}
 
-    // link the vertex attribute pointers
-    for(const VertexAttributeEntry& attribute : attributes) {
-        glEnableVertexAttribArray(attribute.index);
-        glCheckError();
-        glVertexAttribPointer(attribute.index, attribute.size, GL_FLOAT, GL_FALSE, bytesPerVertex, (void*)(attribute.offset * sizeof(float)));
-        glCheckError();
+void Mesh::ReleaseGeometry() {
+    if(pool != nullptr) {
+        pool->Free(poolHandle);
     }
 
-    // clean up and unbind
-    glBindVertexArray(0);
-    glCheckError();
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glCheckError();
+    pool = nullptr;
+    poolHandle = -1;
+    vertexArray = nullptr;
 }
 
 void Mesh::ComputeBounds() {
@@ -226,43 +163,105 @@ void Mesh::ComputeBounds() {
     bounds = { minPoint, maxPoint };
 }
 
+void Mesh::ComputeGeometryKey() {
+    // hash everything that can end up in our vertex and index buffers,
+    // prefixed by each stream's length so differently split data can't match
+    auto hashStream = [this](const auto& stream) {
+        const size_t count = stream.size();
+        geometryKey = hash_bytes(&count, sizeof(count), geometryKey);
+        if(count > 0) {
+            geometryKey = hash_bytes(stream.data(), count * sizeof(stream[0]), geometryKey);
+        }
+    };
+
+    geometryKey = FNV1A_64_OFFSET;
+    hashStream(geometry->positions);
+    hashStream(geometry->normals);
+    hashStream(geometry->texCoords);
+    hashStream(geometry->tangents);
+    hashStream(geometry->indices);
+}
+
 Mesh::~Mesh() {
     delete geometry;
     geometry = nullptr;
 
-    delete material;
-    material = nullptr;
+    if(material != nullptr) {
+        material->Release();
+        material = nullptr;
+    }
 
-    glDeleteVertexArrays(1, &VAO);
-    glCheckError();
-    glDeleteBuffers(1, &VBO);
-    glCheckError();
-    glDeleteBuffers(1, &EBO);
-    glCheckError();
+    ReleaseGeometry();
 }
 
 void Mesh::SetMaterial(Material* newMaterial) {
+    // take our reference first, in case it's the material we already have
+    if(newMaterial) {
+        newMaterial->AddRef();
+    }
+
     if(this->material) {
-        delete this->material;
+        this->material->Release();
         this->material = nullptr;
     }
 
     if(newMaterial) {
         this->material = newMaterial;
-        this->ComputeVertexArrayBuffer();
+        this->UpdateVertexArray();
     }
+
+    bindingVersion++;
+}
+
+bool Mesh::IsInstanceable() const {
+    return vertexArray != nullptr && vertexArray->IsInstanceable();
 }
 
 void Mesh::Draw() {
-    if(VAO == 0) {
-        return;
+    if(vertexArray != nullptr) {
+        Draw(*vertexArray);
     }
+}
 
-    glBindVertexArray(VAO);
-    glCheckError();
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+void Mesh::Draw(const VertexArray& vertexArray) {
+    const GeometryAllocation& allocation = pool->GetAllocation(poolHandle);
+
+    GeometryPool::Bind(vertexArray);
+    GeometryPool::SetPositionBounds(vertexArray, allocation);
+    glDrawElementsBaseVertex(GL_TRIANGLES, allocation.indexCount, allocation.indexType,
+        (void*)allocation.GetIndexOffset(), allocation.firstVertex);
     glCheckError();
-    glBindVertexArray(0);
+    GeometryPool::Unbind();
+}
+
+void Mesh::Bind() {
+    if(vertexArray != nullptr) {
+        GeometryPool::Bind(*vertexArray);
+    }
+}
+
+void Mesh::Unbind() {
+    GeometryPool::Unbind();
+}
+
+void Mesh::DrawInstanced(unsigned int instanceBuffer, size_t instanceOffset, int instanceCount) {
+    if(vertexArray != nullptr) {
+        DrawInstanced(*vertexArray, instanceBuffer, instanceOffset, instanceCount);
+    }
+}
+
+void Mesh::DrawInstanced(const VertexArray& vertexArray, unsigned int instanceBuffer, size_t instanceOffset, int instanceCount) {
+    if(!vertexArray.IsInstanceable()) {
+        return;
+    }
+
+    const GeometryAllocation& allocation = pool->GetAllocation(poolHandle);
+
+    GeometryPool::SetInstanceAttributes(vertexArray, instanceBuffer, instanceOffset);
+    GeometryPool::SetPositionBounds(vertexArray, allocation);
+
+    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, allocation.indexCount, allocation.indexType,
+        (void*)allocation.GetIndexOffset(), instanceCount, allocation.firstVertex);
     glCheckError();
 }
 
@@ -1,6 +1,8 @@
 #ifndef MESH_H
 #define MESH_H
 
+#include <cstdint>
+
 #include <glm/glm.hpp>
 
 #include <gyo/math/AABB.h>
@@ -9,18 +11,82 @@
 namespace gyo {
 
 class Shader;
+class GeometryPool;
+struct VertexArray;
 struct Geometry;
+struct GeometrySource;
 
+/**
+ * Geometry that's already in the pool under a shared key, e.g. from
+ * Resources::GetGeometry, which meshes can be built from without any copy
+ */
+struct SharedGeometry {
+    uint64_t key = 0;
+    AABB bounds;
+    unsigned int indexCount = 0U;
+};
+
+/**
+ * A material and the geometry it's drawn with. Meshes with the same vertex
+ * and index data share one allocation in the geometry pool, and hold a
+ * reference to their material, which may be shared too.
+ */
 class Mesh {
 public:
     // constructor
     Mesh(Geometry* geometry, Material* material);
+
+    /**
+     * Uploads the geometry straight from the source, without keeping a copy.
+     * The source must already have tangents, and can be released once we're
+     * constructed.
+     */
+    Mesh(const GeometrySource& source, const AABB& bounds, uint64_t geometryKey, Material* material);
+
+    // adds a reference to geometry already in the pool
+    Mesh(const SharedGeometry& geometry, Material* material);
     ~Mesh();
 
     void Draw();
 
+    // draws through vertexArray rather than our own, e.g. for another material's layout
+    void Draw(const VertexArray& vertexArray);
+
+    // binds the vertex array for our material's layout, which every mesh
+    // with the same layout shares
+    void Bind();
+    static void Unbind();
+
+    // meshes with the same vertex array can be drawn without rebinding
+    const VertexArray* GetVertexArray() const { return vertexArray; }
+
+    /**
+     * Draws instanceCount instances, reading each one's object index from
+     * instanceBuffer starting at instanceOffset bytes. Expects Bind to have
+     * been called first.
+     */
+    void DrawInstanced(unsigned int instanceBuffer, size_t instanceOffset, int instanceCount);
+    void DrawInstanced(const VertexArray& vertexArray, unsigned int instanceBuffer, size_t instanceOffset, int instanceCount);
+
+    /**
+     * The shared vertex array for the layout material's shader reads, which
+     * any mesh can be drawn through. Null if the shader and the semantics
+     * the material declares don't match.
+     */
+    static const VertexArray* FindVertexArray(Material* material);
+
+    // whether our material's shader reads its transforms from the object data buffer
+    bool IsInstanceable() const;
+
+    // meshes with equal geometry keys have identical vertex and index data
+    const uint64_t& GetGeometryKey() const { return geometryKey; }
+
     Material* GetMaterial() { return material; }
     void SetMaterial(Material* newMaterial);
+
+    // bumped whenever a mesh, or a model node's override, changes material,
+    // so retained draw lists know to rebuild
+    static const uint32_t& GetBindingVersion() { return bindingVersion; }
     const RenderType& GetRenderType() { return material->renderType; }
 
     const AABB& GetBounds() { return bounds; }
@@ -32,18 +98,27 @@ protected:
 
     AABB bounds;
 
-    void Initialize();
-    void ComputeVertexArrayBuffer();
+    void UploadGeometry();
+    void UpdateVertexArray();
     void ComputeBounds();
+    void ComputeGeometryKey();
 
 private:
-    // render data
-    unsigned int VAO;
-    unsigned int VBO;
-    unsigned int EBO;
+    friend class ModelNode;
+
+    static uint32_t bindingVersion;
+
+    // render data, sub-allocated from the shared pool
+    GeometryPool* pool = nullptr;
+    int poolHandle = -1;
+    const VertexArray* vertexArray = nullptr;   // for our material's layout
 
     unsigned int indexCount;
     unsigned int numTris;
+
+    uint64_t geometryKey = 0;
+
+    void ReleaseGeometry();
 };
 
 } // namespace gyo
@@ -16,6 +16,12 @@ Model::Model(std::vector<Mesh*> meshes) {
     ComputeBounds();
 };
 
+void Model::Release() {
+    if(--refCount <= 0) {
+        delete this;
+    }
+}
+
 Model::~Model() {
     for(const auto& mesh : meshes) {
         delete mesh;
@@ -10,6 +10,11 @@ namespace gyo {
 class Material;
 struct AABB;
 
+/**
+ * Meshes that are drawn together. Models are shared, e.g. by every ModelNode
+ * showing the same file, and counted: each holder adds a reference, and the
+ * model deletes itself, with its meshes, when the last one is released.
+ */
 class Model {
 private:
     static unsigned int ModelCounter;
@@ -19,7 +24,10 @@ public:
 
     Model(Mesh* mesh);
     Model(std::vector<Mesh*> meshes);
-    ~Model();
+
+    void AddRef() { refCount++; }
+    void Release();
+    const int& GetRefCount() const { return refCount; }
 
     const std::vector<Mesh*>& GetMeshes() const { return meshes; }
     const AABB& GetBounds() const { return bounds; }
@@ -28,6 +36,11 @@ private:
     std::vector<Mesh*> meshes = {};
     AABB bounds;
 
+    int refCount = 0;
+
+    // only Release deletes us
+    ~Model();
+
     void ComputeBounds();
 };
 
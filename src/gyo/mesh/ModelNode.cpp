@@ -1,20 +1,79 @@
 
 #include <gyo/mesh/ModelNode.h>
+#include <gyo/mesh/Mesh.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/math/AABB.h>
+#include <gyo/scene/BVH.h>
+#include <gyo/math/TransformKernel.h>
+#include <gyo/utilities/Log.h>
 
 namespace gyo {
 
 ModelNode::ModelNode(Model* model) : SceneNode() {
     this->model = model;
+    model->AddRef();
 
     UpdateBounds();
 };
 
 ModelNode::~ModelNode() {
-    delete model;
+    for(MaterialOverride& materialOverride : materialOverrides) {
+        if(materialOverride.material != nullptr) {
+            materialOverride.material->Release();
+        }
+    }
+    materialOverrides.clear();
+
+    model->Release();
     model = nullptr;
 }
 
+void ModelNode::SetMaterialOverride(size_t meshIndex, Material* material) {
+    if(meshIndex >= model->GetMeshes().size()) {
+        LOGE("Cannot override material of mesh %zu; the model has %zu", meshIndex, model->GetMeshes().size());
+        return;
+    }
+
+    if(materialOverrides.size() <= meshIndex) {
+        materialOverrides.resize(model->GetMeshes().size());
+    }
+
+    if(material != nullptr) {
+        material->AddRef();
+    }
+
+    MaterialOverride& materialOverride = materialOverrides[meshIndex];
+    if(materialOverride.material != nullptr) {
+        materialOverride.material->Release();
+    }
+
+    materialOverride.material = material;
+    materialOverride.vertexArray = material != nullptr ? Mesh::FindVertexArray(material) : nullptr;
+
+    if(material != nullptr) {
+        const VertexArray* vertexArray = materialOverride.vertexArray;
+        material->BindSceneBlocks(vertexArray != nullptr && vertexArray->IsInstanceable());
+    }
+
+    Mesh::bindingVersion++;
+}
+
+Material* ModelNode::GetMaterial(size_t meshIndex) const {
+    if(meshIndex < materialOverrides.size() && materialOverrides[meshIndex].material != nullptr) {
+        return materialOverrides[meshIndex].material;
+    }
+
+    return model->GetMeshes()[meshIndex]->GetMaterial();
+}
+
+const VertexArray* ModelNode::GetVertexArray(size_t meshIndex) const {
+    if(meshIndex < materialOverrides.size() && materialOverrides[meshIndex].material != nullptr) {
+        return materialOverrides[meshIndex].vertexArray;
+    }
+
+    return model->GetMeshes()[meshIndex]->GetVertexArray();
+}
+
 const AABB& ModelNode::GetBounds() {
     if(isBoundsDirty) {
         UpdateBounds();
@@ -27,36 +86,19 @@ void ModelNode::SetDirty() {
     SceneNode::SetDirty(); // sets the transform isDirty
 
     isBoundsDirty = true;
+
+    // flag our leaf so the scene BVH refits it before the next cull
+    if(bvh != nullptr) {
+        bvh->MarkDirty(this);
+    }
 }
 
 void ModelNode::UpdateBounds() {
     const AABB& meshBounds = model->GetBounds();
     const glm::mat4& transform = GetTransform(); // updates the transform, if necessary
 
-    // extract the 8 corners of the original AABB, ordered like the LUT
-    std::array<glm::vec3, 8> corners = {
-        glm::vec3(meshBounds.min.x, meshBounds.min.y, meshBounds.min.z),
-        glm::vec3(meshBounds.max.x, meshBounds.min.y, meshBounds.min.z),
-        glm::vec3(meshBounds.min.x, meshBounds.max.y, meshBounds.min.z),
-        glm::vec3(meshBounds.max.x, meshBounds.max.y, meshBounds.min.z),
-        glm::vec3(meshBounds.min.x, meshBounds.min.y, meshBounds.max.z),
-        glm::vec3(meshBounds.max.x, meshBounds.min.y, meshBounds.max.z),
-        glm::vec3(meshBounds.min.x, meshBounds.max.y, meshBounds.max.z),
-        glm::vec3(meshBounds.max.x, meshBounds.max.y, meshBounds.max.z),
-    };
-
-    // transform each corner and find new min and max
-    glm::vec3 newMin(std::numeric_limits<float>::max());
-    glm::vec3 newMax(std::numeric_limits<float>::lowest());
-
-    for(int i = 0; i < 8; i++) {
-        glm::vec3 transformedCorner = glm::vec3(transform * glm::vec4(corners[i], 1.0f));
-
-        newMin = glm::min(newMin, transformedCorner);
-        newMax = glm::max(newMax, transformedCorner);
-    }
-
-    bounds = { newMin, newMax };
+    // transform the bounds straight from their center and extents
+    TransformKernel::TransformAABB(meshBounds, transform, bounds);
 
     UpdateBoundsLUT();
 
@@ -6,20 +6,36 @@
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 namespace gyo {
 
 class Mesh;
 class Material;
+class BVH;
 struct AABB;
+struct VertexArray;
 
 class ModelNode : public SceneNode {
 public:
     int boundsLastFailedFrustumPlane = 0; // plane-coherency
 
+    // adds a reference to model, which may be shared with other nodes
     ModelNode(Model* model);
     ~ModelNode();
 
     const Model& GetModel() const { return *model; }
+
+    /**
+     * Draws the model's mesh at meshIndex with material, for this node only,
+     * leaving the shared model untouched. We add a reference to the
+     * material, and null clears the override.
+     */
+    void SetMaterialOverride(size_t meshIndex, Material* material);
+
+    // the material the mesh at meshIndex is drawn with, and the vertex array it's drawn through
+    Material* GetMaterial(size_t meshIndex) const;
+    const VertexArray* GetVertexArray(size_t meshIndex) const;
     
     const AABB& GetBounds();
     const std::array<glm::vec3, 8>& GetLUT() const { return boundsLUT; }
@@ -30,6 +46,19 @@ protected:
     void SetDirty() override;
 
 private:
+    friend class BVH;
+
+    BVH* bvh = nullptr;     // the scene hierarchy we're in, if any
+    int bvhLeaf = -1;       // the BVH leaf that contains us
+
+    struct MaterialOverride {
+        Material* material = nullptr;
+        const VertexArray* vertexArray = nullptr;   // for the material's layout
+    };
+
+    // by mesh index, empty until an override is set
+    std::vector<MaterialOverride> materialOverrides;
+
     AABB bounds;
     std::array<glm::vec3, 8> boundsLUT = {};
     bool isBoundsDirty = true;
@@ -3,17 +3,28 @@
 
 #include <glm/glm.hpp>
 
+#include <cstdint>
+
 namespace gyo {
 
 class Mesh;
 class Material;
+struct VertexArray;
 
 struct DrawCall {
     Mesh* mesh;
     Material* material;
+    const VertexArray* vertexArray; // the mesh's geometry, in the material's layout
+    uint32_t objectIndex; // into this frame's ObjectData
+};
+
+/**
+ * The per-object data shaders read from the object data buffer, written
+ * once per frame for every visible model
+ */
+struct ObjectData {
     glm::mat4 transform;
     glm::mat4 normalMatrix;
-    // unsigned int modelID;
 };
 
 } // namespace gyo
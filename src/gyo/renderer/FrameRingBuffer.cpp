@@ -0,0 +1,151 @@
+
+#include <gyo/renderer/FrameRingBuffer.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/utilities/GetError.h>
+#include <gyo/utilities/Log.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace gyo {
+
+FrameRingBuffer::FrameRingBuffer(GLenum target, size_t regionSize, size_t maxRegionSize) :
+    target(target), regionSize(std::min(regionSize, maxRegionSize)), maxRegionSize(maxRegionSize) {
+    glGenBuffers(1, &buffer);
+    glCheckError();
+
+    glBindBuffer(target, buffer);
+    glCheckError();
+    glBufferData(target, regionSize * FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+    glCheckError();
+    glBindBuffer(target, 0);
+    glCheckError();
+}
+
+FrameRingBuffer::~FrameRingBuffer() {
+    for(GLsync& fence : fences) {
+        if(fence != nullptr) {
+            glDeleteSync(fence);
+            glCheckError();
+            fence = nullptr;
+        }
+    }
+
+    RenderState::DeleteBuffer(buffer);
+}
+
+void FrameRingBuffer::Advance() {
+    frame = (frame + 1) % FRAME_COUNT;
+    cursor = 0;
+    hasAdvanced = true;
+
+    GLsync& fence = fences[frame];
+    if(fence == nullptr) {
+        return;
+    }
+
+    // usually signalled long ago. If not, flush so the fence can ever signal,
+    // and block until it does.
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    glCheckError();
+
+    if(result == GL_TIMEOUT_EXPIRED) {
+        const GLuint64 timeoutNs = 1000000; // 1ms
+        do {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNs);
+            glCheckError();
+        } while(result == GL_TIMEOUT_EXPIRED);
+    }
+
+    if(result == GL_WAIT_FAILED) {
+        LOGE("Failed waiting on frame ring buffer fence");
+    }
+
+    glDeleteSync(fence);
+    glCheckError();
+    fence = nullptr;
+}
+
+void FrameRingBuffer::EndFrame() {
+    GLsync& fence = fences[frame];
+    if(fence != nullptr) {
+        glDeleteSync(fence);
+        glCheckError();
+    }
+
+    fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glCheckError();
+}
+
+size_t FrameRingBuffer::Write(const void* data, size_t size, size_t alignment) {
+    if(!hasAdvanced) {
+        Advance();
+    }
+
+    size_t offset = (cursor + alignment - 1) / alignment * alignment;
+    if(offset + size > regionSize) {
+        Grow(size);
+        offset = 0;
+    }
+
+    const size_t bufferOffset = frame * regionSize + offset;
+    cursor = offset + size;
+
+    if(size == 0) {
+        return bufferOffset;
+    }
+
+    glBindBuffer(target, buffer);
+    glCheckError();
+
+    // the fence in BeginFrame already made sure the GPU is done with this
+    // region, so there's no need for the driver to synchronize too
+    void* mapped = glMapBufferRange(target, bufferOffset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    glCheckError();
+
+    if(mapped != nullptr) {
+        std::memcpy(mapped, data, size);
+        glUnmapBuffer(target);
+        glCheckError();
+    }
+    else {
+        LOGE("Failed to map frame ring buffer");
+    }
+
+    glBindBuffer(target, 0);
+    glCheckError();
+
+    return bufferOffset;
+}
+
+void FrameRingBuffer::Grow(size_t minRegionSize) {
+    // keep doubling, so regions stay aligned to whatever they were before
+    do {
+        regionSize *= 2;
+    } while(regionSize < minRegionSize);
+    regionSize = std::min(regionSize, maxRegionSize);
+
+    LOGD("Growing frame ring buffer to %zu bytes per frame", regionSize);
+
+    // orphaning hands us fresh storage, so no fence covers it yet
+    for(GLsync& fence : fences) {
+        if(fence != nullptr) {
+            glDeleteSync(fence);
+            glCheckError();
+            fence = nullptr;
+        }
+    }
+
+    glBindBuffer(target, buffer);
+    glCheckError();
+    glBufferData(target, regionSize * FRAME_COUNT, nullptr, GL_STREAM_DRAW);
+    glCheckError();
+    glBindBuffer(target, 0);
+    glCheckError();
+
+    cursor = 0;
+    generation++;
+}
+
+} // namespace gyo
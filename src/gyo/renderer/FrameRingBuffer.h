@@ -0,0 +1,80 @@
+#ifndef FRAME_RING_BUFFER_H
+#define FRAME_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace gyo {
+
+/**
+ * A GL buffer split into one region per frame in flight. Each frame writes
+ * into its own region with unsynchronized maps, and fences it when the frame
+ * ends, so the CPU only waits on the GPU if it gets a whole ring ahead.
+ *
+ * A frame that writes nothing keeps reading the region last written, which is
+ * then fenced again, so retained data costs nothing to resubmit. Within one
+ * frame, either every reader rewrites its data or none do, see HasWritten.
+ * Growing throws away everything written before, see GetGeneration.
+ *
+ * GL 3.3 has no persistent mapping, so each write maps and unmaps its range.
+ */
+class FrameRingBuffer {
+public:
+    static const int FRAME_COUNT = 3;
+
+    // regions never grow past maxRegionSize, e.g. to stay within what a
+    // texture buffer can address
+    FrameRingBuffer(GLenum target, size_t regionSize, size_t maxRegionSize = SIZE_MAX);
+    ~FrameRingBuffer();
+
+    /**
+     * Starts a frame. The first write of the frame moves on to the next
+     * region, waiting for the GPU to finish reading it if needed.
+     */
+    void BeginFrame() { hasAdvanced = false; }
+
+    /**
+     * Fences the current region. Call once every command reading it is issued.
+     */
+    void EndFrame();
+
+    /**
+     * Copies the data into the current region, returning its byte offset from
+     * the start of the buffer. If the region is full the buffer is orphaned
+     * and regrown, which is safe for draws already issued. size can't be
+     * more than the max region size.
+     */
+    size_t Write(const void* data, size_t size, size_t alignment);
+
+    const unsigned int& GetBuffer() const { return buffer; }
+    const size_t& GetMaxRegionSize() const { return maxRegionSize; }
+
+    // whether anything has been written this frame, after which every
+    // reader has to write again, or it'd be reading a region we moved off
+    const bool& HasWritten() const { return hasAdvanced; }
+
+    // bumped whenever we grow, orphaning whatever was written before,
+    // including earlier this frame
+    const uint32_t& GetGeneration() const { return generation; }
+
+private:
+    GLenum target;
+    unsigned int buffer = 0;
+
+    size_t regionSize;
+    size_t maxRegionSize;
+    int frame = 0;
+    size_t cursor = 0;                      // within the current region
+    bool hasAdvanced = false;               // written to this frame
+    uint32_t generation = 0;
+    GLsync fences[FRAME_COUNT] = {};
+
+    void Advance();
+    void Grow(size_t minRegionSize);
+};
+
+} // namespace gyo
+
+#endif // FRAME_RING_BUFFER_H
@@ -0,0 +1,116 @@
+
+#include <gyo/renderer/RenderQueue.h>
+#include <gyo/renderer/DrawCall.h>
+#include <gyo/mesh/Mesh.h>
+#include <gyo/shading/Material.h>
+#include <gyo/shading/Shader.h>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/norm.hpp>
+
+#include <bit>
+
+namespace gyo {
+
+// xor-folds a 64-bit hash down to its lowest bits
+static inline uint64_t Fold(uint64_t value, int bits) {
+    uint64_t folded = 0;
+    for(int shift = 0; shift < 64; shift += bits) {
+        folded ^= value >> shift;
+    }
+    return folded & ((1ULL << bits) - 1);
+}
+
+// non-negative floats sort the same as their bit patterns
+static inline uint32_t DepthBits(float viewDistanceSq) {
+    return std::bit_cast<uint32_t>(viewDistanceSq > 0.0f ? viewDistanceSq : 0.0f);
+}
+
+uint64_t RenderQueue::MakeOpaqueKey(uint32_t program, uint64_t material, uint64_t mesh, float viewDistanceSq) {
+    return (static_cast<uint64_t>(Pass::OPAQUE) << 62) |
+        (static_cast<uint64_t>(program & 0x3FFF) << 48) |
+        (Fold(material, 16) << 32) |
+        (Fold(mesh, 16) << 16) |
+        (DepthBits(viewDistanceSq) >> 16);
+}
+
+uint64_t RenderQueue::MakeTransparentKey(uint32_t program, uint64_t material, uint64_t mesh, float viewDistanceSq) {
+    // invert the depth so the furthest draws come first
+    return (static_cast<uint64_t>(Pass::TRANSPARENT) << 62) |
+        (static_cast<uint64_t>(~DepthBits(viewDistanceSq)) << 30) |
+        (static_cast<uint64_t>(program & 0x3FF) << 20) |
+        (Fold(material, 10) << 10) |
+        Fold(mesh, 10);
+}
+
+void RenderQueue::Build(Pass pass, const std::vector<DrawCall>& drawCalls, const std::vector<ObjectData>& objects, const glm::vec3& viewPosition) {
+    items.resize(drawCalls.size());
+
+    for(size_t i = 0; i < drawCalls.size(); i++) {
+        const DrawCall& dc = drawCalls[i];
+
+        // NOTE like before, this only uses the mesh position for depth
+        const glm::vec3 position = glm::vec3(objects[dc.objectIndex].transform[3]);
+        const float viewDistanceSq = glm::length2(position - viewPosition);
+
+        const uint32_t program = dc.material->GetShader().GetID();
+        const uint64_t& material = dc.material->GetInstanceKey();
+        const uint64_t& mesh = dc.mesh->GetGeometryKey();
+
+        items[i].index = static_cast<uint32_t>(i);
+        items[i].key = pass == Pass::OPAQUE ?
+            MakeOpaqueKey(program, material, mesh, viewDistanceSq) :
+            MakeTransparentKey(program, material, mesh, viewDistanceSq);
+    }
+
+    Sort();
+}
+
+void RenderQueue::Sort() {
+    const size_t count = items.size();
+    if(count < 2) {
+        return;
+    }
+
+    scratch.resize(count);
+
+    // histogram every digit in one sweep
+    uint32_t histograms[8][256] = {};
+    for(const RenderQueueItem& item : items) {
+        for(int d = 0; d < 8; d++) {
+            histograms[d][(item.key >> (d * 8)) & 0xFF]++;
+        }
+    }
+
+    RenderQueueItem* src = items.data();
+    RenderQueueItem* dst = scratch.data();
+
+    for(int d = 0; d < 8; d++) {
+        uint32_t* histogram = histograms[d];
+
+        // every key shares this digit, so this pass wouldn't move anything
+        if(histogram[(src[0].key >> (d * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for(int b = 0; b < 256; b++) {
+            uint32_t bucketCount = histogram[b];
+            histogram[b] = offset;
+            offset += bucketCount;
+        }
+
+        for(size_t i = 0; i < count; i++) {
+            dst[histogram[(src[i].key >> (d * 8)) & 0xFF]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    // an odd number of passes leaves the result in the scratch buffer
+    if(src != items.data()) {
+        items.swap(scratch);
+    }
+}
+
+} // namespace gyo
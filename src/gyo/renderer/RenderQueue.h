@@ -0,0 +1,64 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace gyo {
+
+struct DrawCall;
+struct ObjectData;
+
+struct RenderQueueItem {
+    uint64_t key;
+    uint32_t index; // into the draw calls the queue was built from
+};
+
+/**
+ * Orders a pass's draw calls by a 64-bit sort key, so that draws sharing a
+ * shader program, material, and mesh end up next to each other and the
+ * renderer only has to change state when the key prefix changes.
+ *
+ * Opaque keys, front to back within each mesh:
+ *   | pass 2 | program 14 | material 16 | mesh 16 | depth 16 |
+ *
+ * Transparent keys, back to front first since blending depends on it:
+ *   | pass 2 | inverted depth 32 | program 10 | material 10 | mesh 10 |
+ *
+ * Material and mesh bits are folded from their instance and geometry keys,
+ * so they only order draws; the renderer still compares the real values
+ * before skipping a state change.
+ */
+class RenderQueue {
+public:
+    enum class Pass {
+        OPAQUE = 0,
+        TRANSPARENT = 1
+    };
+
+    /**
+     * Builds a key for each draw call, and radix sorts them
+     */
+    void Build(Pass pass, const std::vector<DrawCall>& drawCalls, const std::vector<ObjectData>& objects, const glm::vec3& viewPosition);
+
+    const std::vector<RenderQueueItem>& GetItems() const { return items; }
+
+    static uint64_t MakeOpaqueKey(uint32_t program, uint64_t material, uint64_t mesh, float viewDistanceSq);
+    static uint64_t MakeTransparentKey(uint32_t program, uint64_t material, uint64_t mesh, float viewDistanceSq);
+
+private:
+    std::vector<RenderQueueItem> items = {};
+    std::vector<RenderQueueItem> scratch = {};
+
+    /**
+     * LSD radix sort on the keys, 8 bits per pass. Passes where every key
+     * has the same digit are skipped, which is most of them in practice.
+     */
+    void Sort();
+};
+
+} // namespace gyo
+
+#endif // RENDER_QUEUE_H
@@ -4,8 +4,24 @@
 
 namespace gyo {
 
-RenderState::RenderState() {
-}
+bool RenderState::isBlendingEnabled = false;
+bool RenderState::isDepthTestingEnabled = false;
+bool RenderState::isFaceCullingEnabled = false;
+
+GLenum RenderState::blendSrcFactor = GL_ONE;
+GLenum RenderState::blendDstFactor = GL_ZERO;
+GLenum RenderState::depthFunction = GL_LESS;
+GLenum RenderState::cullFace = GL_BACK;
+
+unsigned int RenderState::program = 0;
+unsigned int RenderState::vertexArray = 0;
+unsigned int RenderState::activeTextureUnit = 0;
+unsigned int RenderState::textures[MAX_TEXTURE_UNITS][4] = {};
+unsigned int RenderState::uniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS] = {};
+unsigned int RenderState::drawFramebuffer = 0;
+unsigned int RenderState::readFramebuffer = 0;
+
+unsigned int RenderState::redundantCalls = 0;
 
 void RenderState::SetBlendingEnabled(bool enable, GLenum srcFactor, GLenum dstFactor) {
     if(enable && !isBlendingEnabled) {
@@ -18,6 +34,9 @@ void RenderState::SetBlendingEnabled(bool enable, GLenum srcFactor, GLenum dstFa
         glCheckError();
         isBlendingEnabled = false;
     }
+    else {
+        redundantCalls++;
+    }
 
     if(srcFactor != blendSrcFactor || dstFactor != blendDstFactor) {
         glBlendFunc(srcFactor, dstFactor);
@@ -25,6 +44,9 @@ void RenderState::SetBlendingEnabled(bool enable, GLenum srcFactor, GLenum dstFa
         blendSrcFactor = srcFactor;
         blendDstFactor = dstFactor;
     }
+    else {
+        redundantCalls++;
+    }
 }
 
 void RenderState::SetDepthTestingEnabled(bool enable, GLenum function) {
@@ -38,12 +60,18 @@ void RenderState::SetDepthTestingEnabled(bool enable, GLenum function) {
         glCheckError();
         isDepthTestingEnabled = false;
     }
+    else {
+        redundantCalls++;
+    }
 
     if(function != depthFunction) {
         glDepthFunc(function);
         glCheckError();
         depthFunction = function;
     }
+    else {
+        redundantCalls++;
+    }
 }
 
 void RenderState::SetFaceCullingEnabled(bool enable, GLenum face) {
@@ -57,12 +85,164 @@ void RenderState::SetFaceCullingEnabled(bool enable, GLenum face) {
         glCheckError();
         isFaceCullingEnabled = false;
     }
+    else {
+        redundantCalls++;
+    }
 
     if(face != cullFace) {
         glCullFace(face);
         glCheckError();
         cullFace = face;
     }
+    else {
+        redundantCalls++;
+    }
+}
+
+void RenderState::UseProgram(unsigned int program) {
+    if(RenderState::program == program) {
+        redundantCalls++;
+        return;
+    }
+
+    glUseProgram(program);
+    glCheckError();
+    RenderState::program = program;
+}
+
+void RenderState::BindVertexArray(unsigned int vertexArray) {
+    if(RenderState::vertexArray == vertexArray) {
+        redundantCalls++;
+        return;
+    }
+
+    glBindVertexArray(vertexArray);
+    glCheckError();
+    RenderState::vertexArray = vertexArray;
+}
+
+int RenderState::TargetIndex(GLenum target) {
+    switch(target) {
+        case GL_TEXTURE_2D:             return 0;
+        case GL_TEXTURE_CUBE_MAP:       return 1;
+        case GL_TEXTURE_2D_MULTISAMPLE: return 2;
+        case GL_TEXTURE_BUFFER:         return 3;
+        default:                        return -1;
+    }
+}
+
+void RenderState::BindTexture(unsigned int textureUnit, GLenum target, unsigned int texture) {
+    const int targetIndex = TargetIndex(target);
+    const bool isTracked = targetIndex != -1 && textureUnit < MAX_TEXTURE_UNITS;
+
+    if(isTracked && textures[textureUnit][targetIndex] == texture) {
+        redundantCalls++;
+        return;
+    }
+
+    if(activeTextureUnit != textureUnit) {
+        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        glCheckError();
+        activeTextureUnit = textureUnit;
+    }
+
+    glBindTexture(target, texture);
+    glCheckError();
+
+    if(isTracked) {
+        textures[textureUnit][targetIndex] = texture;
+    }
+}
+
+void RenderState::BindUniformBuffer(unsigned int bindingPoint, unsigned int buffer) {
+    const bool isTracked = bindingPoint < MAX_UNIFORM_BUFFER_BINDINGS;
+
+    if(isTracked && uniformBuffers[bindingPoint] == buffer) {
+        redundantCalls++;
+        return;
+    }
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, buffer);
+    glCheckError();
+
+    if(isTracked) {
+        uniformBuffers[bindingPoint] = buffer;
+    }
+}
+
+void RenderState::BindFramebuffer(GLenum target, unsigned int framebuffer) {
+    const bool setsDraw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+    const bool setsRead = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+
+    if((!setsDraw || drawFramebuffer == framebuffer) && (!setsRead || readFramebuffer == framebuffer)) {
+        redundantCalls++;
+        return;
+    }
+
+    glBindFramebuffer(target, framebuffer);
+    glCheckError();
+
+    if(setsDraw) {
+        drawFramebuffer = framebuffer;
+    }
+    if(setsRead) {
+        readFramebuffer = framebuffer;
+    }
+}
+
+void RenderState::DeleteProgram(unsigned int program) {
+    glDeleteProgram(program);
+    glCheckError();
+
+    if(RenderState::program == program) {
+        RenderState::program = 0;
+    }
+}
+
+void RenderState::DeleteVertexArray(unsigned int vertexArray) {
+    glDeleteVertexArrays(1, &vertexArray);
+    glCheckError();
+
+    if(RenderState::vertexArray == vertexArray) {
+        RenderState::vertexArray = 0;
+    }
+}
+
+void RenderState::DeleteTexture(unsigned int texture) {
+    glDeleteTextures(1, &texture);
+    glCheckError();
+
+    // GL unbinds a deleted texture from every unit it was bound to
+    for(int unit = 0; unit < MAX_TEXTURE_UNITS; unit++) {
+        for(unsigned int& bound : textures[unit]) {
+            if(bound == texture) {
+                bound = 0;
+            }
+        }
+    }
+}
+
+void RenderState::DeleteBuffer(unsigned int buffer) {
+    glDeleteBuffers(1, &buffer);
+    glCheckError();
+
+    for(unsigned int& bound : uniformBuffers) {
+        if(bound == buffer) {
+            bound = 0;
+        }
+    }
+}
+
+void RenderState::DeleteFramebuffer(unsigned int framebuffer) {
+    glDeleteFramebuffers(1, &framebuffer);
+    glCheckError();
+
+    if(drawFramebuffer == framebuffer) {
+        drawFramebuffer = 0;
+    }
+    if(readFramebuffer == framebuffer) {
+        readFramebuffer = 0;
+    }
 }
 
 } // namespace gyo
@@ -3,8 +3,15 @@
 
 /**
  * Cache our current OpenGL state here to reduce the number of commands we send
- * per draw call – only send the commands if they are different from what is
+ * per draw call – only send the commands if they are different from what is
  * currently set.
+ *
+ * This is the single shadow of bound GL state, so every bind of a program,
+ * vertex array, texture, uniform buffer or framebuffer must go through here,
+ * as must deleting any of them, since GL may hand out a deleted name again.
+ * Only indexed uniform buffer bindings are shadowed. Binding a buffer to a
+ * generic target like GL_UNIFORM_BUFFER just to fill it isn't, since nothing
+ * draws with those, so always bind it before filling and reset it after.
  */
 
 #include <glad/glad.h>
@@ -13,22 +20,56 @@ namespace gyo {
 
 class RenderState {
 public:
-    // constructor
-    RenderState();
+    static const int MAX_TEXTURE_UNITS = 32;
+    static const int MAX_UNIFORM_BUFFER_BINDINGS = 16;
 
-    void SetBlendingEnabled(bool enable, GLenum srcFactor = GL_SRC_ALPHA, GLenum dstFactor = GL_ONE_MINUS_SRC_ALPHA);
-    void SetDepthTestingEnabled(bool enable, GLenum function = GL_LESS);
-    void SetFaceCullingEnabled(bool enable, GLenum face = GL_BACK);
+    static void SetBlendingEnabled(bool enable, GLenum srcFactor = GL_SRC_ALPHA, GLenum dstFactor = GL_ONE_MINUS_SRC_ALPHA);
+    static void SetDepthTestingEnabled(bool enable, GLenum function = GL_LESS);
+    static void SetFaceCullingEnabled(bool enable, GLenum face = GL_BACK);
+
+    static void UseProgram(unsigned int program);
+    static void BindVertexArray(unsigned int vertexArray);
+    static void BindTexture(unsigned int textureUnit, GLenum target, unsigned int texture);
+    static void BindUniformBuffer(unsigned int bindingPoint, unsigned int buffer);
+    static void BindFramebuffer(GLenum target, unsigned int framebuffer);
+
+    // deletes the object, and forgets it anywhere it was bound
+    static void DeleteProgram(unsigned int program);
+    static void DeleteVertexArray(unsigned int vertexArray);
+    static void DeleteTexture(unsigned int texture);
+    static void DeleteBuffer(unsigned int buffer);
+    static void DeleteFramebuffer(unsigned int framebuffer);
+
+    // the number of requests that matched the shadowed state since the last
+    // reset, for our stats. Not every one would have changed anything, e.g.
+    // disabling blending that was never enabled.
+    static const unsigned int& GetRedundantCalls() { return redundantCalls; }
+    static void ResetRedundantCalls() { redundantCalls = 0; }
 
 private:
-    bool isBlendingEnabled;
-    bool isDepthTestingEnabled;
-    bool isFaceCullingEnabled;
-
-    GLenum blendSrcFactor;
-    GLenum blendDstFactor;
-    GLenum depthFunction;
-    GLenum cullFace;
+    // fixed function state, initialized to the GL defaults
+    static bool isBlendingEnabled;
+    static bool isDepthTestingEnabled;
+    static bool isFaceCullingEnabled;
+
+    static GLenum blendSrcFactor;
+    static GLenum blendDstFactor;
+    static GLenum depthFunction;
+    static GLenum cullFace;
+
+    // bindings
+    static unsigned int program;
+    static unsigned int vertexArray;
+    static unsigned int activeTextureUnit;
+    static unsigned int textures[MAX_TEXTURE_UNITS][4]; // by unit, then target, see TargetIndex
+    static unsigned int uniformBuffers[MAX_UNIFORM_BUFFER_BINDINGS];
+    static unsigned int drawFramebuffer;
+    static unsigned int readFramebuffer;
+
+    static unsigned int redundantCalls;
+
+    // the index of a shadowed texture target, or -1 if we don't track it
+    static int TargetIndex(GLenum target);
 };
 
 } // namespace gyo
@@ -2,6 +2,9 @@
 #include <gyo/renderer/Renderer.h>
 #include <gyo/renderer/ScreenQuad.h>
 #include <gyo/renderer/DrawCall.h>
+#include <gyo/renderer/FrameRingBuffer.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/mesh/Mesh.h>
 #include <gyo/mesh/Skybox.h>
 #include <gyo/shading/TextureCube.h>
@@ -28,10 +31,9 @@ Renderer::Renderer(const int& width, const int& height, int msaaSamples, float p
 
     // setup our render state
 
-    state = RenderState();
-    state.SetFaceCullingEnabled(true);
-    state.SetDepthTestingEnabled(true);
-    state.SetBlendingEnabled(false);
+    RenderState::SetFaceCullingEnabled(true);
+    RenderState::SetDepthTestingEnabled(true);
+    RenderState::SetBlendingEnabled(false);
 
     CreateFrameBuffer();
 
@@ -39,29 +41,49 @@ Renderer::Renderer(const int& width, const int& height, int msaaSamples, float p
     glCheckError();
     glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     glCheckError();
+
+    // the per-object data, exposed to shaders as a texture buffer of columns.
+    // GL 3.3 only guarantees 65536 texels, across every frame's region.
+
+    GLint maxTexels;
+    glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+    glCheckError();
+    const size_t maxObjects = static_cast<size_t>(maxTexels) * 16 / FrameRingBuffer::FRAME_COUNT / sizeof(ObjectData);
+    const size_t maxRegionSize = maxObjects * sizeof(ObjectData);
+
+    objectBuffer = new FrameRingBuffer(GL_TEXTURE_BUFFER, std::min<size_t>(1 << 20, maxRegionSize), maxRegionSize);
+    glGenTextures(1, &objectDataTexture);
+    glCheckError();
+    RenderState::BindTexture(OBJECT_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, objectDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, objectBuffer->GetBuffer());
+    glCheckError();
+
+    // the per-instance object indices
+    instanceBuffer = new FrameRingBuffer(GL_ARRAY_BUFFER, 1 << 16);
 }
 
 Renderer::~Renderer() {
     delete screenQuad;
     screenQuad = nullptr;
 
-    glDeleteFramebuffers(1, &framebuffer);
-    glCheckError();
+    RenderState::DeleteTexture(objectDataTexture);
+    delete objectBuffer;
+    objectBuffer = nullptr;
+    delete instanceBuffer;
+    instanceBuffer = nullptr;
+
+    RenderState::DeleteFramebuffer(framebuffer);
 
     if(msaaSamples > 0) {
-        glDeleteTextures(1, &textureColorbufferMS);
-        glCheckError();
+        RenderState::DeleteTexture(textureColorbufferMS);
         glDeleteRenderbuffers(1, &depthRenderbufferMS);
         glCheckError();
 
-        glDeleteFramebuffers(1, &intermediateFramebuffer);
-        glCheckError();
-        glDeleteTextures(1, &textureColorbuffer);
-        glCheckError();
+        RenderState::DeleteFramebuffer(intermediateFramebuffer);
+        RenderState::DeleteTexture(textureColorbuffer);
     }
     else {
-        glDeleteTextures(1, &textureColorbuffer);
-        glCheckError();
+        RenderState::DeleteTexture(textureColorbuffer);
         glDeleteRenderbuffers(1, &depthRenderbuffer);
         glCheckError();
     }
@@ -73,19 +95,16 @@ void Renderer::CreateFrameBuffer() {
     // create and bind our main framebuffer
     glGenFramebuffers(1, &framebuffer);
     glCheckError();
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
 
     if(msaaSamples > 0) {
         // create our ms texture object and image
         glGenTextures(1, &textureColorbufferMS);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, textureColorbufferMS);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, textureColorbufferMS);
         glTexImage2DMultisample(GL_TEXTURE_2D_MULTISAMPLE, msaaSamples, GL_RGB16F, size.x, size.y, GL_TRUE);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D_MULTISAMPLE, 0);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D_MULTISAMPLE, 0);
         
         // create a (also multisampled) renderbuffer object for depth and stencil attachments
         glGenRenderbuffers(1, &depthRenderbufferMS);
@@ -107,28 +126,24 @@ void Renderer::CreateFrameBuffer() {
             LOGE("Framebuffer not complete");
         }
         glCheckError();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glCheckError();
+        RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
         // now configure our secondary post-process framebuffer
         glGenFramebuffers(1, &intermediateFramebuffer);
         glCheckError();
-        glBindFramebuffer(GL_FRAMEBUFFER, intermediateFramebuffer);
-        glCheckError();
+        RenderState::BindFramebuffer(GL_FRAMEBUFFER, intermediateFramebuffer);
 
         // generate intermediate hdr color texture
         glGenTextures(1, &textureColorbuffer);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, size.x, size.y, 0, GL_RGB, GL_FLOAT, NULL);
         glCheckError();
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glCheckError();
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
 
         // attach color buffer (we don't need depth/stencil) to currently bound framebuffer object
         glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textureColorbuffer, 0);
@@ -138,23 +153,20 @@ void Renderer::CreateFrameBuffer() {
             LOGE("Framebuffer not complete");
         }
         glCheckError();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glCheckError();
+        RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
     else {
         // generate hdr color texture
         glGenTextures(1, &textureColorbuffer);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, size.x, size.y, 0, GL_RGB, GL_FLOAT, NULL);
         glCheckError();
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glCheckError();
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glCheckError();
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glCheckError();
+        RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
     
         // generate render buffer object for depth / stencil
         glGenRenderbuffers(1, &depthRenderbuffer);
@@ -176,8 +188,7 @@ void Renderer::CreateFrameBuffer() {
             LOGE("Framebuffer not complete");
         }
         glCheckError();
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glCheckError();
+        RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     }
 }
 
@@ -295,10 +306,14 @@ void Renderer::PrintGLInfo() {
 }
 
 void Renderer::BeginFrame() {
+    // the first write of the frame moves our ring buffers on to their next
+    // region, frames that retain everything keep reading the last one
+    objectBuffer->BeginFrame();
+    instanceBuffer->BeginFrame();
+
     // bind and clear our frame buffer
 
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, framebuffer);
     glViewport(0, 0, size.x, size.y);
     glCheckError();
     glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
@@ -307,52 +322,195 @@ void Renderer::BeginFrame() {
     glCheckError();
 }
 
-void Renderer::RenderOpaque(std::vector<DrawCall> drawCalls, const IBLEnvironment& environment) {
-    state.SetDepthTestingEnabled(true);
-    state.SetBlendingEnabled(false);
+void Renderer::SetObjectData(const std::vector<ObjectData>& objects, uint32_t version) {
+    RenderState::BindTexture(OBJECT_DATA_TEXTURE_UNIT, GL_TEXTURE_BUFFER, objectDataTexture);
 
-    for(const DrawCall& dc : drawCalls) {
-        dc.material->Queue();
-        
-        // bind the IBL maps for any IBL materials
-        if(dc.material->usesIBL) {
-            if(environment.irradianceMap == nullptr) {
-                LOGE("Cannot render IBL PBR Mesh without environment");
-                continue;
-            }
-            environment.irradianceMap->Bind(0U);
-            environment.prefilteredEnvMap->Bind(1U);
-            environment.brdfLUT->Bind(2U);
+    if(this->objects == &objects && objectDataVersion == version) {
+        return;
+    }
+
+    this->objects = &objects;
+    objectDataVersion = version;
+
+    // more than the texture buffer can address are left out, and read as zero
+    size_t count = objects.size();
+    const size_t maxObjects = objectBuffer->GetMaxRegionSize() / sizeof(ObjectData);
+    if(count > maxObjects) {
+        LOGE("Only %zu of %zu objects fit in the object data buffer", maxObjects, count);
+        count = maxObjects;
+    }
+
+    // keep every object aligned to its 8 texels
+    const size_t offset = objectBuffer->Write(objects.data(), count * sizeof(ObjectData), sizeof(ObjectData));
+    firstObject = static_cast<uint32_t>(offset / sizeof(ObjectData));
+}
+
+void Renderer::PreparePass(RetainedPass& retained, RenderQueue::Pass pass, const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const glm::vec3& viewPosition) {
+    const bool hasListChanged = retained.drawListVersion != drawListVersion;
+    const bool haveObjectsChanged = retained.objectDataVersion != objectDataVersion;
+
+    // our indices are gone if the ring grew since we wrote them, and if
+    // another pass wrote this frame, the ring moved on to a region without them
+    const bool haveIndicesMoved = retained.instanceGeneration != instanceBuffer->GetGeneration() ||
+        instanceBuffer->HasWritten();
+
+    if(!hasListChanged && !haveObjectsChanged) {
+        if(haveIndicesMoved) {
+            BuildInstanceBatches(retained, drawCalls);
         }
-        
-        // set any shader uniforms
+        return;
+    }
+
+    // opaque depth only orders draws that are otherwise equal, so moving
+    // objects don't need a re-sort there. Transparent draws are depth first.
+    if(hasListChanged || pass == RenderQueue::Pass::TRANSPARENT) {
+        retained.renderQueue.Build(pass, drawCalls, *objects, viewPosition);
+    }
+
+    // the object indices still move with the object data in the ring
+    BuildInstanceBatches(retained, drawCalls);
+
+    retained.drawListVersion = drawListVersion;
+    retained.objectDataVersion = objectDataVersion;
+}
+
+void Renderer::BuildInstanceBatches(RetainedPass& retained, const std::vector<DrawCall>& drawCalls) {
+    std::vector<InstanceBatch>& batches = retained.batches;
+    std::vector<uint32_t>& instanceIndices = retained.instanceIndices;
+
+    batches.clear();
+    instanceIndices.clear();
+    instanceIndices.reserve(drawCalls.size());
+
+    // merge neighbouring queue items into runs, starting a new batch whenever
+    // the material or geometry changes
+
+    for(const RenderQueueItem& item : retained.renderQueue.GetItems()) {
+        const DrawCall& dc = drawCalls[item.index];
+
+        bool extendsBatch = false;
+        if(!batches.empty()) {
+            const DrawCall& batchDC = *batches.back().drawCall;
+
+            extendsBatch = dc.vertexArray != nullptr && dc.vertexArray->IsInstanceable() &&
+                dc.vertexArray == batchDC.vertexArray &&
+                dc.material->GetInstanceKey() == batchDC.material->GetInstanceKey() &&
+                dc.mesh->GetGeometryKey() == batchDC.mesh->GetGeometryKey();
+        }
+
+        if(extendsBatch) {
+            batches.back().instanceCount++;
+        }
+        else {
+            batches.push_back({ &dc, static_cast<int>(instanceIndices.size()), 1 });
+        }
+
+        instanceIndices.push_back(firstObject + dc.objectIndex);
+    }
+
+    // 4 bytes per draw, rather than the two matrices we used to stream
+    retained.instanceOffset = instanceBuffer->Write(instanceIndices.data(), instanceIndices.size() * sizeof(uint32_t), sizeof(uint32_t));
+    retained.instanceGeneration = instanceBuffer->GetGeneration();
+}
+
+bool Renderer::BindMaterial(Material* material, const IBLEnvironment* environment) {
+    // equivalent materials set the same program, uniforms and textures, so
+    // only queue a material when the sorted key moves on to a different one
+    if(currentMaterial != nullptr && currentMaterial->GetInstanceKey() == material->GetInstanceKey()) {
+        return true;
+    }
+
+    material->Queue();
+    currentMaterial = material;
+
+    // bind the IBL maps for any IBL materials
+    if(material->usesIBL && environment != nullptr) {
+        if(environment->irradianceMap == nullptr) {
+            LOGE("Cannot render IBL PBR Mesh without environment");
+            currentMaterial = nullptr;
+            return false;
+        }
+        environment->irradianceMap->Bind(0U);
+        environment->prefilteredEnvMap->Bind(1U);
+        environment->brdfLUT->Bind(2U);
+    }
+
+    return true;
+}
+
+void Renderer::DrawBatch(const InstanceBatch& batch, size_t instanceOffset) {
+    const DrawCall& dc = *batch.drawCall;
+
+    if(dc.vertexArray == nullptr) {
+        return;
+    }
+
+    if(dc.vertexArray->IsInstanceable()) {
+        // every mesh with the same vertex layout shares a vertex array, so
+        // we only bind when the layout changes
+        if(currentVertexArray != dc.vertexArray) {
+            GeometryPool::Bind(*dc.vertexArray);
+            currentVertexArray = dc.vertexArray;
+        }
+
+        dc.mesh->DrawInstanced(*dc.vertexArray, instanceBuffer->GetBuffer(), instanceOffset + batch.firstInstance * sizeof(uint32_t), batch.instanceCount);
+    }
+    else {
+        // custom shaders without the object index still take uniforms
+        const ObjectData& object = (*objects)[dc.objectIndex];
         const Shader& shader = dc.material->GetShader();
-        shader.SetMat4("model", dc.transform);
-        shader.SetMat4("normalMatrix", dc.normalMatrix);
+        shader.SetMat4("model", object.transform);
+        shader.SetMat4("normalMatrix", object.normalMatrix);
 
-        dc.mesh->Draw();
+        // Draw binds and unbinds the vertex array itself
+        dc.mesh->Draw(*dc.vertexArray);
+        currentVertexArray = nullptr;
     }
+
+    stats.drawCalls++;
+}
+
+void Renderer::RenderOpaque(const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const IBLEnvironment& environment, const glm::vec3& viewPosition) {
+    RenderState::SetDepthTestingEnabled(true);
+    RenderState::SetBlendingEnabled(false);
+
+    // sort by program, material, then mesh, so each is only changed when the
+    // key prefix changes, and equal draws can be instanced together
+    PreparePass(opaquePass, RenderQueue::Pass::OPAQUE, drawCalls, drawListVersion, viewPosition);
+
+    currentMaterial = nullptr;
+    currentVertexArray = nullptr;
+
+    for(const InstanceBatch& batch : opaquePass.batches) {
+        if(!BindMaterial(batch.drawCall->material, &environment)) {
+            continue;
+        }
+
+        DrawBatch(batch, opaquePass.instanceOffset);
+    }
+
+    Mesh::Unbind();
 }
 
 void Renderer::RenderSkybox(Skybox* skybox, glm::mat4 cameraView, glm::mat4 cameraProjection) {
     // Change depth function so depth test passes when values are equal to
     // depth buffer's content. Do this because we're setting the cubemap depth
     // value to 1.0 in the shader.
-    state.SetDepthTestingEnabled(true, GL_LEQUAL);
+    RenderState::SetDepthTestingEnabled(true, GL_LEQUAL);
 
     skybox->Draw(cameraView, cameraProjection);
 
     // set depth function back to default
-    state.SetDepthTestingEnabled(true, GL_LESS);
+    RenderState::SetDepthTestingEnabled(true, GL_LESS);
 }
 
-void Renderer::RenderTransparent(std::vector<DrawCall> drawCalls) {
-    state.SetDepthTestingEnabled(true);
-    state.SetBlendingEnabled(true);
+void Renderer::RenderTransparent(const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const glm::vec3& viewPosition) {
+    RenderState::SetDepthTestingEnabled(true);
+    RenderState::SetBlendingEnabled(true);
 
     // TODO first render back faces, then front faces?
     /*
-    state.SetFaceCullingEnabled(true, GL_FRONT);
+    RenderState::SetFaceCullingEnabled(true, GL_FRONT);
 
     for(const DrawCall& dc : drawCalls) {
         // only render the backfaces of transparent types
@@ -364,48 +522,53 @@ void Renderer::RenderTransparent(std::vector<DrawCall> drawCalls) {
         const Shader& shader = dc.material->GetShader();
 
         // set any shader uniforms
-        shader.SetMat4("model", dc.transform);
-        shader.SetMat4("normalMatrix", dc.normalMatrix);
+        const ObjectData& object = (*objects)[dc.objectIndex];
+        shader.SetMat4("model", object.transform);
+        shader.SetMat4("normalMatrix", object.normalMatrix);
 
         // set the proper gl blend mode (no-op if already set)
-        state.SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        RenderState::SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
         dc.mesh->Draw();
     }
 
-    state.SetFaceCullingEnabled(true, GL_BACK);
+    RenderState::SetFaceCullingEnabled(true, GL_BACK);
     */
 
-    for(const DrawCall& dc : drawCalls) {
-        dc.material->Queue();
-        const Shader& shader = dc.material->GetShader();
+    // sort back to front, then by program, material, and mesh for draws at
+    // the same depth. Only draw calls that end up next to each other merge.
+    PreparePass(transparentPass, RenderQueue::Pass::TRANSPARENT, drawCalls, drawListVersion, viewPosition);
 
-        // set any shader uniforms
-        shader.SetMat4("model", dc.transform);
-        shader.SetMat4("normalMatrix", dc.normalMatrix);
+    currentMaterial = nullptr;
+    currentVertexArray = nullptr;
+
+    for(const InstanceBatch& batch : transparentPass.batches) {
+        const DrawCall& dc = *batch.drawCall;
+
+        BindMaterial(dc.material, nullptr);
 
         // set the proper gl blend mode
         if(dc.material->renderType == RenderType::TRANSPARENT) {
-            state.SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            RenderState::SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         }
         else if(dc.material->renderType == RenderType::ADDITIVE) {
-            state.SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE);
+            RenderState::SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE);
         }
 
-        dc.mesh->Draw();
+        DrawBatch(batch, transparentPass.instanceOffset);
     }
+
+    Mesh::Unbind();
 }
 
 void Renderer::EndGeometryPass() {
-    state.SetDepthTestingEnabled(false);
-    state.SetBlendingEnabled(false);
+    RenderState::SetDepthTestingEnabled(false);
+    RenderState::SetBlendingEnabled(false);
 
     // copy the MS buffer to the normal colorbuffer of intermediate framebuffer
     if(msaaSamples > 0) {
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-        glCheckError();
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFramebuffer);
-        glCheckError();
+        RenderState::BindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        RenderState::BindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFramebuffer);
         glBlitFramebuffer(
             0, 0, size.x, size.y,
             0, 0, size.x, size.y,
@@ -415,8 +578,7 @@ void Renderer::EndGeometryPass() {
 
     // unbind our framebuffer, and render the full screen quad
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); // back to default
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0); // back to default
     glClearColor(clearColor.r, clearColor.g, clearColor.b, 1.0f);
     glCheckError();
     glClear(GL_COLOR_BUFFER_BIT);
@@ -427,6 +589,13 @@ void Renderer::EndGeometryPass() {
 
 void Renderer::EndFrame() {
     // TODO do final tonemapping and gamma correction pass here?
+
+    // fence this frame's ring buffer regions, now every draw reading them is in
+    objectBuffer->EndFrame();
+    instanceBuffer->EndFrame();
+
+    stats.redundantStateCalls = RenderState::GetRedundantCalls();
+    RenderState::ResetRedundantCalls();
 }
 
 } // namespace gyo
@@ -4,29 +4,48 @@
 #include <vector>
 #include <glm/glm.hpp>
 
-#include <gyo/renderer/RenderState.h>
+#include <gyo/renderer/DrawCall.h>
+#include <gyo/renderer/RenderQueue.h>
 #include <gyo/shading/IBLEnvironment.h>
 #include <gyo/utilities/FrameStats.h>
 
 namespace gyo {
 
 class ScreenQuad;
-class DrawCall;
+class FrameRingBuffer;
+class Material;
 class Skybox;
+struct VertexArray;
 
 class Renderer {
 public:
     FrameStats stats;
 
+    // where shaders find the object data texture buffer
+    static const unsigned int OBJECT_DATA_TEXTURE_UNIT = 15;
+
     Renderer(const int& width, const int& height, int msaaSamples, float pixelScale);
     ~Renderer();
 
     void CreateFrameBuffer();
 
     void BeginFrame();
-    void RenderOpaque(std::vector<DrawCall> drawCalls, const IBLEnvironment& environment);
+
+    /**
+     * Uploads this frame's object data, which draw calls index into. Call
+     * once per frame, before any of the render passes. If the version is the
+     * same as last frame's, the previous upload is reused.
+     */
+    void SetObjectData(const std::vector<ObjectData>& objects, uint32_t version);
+
+    /**
+     * Each pass retains its sorted and batched draws between frames, and only
+     * rebuilds them when the version of its draw list, or the object data,
+     * changes. The draw calls must be left untouched while their version is.
+     */
+    void RenderOpaque(const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const IBLEnvironment& environment, const glm::vec3& viewPosition);
     void RenderSkybox(Skybox* skybox, glm::mat4 cameraView, glm::mat4 cameraProjection);
-    void RenderTransparent(std::vector<DrawCall> drawCalls);
+    void RenderTransparent(const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const glm::vec3& viewPosition);
     void EndGeometryPass();
     void RenderImageEffects();
     void RenderUI();
@@ -39,8 +58,6 @@ private:
     unsigned int msaaSamples;
     float pixelScale;
 
-    RenderState state;
-
     const glm::vec3 clearColor = { 0.0008f, 0.0008f, 0.0004f };
 
     // frame buffer
@@ -55,6 +72,57 @@ private:
     unsigned int depthRenderbufferMS;
     unsigned int intermediateFramebuffer;
 
+    // instancing
+
+    /**
+     * A run of draw calls with the same geometry and equivalent materials,
+     * drawn as instances of the first one
+     */
+    struct InstanceBatch {
+        const DrawCall* drawCall;
+        int firstInstance;
+        int instanceCount;
+    };
+
+    /**
+     * The sorted and batched draws of a pass, kept until its draw list or
+     * the object data they index change
+     */
+    struct RetainedPass {
+        RenderQueue renderQueue;
+        std::vector<InstanceBatch> batches = {};
+        std::vector<uint32_t> instanceIndices = {};
+        size_t instanceOffset = 0; // of the indices, within instanceBuffer
+
+        // what they were built from. Versions start at zero, so these don't.
+        uint32_t drawListVersion = UINT32_MAX;
+        uint32_t objectDataVersion = UINT32_MAX;
+        uint32_t instanceGeneration = UINT32_MAX; // of instanceBuffer
+    };
+
+    RetainedPass opaquePass;
+    RetainedPass transparentPass;
+
+    // every visible object's transforms, written when they change and read
+    // by shaders through a texture buffer
+    FrameRingBuffer* objectBuffer = nullptr;
+    unsigned int objectDataTexture = 0;
+    const std::vector<ObjectData>* objects = nullptr;
+    uint32_t objectDataVersion = UINT32_MAX;
+    uint32_t firstObject = 0; // of the last upload, within the ring
+
+    // the object index of each instance, written whenever a pass is rebuilt
+    FrameRingBuffer* instanceBuffer = nullptr;
+
+    // what the submit loop last bound, to skip redundant changes
+    Material* currentMaterial = nullptr;
+    const VertexArray* currentVertexArray = nullptr;
+
+    void PreparePass(RetainedPass& retained, RenderQueue::Pass pass, const std::vector<DrawCall>& drawCalls, uint32_t drawListVersion, const glm::vec3& viewPosition);
+    void BuildInstanceBatches(RetainedPass& retained, const std::vector<DrawCall>& drawCalls);
+    bool BindMaterial(Material* material, const IBLEnvironment* environment);
+    void DrawBatch(const InstanceBatch& batch, size_t instanceOffset);
+
     void PrintGLInfo();
 };
 
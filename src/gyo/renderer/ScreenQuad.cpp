@@ -5,6 +5,7 @@
 #include <gyo/shading/ShaderMaterial.h>
 #include <gyo/shading/ShaderSemantics.h>
 #include <gyo/resources/Resources.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 
 namespace gyo {
@@ -31,10 +32,7 @@ ScreenQuad::~ScreenQuad() {
 void ScreenQuad::Draw(unsigned int textureColorbuffer) {
     mesh->GetMaterial()->Queue();
 
-    glActiveTexture(GL_TEXTURE0);
-    glCheckError();
-    glBindTexture(GL_TEXTURE_2D, textureColorbuffer);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, textureColorbuffer);
 
     mesh->Draw();
 }
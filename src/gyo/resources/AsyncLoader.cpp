@@ -0,0 +1,536 @@
+
+#include <gyo/resources/AsyncLoader.h>
+#include <gyo/resources/CookedModel.h>
+#include <gyo/resources/KTX2.h>
+#include <gyo/resources/MeshCooker.h>
+#include <gyo/resources/ModelLoader.h>
+#include <gyo/resources/Resources.h>
+#include <gyo/resources/TextureLoader.h>
+#include <gyo/resources/TextureStreamer.h>
+#include <gyo/core/ThreadPool.h>
+#include <gyo/mesh/Mesh.h>
+#include <gyo/mesh/Model.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/shading/Texture2D.h>
+#include <gyo/utilities/GetError.h>
+#include <gyo/utilities/Hash.h>
+#include <gyo/utilities/Log.h>
+#include <gyo/utilities/MappedFile.h>
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+namespace gyo {
+
+ThreadPool* AsyncLoader::threadPool = nullptr;
+unsigned int AsyncLoader::pixelBuffer = 0;
+std::vector<AsyncLoader::Job*> AsyncLoader::jobs = {};
+std::deque<AsyncLoader::Job*> AsyncLoader::uploads = {};
+std::mutex AsyncLoader::mutex;
+std::vector<AsyncLoader::Job*> AsyncLoader::decoded = {};
+
+/**
+ * One load. Decode runs on a worker, everything else on the main thread.
+ */
+struct AsyncLoader::Job {
+    std::string filePath;
+
+    // set by the worker before handing the job back
+    bool isDecoded = false;
+
+    virtual ~Job() {}
+
+    // reads and decodes everything without touching GL
+    virtual bool Decode() = 0;
+
+    // takes the next upload step, and returns true once there are none left
+    virtual bool Upload() = 0;
+
+    // hands the result over, or reports the failure
+    virtual void Complete(bool succeeded) = 0;
+};
+
+/**
+ * Streams an image into a new texture a strip of rows at a time, each strip
+ * copied into the pixel buffer so the driver can transfer it asynchronously
+ */
+struct AsyncLoader::TextureUpload {
+    const DecodedImage* image = nullptr;
+    bool srgb = false;
+    int wrapMode = GL_REPEAT;
+    bool useMipmaps = true;
+
+    unsigned int id = 0;
+    int nextRow = 0;
+
+    // uploads up to about maxBytes of rows, returns true once they're all in
+    bool Step(size_t maxBytes) {
+        unsigned int format;
+        unsigned int internalFormat;
+        TextureLoader::GetTextureFormat(srgb, image->numChannels, &format, &internalFormat);
+
+        if(id == 0) {
+            glGenTextures(1, &id);
+            glCheckError();
+            RenderState::BindTexture(0, GL_TEXTURE_2D, id);
+
+            // allocate every row up front, we fill them in below
+            glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image->width, image->height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+            glCheckError();
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
+            glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
+            glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, useMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+            glCheckError();
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glCheckError();
+        }
+        else {
+            RenderState::BindTexture(0, GL_TEXTURE_2D, id);
+        }
+
+        const size_t rowSize = static_cast<size_t>(image->width) * image->numChannels;
+        const int rowCount = std::clamp(static_cast<int>(maxBytes / rowSize), 1, image->height - nextRow);
+        const size_t size = rowSize * rowCount;
+        const unsigned char* rows = image->pixels + nextRow * rowSize;
+
+        // our rows are tightly packed
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glCheckError();
+
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, AsyncLoader::pixelBuffer);
+        glCheckError();
+
+        // orphan the last strip's storage, rather than wait for it to be read
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        glCheckError();
+
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glCheckError();
+
+        if(mapped != nullptr) {
+            std::memcpy(mapped, rows, size);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glCheckError();
+
+            // reads from the pixel buffer, at offset 0
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nextRow, image->width, rowCount, format, GL_UNSIGNED_BYTE, nullptr);
+            glCheckError();
+
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glCheckError();
+        }
+        else {
+            // couldn't map, so upload from client memory instead
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glCheckError();
+
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nextRow, image->width, rowCount, format, GL_UNSIGNED_BYTE, rows);
+            glCheckError();
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glCheckError();
+
+        nextRow += rowCount;
+        const bool isComplete = nextRow == image->height;
+
+        if(isComplete && useMipmaps) {
+            glGenerateMipmap(GL_TEXTURE_2D);
+            glCheckError();
+        }
+
+        RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+        return isComplete;
+    }
+
+    Texture2D GetTexture() const {
+        return Texture2D(id, image->width, image->height, image->numChannels == 4);
+    }
+};
+
+struct AsyncLoader::TextureJob : AsyncLoader::Job {
+    std::string key;
+    DecodedImage image;
+    TextureUpload upload;
+    bool isHandedOver = false;
+
+    // the cooked .ktx2 instead, if there's a usable one, uploaded in one step,
+    // or only its smallest levels, with the file handed to TextureStreamer
+    MappedFile* cookedFile = nullptr;
+    KTX2View cooked;
+    bool isCooked = false;
+    Texture2D* compressed = nullptr;
+
+    ~TextureJob() {
+        image.Free();
+        delete cookedFile;
+
+        if(!isHandedOver && upload.id != 0) {
+            RenderState::DeleteTexture(upload.id);
+        }
+
+        if(compressed != nullptr) {
+            if(!isHandedOver) {
+                compressed->Dispose();
+            }
+            delete compressed;
+        }
+    }
+
+    bool Decode() override {
+        // prefer a cook, as TextureLoader::LoadTexture does
+        cookedFile = new MappedFile();
+        isCooked = TextureLoader::ReadCookedTexture(filePath, upload.srgb, *cookedFile, cooked);
+        if(isCooked) {
+            return true;
+        }
+
+        // flipped, as TextureLoader::LoadTexture does
+        return TextureLoader::DecodeImageFile(filePath, true, image);
+    }
+
+    bool Upload() override {
+        if(isCooked) {
+            if(TextureStreamer::CanStream(cooked, upload.useMipmaps)) {
+                compressed = TextureStreamer::CreateTexture(cookedFile, cooked, upload.wrapMode);
+                cookedFile = nullptr;
+            }
+            else {
+                compressed = TextureLoader::CreateCompressedTexture2D(cooked, upload.wrapMode, upload.useMipmaps);
+            }
+            return true;
+        }
+
+        return upload.Step(UPLOAD_CHUNK_BYTES);
+    }
+
+    void Complete(bool succeeded) override {
+        if(!succeeded || (isCooked && compressed == nullptr)) {
+            Resources::FinishTextureLoad(key, nullptr, false);
+            return;
+        }
+
+        Texture2D texture = isCooked ? *compressed : upload.GetTexture();
+        isHandedOver = true;
+
+        Resources::FinishTextureLoad(key, &texture, upload.useMipmaps);
+    }
+};
+
+struct AsyncLoader::ModelJob : AsyncLoader::Job {
+    typedef std::pair<int32_t, bool> TextureKey;    // cooked index, and whether it's sRGB
+
+    bool flipUVs = false;
+    LoadHandle<Model> handle;
+
+    // the cooked model, either mapped from disk or cooked by us
+    MappedFile file;
+    std::vector<unsigned char> cookedBytes;
+    CookedModelView cooked;
+
+    // decoded by cooked index, then uploaded once per key, unless another
+    // load has cached the same image already. Resources caches the textures,
+    // and we hold them until the materials do.
+    std::vector<DecodedImage> images;
+    std::vector<uint64_t> imageHashes;
+    std::vector<TextureKey> textureKeys;
+    std::vector<TextureUpload> textureUploads;
+    std::map<TextureKey, TextureHandle> textures;
+    size_t nextTexture = 0;
+
+    std::vector<Material*> materials;   // by cooked index, created as meshes first use them
+    std::vector<Mesh*> meshes;
+    bool isHandedOver = false;
+
+    ~ModelJob() {
+        FreeImages();
+
+        if(isHandedOver) {
+            return;
+        }
+
+        for(Mesh* mesh : meshes) {
+            delete mesh;
+        }
+
+        // any cut off partway through isn't cached yet
+        if(nextTexture < textureUploads.size() && textureUploads[nextTexture].id != 0) {
+            RenderState::DeleteTexture(textureUploads[nextTexture].id);
+        }
+    }
+
+    void FreeImages() {
+        for(DecodedImage& image : images) {
+            image.Free();
+        }
+    }
+
+    bool Decode() override {
+        // prefer an up to date cook, as ModelLoader does
+        std::string cookedFilePath = MeshCooker::GetCookedPath(filePath);
+        bool isCooked = false;
+
+        if(std::filesystem::exists(cookedFilePath) && file.Open(cookedFilePath)) {
+            isCooked = MeshCooker::Read(file.GetData(), file.GetSize(), cookedFilePath != filePath ? filePath : "", flipUVs, cooked);
+            if(!isCooked) {
+                LOGW("Ignoring cooked model %s", cookedFilePath.c_str());
+                file.Close();
+            }
+        }
+
+        if(!isCooked) {
+            if(!MeshCooker::CookToMemory(filePath, flipUVs, cookedBytes) ||
+                !MeshCooker::Read(cookedBytes.data(), cookedBytes.size(), "", flipUVs, cooked)) {
+                return false;
+            }
+        }
+
+        // falling back on the source images of any textures we can't sample
+        TextureLoader::SelectCookedTextures(cooked);
+
+        materials.resize(cooked.materials.size(), nullptr);
+
+        // decode every texture a mesh's material uses, once each
+        images.resize(cooked.textures.size());
+        imageHashes.resize(cooked.textures.size(), 0);
+
+        for(const CookedMeshEntry& mesh : cooked.meshes) {
+            const CookedMaterial& material = cooked.materials[mesh.materialIndex];
+
+            for(uint32_t slot = 0; slot < COOKED_TEXTURE_SLOT_COUNT; slot++) {
+                const int32_t index = material.textures[slot];
+                if(index < 0 || index >= static_cast<int32_t>(images.size())) {
+                    continue;
+                }
+
+                const TextureKey key = { index, IsCookedTextureSRGB(slot) };
+                if(std::find(textureKeys.begin(), textureKeys.end(), key) != textureKeys.end()) {
+                    continue;
+                }
+
+                const CookedTexture& entry = cooked.textures[index];
+                std::string formatHint(entry.formatHint, strnlen(entry.formatHint, sizeof(entry.formatHint)));
+
+                // block compressed by the cooker, uploaded without decoding
+                const bool isBlockCompressed = formatHint == KTX2_EXTENSION;
+
+                DecodedImage& image = images[index];
+                if(image.pixels == nullptr) {
+                    // cached by content, as Resources::AcquireCompressedTexture does
+                    imageHashes[index] = hash_bytes(cooked.data + entry.offset, entry.size);
+
+                    // the material goes without, as it would loading synchronously
+                    const bool isDecoded = isBlockCompressed || (formatHint == COOKED_TEXTURE_RAW_FORMAT ?
+                        TextureLoader::DecodeRawImage(cooked.data + entry.offset, entry.width, entry.height, image) :
+                        TextureLoader::DecodeCompressedImage(cooked.data + entry.offset, entry.size, formatHint, image));
+                    if(!isDecoded) {
+                        continue;
+                    }
+                }
+
+                TextureUpload upload;
+                upload.image = isBlockCompressed ? nullptr : &image;
+                upload.srgb = key.second;
+
+                textureKeys.push_back(key);
+                textureUploads.push_back(upload);
+            }
+        }
+
+        return true;
+    }
+
+    bool Upload() override {
+        // textures first, since the materials need them
+        if(nextTexture < textureUploads.size()) {
+            TextureUpload& upload = textureUploads[nextTexture];
+            const TextureKey& key = textureKeys[nextTexture];
+            const std::string cacheKey = Resources::GetEmbeddedTextureKey(imageHashes[key.first], key.second);
+
+            // skip any image another model has uploaded since we decoded it
+            TextureHandle cached = upload.id == 0 ? Resources::FindTexture(cacheKey) : nullptr;
+            if(cached) {
+                textures[key] = cached;
+                nextTexture++;
+            }
+            else if(upload.image == nullptr) {
+                // every level at once, it's a fraction of the decoded size
+                const CookedTexture& entry = cooked.textures[key.first];
+                Texture2D* texture = TextureLoader::LoadCompressedTexture(cooked.data + entry.offset, entry.size, KTX2_EXTENSION, key.second);
+                if(texture != nullptr) {
+                    textures[key] = Resources::CacheTexture(cacheKey, *texture, true);
+                    delete texture;
+                }
+                nextTexture++;
+            }
+            else if(upload.Step(UPLOAD_CHUNK_BYTES)) {
+                textures[key] = Resources::CacheTexture(cacheKey, upload.GetTexture(), upload.useMipmaps);
+                nextTexture++;
+            }
+
+            if(nextTexture == textureUploads.size()) {
+                FreeImages();
+            }
+
+            return false;
+        }
+
+        // then a mesh at a time
+        if(meshes.size() < cooked.meshes.size()) {
+            const CookedMeshEntry& entry = cooked.meshes[meshes.size()];
+
+            // shared by the meshes using it, as when loading synchronously
+            Material*& material = materials[entry.materialIndex];
+            if(material == nullptr) {
+                material = Resources::ShareMaterial(ModelLoader::CreateCookedMaterial(cooked.materials[entry.materialIndex], cooked,
+                    [this](int32_t index, bool srgb) -> TextureHandle {
+                        auto it = textures.find({ index, srgb });
+                        return it != textures.end() ? it->second : nullptr;
+                    }));
+            }
+
+            meshes.push_back(ModelLoader::CreateCookedMesh(cooked, entry, material));
+        }
+
+        return meshes.size() == cooked.meshes.size();
+    }
+
+    void Complete(bool succeeded) override {
+        if(!succeeded) {
+            LOGE("Failed to load model %s", filePath.c_str());
+            handle.Resolve(nullptr);
+            return;
+        }
+
+        isHandedOver = true;
+        handle.Resolve(new Model(meshes));
+    }
+};
+
+void AsyncLoader::Initialize(ThreadPool* pool) {
+    threadPool = pool;
+
+    glGenBuffers(1, &pixelBuffer);
+    glCheckError();
+}
+
+void AsyncLoader::Dispose() {
+    for(Job* job : jobs) {
+        delete job;
+    }
+    jobs.clear();
+    uploads.clear();
+    decoded.clear();
+
+    if(pixelBuffer != 0) {
+        RenderState::DeleteBuffer(pixelBuffer);
+        pixelBuffer = 0;
+    }
+
+    threadPool = nullptr;
+}
+
+LoadHandle<Model> AsyncLoader::LoadModel(const std::string& modelFilePath, bool flipUVs) {
+    LOGI("Loading model %s in the background", modelFilePath.c_str());
+
+    ModelJob* job = new ModelJob();
+    job->filePath = modelFilePath;
+    job->flipUVs = flipUVs;
+    job->handle = LoadHandle<Model>::Create();
+
+    LoadHandle<Model> handle = job->handle;
+    Submit(job);
+
+    return handle;
+}
+
+void AsyncLoader::LoadTexture(const std::string& imageFilePath, const std::string& key, bool srgb, int wrapMode, bool useMipmaps) {
+    TextureJob* job = new TextureJob();
+    job->filePath = imageFilePath;
+    job->key = key;
+    job->upload.image = &job->image;
+    job->upload.srgb = srgb;
+    job->upload.wrapMode = wrapMode;
+    job->upload.useMipmaps = useMipmaps;
+
+    Submit(job);
+}
+
+void AsyncLoader::Submit(Job* job) {
+    jobs.push_back(job);
+
+    auto decode = [job]() {
+        bool succeeded = false;
+        try {
+            succeeded = job->Decode();
+        }
+        catch(const std::exception& e) {
+            LOGE("Failed to decode %s: %s", job->filePath.c_str(), e.what());
+        }
+
+        // failures go back to the main thread too, to be reported from there
+        std::lock_guard<std::mutex> lock(mutex);
+        job->isDecoded = succeeded;
+        decoded.push_back(job);
+    };
+
+    if(threadPool != nullptr) {
+        threadPool->Submit(decode);
+    }
+    else {
+        decode();
+    }
+}
+
+void AsyncLoader::ProcessUploads(double budgetMs) {
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // pick up what the workers have finished
+    std::vector<Job*> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(decoded);
+    }
+
+    for(Job* job : finished) {
+        if(job->isDecoded) {
+            uploads.push_back(job);
+        }
+        else {
+            Finish(job, false);
+        }
+    }
+
+    // then upload in order, a step at a time, until we're out of time
+    while(!uploads.empty()) {
+        Job* job = uploads.front();
+        if(job->Upload()) {
+            uploads.pop_front();
+            Finish(job, true);
+        }
+
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        if(ms >= budgetMs) {
+            break;
+        }
+    }
+}
+
+void AsyncLoader::Finish(Job* job, bool succeeded) {
+    jobs.erase(std::remove(jobs.begin(), jobs.end(), job), jobs.end());
+
+    // callbacks may start more loads, so the job is already off the list
+    job->Complete(succeeded);
+    delete job;
+}
+
+} // namespace gyo
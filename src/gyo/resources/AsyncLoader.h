@@ -0,0 +1,80 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <gyo/resources/LoadHandle.h>
+
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace gyo {
+
+class Model;
+class ThreadPool;
+
+/**
+ * Loads resources without stalling the main thread. File reads, imports and
+ * image decoding run as thread pool tasks, and what they produce is queued
+ * for the main thread, which uploads it to GL a piece at a time within a
+ * per-frame budget. Textures are streamed a strip of rows at a time through
+ * a pixel buffer, and models a texture strip or mesh at a time.
+ *
+ * Models load from their cooked .gyomesh when there's an up to date one,
+ * otherwise they're cooked in memory on the worker. Block compressed
+ * textures, cooked alone or inside a model, upload in a single step, only
+ * their smallest levels if TextureStreamer streams in the rest.
+ */
+class AsyncLoader {
+public:
+    // about how much pixel data a single upload step copies
+    static const size_t UPLOAD_CHUNK_BYTES = 1 << 20;
+
+    static void Initialize(ThreadPool* threadPool);
+
+    // the thread pool must be gone by now, so no worker is mid-load
+    static void Dispose();
+
+    static LoadHandle<Model> LoadModel(const std::string& modelFilePath, bool flipUVs);
+
+    // hands the texture to Resources, under key, once it's uploaded
+    static void LoadTexture(const std::string& imageFilePath, const std::string& key, bool srgb, int wrapMode, bool useMipmaps);
+
+    /**
+     * Uploads whatever's been decoded, until budgetMs has passed. At least
+     * one step is taken each call, so loads always make progress.
+     */
+    static void ProcessUploads(double budgetMs);
+
+    // loads not yet finished, whether decoding or uploading
+    static size_t GetPendingCount() { return jobs.size(); }
+
+private:
+    struct Job;
+    struct TextureUpload;
+    struct TextureJob;
+    struct ModelJob;
+
+    static ThreadPool* threadPool;
+
+    // streams texture rows to GL, orphaned on each upload
+    static unsigned int pixelBuffer;
+
+    // every job in flight, main thread only
+    static std::vector<Job*> jobs;
+
+    // decoded jobs, in the order they'll be uploaded, main thread only
+    static std::deque<Job*> uploads;
+
+    // jobs handed back by the workers, guarded by mutex
+    static std::mutex mutex;
+    static std::vector<Job*> decoded;
+
+    static void Submit(Job* job);
+    static void Finish(Job* job, bool succeeded);
+};
+
+} // namespace gyo
+
+#endif // ASYNC_LOADER_H
@@ -0,0 +1,485 @@
+
+#include <gyo/resources/BlockCompressor.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+namespace gyo {
+
+// how far the interpolated BC7 colors are from the first endpoint, in 64ths
+static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// how far BC1's palette entries are from the first endpoint
+static const float BC1_WEIGHTS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+/**
+ * Fits a line through a block's texels, over its first channelCount channels,
+ * and returns its ends, pulled in by inset of the spread since the extremes
+ * are rarely worth hitting exactly. The line follows the principal axis,
+ * found by power iteration on the texels' covariance.
+ */
+static void FitEndpoints(const unsigned char texels[64], int channelCount, float inset, float lo[4], float hi[4]) {
+    float mean[4] = {};
+    for(int i = 0; i < 16; i++) {
+        for(int c = 0; c < channelCount; c++) {
+            mean[c] += texels[i * 4 + c];
+        }
+    }
+    for(int c = 0; c < channelCount; c++) {
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[4][4] = {};
+    for(int i = 0; i < 16; i++) {
+        for(int a = 0; a < channelCount; a++) {
+            for(int b = 0; b < channelCount; b++) {
+                covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+            }
+        }
+    }
+
+    // start from the row of the channel that varies most, which is never
+    // orthogonal to the axis we're after
+    int widest = 0;
+    for(int c = 1; c < channelCount; c++) {
+        if(covariance[c][c] > covariance[widest][widest]) {
+            widest = c;
+        }
+    }
+
+    float axis[4] = {};
+    for(int c = 0; c < channelCount; c++) {
+        axis[c] = covariance[widest][c];
+    }
+
+    for(int iteration = 0; iteration < 8; iteration++) {
+        float next[4] = {};
+        float largest = 0.0f;
+        for(int a = 0; a < channelCount; a++) {
+            for(int b = 0; b < channelCount; b++) {
+                next[a] += covariance[a][b] * axis[b];
+            }
+            largest = std::max(largest, std::abs(next[a]));
+        }
+
+        // a flat block, every texel the same
+        if(largest < 1e-6f) {
+            break;
+        }
+
+        for(int c = 0; c < channelCount; c++) {
+            axis[c] = next[c] / largest;
+        }
+    }
+
+    float length = 0.0f;
+    for(int c = 0; c < channelCount; c++) {
+        length += axis[c] * axis[c];
+    }
+    length = std::sqrt(length);
+
+    float minProjection = 0.0f;
+    float maxProjection = 0.0f;
+    if(length > 1e-6f) {
+        for(int c = 0; c < channelCount; c++) {
+            axis[c] /= length;
+        }
+
+        minProjection = std::numeric_limits<float>::max();
+        maxProjection = std::numeric_limits<float>::lowest();
+        for(int i = 0; i < 16; i++) {
+            float projection = 0.0f;
+            for(int c = 0; c < channelCount; c++) {
+                projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+            }
+            minProjection = std::min(minProjection, projection);
+            maxProjection = std::max(maxProjection, projection);
+        }
+    }
+
+    for(int c = 0; c < 4; c++) {
+        if(c < channelCount) {
+            lo[c] = mean[c] + axis[c] * minProjection;
+            hi[c] = mean[c] + axis[c] * maxProjection;
+
+            const float pull = (hi[c] - lo[c]) * inset;
+            lo[c] = std::clamp(lo[c] + pull, 0.0f, 255.0f);
+            hi[c] = std::clamp(hi[c] - pull, 0.0f, 255.0f);
+        }
+        else {
+            lo[c] = hi[c] = 255.0f;
+        }
+    }
+}
+
+/**
+ * The endpoints that best reproduce the texels by least squares, given how
+ * far along the line each texel was placed. Returns false if every texel was
+ * placed at the same point, which leaves them undetermined.
+ */
+static bool RefitEndpoints(const unsigned char texels[64], int channelCount, const float weights[16], float lo[4], float hi[4]) {
+    float a = 0.0f;
+    float b = 0.0f;
+    float c = 0.0f;
+    for(int i = 0; i < 16; i++) {
+        const float w = weights[i];
+        a += (1.0f - w) * (1.0f - w);
+        b += (1.0f - w) * w;
+        c += w * w;
+    }
+
+    const float determinant = a * c - b * b;
+    if(std::abs(determinant) < 1e-6f) {
+        return false;
+    }
+
+    for(int channel = 0; channel < channelCount; channel++) {
+        float toLo = 0.0f;
+        float toHi = 0.0f;
+        for(int i = 0; i < 16; i++) {
+            toLo += (1.0f - weights[i]) * texels[i * 4 + channel];
+            toHi += weights[i] * texels[i * 4 + channel];
+        }
+
+        lo[channel] = std::clamp((c * toLo - b * toHi) / determinant, 0.0f, 255.0f);
+        hi[channel] = std::clamp((a * toHi - b * toLo) / determinant, 0.0f, 255.0f);
+    }
+
+    return true;
+}
+
+static uint16_t ToRGB565(const float color[4]) {
+    const int r = std::clamp(static_cast<int>(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    const int g = std::clamp(static_cast<int>(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    const int b = std::clamp(static_cast<int>(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static void FromRGB565(uint16_t color, int out[3]) {
+    const int r = color >> 11 & 31;
+    const int g = color >> 5 & 63;
+    const int b = color & 31;
+    out[0] = r << 3 | r >> 2;
+    out[1] = g << 2 | g >> 4;
+    out[2] = b << 3 | b >> 2;
+}
+
+// gives each texel the closest of the four colors, returns the squared error
+static int PickColorIndices(const unsigned char texels[64], uint16_t color0, uint16_t color1, uint32_t& indices) {
+    int palette[4][3];
+    FromRGB565(color0, palette[0]);
+    FromRGB565(color1, palette[1]);
+    for(int c = 0; c < 3; c++) {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    indices = 0;
+    int totalError = 0;
+    for(int i = 0; i < 16; i++) {
+        int bestIndex = 0;
+        int bestError = std::numeric_limits<int>::max();
+        for(int k = 0; k < 4; k++) {
+            int error = 0;
+            for(int c = 0; c < 3; c++) {
+                const int difference = texels[i * 4 + c] - palette[k][c];
+                error += difference * difference;
+            }
+            if(error < bestError) {
+                bestError = error;
+                bestIndex = k;
+            }
+        }
+
+        indices |= static_cast<uint32_t>(bestIndex) << (2 * i);
+        totalError += bestError;
+    }
+
+    return totalError;
+}
+
+// an opaque BC1 block, always in four color mode so it's also valid in BC3
+static void EncodeColorBlock(const unsigned char texels[64], unsigned char out[8]) {
+    float lo[4];
+    float hi[4];
+    FitEndpoints(texels, 3, 1.0f / 16.0f, lo, hi);
+
+    uint16_t color0 = ToRGB565(lo);
+    uint16_t color1 = ToRGB565(hi);
+    uint32_t indices;
+    int error = PickColorIndices(texels, color0, color1, indices);
+
+    // refit to what each texel picked, and keep that if it's closer
+    float weights[16];
+    for(int i = 0; i < 16; i++) {
+        weights[i] = BC1_WEIGHTS[indices >> (2 * i) & 3];
+    }
+
+    if(RefitEndpoints(texels, 3, weights, lo, hi)) {
+        const uint16_t refit0 = ToRGB565(lo);
+        const uint16_t refit1 = ToRGB565(hi);
+        uint32_t refitIndices;
+        const int refitError = PickColorIndices(texels, refit0, refit1, refitIndices);
+        if(refitError < error) {
+            color0 = refit0;
+            color1 = refit1;
+            indices = refitIndices;
+            error = refitError;
+        }
+    }
+
+    // four color mode needs color0 > color1, and swapping them swaps the
+    // first two indices and the last two
+    if(color0 < color1) {
+        std::swap(color0, color1);
+        indices ^= 0x55555555;
+    }
+    else if(color0 == color1) {
+        indices = 0;
+    }
+
+    out[0] = color0 & 0xFF;
+    out[1] = color0 >> 8;
+    out[2] = color1 & 0xFF;
+    out[3] = color1 >> 8;
+    for(int i = 0; i < 4; i++) {
+        out[4 + i] = indices >> (8 * i) & 0xFF;
+    }
+}
+
+// the closest 7-bit endpoint and p-bit, shared by its channels, as 8 bits each
+static void QuantizeBC7Endpoint(const float color[4], int out[4]) {
+    float bestError = std::numeric_limits<float>::max();
+    for(int pBit = 0; pBit < 2; pBit++) {
+        int quantized[4];
+        float error = 0.0f;
+        for(int c = 0; c < 4; c++) {
+            const int value = std::clamp(static_cast<int>((color[c] - pBit) / 2.0f + 0.5f), 0, 127);
+            quantized[c] = value << 1 | pBit;
+
+            const float difference = quantized[c] - color[c];
+            error += difference * difference;
+        }
+
+        if(error < bestError) {
+            bestError = error;
+            std::memcpy(out, quantized, sizeof(quantized));
+        }
+    }
+}
+
+// gives each texel the closest of the sixteen colors, returns the squared error
+static int PickBC7Indices(const unsigned char texels[64], const int endpoint0[4], const int endpoint1[4], unsigned char indices[16]) {
+    int palette[16][4];
+    for(int k = 0; k < 16; k++) {
+        for(int c = 0; c < 4; c++) {
+            palette[k][c] = ((64 - BC7_WEIGHTS[k]) * endpoint0[c] + BC7_WEIGHTS[k] * endpoint1[c] + 32) >> 6;
+        }
+    }
+
+    int totalError = 0;
+    for(int i = 0; i < 16; i++) {
+        int bestError = std::numeric_limits<int>::max();
+        for(int k = 0; k < 16; k++) {
+            int error = 0;
+            for(int c = 0; c < 4; c++) {
+                const int difference = texels[i * 4 + c] - palette[k][c];
+                error += difference * difference;
+            }
+            if(error < bestError) {
+                bestError = error;
+                indices[i] = static_cast<unsigned char>(k);
+            }
+        }
+
+        totalError += bestError;
+    }
+
+    return totalError;
+}
+
+// writes fields into a block, least significant bit first
+class BlockBitWriter {
+public:
+    explicit BlockBitWriter(unsigned char* block) : block(block) {}
+
+    void Write(uint32_t value, int bitCount) {
+        for(int i = 0; i < bitCount; i++, position++) {
+            if(value >> i & 1) {
+                block[position >> 3] |= 1 << (position & 7);
+            }
+        }
+    }
+
+private:
+    unsigned char* block;
+    int position = 0;
+};
+
+size_t BlockCompressor::GetBlockSize(BlockFormat format) {
+    return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8 : 16;
+}
+
+void BlockCompressor::Compress(const unsigned char* rgba, int width, int height, BlockFormat format, std::vector<unsigned char>& out) {
+    const int blocksX = (width + 3) / 4;
+    const int blocksY = (height + 3) / 4;
+    const size_t blockSize = GetBlockSize(format);
+
+    out.resize(static_cast<size_t>(blocksX) * blocksY * blockSize);
+    unsigned char* block = out.data();
+
+    unsigned char texels[64];
+    for(int blockY = 0; blockY < blocksY; blockY++) {
+        for(int blockX = 0; blockX < blocksX; blockX++) {
+            for(int y = 0; y < 4; y++) {
+                const int sourceY = std::min(blockY * 4 + y, height - 1);
+                for(int x = 0; x < 4; x++) {
+                    const int sourceX = std::min(blockX * 4 + x, width - 1);
+                    std::memcpy(texels + (y * 4 + x) * 4, rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4, 4);
+                }
+            }
+
+            switch(format) {
+                case BlockFormat::BC1:
+                    EncodeBC1(texels, block);
+                    break;
+                case BlockFormat::BC3:
+                    EncodeBC3(texels, block);
+                    break;
+                case BlockFormat::BC4:
+                    EncodeBC4(texels, 0, block);
+                    break;
+                case BlockFormat::BC5:
+                    EncodeBC5(texels, block);
+                    break;
+                case BlockFormat::BC7:
+                    EncodeBC7(texels, block);
+                    break;
+            }
+
+            block += blockSize;
+        }
+    }
+}
+
+void BlockCompressor::EncodeBC1(const unsigned char texels[64], unsigned char out[8]) {
+    EncodeColorBlock(texels, out);
+}
+
+void BlockCompressor::EncodeBC3(const unsigned char texels[64], unsigned char out[16]) {
+    EncodeBC4(texels, 3, out);
+    EncodeColorBlock(texels, out + 8);
+}
+
+void BlockCompressor::EncodeBC4(const unsigned char texels[64], int channel, unsigned char out[8]) {
+    int lo = 255;
+    int hi = 0;
+    for(int i = 0; i < 16; i++) {
+        lo = std::min(lo, static_cast<int>(texels[i * 4 + channel]));
+        hi = std::max(hi, static_cast<int>(texels[i * 4 + channel]));
+    }
+
+    // hi first, for the mode with six interpolated values
+    out[0] = static_cast<unsigned char>(hi);
+    out[1] = static_cast<unsigned char>(lo);
+
+    uint64_t indices = 0;
+    if(hi > lo) {
+        int palette[8] = { hi, lo };
+        for(int k = 2; k < 8; k++) {
+            palette[k] = ((8 - k) * hi + (k - 1) * lo + 3) / 7;
+        }
+
+        for(int i = 0; i < 16; i++) {
+            int bestIndex = 0;
+            int bestError = std::numeric_limits<int>::max();
+            for(int k = 0; k < 8; k++) {
+                const int error = std::abs(texels[i * 4 + channel] - palette[k]);
+                if(error < bestError) {
+                    bestError = error;
+                    bestIndex = k;
+                }
+            }
+
+            indices |= static_cast<uint64_t>(bestIndex) << (3 * i);
+        }
+    }
+
+    for(int i = 0; i < 6; i++) {
+        out[2 + i] = indices >> (8 * i) & 0xFF;
+    }
+}
+
+void BlockCompressor::EncodeBC5(const unsigned char texels[64], unsigned char out[16]) {
+    EncodeBC4(texels, 0, out);
+    EncodeBC4(texels, 1, out + 8);
+}
+
+void BlockCompressor::EncodeBC7(const unsigned char texels[64], unsigned char out[16]) {
+    float lo[4];
+    float hi[4];
+    FitEndpoints(texels, 4, 1.0f / 64.0f, lo, hi);
+
+    int endpoint0[4];
+    int endpoint1[4];
+    QuantizeBC7Endpoint(lo, endpoint0);
+    QuantizeBC7Endpoint(hi, endpoint1);
+
+    unsigned char indices[16];
+    int error = PickBC7Indices(texels, endpoint0, endpoint1, indices);
+
+    // refit to what each texel picked, and keep that if it's closer
+    float weights[16];
+    for(int i = 0; i < 16; i++) {
+        weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+    }
+
+    if(RefitEndpoints(texels, 4, weights, lo, hi)) {
+        int refit0[4];
+        int refit1[4];
+        QuantizeBC7Endpoint(lo, refit0);
+        QuantizeBC7Endpoint(hi, refit1);
+
+        unsigned char refitIndices[16];
+        const int refitError = PickBC7Indices(texels, refit0, refit1, refitIndices);
+        if(refitError < error) {
+            std::memcpy(endpoint0, refit0, sizeof(refit0));
+            std::memcpy(endpoint1, refit1, sizeof(refit1));
+            std::memcpy(indices, refitIndices, sizeof(refitIndices));
+            error = refitError;
+        }
+    }
+
+    // the first texel's index goes without its top bit, so it has to be under
+    // 8. The weights are symmetric, so swapping the endpoints mirrors them.
+    if(indices[0] & 8) {
+        std::swap(endpoint0, endpoint1);
+        for(unsigned char& index : indices) {
+            index = 15 - index;
+        }
+    }
+
+    std::memset(out, 0, 16);
+    BlockBitWriter writer(out);
+
+    // mode 6
+    writer.Write(1 << 6, 7);
+
+    for(int c = 0; c < 4; c++) {
+        writer.Write(endpoint0[c] >> 1, 7);
+        writer.Write(endpoint1[c] >> 1, 7);
+    }
+
+    writer.Write(endpoint0[0] & 1, 1);
+    writer.Write(endpoint1[0] & 1, 1);
+
+    writer.Write(indices[0], 3);
+    for(int i = 1; i < 16; i++) {
+        writer.Write(indices[i], 4);
+    }
+}
+
+} // namespace gyo
@@ -0,0 +1,48 @@
+#ifndef BLOCK_COMPRESSOR_H
+#define BLOCK_COMPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gyo {
+
+enum class BlockFormat {
+    BC1,    // RGB, 4 bits per texel
+    BC3,    // RGBA, 8 bits per texel
+    BC4,    // R, 4 bits per texel
+    BC5,    // RG, 8 bits per texel
+    BC7     // RGBA, 8 bits per texel, better quality than BC1 or BC3
+};
+
+/**
+ * Encodes 8-bit RGBA images into 4x4 blocks on the CPU. Endpoints are fit
+ * along each block's principal axis and refined by least squares once the
+ * indices are picked. BC7 only uses mode 6, a single RGBA subset, which is
+ * plenty for textures that aren't mostly sharp edges.
+ *
+ * Doesn't touch GL, so it can run from a tool or a worker.
+ */
+class BlockCompressor {
+public:
+    // bytes per 4x4 block
+    static size_t GetBlockSize(BlockFormat format);
+
+    /**
+     * Encodes every block of a tightly packed RGBA image, rows of blocks from
+     * the first row of texels on. Blocks hanging off the right or bottom edge
+     * repeat the edge texels.
+     */
+    static void Compress(const unsigned char* rgba, int width, int height, BlockFormat format, std::vector<unsigned char>& out);
+
+    // each takes 16 RGBA texels, row by row
+    static void EncodeBC1(const unsigned char texels[64], unsigned char out[8]);
+    static void EncodeBC3(const unsigned char texels[64], unsigned char out[16]);
+    static void EncodeBC4(const unsigned char texels[64], int channel, unsigned char out[8]);
+    static void EncodeBC5(const unsigned char texels[64], unsigned char out[16]);
+    static void EncodeBC7(const unsigned char texels[64], unsigned char out[16]);
+};
+
+} // namespace gyo
+
+#endif // BLOCK_COMPRESSOR_H
@@ -0,0 +1,133 @@
+#ifndef COOKED_MODEL_H
+#define COOKED_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * The layout of a cooked .gyomesh file, as written by MeshCooker and read by
+ * ModelLoader. Everything is little-endian, and laid out so the runtime can
+ * map the file and upload straight from it:
+ *
+ *  CookedHeader
+ *  CookedMeshEntry[meshCount]
+ *  CookedMaterial[materialCount]
+ *  CookedTexture[textureCount]
+ *  data, each block 16-byte aligned and addressed by its offset in the file
+ *
+ * Vertex streams are tightly packed floats in GeometryPool::STREAMS order,
+ * and indices are 16-bit wherever the mesh has at most 65536 vertices.
+ */
+
+static const char GYOMESH_MAGIC[8] = { 'G', 'Y', 'O', 'M', 'E', 'S', 'H', '\0' };
+static const uint32_t GYOMESH_VERSION = 3;
+static const char* const GYOMESH_EXTENSION = "gyomesh";
+
+static const uint32_t COOKED_FLAG_FLIP_UVS = 1U << 0;
+
+static const uint32_t COOKED_STREAM_COUNT = 4;
+static const uint32_t COOKED_DATA_ALIGNMENT = 16;
+
+enum CookedMaterialType : uint32_t {
+    COOKED_MATERIAL_GOOCH = 0,
+    COOKED_MATERIAL_PBR = 1,
+    COOKED_MATERIAL_PHONG = 2
+};
+
+// Phong materials use the albedo slot for their diffuse map
+enum CookedTextureSlot : uint32_t {
+    COOKED_TEXTURE_ALBEDO = 0,
+    COOKED_TEXTURE_NORMAL,
+    COOKED_TEXTURE_METALLIC,
+    COOKED_TEXTURE_ROUGHNESS,
+    COOKED_TEXTURE_METALLIC_ROUGHNESS,
+    COOKED_TEXTURE_AO,
+    COOKED_TEXTURE_EMISSIVE,
+    COOKED_TEXTURE_SPECULAR,
+    COOKED_TEXTURE_SLOT_COUNT
+};
+
+struct CookedHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t meshCount;
+    uint32_t materialCount;
+    uint32_t textureCount;
+    uint32_t reserved;
+
+    // the file we were cooked from, to tell when we're stale
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+
+    // FNV-1a of everything after the header
+    uint64_t contentHash;
+};
+
+struct CookedMeshEntry {
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexType;         // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t materialIndex;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint64_t streamOffsets[COOKED_STREAM_COUNT];
+    uint64_t indexOffset;
+};
+
+struct CookedMaterial {
+    uint32_t type;              // CookedMaterialType
+    float metallic;
+    float roughness;
+    float emissive;
+    int32_t textures[COOKED_TEXTURE_SLOT_COUNT];    // -1 if unused
+};
+
+// the format hint of texels stored as assimp has them, BGRA 8888 top row first
+static const char* const COOKED_TEXTURE_RAW_FORMAT = "bgra8";
+
+// an embedded image file, e.g. a jpg, decoded at load, with the format hint
+// "ktx2" a block compressed texture (see KTX2.h) uploaded as it is, or with
+// COOKED_TEXTURE_RAW_FORMAT uncompressed texels
+struct CookedTexture {
+    uint64_t offset;
+    uint64_t size;
+    char formatHint[8];
+
+    // the image file or texels a ktx2 was compressed from, for contexts that
+    // can't sample its format. sourceSize is 0 if there wasn't one.
+    uint64_t sourceOffset;
+    uint64_t sourceSize;
+    char sourceFormatHint[8];
+
+    // the dimensions of raw texels, whether they're the texture or its
+    // source, and 0 otherwise
+    uint32_t width;
+    uint32_t height;
+};
+
+// color textures are sampled as sRGB, the rest as linear data
+inline bool IsCookedTextureSRGB(uint32_t slot) {
+    return slot == COOKED_TEXTURE_ALBEDO || slot == COOKED_TEXTURE_EMISSIVE;
+}
+
+/**
+ * A cooked model's tables, read back and checked by MeshCooker::Read. Offsets
+ * are into data, which must outlive the view.
+ */
+struct CookedModelView {
+    CookedHeader header;
+    std::vector<CookedMeshEntry> meshes;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedTexture> textures;
+
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+} // namespace gyo
+
+#endif // COOKED_MODEL_H
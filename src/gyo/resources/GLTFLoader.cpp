@@ -0,0 +1,735 @@
+
+#include <gyo/resources/GLTFLoader.h>
+#include <gyo/resources/Resources.h>
+#include <gyo/geometry/Geometry.h>
+#include <gyo/geometry/GeometryOptimizer.h>
+#include <gyo/math/AABB.h>
+#include <gyo/mesh/GeometryPool.h>
+#include <gyo/mesh/Mesh.h>
+#include <gyo/mesh/Model.h>
+#include <gyo/mesh/ModelNode.h>
+#include <gyo/scene/SceneNode.h>
+#include <gyo/shading/GoochMaterial.h>
+#include <gyo/shading/PBRMaterial.h>
+#include <gyo/utilities/Clock.h>
+#include <gyo/utilities/Hash.h>
+#include <gyo/utilities/Json.h>
+#include <gyo/utilities/Log.h>
+#include <gyo/utilities/MappedFile.h>
+
+#include <glad/glad.h>
+
+#include <cstring>
+#include <limits>
+#include <map>
+
+namespace gyo {
+
+static const uint32_t GLB_MAGIC = 0x46546C67;        // "glTF"
+static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;   // "JSON"
+static const uint32_t GLB_CHUNK_BIN = 0x004E4942;    // "BIN\0"
+static const size_t GLB_HEADER_SIZE = 12;
+static const size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+static const int GLTF_MODE_TRIANGLES = 4;
+
+// node hierarchies are checked to be trees, but a deep one could still
+// overflow the stack
+static const int MAX_NODE_DEPTH = 256;
+
+struct GLTFLoader::Document {
+    std::string filePath;
+    bool flipUVs = false;
+
+    MappedFile file;
+    JsonValue json;
+    const unsigned char* bin = nullptr;
+    size_t binSize = 0;
+
+    // by image index and whether it's sRGB, shared by every material using it
+    std::map<std::pair<int, bool>, TextureHandle> textures;
+
+    // by material index, shared by every primitive using it
+    std::map<int, Material*> materials;
+};
+
+/**
+ * An accessor's elements, in place in the binary chunk. glTF component types
+ * are the GL enums.
+ */
+struct GLTFLoader::AccessorView {
+    const unsigned char* data = nullptr;
+    size_t count = 0;
+    size_t stride = 0;      // in bytes
+    GLenum componentType = 0;
+    int components = 0;
+    bool isNormalized = false;
+};
+
+static int GetComponentCount(const std::string& type) {
+    if(type == "SCALAR") return 1;
+    if(type == "VEC2")   return 2;
+    if(type == "VEC3")   return 3;
+    if(type == "VEC4")   return 4;
+    if(type == "MAT2")   return 4;
+    if(type == "MAT3")   return 9;
+    if(type == "MAT4")   return 16;
+    return 0;
+}
+
+static size_t GetComponentSize(GLenum componentType) {
+    switch(componentType) {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:  return 1;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT: return 2;
+        case GL_UNSIGNED_INT:
+        case GL_FLOAT:          return 4;
+        default:                return 0;
+    }
+}
+
+static glm::vec3 ReadVec3(const JsonValue& value, const glm::vec3& fallback) {
+    if(!value.IsArray() || value.Size() < 3) {
+        return fallback;
+    }
+
+    return glm::vec3(value[0].AsFloat(), value[1].AsFloat(), value[2].AsFloat());
+}
+
+// reads the i-th of tightly packed indices of a glTF index component type
+static unsigned int ReadIndex(const unsigned char* data, GLenum componentType, size_t i) {
+    switch(componentType) {
+        case GL_UNSIGNED_BYTE: {
+            return data[i];
+        }
+        case GL_UNSIGNED_SHORT: {
+            uint16_t index;
+            std::memcpy(&index, data + i * sizeof(index), sizeof(index));
+            return index;
+        }
+        default: {
+            uint32_t index;
+            std::memcpy(&index, data + i * sizeof(index), sizeof(index));
+            return index;
+        }
+    }
+}
+
+// copies a float accessor's elements out into a tightly packed vector
+template<typename T>
+static void CopyElements(const unsigned char* data, size_t count, size_t stride, std::vector<T>& out) {
+    out.resize(count);
+    for(size_t i = 0; i < count; i++) {
+        std::memcpy(&out[i], data + i * stride, sizeof(T));
+    }
+}
+
+Model* GLTFLoader::LoadModel(const std::string& filePath, bool flipUVs) {
+    CLOCK(GLB_Load);
+
+    Document doc;
+    if(!OpenDocument(filePath, flipUVs, doc)) {
+        return nullptr;
+    }
+
+    // like assimp's flattened import, node transforms are ignored
+    std::vector<Mesh*> meshes;
+    for(int nodeIndex : GetRootNodes(doc)) {
+        CollectMeshes(doc, nodeIndex, meshes, 0);
+    }
+
+    return new Model(meshes);
+}
+
+SceneNode* GLTFLoader::LoadModelHierarchy(const std::string& filePath, bool flipUVs) {
+    CLOCK(GLB_Hierarchy_Load);
+
+    Document doc;
+    if(!OpenDocument(filePath, flipUVs, doc)) {
+        return nullptr;
+    }
+
+    std::vector<int> rootNodes = GetRootNodes(doc);
+    if(rootNodes.size() == 1) {
+        return ProcessNode(doc, rootNodes[0], 0);
+    }
+
+    // gather multiple roots under one, as assimp does
+    SceneNode* root = new SceneNode();
+    for(int nodeIndex : rootNodes) {
+        root->AddChild(ProcessNode(doc, nodeIndex, 1));
+    }
+
+    return root;
+}
+
+bool GLTFLoader::OpenDocument(const std::string& filePath, bool flipUVs, Document& doc) {
+    doc.filePath = filePath;
+    doc.flipUVs = flipUVs;
+
+    if(!doc.file.Open(filePath)) {
+        return false;
+    }
+
+    const unsigned char* data = doc.file.GetData();
+    const size_t size = doc.file.GetSize();
+
+    auto readU32 = [data](size_t offset) {
+        uint32_t value;
+        std::memcpy(&value, data + offset, sizeof(value));
+        return value;
+    };
+
+    if(size < GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE || readU32(0) != GLB_MAGIC || readU32(4) != 2) {
+        LOGW("%s isn't a glTF 2.0 binary file", filePath.c_str());
+        return false;
+    }
+
+    const size_t length = std::min<size_t>(readU32(8), size);
+
+    // the JSON chunk always comes first, optionally followed by the binary chunk
+    const size_t jsonLength = readU32(GLB_HEADER_SIZE);
+    const size_t jsonOffset = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE;
+
+    if(readU32(GLB_HEADER_SIZE + 4) != GLB_CHUNK_JSON || jsonOffset + jsonLength > length) {
+        LOGW("%s has a malformed JSON chunk", filePath.c_str());
+        return false;
+    }
+
+    if(!JsonValue::Parse(reinterpret_cast<const char*>(data + jsonOffset), jsonLength, doc.json)) {
+        LOGW("Failed to parse the JSON chunk of %s", filePath.c_str());
+        return false;
+    }
+
+    // chunks are padded to 4 bytes
+    const size_t binHeaderOffset = (jsonOffset + jsonLength + 3) & ~size_t(3);
+    if(binHeaderOffset + GLB_CHUNK_HEADER_SIZE <= length && readU32(binHeaderOffset + 4) == GLB_CHUNK_BIN) {
+        doc.bin = data + binHeaderOffset + GLB_CHUNK_HEADER_SIZE;
+        doc.binSize = std::min<size_t>(readU32(binHeaderOffset), length - binHeaderOffset - GLB_CHUNK_HEADER_SIZE);
+    }
+
+    if(!ValidateDocument(doc)) {
+        LOGI("Falling back to assimp for %s", filePath.c_str());
+        return false;
+    }
+
+    const JsonValue& json = doc.json;
+    LOGI("Importing glb '%s' with %zu meshes, %zu materials, and %zu images",
+        filePath.c_str(), json["meshes"].Size(), json["materials"].Size(), json["images"].Size());
+
+    return true;
+}
+
+bool GLTFLoader::ValidateDocument(const Document& doc) {
+    const JsonValue& json = doc.json;
+
+    if(json["asset"]["version"].AsString().rfind("2", 0) != 0) {
+        LOGW("Unsupported glTF version '%s'", json["asset"]["version"].AsString().c_str());
+        return false;
+    }
+
+    if(json["extensionsRequired"].Size() > 0) {
+        LOGW("Unsupported required glTF extension '%s'", json["extensionsRequired"][0].AsString().c_str());
+        return false;
+    }
+
+    // check everything we'll read up front, so building can't fail halfway
+
+    // node hierarchies must be trees, or they'd be walked more than once:
+    // every node has at most one parent, and none is its own ancestor
+    const JsonValue& nodes = json["nodes"];
+    std::vector<int> parents(nodes.Size(), -1);
+    for(size_t n = 0; n < nodes.Size(); n++) {
+        const JsonValue& children = nodes[n]["children"];
+        for(size_t c = 0; c < children.Size(); c++) {
+            const size_t child = children[c].AsSize(nodes.Size());
+            if(child >= nodes.Size() || parents[child] != -1) {
+                LOGW("Node %zu has an invalid or repeated child", n);
+                return false;
+            }
+            parents[child] = static_cast<int>(n);
+        }
+    }
+
+    // with one parent each, any node not reachable from a root is on a cycle
+    std::vector<bool> isVisited(nodes.Size(), false);
+    std::vector<size_t> stack;
+    for(size_t n = 0; n < nodes.Size(); n++) {
+        if(parents[n] == -1) {
+            stack.push_back(n);
+        }
+    }
+    while(!stack.empty()) {
+        const size_t n = stack.back();
+        stack.pop_back();
+        isVisited[n] = true;
+
+        const JsonValue& children = nodes[n]["children"];
+        for(size_t c = 0; c < children.Size(); c++) {
+            stack.push_back(children[c].AsSize());
+        }
+    }
+    for(size_t n = 0; n < nodes.Size(); n++) {
+        if(!isVisited[n]) {
+            LOGW("Node %zu is its own ancestor", n);
+            return false;
+        }
+    }
+
+    // and the scene's roots are distinct nodes without parents
+    const JsonValue& scene = json["scenes"][json["scene"].AsInt(0)];
+    std::vector<bool> isRoot(nodes.Size(), false);
+    for(size_t r = 0; r < scene["nodes"].Size(); r++) {
+        const size_t root = scene["nodes"][r].AsSize(nodes.Size());
+        if(root >= nodes.Size() || parents[root] != -1 || isRoot[root]) {
+            LOGW("Invalid or repeated scene root node");
+            return false;
+        }
+        isRoot[root] = true;
+    }
+
+    static const std::pair<const char*, int> ATTRIBUTES[] = {
+        { "POSITION", 3 }, { "NORMAL", 3 }, { "TEXCOORD_0", 2 }, { "TANGENT", 4 }
+    };
+
+    const JsonValue& meshes = json["meshes"];
+    for(size_t m = 0; m < meshes.Size(); m++) {
+        const JsonValue& primitives = meshes[m]["primitives"];
+
+        for(size_t p = 0; p < primitives.Size(); p++) {
+            const JsonValue& primitive = primitives[p];
+            const JsonValue& attributes = primitive["attributes"];
+
+            if(primitive["mode"].AsInt(GLTF_MODE_TRIANGLES) != GLTF_MODE_TRIANGLES) {
+                LOGW("Unsupported primitive mode %d", primitive["mode"].AsInt());
+                return false;
+            }
+
+            if(!attributes.Has("POSITION")) {
+                LOGW("Primitive without positions");
+                return false;
+            }
+
+            AccessorView view;
+            size_t vertexCount = 0;
+
+            for(const auto& attribute : ATTRIBUTES) {
+                const JsonValue& accessorIndex = attributes[attribute.first];
+                if(accessorIndex.IsNull()) {
+                    continue;
+                }
+
+                if(!ReadAccessor(doc, accessorIndex, view) || view.componentType != GL_FLOAT || view.components != attribute.second) {
+                    LOGW("Unsupported %s accessor", attribute.first);
+                    return false;
+                }
+
+                if(vertexCount != 0 && view.count != vertexCount) {
+                    LOGW("Mismatched attribute counts");
+                    return false;
+                }
+                vertexCount = view.count;
+            }
+
+            if(primitive.Has("indices")) {
+                if(!ReadAccessor(doc, primitive["indices"], view) || view.components != 1 ||
+                    view.stride != GetComponentSize(view.componentType) ||
+                    (view.componentType != GL_UNSIGNED_BYTE && view.componentType != GL_UNSIGNED_SHORT && view.componentType != GL_UNSIGNED_INT)) {
+                    LOGW("Unsupported index accessor");
+                    return false;
+                }
+
+                // the optimizer, tangent generation and the pool all index
+                // straight into the vertices
+                for(size_t i = 0; i < view.count; i++) {
+                    if(ReadIndex(view.data, view.componentType, i) >= vertexCount) {
+                        LOGW("Index out of range of the primitive's %zu vertices", vertexCount);
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool GLTFLoader::ReadBufferView(const Document& doc, int viewIndex, const unsigned char*& data, size_t& length, size_t& stride) {
+    const JsonValue& view = doc.json["bufferViews"][viewIndex];
+    if(view.IsNull()) {
+        return false;
+    }
+
+    // only the binary chunk, which is always buffer 0 and has no uri
+    const int bufferIndex = view["buffer"].AsInt(-1);
+    if(bufferIndex != 0 || doc.json["buffers"][0].Has("uri") || doc.bin == nullptr) {
+        return false;
+    }
+
+    const size_t offset = view["byteOffset"].AsSize(0);
+    length = view["byteLength"].AsSize(0);
+    stride = view["byteStride"].AsSize(0);
+
+    // without overflowing, whatever the file says
+    if(offset > doc.binSize || length > doc.binSize - offset) {
+        return false;
+    }
+
+    data = doc.bin + offset;
+    return true;
+}
+
+bool GLTFLoader::ReadAccessor(const Document& doc, const JsonValue& accessorIndex, AccessorView& out) {
+    const JsonValue& accessor = doc.json["accessors"][accessorIndex.AsInt(-1)];
+    if(accessor.IsNull() || accessor.Has("sparse") || !accessor.Has("bufferView")) {
+        return false;
+    }
+
+    const unsigned char* viewData;
+    size_t viewLength;
+    size_t viewStride;
+    if(!ReadBufferView(doc, accessor["bufferView"].AsInt(-1), viewData, viewLength, viewStride)) {
+        return false;
+    }
+
+    out.componentType = accessor["componentType"].AsInt();
+    out.components = GetComponentCount(accessor["type"].AsString());
+    out.count = accessor["count"].AsSize(0);
+    out.isNormalized = accessor["normalized"].AsBool(false);
+
+    const size_t elementSize = out.components * GetComponentSize(out.componentType);
+    const size_t offset = accessor["byteOffset"].AsSize(0);
+
+    out.stride = viewStride != 0 ? viewStride : elementSize;
+    out.data = viewData + offset;
+
+    // the last element must end within the view, checked without overflowing
+    if(elementSize == 0 || out.count == 0 ||
+        offset > viewLength || elementSize > viewLength - offset ||
+        out.count - 1 > (viewLength - offset - elementSize) / out.stride) {
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<int> GLTFLoader::GetRootNodes(const Document& doc) {
+    const JsonValue& json = doc.json;
+    std::vector<int> rootNodes;
+
+    const JsonValue& scene = json["scenes"][json["scene"].AsInt(0)];
+    if(scene.IsNull()) {
+        // no scenes, so every node that isn't a child is a root
+        std::vector<bool> isChild(json["nodes"].Size(), false);
+        for(size_t n = 0; n < json["nodes"].Size(); n++) {
+            const JsonValue& children = json["nodes"][n]["children"];
+            for(size_t c = 0; c < children.Size(); c++) {
+                size_t child = children[c].AsSize(isChild.size());
+                if(child < isChild.size()) {
+                    isChild[child] = true;
+                }
+            }
+        }
+
+        for(size_t n = 0; n < isChild.size(); n++) {
+            if(!isChild[n]) {
+                rootNodes.push_back(static_cast<int>(n));
+            }
+        }
+    }
+    else {
+        for(size_t n = 0; n < scene["nodes"].Size(); n++) {
+            rootNodes.push_back(scene["nodes"][n].AsInt());
+        }
+    }
+
+    return rootNodes;
+}
+
+void GLTFLoader::CollectMeshes(Document& doc, int nodeIndex, std::vector<Mesh*>& meshes, int depth) {
+    const JsonValue& node = doc.json["nodes"][nodeIndex];
+    if(node.IsNull() || depth > MAX_NODE_DEPTH) {
+        return;
+    }
+
+    if(node.Has("mesh")) {
+        CreateMeshes(doc, node["mesh"].AsInt(), meshes);
+    }
+
+    const JsonValue& children = node["children"];
+    for(size_t c = 0; c < children.Size(); c++) {
+        CollectMeshes(doc, children[c].AsInt(-1), meshes, depth + 1);
+    }
+}
+
+SceneNode* GLTFLoader::ProcessNode(Document& doc, int nodeIndex, int depth) {
+    const JsonValue& node = doc.json["nodes"][nodeIndex];
+    SceneNode* sceneNode = nullptr;
+
+    std::vector<Mesh*> meshes;
+    if(node.Has("mesh")) {
+        CreateMeshes(doc, node["mesh"].AsInt(), meshes);
+    }
+
+    if(!meshes.empty()) {
+        sceneNode = new ModelNode(new Model(meshes));
+    }
+    else {
+        sceneNode = new SceneNode();
+    }
+
+    // the node's transform is relative to its parent, either as a matrix or TRS
+    const JsonValue& matrix = node["matrix"];
+    if(matrix.Size() == 16) {
+        glm::mat4 m;
+        for(int i = 0; i < 16; i++) {
+            m[i / 4][i % 4] = matrix[i].AsFloat();
+        }
+
+        glm::vec3 scale(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+
+        // a mirrored node keeps its reflection in the scale, so what's left
+        // is a proper rotation
+        if(glm::determinant(glm::mat3(m)) < 0.0f) {
+            scale.x = -scale.x;
+        }
+
+        glm::mat3 rotation;
+        for(int c = 0; c < 3; c++) {
+            rotation[c] = glm::vec3(m[c]) / scale[c];
+        }
+
+        sceneNode->SetPosition(glm::vec3(m[3]));
+        sceneNode->SetRotation(glm::quat_cast(rotation));
+        sceneNode->SetScale(scale);
+    }
+    else {
+        const JsonValue& rotation = node["rotation"];
+
+        sceneNode->SetPosition(ReadVec3(node["translation"], glm::vec3(0.0f)));
+        if(rotation.Size() == 4) {
+            // glTF stores x, y, z, w
+            sceneNode->SetRotation(glm::fquat(rotation[3].AsFloat(), rotation[0].AsFloat(), rotation[1].AsFloat(), rotation[2].AsFloat()));
+        }
+        sceneNode->SetScale(ReadVec3(node["scale"], glm::vec3(1.0f)));
+    }
+
+    const JsonValue& children = node["children"];
+    if(depth < MAX_NODE_DEPTH) {
+        for(size_t c = 0; c < children.Size(); c++) {
+            sceneNode->AddChild(ProcessNode(doc, children[c].AsInt(-1), depth + 1));
+        }
+    }
+
+    return sceneNode;
+}
+
+void GLTFLoader::CreateMeshes(Document& doc, int meshIndex, std::vector<Mesh*>& meshes) {
+    const JsonValue& primitives = doc.json["meshes"][meshIndex]["primitives"];
+
+    LOGD("Processing glb mesh '%s' with %zu primitives",
+        doc.json["meshes"][meshIndex]["name"].AsString().c_str(), primitives.Size());
+
+    for(size_t p = 0; p < primitives.Size(); p++) {
+        meshes.push_back(CreateMesh(doc, meshIndex, static_cast<int>(p)));
+    }
+}
+
+Mesh* GLTFLoader::CreateMesh(Document& doc, int meshIndex, int primitiveIndex) {
+    const JsonValue& primitive = doc.json["meshes"][meshIndex]["primitives"][primitiveIndex];
+    const JsonValue& attributes = primitive["attributes"];
+
+    // everything here was checked by ValidateDocument
+    AccessorView positions, normals, texCoords, tangents, indices;
+    ReadAccessor(doc, attributes["POSITION"], positions);
+    bool hasNormals = ReadAccessor(doc, attributes["NORMAL"], normals);
+    bool hasTexCoords = ReadAccessor(doc, attributes["TEXCOORD_0"], texCoords);
+    bool hasTangents = ReadAccessor(doc, attributes["TANGENT"], tangents);
+    bool hasIndices = ReadAccessor(doc, primitive["indices"], indices);
+
+    // primitives using the same material share it, as do any that look the same
+    const int materialIndex = primitive["material"].AsInt(-1);
+    Material*& material = doc.materials[materialIndex];
+    if(material == nullptr) {
+        material = Resources::ShareMaterial(CreateMaterial(doc, materialIndex));
+    }
+
+    const size_t vertexCount = positions.count;
+
+    // upload straight from the file when there's nothing to fill in or change
+    if(hasNormals && hasTangents && hasIndices && !(hasTexCoords && doc.flipUVs)) {
+        // positions must have bounds, but check anyway
+        const JsonValue& accessor = doc.json["accessors"][attributes["POSITION"].AsInt()];
+        AABB bounds = {
+            ReadVec3(accessor["min"], glm::vec3(std::numeric_limits<float>::max())),
+            ReadVec3(accessor["max"], glm::vec3(std::numeric_limits<float>::lowest()))
+        };
+
+        if(!accessor.Has("min") || !accessor.Has("max")) {
+            for(size_t v = 0; v < vertexCount; v++) {
+                glm::vec3 position;
+                std::memcpy(&position, positions.data + v * positions.stride, sizeof(position));
+                bounds.min = glm::min(bounds.min, position);
+                bounds.max = glm::max(bounds.max, position);
+            }
+        }
+
+        GeometrySource source;
+        source.streams[0] = { positions.data, vertexCount, positions.stride };
+        source.streams[1] = { normals.data, normals.count, normals.stride };
+        source.streams[3] = { tangents.data, tangents.count, tangents.stride };
+        if(hasTexCoords) {
+            source.streams[2] = { texCoords.data, texCoords.count, texCoords.stride };
+        }
+        // reorder a copy of just the indices, as importing would, since the
+        // vertices can stay where they are without their fetch reordered
+        std::vector<unsigned int> optimizedIndices(indices.count);
+        for(size_t i = 0; i < indices.count; i++) {
+            optimizedIndices[i] = ReadIndex(indices.data, indices.componentType, i);
+        }
+        GeometryOptimizer::OptimizeVertexCacheAndOverdraw(optimizedIndices, positions.data, positions.stride, vertexCount);
+
+        source.vertexCount = vertexCount;
+        source.indices = optimizedIndices.data();
+        source.indexCount = optimizedIndices.size();
+        source.indexType = GL_UNSIGNED_INT;
+
+        // the same accessors always hold the same data
+        uint64_t geometryKey = hash_bytes(doc.filePath.data(), doc.filePath.size());
+        geometryKey = hash_bytes(&meshIndex, sizeof(meshIndex), geometryKey);
+        geometryKey = hash_bytes(&primitiveIndex, sizeof(primitiveIndex), geometryKey);
+
+        return new Mesh(source, bounds, geometryKey, material);
+    }
+
+    // otherwise copy out what we have, and let the mesh compute its tangents
+
+    Geometry* geo = new Geometry();
+
+    CopyElements(positions.data, vertexCount, positions.stride, geo->positions);
+
+    if(hasNormals) {
+        CopyElements(normals.data, vertexCount, normals.stride, geo->normals);
+    }
+    else {
+        LOGW("glb primitive has no normals");
+        geo->normals.assign(vertexCount, glm::vec3(0.0f));
+    }
+
+    if(hasTexCoords) {
+        CopyElements(texCoords.data, vertexCount, texCoords.stride, geo->texCoords);
+        if(doc.flipUVs) {
+            for(glm::vec2& texCoord : geo->texCoords) {
+                texCoord.y = 1.0f - texCoord.y;
+            }
+        }
+    }
+    else {
+        geo->texCoords.assign(vertexCount, glm::vec2(0.0f));
+    }
+
+    if(hasTangents) {
+        CopyElements(tangents.data, vertexCount, tangents.stride, geo->tangents);
+    }
+
+    if(hasIndices) {
+        geo->indices.resize(indices.count);
+        for(size_t i = 0; i < indices.count; i++) {
+            geo->indices[i] = ReadIndex(indices.data, indices.componentType, i);
+        }
+    }
+    else {
+        geo->indices.resize(vertexCount);
+        for(size_t i = 0; i < vertexCount; i++) {
+            geo->indices[i] = static_cast<unsigned int>(i);
+        }
+    }
+
+    // reorder for the vertex cache, overdraw, and vertex fetch
+    GeometryOptimizer::Optimize(*geo);
+
+    return new Mesh(geo, material);
+}
+
+Material* GLTFLoader::CreateMaterial(Document& doc, int materialIndex) {
+    const JsonValue& material = doc.json["materials"][materialIndex];
+    if(material.IsNull()) {
+        return new GoochMaterial();
+    }
+
+    const JsonValue& pbr = material["pbrMetallicRoughness"];
+
+    glm::vec3 albedo = ReadVec3(pbr["baseColorFactor"], glm::vec3(1.0f));
+    float metallic = pbr["metallicFactor"].AsFloat(1.0f);
+    float roughness = pbr["roughnessFactor"].AsFloat(1.0f);
+    glm::vec3 emissive = ReadVec3(material["emissiveFactor"], glm::vec3(0.0f));
+
+    TextureHandle albedoMap = LoadTexture(doc, pbr["baseColorTexture"], true);
+    TextureHandle metallicRoughnessMap = LoadTexture(doc, pbr["metallicRoughnessTexture"], false);
+    TextureHandle normalMap = LoadTexture(doc, material["normalTexture"], false);
+    TextureHandle aoMap = LoadTexture(doc, material["occlusionTexture"], false);
+    TextureHandle emissiveMap = LoadTexture(doc, material["emissiveTexture"], true);
+
+    return new PBRMaterial(
+        true,
+        albedo,
+        metallic,
+        roughness,
+        1.0,
+        emissive,
+        albedoMap,
+        normalMap,
+        nullptr,
+        nullptr,
+        metallicRoughnessMap,
+        aoMap,
+        emissiveMap
+    );
+}
+
+TextureHandle GLTFLoader::LoadTexture(Document& doc, const JsonValue& textureInfo, bool srgb) {
+    if(textureInfo.IsNull()) {
+        return nullptr;
+    }
+
+    const JsonValue& texture = doc.json["textures"][textureInfo["index"].AsInt(-1)];
+    const int imageIndex = texture["source"].AsInt(-1);
+    const JsonValue& image = doc.json["images"][imageIndex];
+
+    if(image.IsNull()) {
+        LOGW("Texture without an image");
+        return nullptr;
+    }
+
+    auto it = doc.textures.find({ imageIndex, srgb });
+    if(it != doc.textures.end()) {
+        return it->second;
+    }
+
+    TextureHandle result;
+
+    const unsigned char* data;
+    size_t length;
+    size_t stride;
+
+    if(!image.Has("bufferView")) {
+        // FIXME: as with assimp, referenced textures aren't loaded yet
+        LOGD(" Found referenced texture '%s'", image["uri"].AsString().c_str());
+    }
+    else if(ReadBufferView(doc, image["bufferView"].AsInt(-1), data, length, stride)) {
+        const std::string& mimeType = image["mimeType"].AsString();
+        std::string formatHint = mimeType.rfind("image/", 0) == 0 ? mimeType.substr(6) : mimeType;
+
+        LOGD(" Loading embedded %s texture %d, %zu bytes", formatHint.c_str(), imageIndex, length);
+        result = Resources::AcquireCompressedTexture(data, length, formatHint, srgb);
+    }
+    else {
+        LOGW("Invalid buffer view for image %d", imageIndex);
+    }
+
+    doc.textures[{ imageIndex, srgb }] = result;
+    return result;
+}
+
+} // namespace gyo
@@ -0,0 +1,60 @@
+#ifndef GLTF_LOADER_H
+#define GLTF_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include <gyo/resources/ResourceHandle.h>
+
+namespace gyo {
+
+class JsonValue;
+class Material;
+class Mesh;
+class Model;
+class SceneNode;
+class Texture2D;
+
+/**
+ * Loads binary glTF (.glb) files without assimp. The file is memory mapped,
+ * and accessors are read in place from its binary chunk. Primitives that
+ * already have normals and tangents have their vertices uploaded straight
+ * from the mapping, with only their indices reordered for the vertex cache.
+ * The rest go through a Geometry to fill in what's missing.
+ *
+ * Files needing anything we don't support, like sparse accessors, required
+ * extensions, external buffers, or non-triangle primitives, return nullptr so
+ * the caller can fall back to assimp.
+ */
+class GLTFLoader {
+public:
+    static Model* LoadModel(const std::string& filePath, bool flipUVs);
+
+    /**
+     * Same as above, except the file's node hierarchy and local transforms
+     * are kept. Nodes with meshes become ModelNodes, the rest plain SceneNodes.
+     */
+    static SceneNode* LoadModelHierarchy(const std::string& filePath, bool flipUVs);
+
+private:
+    struct Document;
+    struct AccessorView;
+
+    static bool OpenDocument(const std::string& filePath, bool flipUVs, Document& doc);
+    static bool ValidateDocument(const Document& doc);
+    static bool ReadAccessor(const Document& doc, const JsonValue& accessorIndex, AccessorView& out);
+    static bool ReadBufferView(const Document& doc, int viewIndex, const unsigned char*& data, size_t& length, size_t& stride);
+
+    static std::vector<int> GetRootNodes(const Document& doc);
+    static void CollectMeshes(Document& doc, int nodeIndex, std::vector<Mesh*>& meshes, int depth);
+    static SceneNode* ProcessNode(Document& doc, int nodeIndex, int depth);
+
+    static void CreateMeshes(Document& doc, int meshIndex, std::vector<Mesh*>& meshes);
+    static Mesh* CreateMesh(Document& doc, int meshIndex, int primitiveIndex);
+    static Material* CreateMaterial(Document& doc, int materialIndex);
+    static TextureHandle LoadTexture(Document& doc, const JsonValue& textureInfo, bool srgb);
+};
+
+} // namespace gyo
+
+#endif // GLTF_LOADER_H
@@ -4,6 +4,7 @@
 #include <gyo/geometry/InvertedCube.h>
 #include <gyo/geometry/Quad.h>
 #include <gyo/mesh/Mesh.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/shading/IBLEnvironment.h>
 #include <gyo/shading/Shader.h>
 #include <gyo/shading/ShaderMaterial.h>
@@ -27,8 +28,7 @@ IBLEnvironmentLoader::IBLEnvironmentLoader() {
     glGenRenderbuffers(1, &captureRBO);
     glCheckError();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
@@ -38,8 +38,7 @@ IBLEnvironmentLoader::IBLEnvironmentLoader() {
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // our 6 cube face directions for rendering
 
@@ -115,8 +114,7 @@ IBLEnvironmentLoader::IBLEnvironmentLoader() {
 }
 
 IBLEnvironmentLoader::~IBLEnvironmentLoader() {
-    glDeleteFramebuffers(1, &captureFBO);
-    glCheckError();
+    RenderState::DeleteFramebuffer(captureFBO);
     glDeleteRenderbuffers(1, &captureRBO);
     glCheckError();
 
@@ -135,8 +133,7 @@ TextureCube IBLEnvironmentLoader::GetCubemap(Texture2D* hdrTexture) {
 
     // bind our frame buffer
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
@@ -161,8 +158,7 @@ TextureCube IBLEnvironmentLoader::GetCubemap(Texture2D* hdrTexture) {
 
     // unbind our framebuffer, and restore our initial viewport
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(vp[0],vp[1], vp[2], vp[3]);
     glCheckError();
 
@@ -182,8 +178,7 @@ TextureCube IBLEnvironmentLoader::GetIrradianceMap(TextureCube* cubeMap) {
 
     // bind our frame buffer
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
@@ -198,8 +193,7 @@ TextureCube IBLEnvironmentLoader::GetIrradianceMap(TextureCube* cubeMap) {
 
     // unbind our framebuffer, and restore our initial viewport
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(vp[0],vp[1], vp[2], vp[3]);
     glCheckError();
 
@@ -215,8 +209,7 @@ TextureCube IBLEnvironmentLoader::GetPrefilteredEnvMap(TextureCube* cubeMap) {
 
     // bind our frame buffer
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
@@ -232,8 +225,7 @@ TextureCube IBLEnvironmentLoader::GetPrefilteredEnvMap(TextureCube* cubeMap) {
 
     // unbind our framebuffer, and restore our initial viewport
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(vp[0],vp[1], vp[2], vp[3]);
     glCheckError();
 
@@ -249,8 +241,7 @@ Texture2D IBLEnvironmentLoader::GetBRDFLUT() {
 
     // bind our frame buffer
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
     glBindRenderbuffer(GL_RENDERBUFFER, captureRBO);
     glCheckError();
 
@@ -260,8 +251,7 @@ Texture2D IBLEnvironmentLoader::GetBRDFLUT() {
 
     // unbind our framebuffer, and restore our initial viewport
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, 0);
     glViewport(vp[0],vp[1], vp[2], vp[3]);
     glCheckError();
 
@@ -315,8 +305,7 @@ TextureCube IBLEnvironmentLoader::RenderTexCube(const Shader& captureShader, uns
     unsigned int texId;
     glGenTextures(1, &texId);
     glCheckError();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texId);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_CUBE_MAP, texId);
     for(unsigned int i = 0; i < 6; i++) {
         // store each face with a floating point value
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, nullptr);
@@ -344,8 +333,7 @@ TextureCube IBLEnvironmentLoader::RenderTexCube(const Shader& captureShader, uns
     
     glViewport(0, 0, size, size);
     glCheckError();
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 
     // now capture the faces
 
@@ -370,8 +358,7 @@ TextureCube IBLEnvironmentLoader::RenderPrefilteredTexCube(const Shader& capture
     unsigned int texId;
     glGenTextures(1, &texId);
     glCheckError();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, texId);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_CUBE_MAP, texId);
     for (unsigned int i = 0; i < 6; ++i) {
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, size, size, 0, GL_RGB, GL_FLOAT, nullptr);
         glCheckError();
@@ -400,8 +387,7 @@ TextureCube IBLEnvironmentLoader::RenderPrefilteredTexCube(const Shader& capture
 
     captureShader.SetFloat("maxLuminance", medianHDRLuminance * 50);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, captureFBO);
-    glCheckError();
+    RenderState::BindFramebuffer(GL_FRAMEBUFFER, captureFBO);
 
     // now capture the faces
 
@@ -446,7 +432,7 @@ Texture2D IBLEnvironmentLoader::PreComputeBRDFLUT(unsigned int size) {
 
     unsigned int brdfLUTTexture;
     glGenTextures(1, &brdfLUTTexture);
-    glBindTexture(GL_TEXTURE_2D, brdfLUTTexture);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, brdfLUTTexture);
 
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, size, size, 0, GL_RG, GL_FLOAT, 0);
 
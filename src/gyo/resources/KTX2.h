@@ -0,0 +1,112 @@
+#ifndef KTX2_H
+#define KTX2_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * The parts of the KTX 2.0 container we write and read, for block compressed
+ * 2D textures with a full mip chain. Everything is little-endian:
+ *
+ *  KTX2Header
+ *  KTX2LevelIndex[levelCount], largest level first
+ *  data format descriptor, one basic block
+ *  key/value data, sorted by key
+ *  the levels themselves, smallest first, each aligned to its block size
+ *
+ * No supercompression, arrays, cube maps or 3D textures.
+ */
+
+static const unsigned char KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const char* const KTX2_EXTENSION = "ktx2";
+
+// the VkFormats we use
+enum KTX2Format : uint32_t {
+    KTX2_FORMAT_BC1_RGB_UNORM = 131,
+    KTX2_FORMAT_BC1_RGB_SRGB = 132,
+    KTX2_FORMAT_BC3_UNORM = 137,
+    KTX2_FORMAT_BC3_SRGB = 138,
+    KTX2_FORMAT_BC4_UNORM = 139,
+    KTX2_FORMAT_BC5_UNORM = 141,
+    KTX2_FORMAT_BC7_UNORM = 145,
+    KTX2_FORMAT_BC7_SRGB = 146
+};
+
+struct KTX2Header {
+    unsigned char identifier[12];
+    uint32_t vkFormat;
+    uint32_t typeSize;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t layerCount;
+    uint32_t faceCount;
+    uint32_t levelCount;
+    uint32_t supercompressionScheme;
+
+    uint32_t dfdByteOffset;
+    uint32_t dfdByteLength;
+    uint32_t kvdByteOffset;
+    uint32_t kvdByteLength;
+    uint64_t sgdByteOffset;
+    uint64_t sgdByteLength;
+};
+
+struct KTX2LevelIndex {
+    uint64_t byteOffset;
+    uint64_t byteLength;
+    uint64_t uncompressedByteLength;
+};
+
+// bytes per 4x4 block, 0 if we don't know the format
+inline size_t GetKTX2BlockSize(uint32_t vkFormat) {
+    switch(vkFormat) {
+        case KTX2_FORMAT_BC1_RGB_UNORM:
+        case KTX2_FORMAT_BC1_RGB_SRGB:
+        case KTX2_FORMAT_BC4_UNORM:
+            return 8;
+        case KTX2_FORMAT_BC3_UNORM:
+        case KTX2_FORMAT_BC3_SRGB:
+        case KTX2_FORMAT_BC5_UNORM:
+        case KTX2_FORMAT_BC7_UNORM:
+        case KTX2_FORMAT_BC7_SRGB:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+inline bool IsKTX2FormatSRGB(uint32_t vkFormat) {
+    return vkFormat == KTX2_FORMAT_BC1_RGB_SRGB || vkFormat == KTX2_FORMAT_BC3_SRGB || vkFormat == KTX2_FORMAT_BC7_SRGB;
+}
+
+// the size of one level, in whole blocks
+inline size_t GetKTX2LevelSize(uint32_t vkFormat, uint32_t width, uint32_t height) {
+    return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * GetKTX2BlockSize(vkFormat);
+}
+
+/**
+ * A block compressed texture, read back and checked by TextureCooker::Read.
+ * Levels point into the data read from, which must outlive the view.
+ */
+struct KTX2View {
+    uint32_t vkFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    // what each channel samples as, from "rgba01", e.g. "0rg1"
+    char swizzle[4] = { 'r', 'g', 'b', 'a' };
+
+    struct Level {
+        const unsigned char* data;
+        size_t size;
+    };
+    std::vector<Level> levels;  // largest first
+};
+
+} // namespace gyo
+
+#endif // KTX2_H
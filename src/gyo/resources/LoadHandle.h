@@ -0,0 +1,87 @@
+#ifndef LOAD_HANDLE_H
+#define LOAD_HANDLE_H
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace gyo {
+
+enum class LoadStatus {
+    Pending,
+    Ready,
+    Failed
+};
+
+/**
+ * Tracks a resource loading in the background, and copies of a handle track
+ * the same load. Handles live on the main thread: their status only changes
+ * from Resources::ProcessUploads, which also calls their callbacks.
+ */
+template<typename T>
+class LoadHandle {
+public:
+    typedef std::function<void(T*)> Callback;
+
+    LoadHandle() {}
+
+    bool IsValid() const { return state != nullptr; }
+    bool IsPending() const { return state && state->status == LoadStatus::Pending; }
+    bool IsReady() const { return state && state->status == LoadStatus::Ready; }
+    bool HasFailed() const { return state && state->status == LoadStatus::Failed; }
+
+    // null until ready
+    T* Get() const { return state ? state->resource : nullptr; }
+
+    /**
+     * Calls callback with the resource once it's ready, or with nullptr if it
+     * failed. If the load has already finished, it's called straight away.
+     */
+    void OnLoaded(Callback callback) const {
+        if(!state) {
+            return;
+        }
+
+        if(state->status == LoadStatus::Pending) {
+            state->callbacks.push_back(std::move(callback));
+        }
+        else {
+            callback(state->resource);
+        }
+    }
+
+private:
+    friend class AsyncLoader;
+    friend class Resources;
+
+    struct State {
+        LoadStatus status = LoadStatus::Pending;
+        T* resource = nullptr;
+        std::vector<Callback> callbacks;
+    };
+
+    std::shared_ptr<State> state;
+
+    static LoadHandle Create() {
+        LoadHandle handle;
+        handle.state = std::make_shared<State>();
+        return handle;
+    }
+
+    // a null resource means the load failed
+    void Resolve(T* resource) const {
+        state->resource = resource;
+        state->status = resource != nullptr ? LoadStatus::Ready : LoadStatus::Failed;
+
+        std::vector<Callback> callbacks = std::move(state->callbacks);
+        state->callbacks.clear();
+        for(const Callback& callback : callbacks) {
+            callback(resource);
+        }
+    }
+};
+
+} // namespace gyo
+
+#endif // LOAD_HANDLE_H
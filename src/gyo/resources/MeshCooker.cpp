@@ -0,0 +1,516 @@
+
+#include <gyo/resources/MeshCooker.h>
+#include <gyo/resources/CookedModel.h>
+#include <gyo/resources/KTX2.h>
+#include <gyo/resources/ModelLoader.h>
+#include <gyo/resources/TextureLoader.h>
+#include <gyo/geometry/Geometry.h>
+#include <gyo/geometry/GeometryOptimizer.h>
+#include <gyo/utilities/Clock.h>
+#include <gyo/utilities/Hash.h>
+#include <gyo/utilities/Log.h>
+
+#include <glad/glad.h>
+
+#include <assimp/Importer.hpp>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * Accumulates the data blocks of a cooked file, each aligned, at offsets
+ * relative to where the data starts
+ */
+class CookedDataWriter {
+public:
+    uint64_t Append(const void* data, size_t size) {
+        const size_t offset = (bytes.size() + COOKED_DATA_ALIGNMENT - 1) / COOKED_DATA_ALIGNMENT * COOKED_DATA_ALIGNMENT;
+        bytes.resize(offset + size);
+        if(size > 0) {
+            std::memcpy(bytes.data() + offset, data, size);
+        }
+
+        return offset;
+    }
+
+    template<typename T>
+    uint64_t Append(const std::vector<T>& elements) {
+        return Append(elements.data(), elements.size() * sizeof(T));
+    }
+
+    const std::vector<unsigned char>& GetBytes() const { return bytes; }
+
+private:
+    std::vector<unsigned char> bytes;
+};
+
+/**
+ * Everything we gather from the scene before laying the file out
+ */
+struct CookedScene {
+    std::vector<CookedMeshEntry> meshes;
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedTexture> textures;
+    CookedDataWriter data;
+
+    TextureCompression compression = TextureCompression::NONE;
+
+    // each aiMesh is cooked once, however many nodes use it, and each texture
+    // once for each way it's sampled
+    std::map<unsigned int, size_t> cookedMeshes;
+    std::map<std::pair<const aiTexture*, TextureKind>, int32_t> cookedTextures;
+
+    // the offset of each image file kept to fall back on, however it's sampled
+    std::map<const aiTexture*, uint64_t> sourceOffsets;
+};
+
+// how each slot is sampled by the materials ModelLoader creates
+static TextureKind GetTextureKind(CookedTextureSlot slot) {
+    switch(slot) {
+        case COOKED_TEXTURE_ALBEDO:
+        case COOKED_TEXTURE_EMISSIVE:
+            return TextureKind::COLOR;
+        case COOKED_TEXTURE_NORMAL:
+            return TextureKind::NORMAL;
+        case COOKED_TEXTURE_METALLIC_ROUGHNESS:
+            return TextureKind::METALLIC_ROUGHNESS;
+        case COOKED_TEXTURE_SPECULAR:
+            return TextureKind::LINEAR_COLOR;
+        default:
+            return TextureKind::GRAYSCALE;
+    }
+}
+
+static int32_t CookTexture(aiMaterial* material, aiTextureType type, CookedTextureSlot slot, const aiScene* scene, CookedScene& cooked) {
+    aiString path;
+    if(material->GetTextureCount(type) == 0 || material->GetTexture(type, 0, &path) != AI_SUCCESS) {
+        return -1;
+    }
+
+    const aiTexture* texture = scene->GetEmbeddedTexture(path.C_Str());
+    if(texture == nullptr) {
+        // referenced textures aren't supported yet
+        LOGW("Skipping unsupported texture '%s'", path.C_Str());
+        return -1;
+    }
+
+    const TextureKind kind = GetTextureKind(slot);
+
+    auto it = cooked.cookedTextures.find({ texture, kind });
+    if(it != cooked.cookedTextures.end()) {
+        return it->second;
+    }
+
+    // the image file as it is, or else assimp's texels, byte for byte so
+    // they're cached by the same content hash as on import
+    const bool isRaw = texture->mHeight != 0;
+    const char* imageFormatHint = isRaw ? COOKED_TEXTURE_RAW_FORMAT : texture->achFormatHint;
+    const uint64_t imageSize = isRaw ?
+        uint64_t(texture->mWidth) * texture->mHeight * sizeof(aiTexel) :
+        texture->mWidth;
+
+    CookedTexture entry = {};
+    if(isRaw) {
+        entry.width = texture->mWidth;
+        entry.height = texture->mHeight;
+    }
+
+    if(cooked.compression != TextureCompression::NONE) {
+        // decoded as the runtime would, top row first, then compressed with its mips
+        DecodedImage image;
+        std::vector<unsigned char> compressed;
+        const bool isCompressed =
+            TextureLoader::DecodeEmbeddedImage(texture, image) &&
+            TextureCooker::CookToMemory(image, kind, cooked.compression, false, "", compressed);
+        image.Free();
+
+        if(!isCompressed) {
+            LOGW("Skipping texture '%s', which couldn't be compressed", path.C_Str());
+            return -1;
+        }
+
+        entry.offset = cooked.data.Append(compressed);
+        entry.size = compressed.size();
+        std::strncpy(entry.formatHint, KTX2_EXTENSION, sizeof(entry.formatHint) - 1);
+
+        // keep the image too, to fall back on
+        auto source = cooked.sourceOffsets.find(texture);
+        if(source == cooked.sourceOffsets.end()) {
+            source = cooked.sourceOffsets.emplace(texture, cooked.data.Append(texture->pcData, imageSize)).first;
+        }
+
+        entry.sourceOffset = source->second;
+        entry.sourceSize = imageSize;
+        std::strncpy(entry.sourceFormatHint, imageFormatHint, sizeof(entry.sourceFormatHint) - 1);
+    }
+    else {
+        entry.offset = cooked.data.Append(texture->pcData, imageSize);
+        entry.size = imageSize;
+        std::strncpy(entry.formatHint, imageFormatHint, sizeof(entry.formatHint) - 1);
+    }
+
+    const int32_t index = static_cast<int32_t>(cooked.textures.size());
+    cooked.textures.push_back(entry);
+    cooked.cookedTextures[{ texture, kind }] = index;
+
+    return index;
+}
+
+static void CookMesh(aiMesh* mesh, CookedScene& cooked, CookedMeshEntry& entry) {
+    const unsigned int vertexCount = mesh->mNumVertices;
+
+    Geometry geometry;
+    geometry.positions.reserve(vertexCount);
+    geometry.normals.reserve(vertexCount);
+    geometry.texCoords.reserve(vertexCount);
+
+    for(unsigned int i = 0; i < vertexCount; i++) {
+        geometry.positions.emplace_back(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
+
+        if(mesh->mNormals) {
+            geometry.normals.emplace_back(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
+        }
+        else {
+            geometry.normals.emplace_back(0.0f);
+        }
+
+        // NOTE we're only using the first set of tex coords for now
+        if(mesh->mTextureCoords[0]) {
+            geometry.texCoords.emplace_back(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
+        }
+        else {
+            geometry.texCoords.emplace_back(0.0f);
+        }
+    }
+
+    if(mesh->mTangents) {
+        geometry.tangents.reserve(vertexCount);
+        for(unsigned int i = 0; i < vertexCount; i++) {
+            geometry.tangents.emplace_back(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
+        }
+    }
+
+    for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
+        const aiFace& face = mesh->mFaces[i];
+        for(unsigned int j = 0; j < face.mNumIndices; j++) {
+            geometry.indices.push_back(face.mIndices[j]);
+        }
+    }
+
+    // everything Mesh would otherwise do at load
+    if(geometry.tangents.empty()) {
+        geometry.ComputeTangents();
+    }
+
+    GeometryOptimizer::Optimize(geometry);
+
+    glm::vec3 minPoint(std::numeric_limits<float>::max());
+    glm::vec3 maxPoint(std::numeric_limits<float>::lowest());
+    for(const glm::vec3& position : geometry.positions) {
+        minPoint = glm::min(minPoint, position);
+        maxPoint = glm::max(maxPoint, position);
+    }
+
+    entry.vertexCount = vertexCount;
+    entry.indexCount = static_cast<uint32_t>(geometry.indices.size());
+    for(int i = 0; i < 3; i++) {
+        entry.boundsMin[i] = minPoint[i];
+        entry.boundsMax[i] = maxPoint[i];
+    }
+
+    entry.streamOffsets[0] = cooked.data.Append(geometry.positions);
+    entry.streamOffsets[1] = cooked.data.Append(geometry.normals);
+    entry.streamOffsets[2] = cooked.data.Append(geometry.texCoords);
+    entry.streamOffsets[3] = cooked.data.Append(geometry.tangents);
+
+    // match the index type the geometry pool would pick
+    if(vertexCount <= 0x10000) {
+        std::vector<uint16_t> shortIndices(geometry.indices.begin(), geometry.indices.end());
+        entry.indexType = GL_UNSIGNED_SHORT;
+        entry.indexOffset = cooked.data.Append(shortIndices);
+    }
+    else {
+        entry.indexType = GL_UNSIGNED_INT;
+        entry.indexOffset = cooked.data.Append(geometry.indices);
+    }
+}
+
+static void CookNode(aiNode* node, const aiScene* scene, CookedScene& cooked) {
+    for(unsigned int i = 0; i < node->mNumMeshes; i++) {
+        const unsigned int meshIndex = node->mMeshes[i];
+
+        auto it = cooked.cookedMeshes.find(meshIndex);
+        if(it != cooked.cookedMeshes.end()) {
+            cooked.meshes.push_back(cooked.meshes[it->second]);
+            continue;
+        }
+
+        aiMesh* mesh = scene->mMeshes[meshIndex];
+
+        CookedMeshEntry entry = {};
+        entry.materialIndex = mesh->mMaterialIndex;
+        CookMesh(mesh, cooked, entry);
+
+        cooked.cookedMeshes[meshIndex] = cooked.meshes.size();
+        cooked.meshes.push_back(entry);
+    }
+
+    for(unsigned int i = 0; i < node->mNumChildren; i++) {
+        CookNode(node->mChildren[i], scene, cooked);
+    }
+}
+
+bool MeshCooker::Cook(const std::string& sourcePath, const std::string& cookedPath, bool flipUVs, TextureCompression compression) {
+    std::vector<unsigned char> cooked;
+    if(!CookToMemory(sourcePath, flipUVs, cooked, compression)) {
+        return false;
+    }
+
+    std::ofstream file(cookedPath, std::ios::binary | std::ios::trunc);
+    if(!file) {
+        LOGE("Failed to open %s for writing", cookedPath.c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(cooked.data()), cooked.size());
+
+    if(!file) {
+        LOGE("Failed to write %s", cookedPath.c_str());
+        return false;
+    }
+
+    LOGI("Wrote %s, %zu bytes", cookedPath.c_str(), cooked.size());
+
+    return true;
+}
+
+bool MeshCooker::CookToMemory(const std::string& sourcePath, bool flipUVs, std::vector<unsigned char>& out, TextureCompression compression) {
+    LOGI("Cooking %s", sourcePath.c_str());
+    CLOCK(Model_Cook);
+
+    CookedHeader header = {};
+    std::memcpy(header.magic, GYOMESH_MAGIC, sizeof(header.magic));
+    header.version = GYOMESH_VERSION;
+    header.flags = flipUVs ? COOKED_FLAG_FLIP_UVS : 0U;
+
+    if(!GetSourceStamp(sourcePath, header.sourceSize, header.sourceModifiedTime)) {
+        LOGE("Failed to read %s", sourcePath.c_str());
+        return false;
+    }
+
+    // the same import flags as ModelLoader
+    unsigned int flags = aiProcess_Triangulate | aiProcess_CalcTangentSpace;
+    if(flipUVs) {
+        flags |= aiProcess_FlipUVs;
+    }
+
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(sourcePath, flags);
+
+    if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        LOGE("Import error: %s", importer.GetErrorString());
+        return false;
+    }
+
+    CookedScene cooked;
+    cooked.compression = compression;
+
+    for(unsigned int i = 0; i < scene->mNumMaterials; i++) {
+        aiMaterial* material = scene->mMaterials[i];
+        cooked.materials.push_back(ModelLoader::SelectMaterial(material, [&](aiTextureType type, CookedTextureSlot slot) {
+            return CookTexture(material, type, slot, scene, cooked);
+        }));
+    }
+
+    CookNode(scene->mRootNode, scene, cooked);
+
+    header.meshCount = static_cast<uint32_t>(cooked.meshes.size());
+    header.materialCount = static_cast<uint32_t>(cooked.materials.size());
+    header.textureCount = static_cast<uint32_t>(cooked.textures.size());
+
+    // lay out the tables, then rebase the data offsets to the start of the file
+
+    const size_t tablesSize =
+        cooked.meshes.size() * sizeof(CookedMeshEntry) +
+        cooked.materials.size() * sizeof(CookedMaterial) +
+        cooked.textures.size() * sizeof(CookedTexture);
+    const uint64_t dataOffset = (sizeof(CookedHeader) + tablesSize + COOKED_DATA_ALIGNMENT - 1) / COOKED_DATA_ALIGNMENT * COOKED_DATA_ALIGNMENT;
+
+    for(CookedMeshEntry& mesh : cooked.meshes) {
+        for(uint64_t& offset : mesh.streamOffsets) {
+            offset += dataOffset;
+        }
+        mesh.indexOffset += dataOffset;
+    }
+    for(CookedTexture& texture : cooked.textures) {
+        texture.offset += dataOffset;
+        if(texture.sourceSize > 0) {
+            texture.sourceOffset += dataOffset;
+        }
+    }
+
+    std::vector<unsigned char> body(dataOffset - sizeof(CookedHeader), 0);
+    unsigned char* cursor = body.data();
+    auto writeTable = [&cursor](const auto& table) {
+        const size_t size = table.size() * sizeof(table[0]);
+        if(size > 0) {
+            std::memcpy(cursor, table.data(), size);
+        }
+        cursor += size;
+    };
+    writeTable(cooked.meshes);
+    writeTable(cooked.materials);
+    writeTable(cooked.textures);
+
+    const std::vector<unsigned char>& data = cooked.data.GetBytes();
+    header.contentHash = hash_bytes(body.data(), body.size());
+    header.contentHash = hash_bytes(data.data(), data.size(), header.contentHash);
+
+    out.resize(sizeof(header) + body.size() + data.size());
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), body.data(), body.size());
+    if(!data.empty()) {
+        std::memcpy(out.data() + sizeof(header) + body.size(), data.data(), data.size());
+    }
+
+    LOGI("Cooked %u meshes, %u materials, and %u textures from %s",
+        header.meshCount, header.materialCount, header.textureCount, sourcePath.c_str());
+
+    return true;
+}
+
+bool MeshCooker::Read(const unsigned char* data, size_t size, const std::string& sourcePath, bool flipUVs, CookedModelView& out) {
+    CookedHeader& header = out.header;
+    if(size < sizeof(header)) {
+        LOGW("Cooked model is truncated");
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if(std::memcmp(header.magic, GYOMESH_MAGIC, sizeof(header.magic)) != 0 || header.version != GYOMESH_VERSION) {
+        LOGW("Not a version %u cooked model", GYOMESH_VERSION);
+        return false;
+    }
+
+    if(((header.flags & COOKED_FLAG_FLIP_UVS) != 0) != flipUVs) {
+        LOGW("Cooked model was cooked with different UV flipping");
+        return false;
+    }
+
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    if(!sourcePath.empty() && GetSourceStamp(sourcePath, sourceSize, sourceModifiedTime) &&
+        (sourceSize != header.sourceSize || sourceModifiedTime != header.sourceModifiedTime)) {
+        LOGW("Cooked model is out of date with %s, recook it", sourcePath.c_str());
+        return false;
+    }
+
+    // a corrupt or partly written file doesn't hash the same
+    if(hash_bytes(data + sizeof(header), size - sizeof(header)) != header.contentHash) {
+        LOGW("Cooked model is corrupt, recook it");
+        return false;
+    }
+
+    // read and check the tables, so nothing reads past the end
+
+    const uint64_t tablesSize =
+        uint64_t(header.meshCount) * sizeof(CookedMeshEntry) +
+        uint64_t(header.materialCount) * sizeof(CookedMaterial) +
+        uint64_t(header.textureCount) * sizeof(CookedTexture);
+    if(tablesSize > size - sizeof(header)) {
+        LOGW("Cooked model is truncated");
+        return false;
+    }
+
+    out.meshes.resize(header.meshCount);
+    out.materials.resize(header.materialCount);
+    out.textures.resize(header.textureCount);
+
+    const unsigned char* cursor = data + sizeof(header);
+    auto readTable = [&cursor](auto& table) {
+        const size_t tableSize = table.size() * sizeof(table[0]);
+        if(tableSize > 0) {
+            std::memcpy(table.data(), cursor, tableSize);
+        }
+        cursor += tableSize;
+    };
+    readTable(out.meshes);
+    readTable(out.materials);
+    readTable(out.textures);
+
+    auto isInFile = [size](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    for(const CookedMeshEntry& entry : out.meshes) {
+        const size_t indexSize = entry.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+        const size_t streamSizes[COOKED_STREAM_COUNT] = {
+            sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec3)
+        };
+
+        bool isValid = entry.materialIndex < header.materialCount && isInFile(entry.indexOffset, uint64_t(entry.indexCount) * indexSize);
+        for(uint32_t s = 0; s < COOKED_STREAM_COUNT; s++) {
+            isValid &= isInFile(entry.streamOffsets[s], uint64_t(entry.vertexCount) * streamSizes[s]);
+        }
+
+        if(!isValid) {
+            LOGW("Cooked model has an invalid mesh");
+            return false;
+        }
+    }
+
+    for(const CookedTexture& entry : out.textures) {
+        bool isValid = isInFile(entry.offset, entry.size) && (entry.sourceSize == 0 || isInFile(entry.sourceOffset, entry.sourceSize));
+
+        // raw texels must be as many as their dimensions say
+        const uint64_t rawSize = uint64_t(entry.width) * entry.height * 4;
+        if(std::strncmp(entry.formatHint, COOKED_TEXTURE_RAW_FORMAT, sizeof(entry.formatHint)) == 0) {
+            isValid &= rawSize > 0 && entry.size == rawSize;
+        }
+        if(entry.sourceSize > 0 && std::strncmp(entry.sourceFormatHint, COOKED_TEXTURE_RAW_FORMAT, sizeof(entry.sourceFormatHint)) == 0) {
+            isValid &= rawSize > 0 && entry.sourceSize == rawSize;
+        }
+
+        if(!isValid) {
+            LOGW("Cooked model has an invalid texture");
+            return false;
+        }
+    }
+
+    out.data = data;
+    out.size = size;
+
+    return true;
+}
+
+std::string MeshCooker::GetCookedPath(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).replace_extension(GYOMESH_EXTENSION).string();
+}
+
+bool MeshCooker::GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& modifiedTime) {
+    std::error_code error;
+
+    size = std::filesystem::file_size(sourcePath, error);
+    if(error) {
+        return false;
+    }
+
+    auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+    if(error) {
+        return false;
+    }
+
+    modifiedTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+} // namespace gyo
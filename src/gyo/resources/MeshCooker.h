@@ -0,0 +1,53 @@
+#ifndef MESH_COOKER_H
+#define MESH_COOKER_H
+
+#include <gyo/resources/TextureCooker.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace gyo {
+
+struct CookedModelView;
+
+/**
+ * Imports a model with assimp offline, and writes it out as a .gyomesh file
+ * (see CookedModel.h) which ModelLoader can load without importing again.
+ * Meshes are triangulated, given tangents, optimized and bounded once here,
+ * and embedded textures block compressed by TextureCooker.
+ *
+ * Doesn't touch GL, so it can run from a tool without a context.
+ */
+class MeshCooker {
+public:
+    /**
+     * Returns false, and logs why, if the model couldn't be imported or written
+     */
+    static bool Cook(const std::string& sourcePath, const std::string& cookedPath, bool flipUVs,
+        TextureCompression compression = TextureCompression::BC);
+
+    // same as above, except the file's bytes are returned instead of written.
+    // Compressing is slow, so by default the images are kept as they are.
+    static bool CookToMemory(const std::string& sourcePath, bool flipUVs, std::vector<unsigned char>& cooked,
+        TextureCompression compression = TextureCompression::NONE);
+
+    /**
+     * Reads back the tables of a cooked model, checking every offset against
+     * size. Returns false, and logs why, if it's invalid, was cooked with
+     * different UV flipping, or is stale compared to its source. A missing
+     * source isn't stale.
+     */
+    static bool Read(const unsigned char* data, size_t size, const std::string& sourcePath, bool flipUVs, CookedModelView& out);
+
+    // where the cooked copy of a model lives, next to the source
+    static std::string GetCookedPath(const std::string& sourcePath);
+
+    // what we record about the source, to tell when a cook is stale
+    static bool GetSourceStamp(const std::string& sourcePath, uint64_t& size, int64_t& modifiedTime);
+};
+
+} // namespace gyo
+
+#endif // MESH_COOKER_H
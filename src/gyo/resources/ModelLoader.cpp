@@ -1,10 +1,17 @@
 
 #include <gyo/resources/ModelLoader.h>
+#include <gyo/resources/CookedModel.h>
+#include <gyo/resources/GLTFLoader.h>
+#include <gyo/resources/MeshCooker.h>
 #include <gyo/resources/Resources.h>
 #include <gyo/resources/TextureLoader.h>
+#include <gyo/math/AABB.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/mesh/Model.h>
+#include <gyo/mesh/ModelNode.h>
 #include <gyo/mesh/Mesh.h>
 #include <gyo/geometry/Geometry.h>
+#include <gyo/geometry/GeometryOptimizer.h>
 #include <gyo/shading/GoochMaterial.h>
 #include <gyo/shading/Material.h>
 #include <gyo/shading/PBRMaterial.h>
@@ -12,11 +19,18 @@
 #include <gyo/shading/Texture2D.h>
 #include <gyo/utilities/Clock.h>
 #include <gyo/utilities/FileSystem.h>
+#include <gyo/utilities/Hash.h>
 #include <gyo/utilities/Log.h>
+#include <gyo/utilities/MappedFile.h>
 
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <unordered_set>
+
 namespace gyo {
 
 std::string ModelLoader::ResourceDir = "";
@@ -27,6 +41,187 @@ Model* ModelLoader::LoadModel(const char* fileName, bool flipUVs) {
     LOGI("Importing model %s", fileName);
     CLOCK(Model_Load);
 
+    std::string modelFilePath = FileSystem::CombinePath(ResourceDir, fileName);
+
+    // prefer a cooked copy, as long as it's up to date
+    std::string cookedFilePath = MeshCooker::GetCookedPath(modelFilePath);
+    if(std::filesystem::exists(cookedFilePath)) {
+        Model* model = LoadCookedModel(cookedFilePath, modelFilePath, flipUVs);
+        if(model != nullptr) {
+            return model;
+        }
+    }
+
+    // glb files are read in place, unless they need something only assimp supports
+    if(FileSystem::GetFilePathExtension(modelFilePath) == "glb") {
+        Model* model = GLTFLoader::LoadModel(modelFilePath, flipUVs);
+        if(model != nullptr) {
+            return model;
+        }
+    }
+
+    const aiScene* scene = ReadScene(fileName, flipUVs);
+    if(scene == nullptr) {
+        return nullptr;
+    }
+
+    // assemble the meshes which makeup the model
+    std::vector<Mesh*> meshes;
+    std::vector<Material*> materials(scene->mNumMaterials, nullptr);
+    ProcessNode(scene->mRootNode, scene, meshes, materials);
+
+    return new Model(meshes);
+}
+
+Model* ModelLoader::LoadCookedModel(const std::string& cookedFilePath, const std::string& sourceFilePath, bool flipUVs) {
+    CLOCK(Cooked_Model_Load);
+
+    MappedFile file;
+    if(!file.Open(cookedFilePath)) {
+        return nullptr;
+    }
+
+    // a cooked file loaded by name has no source to go stale against
+    CookedModelView cooked;
+    if(!MeshCooker::Read(file.GetData(), file.GetSize(), sourceFilePath != cookedFilePath ? sourceFilePath : "", flipUVs, cooked)) {
+        LOGW("Ignoring cooked model %s", cookedFilePath.c_str());
+        return nullptr;
+    }
+
+    // falling back on the source images of any textures we can't sample
+    TextureLoader::SelectCookedTextures(cooked);
+
+    LOGI("Loading cooked model '%s' with %u meshes, %u materials, and %u textures",
+        cookedFilePath.c_str(), cooked.header.meshCount, cooked.header.materialCount, cooked.header.textureCount);
+
+    // decode each texture once, however many materials use it
+
+    std::map<std::pair<int32_t, bool>, TextureHandle> textures;
+    auto getTexture = [&](int32_t index, bool srgb) -> TextureHandle {
+        auto it = textures.find({ index, srgb });
+        if(it != textures.end()) {
+            return it->second;
+        }
+
+        const CookedTexture& entry = cooked.textures[index];
+        std::string formatHint(entry.formatHint, strnlen(entry.formatHint, sizeof(entry.formatHint)));
+
+        TextureHandle texture = formatHint == COOKED_TEXTURE_RAW_FORMAT ?
+            Resources::AcquireRawTexture(cooked.data + entry.offset, entry.width, entry.height, srgb) :
+            Resources::AcquireCompressedTexture(cooked.data + entry.offset, entry.size, formatHint, srgb);
+        textures[{ index, srgb }] = texture;
+
+        return texture;
+    };
+
+    // upload every mesh straight from the mapping
+
+    std::vector<Mesh*> meshes;
+    meshes.reserve(cooked.meshes.size());
+
+    // meshes using the same material share it, as on import
+    std::vector<Material*> materials(cooked.materials.size(), nullptr);
+
+    for(const CookedMeshEntry& entry : cooked.meshes) {
+        Material*& material = materials[entry.materialIndex];
+        if(material == nullptr) {
+            material = Resources::ShareMaterial(CreateCookedMaterial(cooked.materials[entry.materialIndex], cooked, getTexture));
+        }
+        meshes.push_back(CreateCookedMesh(cooked, entry, material));
+    }
+
+    return new Model(meshes);
+}
+
+Material* ModelLoader::CreateCookedMaterial(const CookedMaterial& material, const CookedModelView& cooked,
+    const std::function<TextureHandle(int32_t index, bool srgb)>& getTexture) {
+    return CreateMaterial(material, [&](CookedTextureSlot slot) -> TextureHandle {
+        const int32_t index = material.textures[slot];
+        if(index < 0 || index >= static_cast<int32_t>(cooked.textures.size())) {
+            return nullptr;
+        }
+
+        return getTexture(index, IsCookedTextureSRGB(slot));
+    });
+}
+
+Material* ModelLoader::CreateMaterial(const CookedMaterial& material, const std::function<TextureHandle(CookedTextureSlot slot)>& getSlot) {
+    switch(material.type) {
+        case COOKED_MATERIAL_PBR:
+            return new PBRMaterial(
+                true,
+                glm::vec3(1.0),
+                material.metallic,
+                material.roughness,
+                1.0,
+                glm::vec3(material.emissive),
+                getSlot(COOKED_TEXTURE_ALBEDO),
+                getSlot(COOKED_TEXTURE_NORMAL),
+                getSlot(COOKED_TEXTURE_METALLIC),
+                getSlot(COOKED_TEXTURE_ROUGHNESS),
+                getSlot(COOKED_TEXTURE_METALLIC_ROUGHNESS),
+                getSlot(COOKED_TEXTURE_AO),
+                getSlot(COOKED_TEXTURE_EMISSIVE)
+            );
+
+        case COOKED_MATERIAL_PHONG:
+            return new PhongMaterial(
+                glm::vec4(1),
+                glm::vec4(1),
+                128,
+                getSlot(COOKED_TEXTURE_ALBEDO),
+                getSlot(COOKED_TEXTURE_SPECULAR),
+                getSlot(COOKED_TEXTURE_NORMAL));
+
+        default:
+            return new GoochMaterial();
+    }
+}
+
+Mesh* ModelLoader::CreateCookedMesh(const CookedModelView& cooked, const CookedMeshEntry& entry, Material* material) {
+    GeometrySource source;
+    source.streams[0] = { cooked.data + entry.streamOffsets[0], entry.vertexCount, sizeof(glm::vec3) };
+    source.streams[1] = { cooked.data + entry.streamOffsets[1], entry.vertexCount, sizeof(glm::vec3) };
+    source.streams[2] = { cooked.data + entry.streamOffsets[2], entry.vertexCount, sizeof(glm::vec2) };
+    source.streams[3] = { cooked.data + entry.streamOffsets[3], entry.vertexCount, sizeof(glm::vec3) };
+    source.vertexCount = entry.vertexCount;
+    source.indices = cooked.data + entry.indexOffset;
+    source.indexCount = entry.indexCount;
+    source.indexType = entry.indexType;
+
+    AABB bounds = {
+        glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]),
+        glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2])
+    };
+
+    // meshes used by several nodes share their data, and so their key
+    uint64_t geometryKey = hash_bytes(&entry.streamOffsets[0], sizeof(entry.streamOffsets[0]), cooked.header.contentHash);
+
+    return new Mesh(source, bounds, geometryKey, material);
+}
+
+SceneNode* ModelLoader::LoadModelHierarchy(const char* fileName, bool flipUVs) {
+    LOGI("Importing model hierarchy %s", fileName);
+    CLOCK(Model_Hierarchy_Load);
+
+    std::string modelFilePath = FileSystem::CombinePath(ResourceDir, fileName);
+    if(FileSystem::GetFilePathExtension(modelFilePath) == "glb") {
+        SceneNode* root = GLTFLoader::LoadModelHierarchy(modelFilePath, flipUVs);
+        if(root != nullptr) {
+            return root;
+        }
+    }
+
+    const aiScene* scene = ReadScene(fileName, flipUVs);
+    if(scene == nullptr) {
+        return nullptr;
+    }
+
+    std::vector<Material*> materials(scene->mNumMaterials, nullptr);
+    return ProcessNodeHierarchy(scene->mRootNode, scene, materials);
+}
+
+const aiScene* ModelLoader::ReadScene(const char* fileName, bool flipUVs) {
     // get the full file path
     std::string modelFilePath = FileSystem::CombinePath(ResourceDir, fileName);
     
@@ -53,27 +248,58 @@ Model* ModelLoader::LoadModel(const char* fileName, bool flipUVs) {
     LOGI("Importing model '%s' with %u meshes, %u materials, and %u textures",
         fileName, scene->mNumMeshes, scene->mNumMaterials, scene->mNumTextures);
 
-    // assemble the meshes which makeup the model
-    std::vector<Mesh*> meshes;
-    ProcessNode(scene->mRootNode, scene, meshes);
-
-    return new Model(meshes);
+    return scene;
 }
 
-void ModelLoader::ProcessNode(aiNode* node, const aiScene* scene, std::vector<Mesh*>& meshes) {
+void ModelLoader::ProcessNode(aiNode* node, const aiScene* scene, std::vector<Mesh*>& meshes, std::vector<Material*>& materials) {
     // process all node meshes
     for(unsigned int i = 0; i < node->mNumMeshes; i++) {
         aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(ProcessMesh(mesh, scene));
+        meshes.push_back(ProcessMesh(mesh, scene, materials));
     }
 
     // now process node's children
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
-        ProcessNode(node->mChildren[i], scene, meshes);
+        ProcessNode(node->mChildren[i], scene, meshes, materials);
+    }
+}
+
+SceneNode* ModelLoader::ProcessNodeHierarchy(aiNode* node, const aiScene* scene, std::vector<Material*>& materials) {
+    SceneNode* sceneNode = nullptr;
+
+    if(node->mNumMeshes > 0) {
+        std::vector<Mesh*> meshes;
+        meshes.reserve(node->mNumMeshes);
+
+        for(unsigned int i = 0; i < node->mNumMeshes; i++) {
+            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
+            meshes.push_back(ProcessMesh(mesh, scene, materials));
+        }
+
+        sceneNode = new ModelNode(new Model(meshes));
+    }
+    else {
+        sceneNode = new SceneNode();
+    }
+
+    // the node's transform is relative to its parent
+    aiVector3D scaling;
+    aiQuaternion rotation;
+    aiVector3D position;
+    node->mTransformation.Decompose(scaling, rotation, position);
+
+    sceneNode->SetPosition(position.x, position.y, position.z);
+    sceneNode->SetRotation(glm::fquat(rotation.w, rotation.x, rotation.y, rotation.z));
+    sceneNode->SetScale(scaling.x, scaling.y, scaling.z);
+
+    for(unsigned int i = 0; i < node->mNumChildren; i++) {
+        sceneNode->AddChild(ProcessNodeHierarchy(node->mChildren[i], scene, materials));
     }
+
+    return sceneNode;
 }
 
-Mesh* ModelLoader::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
+Mesh* ModelLoader::ProcessMesh(aiMesh* mesh, const aiScene* scene, std::vector<Material*>& materials) {
     std::vector<glm::vec3> positions;
     std::vector<glm::vec3> normals;
     std::vector<glm::vec2> texCoords;
@@ -116,104 +342,116 @@ Mesh* ModelLoader::ProcessMesh(aiMesh* mesh, const aiScene* scene) {
 
     Geometry* geo = new Geometry( positions, normals, texCoords, tangents, indices );
 
-    // process material 0
+    // reorder for the vertex cache, overdraw, and vertex fetch
+    GeometryOptimizer::Optimize(*geo);
 
-    Material* mat = nullptr;
-    if(mesh->mMaterialIndex >= 0) {
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
+    // meshes using the same aiMaterial share it, as do any that look the same
 
-        // assemble our texture types
-    
-        std::unordered_set<aiTextureType> texTypes;
-        for(int i = 0; i < AI_TEXTURE_TYPE_MAX; i++) {
-            aiTextureType type = static_cast<aiTextureType>(i);
-            if(material->GetTextureCount(type) > 0) {
-                texTypes.insert(type);
-            }
+    Material* mat = nullptr;
+    if(mesh->mMaterialIndex < materials.size()) {
+        Material*& shared = materials[mesh->mMaterialIndex];
+        if(shared == nullptr) {
+            shared = Resources::ShareMaterial(ProcessMaterial(scene->mMaterials[mesh->mMaterialIndex], scene));
         }
+        mat = shared;
+    }
+    else {
+        mat = Resources::ShareMaterial(new GoochMaterial());
+    }
 
-        // determine which material type to use depending on the textures
+    return new Mesh(geo, mat);
+}
 
-        LOGD("Processing material with %u properties", material->mNumProperties);
+Material* ModelLoader::ProcessMaterial(aiMaterial* material, const aiScene* scene) {
+    LOGD("Processing material with %u properties", material->mNumProperties);
 
-        LogMaterialProperties(material);
-        LogMaterialTextureTypes(material, scene);
+    LogMaterialProperties(material);
+    LogMaterialTextureTypes(material, scene);
 
-        bool isPBR =
-            texTypes.contains(aiTextureType_METALNESS) |
-            texTypes.contains(aiTextureType_DIFFUSE_ROUGHNESS) |
-            texTypes.contains(aiTextureType_GLTF_METALLIC_ROUGHNESS);
+    // the textures we load, indexed by the selected material's slots
+    std::vector<TextureHandle> textures;
 
-        if(isPBR) {
-            Texture2D* albedoMap = nullptr;
-            Texture2D* normalMap = nullptr;
-            Texture2D* metallicMap = nullptr;
-            Texture2D* roughnessMap = nullptr;
-            Texture2D* metallicRoughnessMap = nullptr;
-            Texture2D* aoMap = nullptr;
-            Texture2D* emissiveMap = nullptr;
+    const CookedMaterial selected = SelectMaterial(material, [&](aiTextureType type, CookedTextureSlot slot) -> int32_t {
+        TextureHandle texture = LoadMaterialTexture(material, type, scene, IsCookedTextureSRGB(slot));
+        if(!texture) {
+            return -1;
+        }
 
-            albedoMap = LoadMaterialTexture(material, aiTextureType_BASE_COLOR, scene, true);
-            if(!albedoMap) albedoMap = LoadMaterialTexture(material, aiTextureType_DIFFUSE, scene, true);
+        textures.push_back(texture);
+        return static_cast<int32_t>(textures.size() - 1);
+    });
 
-            normalMap = LoadMaterialTexture(material, aiTextureType_NORMALS, scene);
+    return CreateMaterial(selected, [&](CookedTextureSlot slot) -> TextureHandle {
+        const int32_t index = selected.textures[slot];
+        return index >= 0 ? textures[index] : nullptr;
+    });
+}
 
-            metallicRoughnessMap = LoadMaterialTexture(material, aiTextureType_GLTF_METALLIC_ROUGHNESS, scene);
-            if(!metallicRoughnessMap) {
-                metallicMap = LoadMaterialTexture(material, aiTextureType_METALNESS, scene);
-                roughnessMap = LoadMaterialTexture(material, aiTextureType_DIFFUSE_ROUGHNESS, scene);
-            }
+CookedMaterial ModelLoader::SelectMaterial(aiMaterial* material,
+    const std::function<int32_t(aiTextureType type, CookedTextureSlot slot)>& loadTexture) {
+    CookedMaterial entry = {};
+    for(int32_t& texture : entry.textures) {
+        texture = -1;
+    }
 
-            aoMap = LoadMaterialTexture(material, aiTextureType_AMBIENT_OCCLUSION, scene);
-            if(!aoMap) aoMap = LoadMaterialTexture(material, aiTextureType_LIGHTMAP, scene);
+    // assemble our texture types
 
-            emissiveMap = LoadMaterialTexture(material, aiTextureType_EMISSION_COLOR, scene);
-            if(!emissiveMap) emissiveMap = LoadMaterialTexture(material, aiTextureType_EMISSIVE, scene);
+    std::unordered_set<aiTextureType> texTypes;
+    for(int i = 0; i < AI_TEXTURE_TYPE_MAX; i++) {
+        aiTextureType type = static_cast<aiTextureType>(i);
+        if(material->GetTextureCount(type) > 0) {
+            texTypes.insert(type);
+        }
+    }
 
-            mat = new PBRMaterial(
-                true,
-                glm::vec3(1.0),
-                metallicMap || metallicRoughnessMap ? 1.0 : 0.0,
-                roughnessMap || metallicRoughnessMap ? 1.0 : 0.5,
-                1.0,
-                emissiveMap ? glm::vec3(1.0) : glm::vec3(0.0),
-                albedoMap,
-                normalMap,
-                metallicMap,
-                roughnessMap,
-                metallicRoughnessMap,
-                aoMap,
-                emissiveMap
-            );
+    // determine which material type to use depending on the textures
+
+    bool isPBR =
+        texTypes.contains(aiTextureType_METALNESS) |
+        texTypes.contains(aiTextureType_DIFFUSE_ROUGHNESS) |
+        texTypes.contains(aiTextureType_GLTF_METALLIC_ROUGHNESS);
+
+    // try each texture type in turn until one is found
+    auto loadFirst = [&](CookedTextureSlot slot, std::initializer_list<aiTextureType> types) {
+        for(aiTextureType type : types) {
+            entry.textures[slot] = loadTexture(type, slot);
+            if(entry.textures[slot] != -1) {
+                break;
+            }
         }
-        else {
-            Texture2D* diffuseMap = nullptr;
-            Texture2D* specularMap = nullptr;
-            Texture2D* normalMap = nullptr;
-    
-            diffuseMap = LoadMaterialTexture(material, aiTextureType_DIFFUSE, scene, true);
-            if(!diffuseMap) diffuseMap = LoadMaterialTexture(material, aiTextureType_BASE_COLOR, scene, true);
+    };
 
-            specularMap = LoadMaterialTexture(material, aiTextureType_SPECULAR, scene);
-            
-            normalMap = LoadMaterialTexture(material, aiTextureType_NORMALS, scene);
+    if(isPBR) {
+        entry.type = COOKED_MATERIAL_PBR;
 
-            mat = new PhongMaterial(
-                glm::vec4(1),
-                glm::vec4(1),
-                128,
-                diffuseMap, specularMap, normalMap);
+        loadFirst(COOKED_TEXTURE_ALBEDO, { aiTextureType_BASE_COLOR, aiTextureType_DIFFUSE });
+        loadFirst(COOKED_TEXTURE_NORMAL, { aiTextureType_NORMALS });
+        loadFirst(COOKED_TEXTURE_METALLIC_ROUGHNESS, { aiTextureType_GLTF_METALLIC_ROUGHNESS });
+        if(entry.textures[COOKED_TEXTURE_METALLIC_ROUGHNESS] == -1) {
+            loadFirst(COOKED_TEXTURE_METALLIC, { aiTextureType_METALNESS });
+            loadFirst(COOKED_TEXTURE_ROUGHNESS, { aiTextureType_DIFFUSE_ROUGHNESS });
         }
+        loadFirst(COOKED_TEXTURE_AO, { aiTextureType_AMBIENT_OCCLUSION, aiTextureType_LIGHTMAP });
+        loadFirst(COOKED_TEXTURE_EMISSIVE, { aiTextureType_EMISSION_COLOR, aiTextureType_EMISSIVE });
+
+        const bool hasMetallicRoughness = entry.textures[COOKED_TEXTURE_METALLIC_ROUGHNESS] != -1;
+        entry.metallic = entry.textures[COOKED_TEXTURE_METALLIC] != -1 || hasMetallicRoughness ? 1.0f : 0.0f;
+        entry.roughness = entry.textures[COOKED_TEXTURE_ROUGHNESS] != -1 || hasMetallicRoughness ? 1.0f : 0.5f;
+        entry.emissive = entry.textures[COOKED_TEXTURE_EMISSIVE] != -1 ? 1.0f : 0.0f;
     }
     else {
-        mat = new GoochMaterial();
+        entry.type = COOKED_MATERIAL_PHONG;
+
+        loadFirst(COOKED_TEXTURE_ALBEDO, { aiTextureType_DIFFUSE, aiTextureType_BASE_COLOR });
+        loadFirst(COOKED_TEXTURE_SPECULAR, { aiTextureType_SPECULAR });
+        loadFirst(COOKED_TEXTURE_NORMAL, { aiTextureType_NORMALS });
     }
 
-    return new Mesh(geo, mat);
+    return entry;
 }
 
-Texture2D* ModelLoader::LoadMaterialTexture(aiMaterial* mat, aiTextureType type, const aiScene* scene, bool srgb) {
-    Texture2D* texture = nullptr;
+TextureHandle ModelLoader::LoadMaterialTexture(aiMaterial* mat, aiTextureType type, const aiScene* scene, bool srgb) {
+    TextureHandle texture;
     
     aiString str;
     for(unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
@@ -227,7 +465,7 @@ Texture2D* ModelLoader::LoadMaterialTexture(aiMaterial* mat, aiTextureType type,
         if(aiTex) {
             LOGD(" Loading embedded %s texture '%s', %ux%u - %s", TextureTypeToString(type), str.C_Str(), aiTex->mWidth, aiTex->mHeight, aiTex->achFormatHint);
             
-            texture = TextureLoader::LoadEmbeddedTexture(aiTex, srgb);
+            texture = Resources::AcquireEmbeddedTexture(aiTex, srgb);
             break;
         }
         else {
@@ -236,7 +474,7 @@ Texture2D* ModelLoader::LoadMaterialTexture(aiMaterial* mat, aiTextureType type,
             // FIXME: this assumes referenced textures use file names (not paths),
             // and are placed in the /textures folder.
             // std::string fileName = FileSystem::GetFileName(str.C_Str());
-            // texture = Resources::GetTexture(fileName.c_str(), srgb);
+            // texture = Resources::AcquireTexture(fileName.c_str(), srgb);
             break;
         }
     }
@@ -1,11 +1,16 @@
 #ifndef MODEL_LOADER_H
 #define MODEL_LOADER_H
 
+#include <cstdint>
+#include <functional>
 #include <string>
 #include <vector>
 #include <assimp/Importer.hpp>
 #include <assimp/material.h>
 
+#include <gyo/resources/CookedModel.h>
+#include <gyo/resources/ResourceHandle.h>
+
 struct aiScene;
 struct aiNode;
 struct aiMesh;
@@ -13,8 +18,10 @@ struct aiMaterial;
 
 namespace gyo {
 
+class Material;
 class Model;
 class Mesh;
+class SceneNode;
 class Texture2D;
 
 class ModelLoader {
@@ -23,12 +30,48 @@ public:
 
     static Model* LoadModel(const char* fileName, bool flipUVs);
 
+    /**
+     * Same as above, except the file's node hierarchy and local transforms
+     * are kept. Nodes with meshes become ModelNodes, the rest plain SceneNodes.
+     */
+    static SceneNode* LoadModelHierarchy(const char* fileName, bool flipUVs);
+
+    /**
+     * Builds one material of a cooked model, fetching its textures by index
+     * from getTexture so they can be shared, or uploaded ahead of time.
+     */
+    static Material* CreateCookedMaterial(const CookedMaterial& material, const CookedModelView& cooked,
+        const std::function<TextureHandle(int32_t index, bool srgb)>& getTexture);
+
+    /**
+     * Chooses how an imported material is shaded, and which of its textures
+     * fill each slot. loadTexture is tried with each texture type a slot
+     * accepts in turn, until it returns an index rather than -1. Imported and
+     * cooked models both choose through here, so they can't drift apart.
+     */
+    static CookedMaterial SelectMaterial(aiMaterial* material,
+        const std::function<int32_t(aiTextureType type, CookedTextureSlot slot)>& loadTexture);
+
+    // uploads one mesh of a cooked model straight from its data
+    static Mesh* CreateCookedMesh(const CookedModelView& cooked, const CookedMeshEntry& entry, Material* material);
+
 private:
     static Assimp::Importer importer;
 
-    static void ProcessNode(aiNode* node, const aiScene* scene, std::vector<Mesh*>& meshes);
-    static Mesh* ProcessMesh(aiMesh* mesh, const aiScene* scene);
-    static Texture2D* LoadMaterialTexture(aiMaterial* mat, aiTextureType type, const aiScene* scene, bool srgb = false);
+    /**
+     * Maps a .gyomesh file written by MeshCooker and uploads straight from it.
+     * Returns nullptr if it's invalid, or stale compared to its source.
+     */
+    static Model* LoadCookedModel(const std::string& cookedFilePath, const std::string& sourceFilePath, bool flipUVs);
+
+    static const aiScene* ReadScene(const char* fileName, bool flipUVs);
+    // materials are by aiMaterial index, created as meshes first use them
+    static void ProcessNode(aiNode* node, const aiScene* scene, std::vector<Mesh*>& meshes, std::vector<Material*>& materials);
+    static SceneNode* ProcessNodeHierarchy(aiNode* node, const aiScene* scene, std::vector<Material*>& materials);
+    static Mesh* ProcessMesh(aiMesh* mesh, const aiScene* scene, std::vector<Material*>& materials);
+    static Material* ProcessMaterial(aiMaterial* material, const aiScene* scene);
+    static Material* CreateMaterial(const CookedMaterial& material, const std::function<TextureHandle(CookedTextureSlot slot)>& getSlot);
+    static TextureHandle LoadMaterialTexture(aiMaterial* mat, aiTextureType type, const aiScene* scene, bool srgb = false);
 
     static void LogMaterialProperties(aiMaterial* mat);
     static void LogMaterialTextureTypes(aiMaterial* mat, const aiScene* scene);
@@ -0,0 +1,109 @@
+#ifndef RESOURCE_CACHE_H
+#define RESOURCE_CACHE_H
+
+#include <gyo/resources/ResourceHandle.h>
+#include <gyo/utilities/Hash.h>
+#include <gyo/utilities/Log.h>
+
+#include <map>
+#include <string>
+
+namespace gyo {
+
+/**
+ * Resources of one type, by the 64-bit hash of a key string, e.g. a file
+ * name. Keys whose hashes collide are kept side by side and told apart by
+ * comparing the keys themselves, so a collision is only ever slower, never
+ * the wrong resource. Entries never move, so pointers to them stay valid
+ * until they're evicted.
+ */
+template<typename T>
+class ResourceCache {
+public:
+    typedef ResourceEntry<T> Entry;
+
+    // null if key isn't cached
+    Entry* Find(const std::string& key) {
+        auto range = entries.equal_range(HASH64(key));
+        for(auto it = range.first; it != range.second; ++it) {
+            if(it->second.key == key) {
+                it->second.Touch();
+                return &it->second;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // key mustn't be cached already
+    Entry* Insert(const std::string& key, const T& resource, size_t gpuBytes) {
+        const ResourceId id = HASH64(key);
+
+        auto collision = entries.find(id);
+        if(collision != entries.end()) {
+            LOGW("Resource '%s' has the same id as '%s'", key.c_str(), collision->second.key.c_str());
+        }
+
+        auto it = entries.emplace(id, Entry());
+        Entry& entry = it->second;
+        entry.key = key;
+        entry.resource = resource;
+        entry.gpuBytes = gpuBytes;
+        entry.Touch();
+
+        // resources that know when they're used, i.e. textures, touch us themselves
+        if constexpr (requires { entry.resource.lastUsed = &entry.lastUsed; }) {
+            entry.resource.lastUsed = &entry.lastUsed;
+        }
+
+        totalGpuBytes += gpuBytes;
+
+        return &entry;
+    }
+
+    // the evictable entry used least recently, or null if there are none
+    Entry* FindLeastRecentlyUsed() {
+        Entry* oldest = nullptr;
+        for(auto& it : entries) {
+            Entry& entry = it.second;
+            if(entry.IsEvictable() && entry.gpuBytes > 0 && (oldest == nullptr || entry.lastUsed < oldest->lastUsed)) {
+                oldest = &entry;
+            }
+        }
+
+        return oldest;
+    }
+
+    void Evict(Entry* entry) {
+        auto range = entries.equal_range(HASH64(entry->key));
+        for(auto it = range.first; it != range.second; ++it) {
+            if(&it->second == entry) {
+                LOGD("Evicting '%s', %zu KB", entry->key.c_str(), entry->gpuBytes / 1024);
+
+                totalGpuBytes -= entry->gpuBytes;
+                entry->resource.Dispose();
+                entries.erase(it);
+                return;
+            }
+        }
+    }
+
+    void Dispose() {
+        for(auto& it : entries) {
+            it.second.resource.Dispose();
+        }
+        entries.clear();
+        totalGpuBytes = 0;
+    }
+
+    const size_t& GetGpuBytes() const { return totalGpuBytes; }
+    size_t GetCount() const { return entries.size(); }
+
+private:
+    std::multimap<ResourceId, Entry> entries;
+    size_t totalGpuBytes = 0;
+};
+
+} // namespace gyo
+
+#endif // RESOURCE_CACHE_H
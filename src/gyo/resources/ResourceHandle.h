@@ -0,0 +1,99 @@
+#ifndef RESOURCE_HANDLE_H
+#define RESOURCE_HANDLE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace gyo {
+
+typedef uint64_t ResourceId;
+
+class Texture2D;
+class TextureCube;
+
+/**
+ * A cached resource, and what the cache needs to know to evict it
+ */
+template<typename T>
+struct ResourceEntry {
+    std::string key;            // what the id was hashed from, to tell collisions apart
+    T resource;
+    size_t gpuBytes = 0;        // estimated
+
+    int refCount = 0;           // live handles
+    bool isPinned = false;      // handed out as a raw pointer, so never evicted
+    std::chrono::steady_clock::time_point lastUsed;     // also touched by Texture2D::Bind
+
+    bool IsEvictable() const { return refCount == 0 && !isPinned; }
+    void Touch() { lastUsed = std::chrono::steady_clock::now(); }
+};
+
+/**
+ * A counted reference to a cached resource. While any handle to a resource
+ * is alive it won't be evicted; once the last one goes it becomes a candidate
+ * for eviction, least recently used first, if the cache is over its memory
+ * budget. Handles mustn't outlive Resources::Dispose.
+ */
+template<typename T>
+class ResourceHandle {
+public:
+    ResourceHandle() {}
+    ResourceHandle(std::nullptr_t) {}
+
+    ResourceHandle(const ResourceHandle& other) : entry(other.entry) {
+        AddRef();
+    }
+
+    ResourceHandle(ResourceHandle&& other) : entry(other.entry) {
+        other.entry = nullptr;
+    }
+
+    ResourceHandle& operator=(ResourceHandle other) {
+        std::swap(entry, other.entry);
+        return *this;
+    }
+
+    ~ResourceHandle() {
+        Release();
+    }
+
+    T* Get() const { return entry ? &entry->resource : nullptr; }
+    T* operator->() const { return Get(); }
+    explicit operator bool() const { return entry != nullptr; }
+
+    const std::string& GetKey() const { return entry->key; }
+
+private:
+    friend class Resources;
+
+    ResourceEntry<T>* entry = nullptr;
+
+    explicit ResourceHandle(ResourceEntry<T>* entry) : entry(entry) {
+        AddRef();
+    }
+
+    void AddRef() {
+        if(entry != nullptr) {
+            entry->refCount++;
+            entry->Touch();
+        }
+    }
+
+    void Release() {
+        if(entry != nullptr) {
+            entry->refCount--;
+            entry->Touch();
+            entry = nullptr;
+        }
+    }
+};
+
+typedef ResourceHandle<Texture2D> TextureHandle;
+typedef ResourceHandle<TextureCube> TextureCubeHandle;
+
+} // namespace gyo
+
+#endif // RESOURCE_HANDLE_H
@@ -1,9 +1,11 @@
 
 #include <gyo/resources/Resources.h>
+#include <gyo/resources/AsyncLoader.h>
 #include <gyo/resources/IBLEnvironmentLoader.h>
 #include <gyo/resources/ModelLoader.h>
 #include <gyo/resources/ShaderLoader.h>
 #include <gyo/resources/TextureLoader.h>
+#include <gyo/resources/TextureStreamer.h>
 #include <gyo/resources/FontLoader.h>
 #include <gyo/resources/DataLoader.h>
 #include <gyo/utilities/FileSystem.h>
@@ -11,24 +13,48 @@
 #include <gyo/utilities/Hash.h>
 
 #include <gyo/geometry/Geometry.h>
+#include <gyo/geometry/GeometryDescriptor.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/mesh/Model.h>
+#include <gyo/shading/Material.h>
 #include <gyo/shading/Shader.h>
 #include <gyo/shading/Texture2D.h>
 #include <gyo/shading/TextureCube.h>
 #include <gyo/ui/Font.h>
 
 #include <glad/glad.h>
+#include <assimp/texture.h>
 
+#include <cstdio>
+#include <limits>
 #include <numeric>
 
 namespace gyo {
 
-std::map<long, Shader> Resources::shaders = {};
-std::map<long, Texture2D> Resources::textures = {};
-std::map<long, TextureCube> Resources::cubeMaps = {};
-std::map<long, Font> Resources::fonts = {};
+ResourceCache<Shader> Resources::shaders;
+ResourceCache<Texture2D> Resources::textures;
+ResourceCache<TextureCube> Resources::cubeMaps;
+ResourceCache<Font> Resources::fonts;
+std::map<std::string, Model*> Resources::models = {};
+std::map<uint64_t, Resources::CachedGeometry> Resources::geometries = {};
+std::unordered_map<uint64_t, Material*> Resources::materials = {};
+std::map<std::string, LoadHandle<Model>> Resources::pendingModels = {};
+std::map<std::string, LoadHandle<Texture2D>> Resources::pendingTextures = {};
+ThreadPool* Resources::threadPool = nullptr;
+size_t Resources::memoryBudget = std::numeric_limits<size_t>::max();
+
+// roughly what a texture takes on the GPU, where 3 channel texels are padded to 4
+static size_t EstimateGpuBytes(unsigned int width, unsigned int height, size_t bytesPerTexel, bool hasMipmaps) {
+    size_t bytes = static_cast<size_t>(width) * height * bytesPerTexel;
+    return hasMipmaps ? bytes * 4 / 3 : bytes;
+}
+
+// exact for block compressed textures, which know their size
+static size_t GetGpuBytes(const Texture2D& texture, bool hasMipmaps) {
+    return texture.gpuBytes != 0 ? texture.gpuBytes : EstimateGpuBytes(texture.width, texture.height, 4, hasMipmaps);
+}
 
-void Resources::Initialize() {
+void Resources::Initialize(ThreadPool* pool) {
     // set the directory paths of our resource loaders
 
     std::string cwd = FileSystem::GetCurrentWorkingDirectory();
@@ -39,20 +65,23 @@ void Resources::Initialize() {
     TextureLoader::ResourceDir = FileSystem::CombinePath(cwd, "resources", "textures");
     FontLoader::ResourceDir = FileSystem::CombinePath(cwd, "resources", "fonts");
 
-    // generate default textures
+    TextureLoader::Initialize();
+    TextureStreamer::Initialize();
+
+    Resources::threadPool = pool;
+    AsyncLoader::Initialize(pool);
+
+    // generate default textures, which materials fall back on so are never evicted
 
-    long id;
     glm::vec4 color;
 
     // a 1 pixel white texture
-    id = HASH("BUILTIN_white");
     color = { 1, 1, 1, 1 };
-    Resources::textures[id] = Resources::GenerateBuiltInTexture(color);
+    Resources::textures.Insert("BUILTIN_white", Resources::GenerateBuiltInTexture(color), 4)->isPinned = true;
 
     // default normal texture
-    id = HASH("BUILTIN_normal");
     color = { 0.5f, 0.5f, 1, 1 };
-    Resources::textures[id] = Resources::GenerateBuiltInTexture(color);
+    Resources::textures.Insert("BUILTIN_normal", Resources::GenerateBuiltInTexture(color), 4)->isPinned = true;
 }
 
 Texture2D Resources::GenerateBuiltInTexture(glm::vec4 color) {
@@ -66,142 +95,304 @@ Texture2D Resources::GenerateBuiltInTexture(glm::vec4 color) {
 }
 
 void Resources::Dispose() {
-    for (auto& shader : Resources::shaders) {
-        shader.second.Dispose();
-    }
-    Resources::shaders.clear();
+    AsyncLoader::Dispose();
+    Resources::pendingModels.clear();
+    Resources::pendingTextures.clear();
 
-    for (auto& texture : Resources::textures) {
-        texture.second.Dispose();
+    // nodes still holding a model keep it alive
+    for(auto& it : Resources::models) {
+        it.second->Release();
     }
-    Resources::textures.clear();
+    Resources::models.clear();
 
-    for (auto& texture : Resources::cubeMaps) {
-        texture.second.Dispose();
+    for(auto& it : Resources::materials) {
+        it.second->Release();
     }
-    Resources::cubeMaps.clear();
+    Resources::materials.clear();
 
-    for (auto& font : Resources::fonts) {
-        font.second.Dispose();
+    // meshes still using the geometry keep it in the pool
+    for(auto& it : Resources::geometries) {
+        GeometryPool::Get()->Free(it.second.poolHandle);
     }
-    Resources::fonts.clear();
+    Resources::geometries.clear();
+
+    Resources::shaders.Dispose();
+    Resources::textures.Dispose();
+    Resources::cubeMaps.Dispose();
+    Resources::fonts.Dispose();
+
+    // after the textures, which remove themselves as they go
+    TextureStreamer::Dispose();
+}
+
+std::string Resources::GetModelKey(const char* fileName, bool flipUVs) {
+    return std::string(fileName) + (flipUVs ? "|flipUVs" : "");
 }
 
 Model* Resources::GetModel(const char* fileName, bool flipUVs) {
-    return ModelLoader::LoadModel(fileName, flipUVs);
+    std::string key = GetModelKey(fileName, flipUVs);
+
+    auto it = Resources::models.find(key);
+    if(it != Resources::models.end()) {
+        return it->second;
+    }
+
+    Model* model = ModelLoader::LoadModel(fileName, flipUVs);
+    if(model != nullptr) {
+        model->AddRef();
+        Resources::models[key] = model;
+    }
+
+    return model;
 }
 
-Shader* Resources::GetShader(const char* vertFileName, const char* fragFileName, const std::set<std::string>& defines) {
-    // get our hash
+SceneNode* Resources::GetModelHierarchy(const char* fileName, bool flipUVs) {
+    return ModelLoader::LoadModelHierarchy(fileName, flipUVs);
+}
 
-    std::string definesStr = "";
-    if(!defines.empty()) {
-        definesStr = std::accumulate(std::next(defines.begin()), defines.end(), *defines.begin(),
-        [](const std::string& a, const std::string& b) {
-            return a + "," + b;
-        });
+Material* Resources::ShareMaterial(Material* material) {
+    const uint64_t& key = material->GetInstanceKey();
+
+    auto it = Resources::materials.find(key);
+    if(it != Resources::materials.end()) {
+        Material* shared = it->second;
+
+        // a material whose parameters have changed since isn't a match anymore
+        if(shared->GetInstanceKey() == key) {
+            // deletes material, unless someone else already holds it
+            if(shared != material) {
+                material->AddRef();
+                material->Release();
+            }
+            return shared;
+        }
+
+        shared->Release();
+        Resources::materials.erase(it);
     }
 
-    std::string hashKey = 
-        std::string(vertFileName) + "|" +
-        std::string(fragFileName) + "|" +
-        definesStr;
+    material->AddRef();
+    Resources::materials[key] = material;
 
-    long id = HASH(hashKey);
+    return material;
+}
 
-    // return early if we've already compiled this variant
+SharedGeometry Resources::GetGeometry(const GeometryDescriptor& descriptor) {
+    const uint64_t key = descriptor.GetKey();
 
-    if(Resources::shaders.find(id) != Resources::shaders.end()) {
-        return &Resources::shaders[id];
+    auto it = Resources::geometries.find(key);
+    if(it != Resources::geometries.end()) {
+        return it->second.geometry;
     }
 
-    // compile and save this variant
+    Geometry* geometry = descriptor.Generate();
 
-    Shader shader = ShaderLoader::LoadShader(vertFileName, fragFileName, defines);
+    CachedGeometry& cached = Resources::geometries[key];
+    cached.geometry.key = key;
+    cached.geometry.indexCount = static_cast<unsigned int>(geometry->indices.size());
+    cached.geometry.bounds = {
+        glm::vec3(std::numeric_limits<float>::max()),
+        glm::vec3(std::numeric_limits<float>::lowest())
+    };
+    for(const glm::vec3& position : geometry->positions) {
+        cached.geometry.bounds.min = glm::min(cached.geometry.bounds.min, position);
+        cached.geometry.bounds.max = glm::max(cached.geometry.bounds.max, position);
+    }
 
-    Resources::shaders[id] = shader;
+    // the pool has its own copy, so we don't need ours
+    cached.poolHandle = GeometryPool::Get()->Allocate(*geometry, key);
+    delete geometry;
 
-    return &Resources::shaders[id];
+    return cached.geometry;
 }
 
-Shader* Resources::GetShader(const char* vertFileName, const char* geomFileName, const char* fragFileName, const std::set<std::string>& defines) {
-    // get our hash
+std::string Resources::GetDefinesKey(const std::set<std::string>& defines) {
+    if(defines.empty()) {
+        return "";
+    }
+
+    return std::accumulate(std::next(defines.begin()), defines.end(), *defines.begin(),
+    [](const std::string& a, const std::string& b) {
+        return a + "," + b;
+    });
+}
+
+Shader* Resources::GetShader(const char* vertFileName, const char* fragFileName, const std::set<std::string>& defines) {
+    std::string key = 
+        std::string(vertFileName) + "|" +
+        std::string(fragFileName) + "|" +
+        GetDefinesKey(defines);
+
+    // return early if we've already compiled this variant
 
-    std::string definesStr = "";
-    if(!defines.empty()) {
-        definesStr = std::accumulate(std::next(defines.begin()), defines.end(), *defines.begin(),
-        [](const std::string& a, const std::string& b) {
-            return a + "," + b;
-        });
+    ResourceEntry<Shader>* entry = Resources::shaders.Find(key);
+    if(entry == nullptr) {
+        // compile and save this variant
+        entry = Resources::shaders.Insert(key, ShaderLoader::LoadShader(vertFileName, fragFileName, defines), 0);
     }
 
-    std::string hashKey = 
+    entry->isPinned = true;
+    return &entry->resource;
+}
+
+Shader* Resources::GetShader(const char* vertFileName, const char* geomFileName, const char* fragFileName, const std::set<std::string>& defines) {
+    std::string key = 
         std::string(vertFileName) + "|" +
         std::string(geomFileName) + "|" +
         std::string(fragFileName) + "|" +
-        definesStr;
-
-    long id = HASH(hashKey);
+        GetDefinesKey(defines);
 
     // return early if we've already compiled this variant
 
-    if(Resources::shaders.find(id) != Resources::shaders.end()) {
-        return &Resources::shaders[id];
+    ResourceEntry<Shader>* entry = Resources::shaders.Find(key);
+    if(entry == nullptr) {
+        // compile and save this variant
+        entry = Resources::shaders.Insert(key, ShaderLoader::LoadShader(vertFileName, geomFileName, fragFileName, defines), 0);
     }
 
-    // compile and save this variant
+    entry->isPinned = true;
+    return &entry->resource;
+}
 
-    Shader shader = ShaderLoader::LoadShader(vertFileName, geomFileName, fragFileName, defines);
+ResourceEntry<Texture2D>* Resources::LoadTexture(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps) {
+    ResourceEntry<Texture2D>* entry = Resources::textures.Find(imageFileName);
+    if(entry != nullptr) {
+        return entry;
+    }
 
-    Resources::shaders[id] = shader;
+    Texture2D texture = TextureLoader::LoadTexture(imageFileName, srgb, wrapMode, useMipmaps);
 
-    return &Resources::shaders[id];
+    return Resources::textures.Insert(imageFileName, texture, GetGpuBytes(texture, useMipmaps));
 }
 
 Texture2D* Resources::GetTexture(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps) {
-    long id = HASH(imageFileName);
+    ResourceEntry<Texture2D>* entry = LoadTexture(imageFileName, srgb, wrapMode, useMipmaps);
+    entry->isPinned = true;
+
+    TrimToBudget();
+
+    return &entry->resource;
+}
+
+TextureHandle Resources::AcquireTexture(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps) {
+    TextureHandle handle(LoadTexture(imageFileName, srgb, wrapMode, useMipmaps));
+
+    TrimToBudget();
+
+    return handle;
+}
+
+std::string Resources::GetEmbeddedTextureKey(uint64_t contentHash, bool srgb) {
+    char key[48];
+    snprintf(key, sizeof(key), "EMBEDDED_%016llx%s", static_cast<unsigned long long>(contentHash), srgb ? "_srgb" : "");
+    return key;
+}
+
+TextureHandle Resources::AcquireCompressedTexture(const unsigned char* data, size_t size, const std::string& formatHint, bool srgb) {
+    std::string key = GetEmbeddedTextureKey(hash_bytes(data, size), srgb);
 
-    if (Resources::textures.find(id) != Resources::textures.end()) {
-        return &Resources::textures[id];
+    TextureHandle handle = FindTexture(key);
+    if(!handle) {
+        Texture2D* texture = TextureLoader::LoadCompressedTexture(data, size, formatHint, srgb);
+        if(texture == nullptr) {
+            return handle;
+        }
+
+        handle = CacheTexture(key, *texture, true);
+        delete texture;
     }
 
-    Texture2D texture = TextureLoader::LoadTexture(imageFileName, srgb, wrapMode, useMipmaps);
+    return handle;
+}
+
+TextureHandle Resources::AcquireEmbeddedTexture(const aiTexture* texture, bool srgb) {
+    // the texels themselves, cached the same as a cooked copy of them
+    if(texture->mHeight != 0) {
+        return AcquireRawTexture(reinterpret_cast<const unsigned char*>(texture->pcData),
+            static_cast<int>(texture->mWidth), static_cast<int>(texture->mHeight), srgb);
+    }
+
+    // otherwise the image file, mWidth bytes of it
+    std::string key = GetEmbeddedTextureKey(hash_bytes(texture->pcData, texture->mWidth), srgb);
+
+    TextureHandle handle = FindTexture(key);
+    if(!handle) {
+        Texture2D* loaded = TextureLoader::LoadEmbeddedTexture(texture, srgb);
+        if(loaded == nullptr) {
+            return handle;
+        }
+
+        handle = CacheTexture(key, *loaded, true);
+        delete loaded;
+    }
+
+    return handle;
+}
+
+TextureHandle Resources::AcquireRawTexture(const unsigned char* texels, int width, int height, bool srgb) {
+    std::string key = GetEmbeddedTextureKey(hash_bytes(texels, static_cast<size_t>(width) * height * 4), srgb);
 
-    Resources::textures[id] = texture;
+    TextureHandle handle = FindTexture(key);
+    if(!handle) {
+        Texture2D* texture = TextureLoader::LoadRawTexture(texels, width, height, srgb);
+        if(texture == nullptr) {
+            return handle;
+        }
 
-    return &Resources::textures[id];
+        handle = CacheTexture(key, *texture, true);
+        delete texture;
+    }
+
+    return handle;
 }
 
 Texture2D* Resources::GetHDRTexture(const char* imageFileName) {
-    long id = HASH(imageFileName);
+    ResourceEntry<Texture2D>* entry = Resources::textures.Find(imageFileName);
 
-    if (Resources::textures.find(id) != Resources::textures.end()) {
-        return &Resources::textures[id];
+    if (entry == nullptr) {
+        Texture2D texture = TextureLoader::LoadHDRTexture(imageFileName);
+
+        // RGB32F, padded
+        entry = Resources::textures.Insert(imageFileName, texture, EstimateGpuBytes(texture.width, texture.height, 16, false));
     }
 
-    Texture2D texture = TextureLoader::LoadHDRTexture(imageFileName);
+    entry->isPinned = true;
 
-    Resources::textures[id] = texture;
+    TrimToBudget();
 
-    return &Resources::textures[id];
+    return &entry->resource;
 }
 
-TextureCube* Resources::GetTextureCube(std::vector<const char*> faceFileNames, bool srgb) {
+ResourceEntry<TextureCube>* Resources::LoadTextureCube(const std::vector<const char*>& faceFileNames, bool srgb) {
     if(faceFileNames.size() != 6) {
         throw std::runtime_error("Cannot load cubmap without 6 faces");
     }
 
-    long id = HASH(faceFileNames[0]);
-    
-    if (Resources::cubeMaps.find(id) != Resources::cubeMaps.end()) {
-        return &Resources::cubeMaps[id];
+    ResourceEntry<TextureCube>* entry = Resources::cubeMaps.Find(faceFileNames[0]);
+    if(entry != nullptr) {
+        return entry;
     }
 
-    TextureCube texture = TextureLoader::LoadTextureCube(faceFileNames, srgb);
+    TextureCube texture = TextureLoader::LoadTextureCube(faceFileNames, srgb, Resources::threadPool);
 
-    Resources::cubeMaps[id] = texture;
+    return Resources::cubeMaps.Insert(faceFileNames[0], texture, 6 * EstimateGpuBytes(texture.width, texture.height, 4, false));
+}
+
+TextureCube* Resources::GetTextureCube(std::vector<const char*> faceFileNames, bool srgb) {
+    ResourceEntry<TextureCube>* entry = LoadTextureCube(faceFileNames, srgb);
+    entry->isPinned = true;
 
-    return &Resources::cubeMaps[id];
+    TrimToBudget();
+
+    return &entry->resource;
+}
+
+TextureCubeHandle Resources::AcquireTextureCube(std::vector<const char*> faceFileNames, bool srgb) {
+    TextureCubeHandle handle(LoadTextureCube(faceFileNames, srgb));
+
+    TrimToBudget();
+
+    return handle;
 }
 
 IBLEnvironment Resources::GetEnvironment(const char* hdrFileName) {
@@ -213,62 +404,63 @@ IBLEnvironment Resources::GetEnvironment(const char* hdrFileName) {
 
     Texture2D* hdrTexture = Resources::GetHDRTexture(hdrFileName);
 
-    // create our hash ids
-
-    std::string cubemapHashKey = std::string(hdrFileName) + "_cubemap";
-    long cubemapId = HASH(cubemapHashKey);
+    // create our keys
 
-    std::string irradianceMapHashKey = std::string(hdrFileName) + "_irradianceMap";
-    long irradianceMapId = HASH(irradianceMapHashKey);
+    std::string cubemapKey = std::string(hdrFileName) + "_cubemap";
+    std::string irradianceMapKey = std::string(hdrFileName) + "_irradianceMap";
+    std::string prefilteredEnvMapKey = std::string(hdrFileName) + "_prefilteredEnvMap";
+    std::string brdfLUTKey = "brdfLUT";
 
-    std::string prefilteredEnvMapHashKey = std::string(hdrFileName) + "_prefilteredEnvMap";
-    long prefilteredEnvMapId = HASH(prefilteredEnvMapHashKey);
+    // now load or generate our textures, which are all half float
 
-    long brdfLUTId = HASH("brdfLUT");
-
-    // now load or generate our textures
-
-    if (Resources::cubeMaps.find(cubemapId) == Resources::cubeMaps.end()) {
-        TextureCube cubemap = envLoader.GetCubemap(hdrTexture);
-        Resources::cubeMaps[cubemapId] = cubemap;
+    ResourceEntry<TextureCube>* cubemap = Resources::cubeMaps.Find(cubemapKey);
+    if (cubemap == nullptr) {
+        TextureCube texture = envLoader.GetCubemap(hdrTexture);
+        cubemap = Resources::cubeMaps.Insert(cubemapKey, texture, 6 * EstimateGpuBytes(texture.width, texture.height, 8, false));
     }
+    cubemap->isPinned = true;
 
-    if (Resources::cubeMaps.find(irradianceMapId) == Resources::cubeMaps.end()) {
-        TextureCube irradianceMap = envLoader.GetIrradianceMap(&Resources::cubeMaps[cubemapId]);
-        Resources::cubeMaps[irradianceMapId] = irradianceMap;
+    ResourceEntry<TextureCube>* irradianceMap = Resources::cubeMaps.Find(irradianceMapKey);
+    if (irradianceMap == nullptr) {
+        TextureCube texture = envLoader.GetIrradianceMap(&cubemap->resource);
+        irradianceMap = Resources::cubeMaps.Insert(irradianceMapKey, texture, 6 * EstimateGpuBytes(texture.width, texture.height, 8, false));
     }
+    irradianceMap->isPinned = true;
 
-    if (Resources::cubeMaps.find(prefilteredEnvMapId) == Resources::cubeMaps.end()) {
-        TextureCube prefilteredEnvMap = envLoader.GetPrefilteredEnvMap(&Resources::cubeMaps[cubemapId]);
-        Resources::cubeMaps[prefilteredEnvMapId] = prefilteredEnvMap;
+    ResourceEntry<TextureCube>* prefilteredEnvMap = Resources::cubeMaps.Find(prefilteredEnvMapKey);
+    if (prefilteredEnvMap == nullptr) {
+        TextureCube texture = envLoader.GetPrefilteredEnvMap(&cubemap->resource);
+        prefilteredEnvMap = Resources::cubeMaps.Insert(prefilteredEnvMapKey, texture, 6 * EstimateGpuBytes(texture.width, texture.height, 8, true));
     }
+    prefilteredEnvMap->isPinned = true;
 
-    if (Resources::textures.find(brdfLUTId) == Resources::textures.end()) {
-        Texture2D brdfLUT = envLoader.GetBRDFLUT();
-        Resources::textures[brdfLUTId] = brdfLUT;
+    ResourceEntry<Texture2D>* brdfLUT = Resources::textures.Find(brdfLUTKey);
+    if (brdfLUT == nullptr) {
+        Texture2D texture = envLoader.GetBRDFLUT();
+        brdfLUT = Resources::textures.Insert(brdfLUTKey, texture, EstimateGpuBytes(texture.width, texture.height, 4, false));
     }
+    brdfLUT->isPinned = true;
+
+    TrimToBudget();
 
     return {
-        &Resources::cubeMaps[cubemapId],
-        &Resources::cubeMaps[irradianceMapId],
-        &Resources::cubeMaps[prefilteredEnvMapId],
-        &Resources::textures[brdfLUTId]
+        &cubemap->resource,
+        &irradianceMap->resource,
+        &prefilteredEnvMap->resource,
+        &brdfLUT->resource
     };
 }
 
 Font* Resources::GetFont(const char* fontName, const float& pixelsPerEm, const float& pixelRange) {
-    std::string hashKey = std::string(fontName) + std::to_string(pixelsPerEm) + std::to_string(pixelRange);
-    long id = HASH(hashKey);
+    std::string key = std::string(fontName) + std::to_string(pixelsPerEm) + std::to_string(pixelRange);
 
-    if(Resources::fonts.find(id) != Resources::fonts.end()) {
-        return &Resources::fonts[id];
+    ResourceEntry<Font>* entry = Resources::fonts.Find(key);
+    if(entry == nullptr) {
+        entry = Resources::fonts.Insert(key, FontLoader::LoadFont(fontName, pixelsPerEm), 0);
     }
 
-    Font font = FontLoader::LoadFont(fontName, pixelsPerEm);
-
-    Resources::fonts[id] = font;
-
-    return &Resources::fonts[id];
+    entry->isPinned = true;
+    return &entry->resource;
 }
 
 CSVData Resources::GetCSV(const char* filePath) {
@@ -277,4 +469,177 @@ CSVData Resources::GetCSV(const char* filePath) {
     return data;
 }
 
+LoadHandle<Model> Resources::LoadModelAsync(const char* fileName, bool flipUVs) {
+    std::string key = GetModelKey(fileName, flipUVs);
+
+    auto pending = Resources::pendingModels.find(key);
+    if(pending != Resources::pendingModels.end()) {
+        return pending->second;
+    }
+
+    auto it = Resources::models.find(key);
+    if(it != Resources::models.end()) {
+        LoadHandle<Model> handle = LoadHandle<Model>::Create();
+        handle.Resolve(it->second);
+        return handle;
+    }
+
+    LoadHandle<Model> handle = LoadHandle<Model>::Create();
+    Resources::pendingModels[key] = handle;
+
+    // cache it once it's uploaded, the same as GetModel would have
+    LoadHandle<Model> load = AsyncLoader::LoadModel(FileSystem::CombinePath(ModelLoader::ResourceDir, fileName), flipUVs);
+    load.OnLoaded([key, handle](Model* model) {
+        Resources::pendingModels.erase(key);
+
+        if(model != nullptr) {
+            auto cached = Resources::models.emplace(key, model);
+            if(cached.second) {
+                model->AddRef();
+            }
+            else {
+                // GetModel loaded it meanwhile, so use that one instead. Nobody
+                // else has seen ours, so this deletes it.
+                model->Release();
+                model = cached.first->second;
+            }
+        }
+
+        handle.Resolve(model);
+    });
+
+    return handle;
+}
+
+LoadHandle<Texture2D> Resources::LoadTextureAsync(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps) {
+    std::string key = imageFileName;
+
+    auto pending = Resources::pendingTextures.find(key);
+    if(pending != Resources::pendingTextures.end()) {
+        return pending->second;
+    }
+
+    LoadHandle<Texture2D> handle = LoadHandle<Texture2D>::Create();
+
+    ResourceEntry<Texture2D>* entry = Resources::textures.Find(key);
+    if (entry != nullptr) {
+        entry->isPinned = true;
+        handle.Resolve(&entry->resource);
+        return handle;
+    }
+
+    Resources::pendingTextures[key] = handle;
+    AsyncLoader::LoadTexture(FileSystem::CombinePath(TextureLoader::ResourceDir, imageFileName), key, srgb, wrapMode, useMipmaps);
+
+    return handle;
+}
+
+void Resources::ProcessUploads(double budgetMs) {
+    AsyncLoader::ProcessUploads(budgetMs);
+
+    // textures just loaded come up blurry, and sharpen from here on
+    TextureStreamer::Update();
+}
+
+void Resources::FinishTextureLoad(const std::string& key, const Texture2D* texture, bool hasMipmaps) {
+    auto pending = Resources::pendingTextures.find(key);
+    if(pending == Resources::pendingTextures.end()) {
+        return;
+    }
+
+    LoadHandle<Texture2D> handle = pending->second;
+    Resources::pendingTextures.erase(pending);
+
+    if(texture == nullptr) {
+        handle.Resolve(nullptr);
+        return;
+    }
+
+    // it may have been loaded synchronously in the meantime
+    TextureHandle cached = CacheTexture(key, *texture, hasMipmaps);
+
+    // handed out as a raw pointer
+    cached.entry->isPinned = true;
+
+    handle.Resolve(cached.Get());
+}
+
+TextureHandle Resources::CacheTexture(const std::string& key, const Texture2D& texture, bool hasMipmaps) {
+    ResourceEntry<Texture2D>* entry = Resources::textures.Find(key);
+    if (entry != nullptr) {
+        Texture2D duplicate = texture;
+        duplicate.Dispose();
+    }
+    else {
+        entry = Resources::textures.Insert(key, texture, GetGpuBytes(texture, hasMipmaps));
+    }
+
+    return TextureHandle(entry);
+}
+
+TextureHandle Resources::FindTexture(const std::string& key) {
+    ResourceEntry<Texture2D>* entry = Resources::textures.Find(key);
+    return entry != nullptr ? TextureHandle(entry) : TextureHandle();
+}
+
+void Resources::SetMemoryBudget(size_t bytes) {
+    Resources::memoryBudget = bytes;
+
+    TrimToBudget();
+}
+
+size_t Resources::GetMemoryUsage() {
+    return Resources::textures.GetGpuBytes() + Resources::cubeMaps.GetGpuBytes();
+}
+
+void Resources::SetStreamingBudget(size_t bytes) {
+    TextureStreamer::SetBudget(bytes);
+}
+
+size_t Resources::GetStreamingUsage() {
+    return TextureStreamer::GetStreamedBytes();
+}
+
+void Resources::ReleaseUnused() {
+    // models first, since their meshes hold the materials
+    for(auto it = Resources::models.begin(); it != Resources::models.end();) {
+        if(it->second->GetRefCount() == 1) {
+            it->second->Release();
+            it = Resources::models.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    for(auto it = Resources::materials.begin(); it != Resources::materials.end();) {
+        if(it->second->GetRefCount() == 1) {
+            it->second->Release();
+            it = Resources::materials.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void Resources::TrimToBudget() {
+    while(GetMemoryUsage() > Resources::memoryBudget) {
+        // the least recently used of either kind
+        ResourceEntry<Texture2D>* texture = Resources::textures.FindLeastRecentlyUsed();
+        ResourceEntry<TextureCube>* cubeMap = Resources::cubeMaps.FindLeastRecentlyUsed();
+
+        if(cubeMap != nullptr && (texture == nullptr || cubeMap->lastUsed < texture->lastUsed)) {
+            Resources::cubeMaps.Evict(cubeMap);
+        }
+        else if(texture != nullptr) {
+            Resources::textures.Evict(texture);
+        }
+        else {
+            // everything left is in use
+            break;
+        }
+    }
+}
+
 } // namespace gyo
@@ -1,45 +1,187 @@
 #ifndef RESOURCES_H
 #define RESOURCES_H
 
+#include <gyo/mesh/Mesh.h>
+#include <gyo/resources/LoadHandle.h>
+#include <gyo/resources/ResourceCache.h>
 #include <gyo/shading/IBLEnvironment.h>
 
 #include <map>
 #include <set>
+#include <unordered_map>
 
 #include <glm/glm.hpp>
 #include <glad/glad.h>
 
+struct aiTexture;
+
 namespace gyo {
 
+class Material;
 class Model;
+class SceneNode;
 class Shader;
 class Texture2D;
 class TextureCube;
 class Font;
+class ThreadPool;
+struct GeometryDescriptor;
 
 typedef std::vector<std::vector<std::string>> CSVData;
 
+/**
+ * Loads and caches resources by name. Resources handed out as raw pointers
+ * by the Get functions are pinned, and stay loaded until Dispose. Models and
+ * shared materials are counted instead, and let go of at the end of the first
+ * frame nothing else references them, see ReleaseUnused. The Acquire
+ * functions instead return counted handles, and once a texture's last handle
+ * is gone it may be evicted, least recently bound first, to keep textures and
+ * cube maps within the memory budget. Materials hold handles to their
+ * textures, so a model's textures can go once the model itself has.
+ */
+
 class Resources {
 public:
-    static void Initialize();
+    // given a thread pool, loads can run in the background
+    static void Initialize(ThreadPool* threadPool = nullptr);
     static void Dispose();
 
+    /**
+     * The same model is returned for every call with the same file while
+     * it's still in use, to be shared between ModelNodes. Per-node materials
+     * go on the node, as material overrides, since changing the model's
+     * changes it everywhere.
+     */
     static Model* GetModel(const char* fileName, bool flipUVs);
+    static SceneNode* GetModelHierarchy(const char* fileName, bool flipUVs);
+
+    /**
+     * The shape, generated and uploaded the first time it's asked for, and
+     * then shared by every mesh built from it. Meshes built from their own
+     * Geometry are shared by content instead, once it's been hashed.
+     */
+    static SharedGeometry GetGeometry(const GeometryDescriptor& descriptor);
+
+    /**
+     * Returns a cached material that renders the same as material, i.e. has
+     * the same instance key, or else caches material and returns it. If it
+     * isn't returned, material is deleted unless something references it.
+     * Loaders pass what they create through here, so meshes and models that
+     * look alike share one material, and so its parameters: editing an
+     * imported model's material changes every model that looks like it. Use
+     * ModelNode::SetMaterialOverride to change just one.
+     */
+    static Material* ShareMaterial(Material* material);
     static Shader* GetShader(const char* vertFileName, const char* fragFileName, const std::set<std::string>& defines = {});
     static Shader* GetShader(const char* vertFileName, const char* geomFileName, const char* fragFileName, const std::set<std::string>& defines = { });
     static Texture2D* GetTexture(const char* imageFileName, bool srgb, int wrapMode = GL_REPEAT, bool useMipmaps = true);
     static Texture2D* GetHDRTexture(const char* imageFileName);
+
     static TextureCube* GetTextureCube(std::vector<const char*> faceFileNames, bool srgb);
     static IBLEnvironment GetEnvironment(const char* imageFileName);
     static Font* GetFont(const char* fontName, const float& pixelsPerEm, const float& pixelRange);
     static CSVData GetCSV(const char* filePath);
 
+    /**
+     * Same as GetModel and GetTexture, except files are read and decoded on
+     * worker threads, and uploaded a piece at a time by ProcessUploads.
+     * Loading a model or texture that's already loading shares the same handle.
+     * A loaded model is released with the frame it's ready in unless it's
+     * been given to a ModelNode, e.g. from its OnLoaded callback.
+     */
+    static LoadHandle<Model> LoadModelAsync(const char* fileName, bool flipUVs);
+    static LoadHandle<Texture2D> LoadTextureAsync(const char* imageFileName, bool srgb, int wrapMode = GL_REPEAT, bool useMipmaps = true);
+
+    // called once a frame on the main thread, spending up to budgetMs on uploads
+    static void ProcessUploads(double budgetMs);
+
+    // same as GetTexture and GetTextureCube, except the result can be evicted once released
+    static TextureHandle AcquireTexture(const char* imageFileName, bool srgb, int wrapMode = GL_REPEAT, bool useMipmaps = true);
+    static TextureCubeHandle AcquireTextureCube(std::vector<const char*> faceFileNames, bool srgb);
+
+    /**
+     * An image embedded in a model, decoded and uploaded once by the hash of
+     * its data, however many meshes, materials or models use it. The handle
+     * is empty if it couldn't be loaded.
+     */
+    static TextureHandle AcquireCompressedTexture(const unsigned char* data, size_t size, const std::string& formatHint, bool srgb);
+    static TextureHandle AcquireEmbeddedTexture(const aiTexture* texture, bool srgb);
+
+    // uncompressed texels laid out as assimp's, see TextureLoader::DecodeRawImage
+    static TextureHandle AcquireRawTexture(const unsigned char* texels, int width, int height, bool srgb);
+
+    /**
+     * Sets how many bytes of GPU memory textures and cube maps should stay
+     * within, going by their estimated sizes. There's no limit by default.
+     * Pinned and referenced resources are never evicted, so it may be exceeded.
+     */
+    static void SetMemoryBudget(size_t bytes);
+    static size_t GetMemoryUsage();
+
+    /**
+     * Sets how many bytes the streamed mip levels of cooked textures may take,
+     * on top of the memory budget, which only counts their smallest levels.
+     * Past it, textures covering the least of the screen stay blurrier. There's
+     * no limit by default. See TextureStreamer.
+     */
+    static void SetStreamingBudget(size_t bytes);
+    static size_t GetStreamingUsage();
+
+    // evicts released textures until we're within budget, called once a frame
+    static void TrimToBudget();
+
+    /**
+     * Releases cached models and materials that only we still reference,
+     * called at the end of each frame. Hold onto a model past the frame it was
+     * returned or loaded in with a ModelNode or AddRef, or it'll be deleted,
+     * along with its pool geometry, and its textures can be evicted.
+     */
+    static void ReleaseUnused();
+
 private:
+    friend class AsyncLoader;
+
+    static ThreadPool* threadPool;
+    static size_t memoryBudget;
+
     // our cached resources
-    static std::map<long, Shader> shaders;
-    static std::map<long, Texture2D> textures;
-    static std::map<long, TextureCube> cubeMaps;
-    static std::map<long, Font> fonts;
+    static ResourceCache<Shader> shaders;
+    static ResourceCache<Texture2D> textures;
+    static ResourceCache<TextureCube> cubeMaps;
+    static ResourceCache<Font> fonts;
+
+    // each holding a reference, which we release once it's the last one
+    static std::map<std::string, Model*> models;
+
+    struct CachedGeometry {
+        SharedGeometry geometry;
+        int poolHandle;     // our reference
+    };
+    static std::map<uint64_t, CachedGeometry> geometries;   // by descriptor key
+
+    // by instance key, each holding a reference
+    static std::unordered_map<uint64_t, Material*> materials;
+
+    // models and textures loading in the background, by key
+    static std::map<std::string, LoadHandle<Model>> pendingModels;
+    static std::map<std::string, LoadHandle<Texture2D>> pendingTextures;
+
+    // caches a texture AsyncLoader has uploaded, or null if it failed, and resolves its handle
+    static void FinishTextureLoad(const std::string& key, const Texture2D* texture, bool hasMipmaps);
+
+    // caches texture under key, unless there's one there already, in which case it's disposed
+    static TextureHandle CacheTexture(const std::string& key, const Texture2D& texture, bool hasMipmaps);
+
+    // empty if key isn't cached
+    static TextureHandle FindTexture(const std::string& key);
+
+    // embedded images are cached by content, with mipmaps
+    static std::string GetEmbeddedTextureKey(uint64_t contentHash, bool srgb);
+
+    static ResourceEntry<Texture2D>* LoadTexture(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps);
+    static ResourceEntry<TextureCube>* LoadTextureCube(const std::vector<const char*>& faceFileNames, bool srgb);
+    static std::string GetModelKey(const char* fileName, bool flipUVs);
+    static std::string GetDefinesKey(const std::set<std::string>& defines);
 
     static Texture2D GenerateBuiltInTexture(glm::vec4 color);
 };
@@ -0,0 +1,525 @@
+
+#include <gyo/resources/TextureCooker.h>
+#include <gyo/resources/BlockCompressor.h>
+#include <gyo/resources/KTX2.h>
+#include <gyo/resources/MeshCooker.h>
+#include <gyo/resources/TextureLoader.h>
+#include <gyo/utilities/Clock.h>
+#include <gyo/utilities/Log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+namespace gyo {
+
+static const char* const KTX2_WRITER = "gyokuro";
+
+// our own key, the source's size and modified time, to tell when we're stale
+static const char* const KTX2_SOURCE_KEY = "GYOsource";
+
+// where each level starts, a multiple of every block size we write
+static const size_t KTX2_LEVEL_ALIGNMENT = 16;
+
+/**
+ * One mip level as floats, RGBA. Color is linear, normals are unit vectors
+ * in [-1,1], and everything else is in [0,1].
+ */
+struct MipLevel {
+    int width = 0;
+    int height = 0;
+    std::vector<float> texels;
+};
+
+static float SRGBToLinear(float value) {
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSRGB(float value) {
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static void Normalize(float* normal) {
+    const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    if(length > 1e-6f) {
+        normal[0] /= length;
+        normal[1] /= length;
+        normal[2] /= length;
+    }
+}
+
+// the image as the first level, with the channels the encoder needs first
+static void LoadLevel(const DecodedImage& image, TextureKind kind, MipLevel& out) {
+    float toLinear[256];
+    for(int i = 0; i < 256; i++) {
+        toLinear[i] = SRGBToLinear(i / 255.0f);
+    }
+
+    out.width = image.width;
+    out.height = image.height;
+    out.texels.resize(static_cast<size_t>(image.width) * image.height * 4);
+
+    const size_t texelCount = static_cast<size_t>(image.width) * image.height;
+    for(size_t i = 0; i < texelCount; i++) {
+        const unsigned char* source = image.pixels + i * image.numChannels;
+
+        // gray, gray and alpha, RGB or RGBA
+        unsigned char rgba[4];
+        if(image.numChannels < 3) {
+            rgba[0] = rgba[1] = rgba[2] = source[0];
+            rgba[3] = image.numChannels == 2 ? source[1] : 255;
+        }
+        else {
+            std::memcpy(rgba, source, 3);
+            rgba[3] = image.numChannels == 4 ? source[3] : 255;
+        }
+
+        float* texel = &out.texels[i * 4];
+        switch(kind) {
+            case TextureKind::COLOR:
+                for(int c = 0; c < 3; c++) {
+                    texel[c] = toLinear[rgba[c]];
+                }
+                texel[3] = rgba[3] / 255.0f;
+                break;
+            case TextureKind::NORMAL:
+                for(int c = 0; c < 3; c++) {
+                    texel[c] = rgba[c] / 255.0f * 2.0f - 1.0f;
+                }
+                texel[3] = 1.0f;
+                Normalize(texel);
+                break;
+            case TextureKind::METALLIC_ROUGHNESS:
+                // roughness and metallic, into the two channels BC5 keeps
+                texel[0] = rgba[1] / 255.0f;
+                texel[1] = rgba[2] / 255.0f;
+                texel[2] = 0.0f;
+                texel[3] = 1.0f;
+                break;
+            case TextureKind::LINEAR_COLOR:
+            case TextureKind::GRAYSCALE:
+                for(int c = 0; c < 4; c++) {
+                    texel[c] = rgba[c] / 255.0f;
+                }
+                break;
+        }
+    }
+}
+
+// halves a level with a box filter, clamping at odd edges
+static void Downsample(const MipLevel& source, TextureKind kind, MipLevel& out) {
+    out.width = std::max(1, source.width / 2);
+    out.height = std::max(1, source.height / 2);
+    out.texels.resize(static_cast<size_t>(out.width) * out.height * 4);
+
+    for(int y = 0; y < out.height; y++) {
+        const int y0 = std::min(y * 2, source.height - 1);
+        const int y1 = std::min(y * 2 + 1, source.height - 1);
+
+        for(int x = 0; x < out.width; x++) {
+            const int x0 = std::min(x * 2, source.width - 1);
+            const int x1 = std::min(x * 2 + 1, source.width - 1);
+
+            const float* a = &source.texels[(static_cast<size_t>(y0) * source.width + x0) * 4];
+            const float* b = &source.texels[(static_cast<size_t>(y0) * source.width + x1) * 4];
+            const float* c = &source.texels[(static_cast<size_t>(y1) * source.width + x0) * 4];
+            const float* d = &source.texels[(static_cast<size_t>(y1) * source.width + x1) * 4];
+
+            float* texel = &out.texels[(static_cast<size_t>(y) * out.width + x) * 4];
+            for(int channel = 0; channel < 4; channel++) {
+                texel[channel] = (a[channel] + b[channel] + c[channel] + d[channel]) * 0.25f;
+            }
+
+            // averaged normals are shorter than they should be
+            if(kind == TextureKind::NORMAL) {
+                Normalize(texel);
+            }
+        }
+    }
+}
+
+// back to 8 bits a channel, for the encoder
+static void QuantizeLevel(const MipLevel& level, TextureKind kind, std::vector<unsigned char>& out) {
+    out.resize(level.texels.size());
+
+    for(size_t i = 0; i < level.texels.size(); i++) {
+        const int channel = static_cast<int>(i % 4);
+        float value = level.texels[i];
+
+        if(kind == TextureKind::COLOR && channel < 3) {
+            value = LinearToSRGB(value);
+        }
+        else if(kind == TextureKind::NORMAL && channel < 3) {
+            value = value * 0.5f + 0.5f;
+        }
+
+        out[i] = static_cast<unsigned char>(std::clamp(static_cast<int>(value * 255.0f + 0.5f), 0, 255));
+    }
+}
+
+// how a kind of texture is compressed, and what its channels sample as
+static BlockFormat ChooseFormat(TextureKind kind, TextureCompression compression, bool hasAlpha, uint32_t& vkFormat, const char*& swizzle) {
+    const bool srgb = kind == TextureKind::COLOR;
+
+    switch(kind) {
+        case TextureKind::NORMAL:
+            vkFormat = KTX2_FORMAT_BC5_UNORM;
+            swizzle = "rg01";
+            return BlockFormat::BC5;
+        case TextureKind::METALLIC_ROUGHNESS:
+            // back where glTF has them, roughness in green and metallic in blue
+            vkFormat = KTX2_FORMAT_BC5_UNORM;
+            swizzle = "0rg1";
+            return BlockFormat::BC5;
+        case TextureKind::GRAYSCALE:
+            vkFormat = KTX2_FORMAT_BC4_UNORM;
+            swizzle = "rrr1";
+            return BlockFormat::BC4;
+        default:
+            break;
+    }
+
+    swizzle = hasAlpha ? "rgba" : "rgb1";
+
+    if(compression == TextureCompression::BC7) {
+        vkFormat = srgb ? KTX2_FORMAT_BC7_SRGB : KTX2_FORMAT_BC7_UNORM;
+        return BlockFormat::BC7;
+    }
+
+    if(hasAlpha) {
+        vkFormat = srgb ? KTX2_FORMAT_BC3_SRGB : KTX2_FORMAT_BC3_UNORM;
+        return BlockFormat::BC3;
+    }
+
+    vkFormat = srgb ? KTX2_FORMAT_BC1_RGB_SRGB : KTX2_FORMAT_BC1_RGB_UNORM;
+    return BlockFormat::BC1;
+}
+
+// a basic data format descriptor block, as the KTX2 spec requires
+static void WriteDataFormatDescriptor(uint32_t vkFormat, std::vector<uint32_t>& out) {
+    struct Sample {
+        uint32_t bitOffset;
+        uint32_t bitLength;
+        uint32_t channel;
+    };
+
+    // the Khronos color models for each BCn, and their channels
+    uint32_t colorModel = 0;
+    std::vector<Sample> samples;
+    switch(vkFormat) {
+        case KTX2_FORMAT_BC1_RGB_UNORM:
+        case KTX2_FORMAT_BC1_RGB_SRGB:
+            colorModel = 128;
+            samples = { { 0, 64, 0 } };
+            break;
+        case KTX2_FORMAT_BC3_UNORM:
+        case KTX2_FORMAT_BC3_SRGB:
+            colorModel = 130;
+            samples = { { 0, 64, 15 }, { 64, 64, 0 } };
+            break;
+        case KTX2_FORMAT_BC4_UNORM:
+            colorModel = 131;
+            samples = { { 0, 64, 0 } };
+            break;
+        case KTX2_FORMAT_BC5_UNORM:
+            colorModel = 132;
+            samples = { { 0, 64, 0 }, { 64, 64, 1 } };
+            break;
+        case KTX2_FORMAT_BC7_UNORM:
+        case KTX2_FORMAT_BC7_SRGB:
+            colorModel = 134;
+            samples = { { 0, 128, 0 } };
+            break;
+    }
+
+    const uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+    const uint32_t transferFunction = IsKTX2FormatSRGB(vkFormat) ? 2 : 1;
+
+    out.push_back(4 + blockSize);                                   // total size
+    out.push_back(0);                                               // Khronos, basic
+    out.push_back(2 | blockSize << 16);                             // version 1.3
+    out.push_back(colorModel | 1 << 8 | transferFunction << 16);    // BT.709 primaries
+    out.push_back(3 | 3 << 8);                                      // 4x4 blocks
+    out.push_back(static_cast<uint32_t>(GetKTX2BlockSize(vkFormat)));
+    out.push_back(0);
+
+    for(const Sample& sample : samples) {
+        out.push_back(sample.bitOffset | (sample.bitLength - 1) << 16 | sample.channel << 24);
+        out.push_back(0);
+        out.push_back(0);
+        out.push_back(0xFFFFFFFF);
+    }
+}
+
+bool TextureCooker::Cook(const std::string& sourcePath, const std::string& cookedPath, TextureKind kind, TextureCompression compression) {
+    // flipped, as TextureLoader::LoadTexture does
+    DecodedImage image;
+    if(!TextureLoader::DecodeImageFile(sourcePath, true, image)) {
+        return false;
+    }
+
+    std::vector<unsigned char> cooked;
+    const bool isCooked = CookToMemory(image, kind, compression, true, sourcePath, cooked);
+    image.Free();
+
+    if(!isCooked) {
+        return false;
+    }
+
+    std::ofstream file(cookedPath, std::ios::binary | std::ios::trunc);
+    if(!file) {
+        LOGE("Failed to open %s for writing", cookedPath.c_str());
+        return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(cooked.data()), cooked.size());
+
+    if(!file) {
+        LOGE("Failed to write %s", cookedPath.c_str());
+        return false;
+    }
+
+    LOGI("Wrote %s, %zu bytes", cookedPath.c_str(), cooked.size());
+
+    return true;
+}
+
+bool TextureCooker::CookToMemory(const DecodedImage& image, TextureKind kind, TextureCompression compression,
+    bool flippedVertically, const std::string& sourcePath, std::vector<unsigned char>& out)
+{
+    if(compression == TextureCompression::NONE) {
+        LOGE("Textures are only cooked block compressed");
+        return false;
+    }
+
+    if(image.pixels == nullptr || image.width <= 0 || image.height <= 0 || image.numChannels < 1 || image.numChannels > 4) {
+        LOGE("Can't cook an empty image");
+        return false;
+    }
+
+    CLOCK(Texture_Cook);
+
+    MipLevel level;
+    LoadLevel(image, kind, level);
+
+    bool hasAlpha = false;
+    if(kind == TextureKind::COLOR || kind == TextureKind::LINEAR_COLOR) {
+        for(size_t i = 3; i < level.texels.size() && !hasAlpha; i += 4) {
+            hasAlpha = level.texels[i] < 1.0f;
+        }
+    }
+
+    uint32_t vkFormat;
+    const char* swizzle;
+    const BlockFormat format = ChooseFormat(kind, compression, hasAlpha, vkFormat, swizzle);
+
+    // every level down to 1x1, largest first
+    std::vector<std::vector<unsigned char>> levels;
+    std::vector<unsigned char> texels;
+    while(true) {
+        QuantizeLevel(level, kind, texels);
+
+        levels.emplace_back();
+        BlockCompressor::Compress(texels.data(), level.width, level.height, format, levels.back());
+
+        if(level.width == 1 && level.height == 1) {
+            break;
+        }
+
+        MipLevel next;
+        Downsample(level, kind, next);
+        level = std::move(next);
+    }
+
+    // key/value data, sorted by key, each padded to 4 bytes
+
+    std::vector<unsigned char> keyValues;
+    auto appendKeyValue = [&keyValues](const char* key, const void* value, size_t valueSize) {
+        const size_t keySize = std::strlen(key) + 1;
+        const uint32_t length = static_cast<uint32_t>(keySize + valueSize);
+
+        const size_t offset = keyValues.size();
+        keyValues.resize(offset + 4 + (length + 3) / 4 * 4, 0);
+        std::memcpy(keyValues.data() + offset, &length, 4);
+        std::memcpy(keyValues.data() + offset + 4, key, keySize);
+        std::memcpy(keyValues.data() + offset + 4 + keySize, value, valueSize);
+    };
+
+    if(!sourcePath.empty()) {
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        if(!MeshCooker::GetSourceStamp(sourcePath, sourceSize, sourceModifiedTime)) {
+            LOGE("Failed to read %s", sourcePath.c_str());
+            return false;
+        }
+
+        unsigned char stamp[16];
+        std::memcpy(stamp, &sourceSize, 8);
+        std::memcpy(stamp + 8, &sourceModifiedTime, 8);
+        appendKeyValue(KTX2_SOURCE_KEY, stamp, sizeof(stamp));
+    }
+
+    // rows bottom up are "ru", right and up, top down are "rd"
+    appendKeyValue("KTXorientation", flippedVertically ? "ru" : "rd", 3);
+    appendKeyValue("KTXswizzle", swizzle, 5);
+    appendKeyValue("KTXwriter", KTX2_WRITER, std::strlen(KTX2_WRITER) + 1);
+
+    std::vector<uint32_t> descriptor;
+    WriteDataFormatDescriptor(vkFormat, descriptor);
+
+    KTX2Header header = {};
+    std::memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(header.identifier));
+    header.vkFormat = vkFormat;
+    header.typeSize = 1;
+    header.pixelWidth = static_cast<uint32_t>(image.width);
+    header.pixelHeight = static_cast<uint32_t>(image.height);
+    header.faceCount = 1;
+    header.levelCount = static_cast<uint32_t>(levels.size());
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levels.size() * sizeof(KTX2LevelIndex));
+    header.dfdByteLength = static_cast<uint32_t>(descriptor.size() * sizeof(uint32_t));
+    header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+    header.kvdByteLength = static_cast<uint32_t>(keyValues.size());
+
+    // lay the levels out smallest first, so a reader can stop partway
+    std::vector<KTX2LevelIndex> levelIndex(levels.size());
+    size_t offset = header.kvdByteOffset + header.kvdByteLength;
+    for(size_t i = levels.size(); i-- > 0;) {
+        offset = (offset + KTX2_LEVEL_ALIGNMENT - 1) / KTX2_LEVEL_ALIGNMENT * KTX2_LEVEL_ALIGNMENT;
+        levelIndex[i].byteOffset = offset;
+        levelIndex[i].byteLength = levels[i].size();
+        levelIndex[i].uncompressedByteLength = levels[i].size();
+        offset += levels[i].size();
+    }
+
+    out.assign(offset, 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+    std::memcpy(out.data() + sizeof(header), levelIndex.data(), levelIndex.size() * sizeof(KTX2LevelIndex));
+    std::memcpy(out.data() + header.dfdByteOffset, descriptor.data(), header.dfdByteLength);
+    std::memcpy(out.data() + header.kvdByteOffset, keyValues.data(), header.kvdByteLength);
+    for(size_t i = 0; i < levels.size(); i++) {
+        std::memcpy(out.data() + levelIndex[i].byteOffset, levels[i].data(), levels[i].size());
+    }
+
+    LOGI("Cooked a %dx%d texture, %zu levels in %zu bytes", image.width, image.height, levels.size(), out.size());
+
+    return true;
+}
+
+bool TextureCooker::Read(const unsigned char* data, size_t size, const std::string& sourcePath, KTX2View& out) {
+    KTX2Header header;
+    if(size < sizeof(header)) {
+        LOGW("Cooked texture is truncated");
+        return false;
+    }
+    std::memcpy(&header, data, sizeof(header));
+
+    if(std::memcmp(header.identifier, KTX2_IDENTIFIER, sizeof(header.identifier)) != 0) {
+        LOGW("Not a KTX2 file");
+        return false;
+    }
+
+    // only what we write, a single 2D image with its mips
+    if(GetKTX2BlockSize(header.vkFormat) == 0 || header.supercompressionScheme != 0 ||
+        header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1 ||
+        header.pixelWidth == 0 || header.pixelHeight == 0 || header.levelCount == 0 || header.levelCount > 32 ||
+        std::max(header.pixelWidth, header.pixelHeight) >> (header.levelCount - 1) == 0) {
+        LOGW("Cooked texture is in a format we don't read");
+        return false;
+    }
+
+    auto isInFile = [size](uint64_t offset, uint64_t length) {
+        return offset <= size && length <= size - offset;
+    };
+
+    if(!isInFile(sizeof(header), uint64_t(header.levelCount) * sizeof(KTX2LevelIndex)) ||
+        !isInFile(header.kvdByteOffset, header.kvdByteLength)) {
+        LOGW("Cooked texture is truncated");
+        return false;
+    }
+
+    // the swizzle, and when we cooked it, from the key/value data
+
+    bool hasSourceStamp = false;
+    uint64_t cookedSourceSize = 0;
+    int64_t cookedSourceModifiedTime = 0;
+
+    const unsigned char* cursor = data + header.kvdByteOffset;
+    const unsigned char* end = cursor + header.kvdByteLength;
+    while(end - cursor >= 4) {
+        uint32_t length;
+        std::memcpy(&length, cursor, 4);
+        cursor += 4;
+
+        if(length > static_cast<size_t>(end - cursor)) {
+            LOGW("Cooked texture has invalid key/value data");
+            return false;
+        }
+
+        const char* key = reinterpret_cast<const char*>(cursor);
+        const size_t keySize = strnlen(key, length) + 1;
+        if(keySize > length) {
+            LOGW("Cooked texture has invalid key/value data");
+            return false;
+        }
+
+        const unsigned char* value = cursor + keySize;
+        const size_t valueSize = length - keySize;
+
+        if(std::strcmp(key, "KTXswizzle") == 0 && valueSize >= 4) {
+            for(int c = 0; c < 4; c++) {
+                const char channel = static_cast<char>(value[c]);
+                if(channel != '\0' && std::strchr("rgba01", channel) != nullptr) {
+                    out.swizzle[c] = channel;
+                }
+            }
+        }
+        else if(std::strcmp(key, KTX2_SOURCE_KEY) == 0 && valueSize == 16) {
+            std::memcpy(&cookedSourceSize, value, 8);
+            std::memcpy(&cookedSourceModifiedTime, value + 8, 8);
+            hasSourceStamp = true;
+        }
+
+        cursor += std::min<size_t>((length + 3) / 4 * 4, end - cursor);
+    }
+
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+    if(hasSourceStamp && !sourcePath.empty() && MeshCooker::GetSourceStamp(sourcePath, sourceSize, sourceModifiedTime) &&
+        (sourceSize != cookedSourceSize || sourceModifiedTime != cookedSourceModifiedTime)) {
+        LOGW("Cooked texture is out of date with %s, recook it", sourcePath.c_str());
+        return false;
+    }
+
+    // every level must be where the index says, and exactly its size
+
+    out.levels.resize(header.levelCount);
+    for(uint32_t i = 0; i < header.levelCount; i++) {
+        KTX2LevelIndex entry;
+        std::memcpy(&entry, data + sizeof(header) + i * sizeof(KTX2LevelIndex), sizeof(entry));
+
+        const uint32_t width = std::max(1U, header.pixelWidth >> i);
+        const uint32_t height = std::max(1U, header.pixelHeight >> i);
+        if(!isInFile(entry.byteOffset, entry.byteLength) || entry.byteLength != GetKTX2LevelSize(header.vkFormat, width, height)) {
+            LOGW("Cooked texture has an invalid level");
+            return false;
+        }
+
+        out.levels[i].data = data + entry.byteOffset;
+        out.levels[i].size = static_cast<size_t>(entry.byteLength);
+    }
+
+    out.vkFormat = header.vkFormat;
+    out.width = header.pixelWidth;
+    out.height = header.pixelHeight;
+
+    return true;
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).replace_extension(KTX2_EXTENSION).string();
+}
+
+} // namespace gyo
@@ -0,0 +1,64 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace gyo {
+
+struct DecodedImage;
+struct KTX2View;
+
+// what a texture holds, which decides how it's filtered and compressed
+enum class TextureKind {
+    COLOR,              // sRGB color, BC1, or BC3 if it uses alpha
+    LINEAR_COLOR,       // the same, sampled as linear data
+    NORMAL,             // tangent space x and y in BC5, z is rebuilt when sampled
+    METALLIC_ROUGHNESS, // glTF's, roughness in green and metallic in blue, in BC5
+    GRAYSCALE           // the red channel alone in BC4, e.g. ambient occlusion
+};
+
+enum class TextureCompression {
+    NONE,   // images are kept as they are
+    BC,     // color in BC1 or BC3
+    BC7     // color in BC7, slower to cook and needs GL_ARB_texture_compression_bptc
+};
+
+/**
+ * Encodes images offline into block compressed .ktx2 files (see KTX2.h),
+ * with every mip precomputed, which TextureLoader uploads as they are. Mips
+ * of color are averaged in linear space, and of normals renormalized.
+ *
+ * Doesn't touch GL, so it can run from a tool without a context.
+ */
+class TextureCooker {
+public:
+    /**
+     * Returns false, and logs why, if the image couldn't be decoded or written
+     */
+    static bool Cook(const std::string& sourcePath, const std::string& cookedPath, TextureKind kind, TextureCompression compression);
+
+    /**
+     * Same as above, from an image already decoded, with the file's bytes
+     * returned instead of written. flippedVertically says the rows are bottom
+     * up, as LoadTexture decodes files. Given a sourcePath, the file records
+     * it to tell when it's stale.
+     */
+    static bool CookToMemory(const DecodedImage& image, TextureKind kind, TextureCompression compression,
+        bool flippedVertically, const std::string& sourcePath, std::vector<unsigned char>& cooked);
+
+    /**
+     * Reads back a cooked texture, checking every offset against size.
+     * Returns false, and logs why, if it's invalid, in a format we don't
+     * write, or is stale compared to its source. A missing source isn't stale.
+     */
+    static bool Read(const unsigned char* data, size_t size, const std::string& sourcePath, KTX2View& out);
+
+    // where the cooked copy of an image lives, next to the source
+    static std::string GetCookedPath(const std::string& sourcePath);
+};
+
+} // namespace gyo
+
+#endif // TEXTURE_COOKER_H
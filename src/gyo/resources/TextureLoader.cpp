@@ -1,56 +1,295 @@
 
 #include <gyo/resources/TextureLoader.h>
+#include <gyo/resources/CookedModel.h>
+#include <gyo/resources/KTX2.h>
+#include <gyo/resources/TextureCooker.h>
+#include <gyo/resources/TextureStreamer.h>
+#include <gyo/core/ThreadPool.h>
 #include <gyo/shading/Texture2D.h>
 #include <gyo/shading/TextureCube.h>
 #include <gyo/utilities/FileSystem.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
+#include <gyo/utilities/MappedFile.h>
 
 #include <algorithm>
+#include <cstring>
+#include <filesystem>
 
 #include <stb/stb_image.h>
 #include <assimp/texture.h>
 #include <jpeglib.h>
 
+// block compressed formats outside core 3.3, from EXT_texture_compression_s3tc,
+// EXT_texture_sRGB and ARB_texture_compression_bptc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+#define GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM 0x8E8D
+#endif
+
 namespace gyo {
 
 std::string TextureLoader::ResourceDir = "";
+bool TextureLoader::supportsS3TC = false;
+bool TextureLoader::supportsBPTC = false;
+
+unsigned int TextureLoader::GetCompressedInternalFormat(uint32_t vkFormat) {
+    switch(vkFormat) {
+        case KTX2_FORMAT_BC1_RGB_UNORM: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case KTX2_FORMAT_BC1_RGB_SRGB: return GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+        case KTX2_FORMAT_BC3_UNORM: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case KTX2_FORMAT_BC3_SRGB: return GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+        case KTX2_FORMAT_BC4_UNORM: return GL_COMPRESSED_RED_RGTC1;
+        case KTX2_FORMAT_BC5_UNORM: return GL_COMPRESSED_RG_RGTC2;
+        case KTX2_FORMAT_BC7_UNORM: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case KTX2_FORMAT_BC7_SRGB: return GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+        default: return 0;
+    }
+}
+
+static GLint GetSwizzle(char channel) {
+    switch(channel) {
+        case 'r': return GL_RED;
+        case 'g': return GL_GREEN;
+        case 'b': return GL_BLUE;
+        case '0': return GL_ZERO;
+        case '1': return GL_ONE;
+        default: return GL_ALPHA;
+    }
+}
+
+void DecodedImage::Free() {
+    // stb, libjpeg and DecodeEmbeddedImage all allocate with malloc
+    free(pixels);
+    pixels = nullptr;
+}
+
+void TextureLoader::Initialize() {
+    GLint extensionCount = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+    glCheckError();
+
+    for(GLint i = 0; i < extensionCount; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        glCheckError();
+
+        if(extension == nullptr) {
+            continue;
+        }
+
+        if(std::strcmp(extension, "GL_EXT_texture_compression_s3tc") == 0) {
+            supportsS3TC = true;
+        }
+        else if(std::strcmp(extension, "GL_ARB_texture_compression_bptc") == 0) {
+            supportsBPTC = true;
+        }
+    }
+
+    LOGI("Block compression: S3TC %s, RGTC yes, BPTC %s", supportsS3TC ? "yes" : "no", supportsBPTC ? "yes" : "no");
+}
 
 Texture2D TextureLoader::LoadTexture(const char* imageFileName, bool srgb, int wrapMode, bool useMipmaps) {
     // get the full file path
     std::string imageFilePath = FileSystem::CombinePath(ResourceDir, imageFileName);
 
+    // prefer the cooked copy, which has its mips already, and can come up
+    // with only its smallest while the rest stream in
+    MappedFile* cookedFile = new MappedFile();
+    KTX2View cooked;
+    Texture2D* compressed = nullptr;
+    if(ReadCookedTexture(imageFilePath, srgb, *cookedFile, cooked)) {
+        if(TextureStreamer::CanStream(cooked, useMipmaps)) {
+            // which now owns the file
+            compressed = TextureStreamer::CreateTexture(cookedFile, cooked, wrapMode);
+            cookedFile = nullptr;
+        }
+        else {
+            compressed = CreateCompressedTexture2D(cooked, wrapMode, useMipmaps);
+        }
+    }
+    delete cookedFile;
+
+    if(compressed != nullptr) {
+        Texture2D texture = *compressed;
+        delete compressed;
+        return texture;
+    }
+
+    // load and flip vertically
+    DecodedImage image;
+    if(!DecodeImageFile(imageFilePath, true, image)) {
+        throw std::runtime_error("Failed to load texture");
+    }
+
+    Texture2D texture = CreateTexture2D(image, srgb, wrapMode, useMipmaps);
+
+    // free the image memory
+    image.Free();
+
+    return texture;
+}
+
+Texture2D* TextureLoader::LoadEmbeddedTexture(const aiTexture* texture, bool srgb) {
+    DecodedImage image;
+    if(!DecodeEmbeddedImage(texture, image)) {
+        return nullptr;
+    }
+
+    Texture2D* result = new Texture2D(CreateTexture2D(image, srgb, GL_REPEAT, true));
+    image.Free();
+
+    return result;
+}
+
+Texture2D* TextureLoader::LoadRawTexture(const unsigned char* texels, int width, int height, bool srgb) {
+    DecodedImage image;
+    if(!DecodeRawImage(texels, width, height, image)) {
+        return nullptr;
+    }
+
+    Texture2D* result = new Texture2D(CreateTexture2D(image, srgb, GL_REPEAT, true));
+    image.Free();
+
+    return result;
+}
+
+Texture2D* TextureLoader::LoadCompressedTexture(const unsigned char* data, size_t size, const std::string& formatHint, bool srgb) {
+    if(formatHint == KTX2_EXTENSION) {
+        KTX2View cooked;
+        if(!TextureCooker::Read(data, size, "", cooked)) {
+            return nullptr;
+        }
+
+        if(IsKTX2FormatSRGB(cooked.vkFormat) != srgb) {
+            LOGW("Cooked texture isn't %s, as it's sampled", srgb ? "sRGB" : "linear");
+            return nullptr;
+        }
+
+        if(TextureStreamer::CanStream(cooked, true)) {
+            return TextureStreamer::CreateTexture(data, size, cooked, GL_REPEAT);
+        }
+
+        return CreateCompressedTexture2D(cooked, GL_REPEAT, true);
+    }
+
+    DecodedImage image;
+    if(!DecodeCompressedImage(data, size, formatHint, image)) {
+        return nullptr;
+    }
+
+    Texture2D* texture = new Texture2D(CreateTexture2D(image, srgb, GL_REPEAT, true));
+
+    // free the image data after uploading it to the GPU
+    image.Free();
+
+    return texture;
+}
+
+bool TextureLoader::DecodeImageFile(const std::string& imageFilePath, bool flipVertically, DecodedImage& out) {
+    // per thread, so workers can decode alongside the main thread
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+    out.pixels = stbi_load(imageFilePath.c_str(), &out.width, &out.height, &out.numChannels, 0);
+    if(!out.pixels) {
+        LOGE("Failed to load image at path '%s': %s", imageFilePath.c_str(), stbi_failure_reason());
+        return false;
+    }
+
+    return true;
+}
+
+bool TextureLoader::DecodeCompressedImage(const unsigned char* data, size_t size, const std::string& formatHint, DecodedImage& out) {
+    if(formatHint == "jpg" || formatHint == "jpeg") {
+        TextureLoader::DecompressJpegData(data, size, &out.width, &out.height, &out.numChannels, &out.pixels);
+    }
+    else {
+        // stb works out the format itself, so the hint is only for the log.
+        // Embedded images are stored top row first, as we upload them.
+        stbi_set_flip_vertically_on_load_thread(false);
+        out.pixels = stbi_load_from_memory(data, static_cast<int>(size), &out.width, &out.height, &out.numChannels, 0);
+
+        if(!out.pixels) {
+            LOGE("Failed to decode embedded %s image: %s", formatHint.c_str(), stbi_failure_reason());
+            return false;
+        }
+    }
+
+    if(!out.pixels) {
+        LOGE("Failed to extract embedded image data");
+        return false;
+    }
+
+    return true;
+}
+
+bool TextureLoader::DecodeEmbeddedImage(const aiTexture* texture, DecodedImage& out) {
+    // compressed data, where texture->mWidth is the size of the raw data
+    // https://assimp-docs.readthedocs.io/en/latest/usage/use_the_lib.html#textures
+    if(texture->mHeight == 0) {
+        return DecodeCompressedImage(reinterpret_cast<const unsigned char*>(texture->pcData), texture->mWidth, texture->achFormatHint, out);
+    }
+
+    // otherwise mWidth * mHeight texels
+    return DecodeRawImage(reinterpret_cast<const unsigned char*>(texture->pcData),
+        static_cast<int>(texture->mWidth), static_cast<int>(texture->mHeight), out);
+}
+
+bool TextureLoader::DecodeRawImage(const unsigned char* texels, int width, int height, DecodedImage& out) {
+    const size_t texelCount = static_cast<size_t>(width) * height;
+
+    out.pixels = static_cast<unsigned char*>(malloc(texelCount * 4));
+    if(!out.pixels) {
+        LOGE("Failed to allocate memory for embedded image data");
+        return false;
+    }
+
+    out.width = width;
+    out.height = height;
+    out.numChannels = 4;
+
+    // swizzled to the RGBA we upload
+    for(size_t i = 0; i < texelCount; i++) {
+        out.pixels[i * 4 + 0] = texels[i * 4 + 2];
+        out.pixels[i * 4 + 1] = texels[i * 4 + 1];
+        out.pixels[i * 4 + 2] = texels[i * 4 + 0];
+        out.pixels[i * 4 + 3] = texels[i * 4 + 3];
+    }
+
+    return true;
+}
+
+Texture2D TextureLoader::CreateTexture2D(const DecodedImage& image, bool srgb, int wrapMode, bool useMipmaps) {
     // create and bind the texture object
     unsigned int id;
     glGenTextures(1, &id);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
-    glCheckError();
-    
-    // flip vertically
-    stbi_set_flip_vertically_on_load(true);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, id);
     
-    // load and generate the texture
-    int width, height, numChannels;
-    unsigned char *data = stbi_load(imageFilePath.c_str(), &width, &height, &numChannels, 0);
-    if (data) {
-        unsigned int format;
-        unsigned int internalFormat;
-        GetTextureFormat(srgb, numChannels, &format, &internalFormat);
-        
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    unsigned int format;
+    unsigned int internalFormat;
+    GetTextureFormat(srgb, image.numChannels, &format, &internalFormat);
+
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.pixels);
+    glCheckError();
+    if (useMipmaps) {
+        glGenerateMipmap(GL_TEXTURE_2D);
         glCheckError();
-        if (useMipmaps) {
-            glGenerateMipmap(GL_TEXTURE_2D);
-            glCheckError();
-        }
     }
-    else {
-        throw std::runtime_error("Failed to load texture");
-    }
-
-    // free the image memory
-    stbi_image_free(data);
 
     // set the texture wrapping/filtering options
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
@@ -62,78 +301,137 @@ Texture2D TextureLoader::LoadTexture(const char* imageFileName, bool srgb, int w
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
 
-    return Texture2D(id, width, height, numChannels == 4);
+    return Texture2D(id, image.width, image.height, image.numChannels == 4);
 }
 
-Texture2D* TextureLoader::LoadEmbeddedTexture(const aiTexture* texture, bool srgb) {
-    int width, height, numChannels;
-    unsigned char* imageData = nullptr;
+bool TextureLoader::IsBlockFormatSupported(uint32_t vkFormat) {
+    switch(vkFormat) {
+        case KTX2_FORMAT_BC1_RGB_UNORM:
+        case KTX2_FORMAT_BC1_RGB_SRGB:
+        case KTX2_FORMAT_BC3_UNORM:
+        case KTX2_FORMAT_BC3_SRGB:
+            return supportsS3TC;
+        case KTX2_FORMAT_BC4_UNORM:
+        case KTX2_FORMAT_BC5_UNORM:
+            // RGTC is core since 3.0
+            return true;
+        case KTX2_FORMAT_BC7_UNORM:
+        case KTX2_FORMAT_BC7_SRGB:
+            return supportsBPTC;
+        default:
+            return false;
+    }
+}
 
-    // check format of the embedded texture
-    std::string formatHint(texture->achFormatHint);
+void TextureLoader::SelectCookedTextures(CookedModelView& cooked) {
+    for(CookedTexture& entry : cooked.textures) {
+        if(std::strncmp(entry.formatHint, KTX2_EXTENSION, sizeof(entry.formatHint)) != 0) {
+            continue;
+        }
 
-    // compressed data
-    // https://assimp-docs.readthedocs.io/en/latest/usage/use_the_lib.html#textures
-    if(texture->mHeight == 0) {
-        if(formatHint == "jpg") {
-            // texture->mWidth is the size of the raw data
-            TextureLoader::DecompressJpegData(
-                texture->pcData, texture->mWidth, &width, &height, &numChannels, &imageData);
+        KTX2View view;
+        if(TextureCooker::Read(cooked.data + entry.offset, entry.size, "", view) && IsBlockFormatSupported(view.vkFormat)) {
+            continue;
         }
-        // else if(formatHint == "png") {} // TODO look into using libpng
-        else {
-            LOGE("Unsupported embedded texture compression format %s", formatHint.c_str());
-            return nullptr;
+
+        if(entry.sourceSize == 0) {
+            LOGW("Cooked texture's format isn't supported here, and it has no source to fall back on");
+            continue;
         }
+
+        entry.offset = entry.sourceOffset;
+        entry.size = entry.sourceSize;
+        std::memcpy(entry.formatHint, entry.sourceFormatHint, sizeof(entry.formatHint));
+        entry.sourceSize = 0;
     }
-    // uncompressed image data
-    else {
-        // TODO parse format from hint - e.g. rgba8888, argb8888, rgba5650, etc.
-        LOGE("Unsupported embedded texture format %s", formatHint.c_str());
-        return nullptr;
+}
+
+bool TextureLoader::ReadCookedTexture(const std::string& imageFilePath, bool srgb, MappedFile& file, KTX2View& out) {
+    std::string cookedFilePath = TextureCooker::GetCookedPath(imageFilePath);
+    if(cookedFilePath == imageFilePath || !std::filesystem::exists(cookedFilePath) || !file.Open(cookedFilePath)) {
+        return false;
     }
 
-    if(!imageData) {
-        LOGE("Failed to extract image data from aiTexture");
+    bool isUsable = TextureCooker::Read(file.GetData(), file.GetSize(), imageFilePath, out);
+    if(isUsable && IsKTX2FormatSRGB(out.vkFormat) != srgb) {
+        LOGW("Cooked texture isn't %s, as it's sampled", srgb ? "sRGB" : "linear");
+        isUsable = false;
+    }
+    if(isUsable && !IsBlockFormatSupported(out.vkFormat)) {
+        LOGW("Cooked texture's format isn't supported here");
+        isUsable = false;
+    }
+
+    if(!isUsable) {
+        LOGW("Ignoring cooked texture %s", cookedFilePath.c_str());
+        file.Close();
+    }
+
+    return isUsable;
+}
+
+Texture2D* TextureLoader::CreateCompressedTexture2D(const KTX2View& view, int wrapMode, bool useMipmaps, int firstLevel) {
+    if(!IsBlockFormatSupported(view.vkFormat)) {
+        LOGE("Block compressed format %u isn't supported", view.vkFormat);
         return nullptr;
     }
 
+    const unsigned int internalFormat = GetCompressedInternalFormat(view.vkFormat);
+
     // create and bind the texture object
     unsigned int id;
     glGenTextures(1, &id);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
-    glCheckError();
-    
-    unsigned int format;
-    unsigned int internalFormat;
-    GetTextureFormat(srgb, numChannels, &format, &internalFormat);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, id);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, imageData);
+    // each level as it was cooked, no mipmaps to generate
+    const int levelCount = useMipmaps ? static_cast<int>(view.levels.size()) : 1;
+    firstLevel = std::clamp(firstLevel, 0, levelCount - 1);
+    size_t gpuBytes = 0;
+    for(int level = firstLevel; level < levelCount; level++) {
+        const int width = std::max(1, static_cast<int>(view.width >> level));
+        const int height = std::max(1, static_cast<int>(view.height >> level));
+
+        glCompressedTexImage2D(GL_TEXTURE_2D, level, internalFormat, width, height, 0,
+            static_cast<GLsizei>(view.levels[level].size), view.levels[level].data);
+        glCheckError();
+
+        gpuBytes += view.levels[level].size;
+    }
+
+    // only sample the levels we have
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
     glCheckError();
-    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
     glCheckError();
 
     // set the texture wrapping/filtering options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrapMode);
     glCheckError();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrapMode);
     glCheckError();
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, levelCount > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glCheckError();
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // put the channels back where shaders expect them, e.g. metallic and
+    // roughness out of BC5's red and green
+    GLint swizzle[4];
+    for(int c = 0; c < 4; c++) {
+        swizzle[c] = GetSwizzle(view.swizzle[c]);
+    }
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
     glCheckError();
 
-    // free the image data after uploading it to the GPU
-    free(imageData);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+    Texture2D* texture = new Texture2D(id, view.width, view.height, view.swizzle[3] == 'a');
+    texture->gpuBytes = gpuBytes;
 
-    return new Texture2D(id, width, height, numChannels == 4);
+    return texture;
 }
 
 Texture2D TextureLoader::LoadHDRTexture(const char* imageFileName) {
@@ -144,11 +442,10 @@ Texture2D TextureLoader::LoadHDRTexture(const char* imageFileName) {
     unsigned int id;
     glGenTextures(1, &id);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, id);
     
     // flip vertically
-    stbi_set_flip_vertically_on_load(true);
+    stbi_set_flip_vertically_on_load_thread(true);
     
     // load and generate the texture
     int width, height, numChannels;
@@ -174,46 +471,57 @@ Texture2D TextureLoader::LoadHDRTexture(const char* imageFileName) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glCheckError();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
 
     return Texture2D(id, width, height, false);
 }
 
-TextureCube TextureLoader::LoadTextureCube(std::vector<const char*> faceFileNames, bool srgb) {
+TextureCube TextureLoader::LoadTextureCube(std::vector<const char*> faceFileNames, bool srgb, ThreadPool* threadPool) {
     // get the full file paths
     std::vector<std::string> faceFilePaths(6);
     std::transform(faceFileNames.begin(), faceFileNames.end(), faceFilePaths.begin(), [](const char* fileName) {
         return FileSystem::CombinePath(ResourceDir, fileName);
     });
 
+    // decode every face first, in parallel if we can, without flipping
+    std::vector<DecodedImage> faces(faceFilePaths.size());
+    auto decodeFace = [&](int i) {
+        if(!DecodeImageFile(faceFilePaths[i], false, faces[i])) {
+            LOGE("Failed to load cubemap at path '%s'", faceFilePaths[i].c_str());
+        }
+    };
+
+    if(threadPool != nullptr) {
+        threadPool->ParallelFor(static_cast<int>(faces.size()), decodeFace);
+    }
+    else {
+        for(int i = 0; i < static_cast<int>(faces.size()); i++) {
+            decodeFace(i);
+        }
+    }
+
     // create and bind the texture object
     unsigned int id;
     glGenTextures(1, &id);
     glCheckError();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, id);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_CUBE_MAP, id);
 
-    // flip vertically
-    stbi_set_flip_vertically_on_load(false);
-    
-    // load and generate the textures
-    int width, height, numChannels;
-    for(unsigned int i = 0; i < faceFilePaths.size(); i++) {
-        unsigned char* data = stbi_load(faceFilePaths[i].c_str(), &width, &height, &numChannels, 0);
-        if(data) {
+    // generate the textures
+    int width = 0, height = 0;
+    for(unsigned int i = 0; i < faces.size(); i++) {
+        if(faces[i].pixels) {
             unsigned int format;
             unsigned int internalFormat;
-            GetTextureFormat(srgb, numChannels, &format, &internalFormat);
+            GetTextureFormat(srgb, faces[i].numChannels, &format, &internalFormat);
 
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+            width = faces[i].width;
+            height = faces[i].height;
+
+            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, faces[i].pixels);
             glCheckError();
         }
-        else {
-            LOGE("Failed to load cubemap at path '%s'", faceFilePaths[i].c_str());
-        }
 
-        stbi_image_free(data);
+        faces[i].Free();
     }
 
     // set the texture wrapping/filtering options
@@ -228,8 +536,7 @@ TextureCube TextureLoader::LoadTextureCube(std::vector<const char*> faceFileName
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     glCheckError();
 
-    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_CUBE_MAP, 0);
 
     return TextureCube(id, width, height);
 }
@@ -239,8 +546,7 @@ Texture2D TextureLoader::GenerateTexture2D(int width, int height, unsigned int f
     unsigned int id;
     glGenTextures(1, &id);
     glCheckError();
-    glBindTexture(GL_TEXTURE_2D, id);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, id);
 
     // generate the texture
     glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, pixels);
@@ -256,8 +562,7 @@ Texture2D TextureLoader::GenerateTexture2D(int width, int height, unsigned int f
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glCheckError();
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
 
     bool hasAlpha = format == GL_RGBA || format == GL_SRGB_ALPHA;
 
@@ -265,7 +570,7 @@ Texture2D TextureLoader::GenerateTexture2D(int width, int height, unsigned int f
 }
 
 void TextureLoader::DecompressJpegData(
-    const aiTexel* pcData, const unsigned int& pcDataSize,
+    const unsigned char* pcData, const size_t& pcDataSize,
     int* width, int* height, int* numChannels,
     unsigned char** imageData
 ) {
@@ -1,35 +1,113 @@
 #ifndef TEXTURE_LOADER_H
 #define TEXTURE_LOADER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
 #include <glad/glad.h>
 
 struct aiTexture;
-struct aiTexel;
 
 namespace gyo {
 
+class MappedFile;
 class Texture2D;
 class TextureCube;
+class ThreadPool;
+struct KTX2View;
+struct CookedModelView;
+
+/**
+ * 8-bit pixels decoded on the CPU, before they're uploaded. Decoding touches
+ * no GL, so it can happen on any thread.
+ */
+struct DecodedImage {
+    int width = 0;
+    int height = 0;
+    int numChannels = 0;
+    unsigned char* pixels = nullptr;    // malloc'd, rows tightly packed
+
+    void Free();
+};
 
 class TextureLoader {
 public:
     static std::string ResourceDir;
-    
+
+    // finds which block compressed formats the context can sample, call on
+    // the main thread before loading anything
+    static void Initialize();
+
+    // uploads the image's cooked .ktx2 instead, if it has an up to date one
     static Texture2D LoadTexture(const char* imageFileName, bool srgb, int wrapMode = GL_REPEAT, bool useMipmaps = true);
+    // these upload a new texture every call, Resources caches them by content
     static Texture2D* LoadEmbeddedTexture(const aiTexture* texture, bool srgb);
+
+    // decodes an image file already in memory, e.g. one embedded in a model,
+    // or uploads a cooked "ktx2" as it is
+    static Texture2D* LoadCompressedTexture(const unsigned char* data, size_t size, const std::string& formatHint, bool srgb);
+    static Texture2D* LoadRawTexture(const unsigned char* texels, int width, int height, bool srgb);
     static Texture2D LoadHDRTexture(const char* imageFileName);
-    static TextureCube LoadTextureCube(std::vector<const char*> faceFileNames, bool srgb);
+
+    // given a thread pool, the faces are decoded in parallel
+    static TextureCube LoadTextureCube(std::vector<const char*> faceFileNames, bool srgb, ThreadPool* threadPool = nullptr);
     static Texture2D GenerateTexture2D(int width, int height, unsigned int format, const unsigned char* pixels);
 
+    // returns false, and logs why, if the image couldn't be decoded
+    static bool DecodeImageFile(const std::string& imageFilePath, bool flipVertically, DecodedImage& out);
+
+    /**
+     * Decodes an image file in memory, in place. JPEGs go through libjpeg,
+     * and anything else stb_image reads, e.g. PNG, TGA or BMP, through that.
+     */
+    static bool DecodeCompressedImage(const unsigned char* data, size_t size, const std::string& formatHint, DecodedImage& out);
+
+    // either an embedded image file, or assimp's uncompressed BGRA texels
+    static bool DecodeEmbeddedImage(const aiTexture* texture, DecodedImage& out);
+
+    // texels laid out as assimp's aiTexel, BGRA 8888 top row first, e.g. as
+    // cooked with COOKED_TEXTURE_RAW_FORMAT
+    static bool DecodeRawImage(const unsigned char* texels, int width, int height, DecodedImage& out);
+
+    // the pixel format and internal format to upload an image with
+    static void GetTextureFormat(const bool& srgb, const int& numChannels, unsigned int* format, unsigned int* internalFormat);
+
+    // false before Initialize, or if the context lacks the extension
+    static bool IsBlockFormatSupported(uint32_t vkFormat);
+
+    /**
+     * Points each block compressed texture of a cooked model that we can't
+     * sample back at the image file it was compressed from, if it was kept.
+     * Touches no GL, but call after Initialize.
+     */
+    static void SelectCookedTextures(CookedModelView& cooked);
+
+    /**
+     * Maps the cooked .ktx2 of an image file, if there's one that's up to
+     * date, cooked as srgb says, and in a format we can sample. Touches no GL.
+     */
+    static bool ReadCookedTexture(const std::string& imageFilePath, bool srgb, MappedFile& file, KTX2View& out);
+
+    /**
+     * Uploads every level as it is, or only the first without mipmaps, and
+     * with a firstLevel only from there on, sampling none finer. Returns
+     * null, and logs why, if the format isn't supported.
+     */
+    static Texture2D* CreateCompressedTexture2D(const KTX2View& view, int wrapMode, bool useMipmaps, int firstLevel = 0);
+
+    // the GL internal format of a KTX2 format, or 0 if we don't know it
+    static unsigned int GetCompressedInternalFormat(uint32_t vkFormat);
+
 private:
+    static bool supportsS3TC;
+    static bool supportsBPTC;
+
     static void DecompressJpegData(
-        const aiTexel* pcData, const unsigned int& pcDataSize,
+        const unsigned char* pcData, const size_t& pcDataSize,
         int* width, int* height, int* numChannels,
         unsigned char** imageData);
-    static void GetTextureFormat(const bool& srgb, const int& numChannels, unsigned int* format, unsigned int* internalFormat);
+    static Texture2D CreateTexture2D(const DecodedImage& image, bool srgb, int wrapMode, bool useMipmaps);
 };
   
 } // namespace gyo
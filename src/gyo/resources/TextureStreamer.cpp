@@ -0,0 +1,267 @@
+
+#include <gyo/resources/TextureStreamer.h>
+#include <gyo/resources/KTX2.h>
+#include <gyo/resources/TextureLoader.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/shading/Texture2D.h>
+#include <gyo/utilities/GetError.h>
+#include <gyo/utilities/MappedFile.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glad/glad.h>
+
+namespace gyo {
+
+struct TextureStreamer::StreamedTexture {
+    unsigned int id = 0;
+    unsigned int internalFormat = 0;
+
+    // where view's levels point into, one or the other
+    MappedFile* file = nullptr;
+    std::vector<unsigned char> bytes;
+    KTX2View view;
+
+    int tailLevel = 0;      // this and smaller are always resident
+    int residentLevel = 0;  // the largest level uploaded, and the base level
+    int wantedLevel = 0;    // the largest level the footprint calls for
+    int targetLevel = 0;    // what of that fits in the budget
+
+    float footprint = 0;    // pixels across on screen, 0 if not seen
+
+    ~StreamedTexture() { delete file; }
+};
+
+bool TextureStreamer::isInitialized = false;
+bool TextureStreamer::hasRequests = false;
+uint32_t TextureStreamer::version = 0;
+size_t TextureStreamer::budget = std::numeric_limits<size_t>::max();
+size_t TextureStreamer::streamedBytes = 0;
+std::unordered_map<unsigned int, TextureStreamer::StreamedTexture*> TextureStreamer::textures;
+std::vector<TextureStreamer::StreamedTexture*> TextureStreamer::priorities;
+
+// the first level that fits within TAIL_SIZE, or the last level
+static int GetTailLevel(const KTX2View& view) {
+    const int levelCount = static_cast<int>(view.levels.size());
+    for(int level = 0; level < levelCount; level++) {
+        if(std::max(view.width >> level, view.height >> level) <= TextureStreamer::TAIL_SIZE) {
+            return level;
+        }
+    }
+
+    return levelCount - 1;
+}
+
+void TextureStreamer::Initialize() {
+    isInitialized = true;
+}
+
+void TextureStreamer::Dispose() {
+    for(auto& pair : textures) {
+        delete pair.second;
+    }
+    textures.clear();
+    priorities.clear();
+
+    streamedBytes = 0;
+    hasRequests = false;
+    isInitialized = false;
+}
+
+bool TextureStreamer::CanStream(const KTX2View& view, bool useMipmaps) {
+    return isInitialized && useMipmaps && view.levels.size() > 1 && GetTailLevel(view) > 0;
+}
+
+Texture2D* TextureStreamer::CreateTexture(MappedFile* file, const KTX2View& view, int wrapMode) {
+    StreamedTexture* streamed = new StreamedTexture();
+    streamed->file = file;
+    streamed->view = view;
+
+    return Register(streamed, wrapMode);
+}
+
+Texture2D* TextureStreamer::CreateTexture(const unsigned char* data, size_t size, const KTX2View& view, int wrapMode) {
+    StreamedTexture* streamed = new StreamedTexture();
+    streamed->bytes.assign(data, data + size);
+    streamed->view = view;
+
+    // point the levels into our copy
+    for(auto& level : streamed->view.levels) {
+        level.data = streamed->bytes.data() + (level.data - data);
+    }
+
+    return Register(streamed, wrapMode);
+}
+
+Texture2D* TextureStreamer::Register(StreamedTexture* streamed, int wrapMode) {
+    streamed->tailLevel = GetTailLevel(streamed->view);
+    streamed->residentLevel = streamed->tailLevel;
+    streamed->wantedLevel = streamed->tailLevel;
+    streamed->targetLevel = streamed->tailLevel;
+    streamed->internalFormat = TextureLoader::GetCompressedInternalFormat(streamed->view.vkFormat);
+
+    Texture2D* texture = TextureLoader::CreateCompressedTexture2D(streamed->view, wrapMode, true, streamed->tailLevel);
+    if(texture == nullptr) {
+        delete streamed;
+        return nullptr;
+    }
+
+    texture->isStreamed = true;
+    streamed->id = texture->GetId();
+    textures[streamed->id] = streamed;
+    version++;
+
+    return texture;
+}
+
+void TextureStreamer::Remove(unsigned int textureId) {
+    auto it = textures.find(textureId);
+    if(it == textures.end()) {
+        return;
+    }
+
+    StreamedTexture* streamed = it->second;
+    for(int level = streamed->residentLevel; level < streamed->tailLevel; level++) {
+        streamedBytes -= streamed->view.levels[level].size;
+    }
+
+    delete streamed;
+    textures.erase(it);
+}
+
+void TextureStreamer::BeginRequests() {
+    hasRequests = true;
+
+    for(auto& pair : textures) {
+        pair.second->footprint = 0;
+    }
+}
+
+void TextureStreamer::Request(const Texture2D* texture, float footprint) {
+    if(texture == nullptr || !texture->isStreamed) {
+        return;
+    }
+
+    auto it = textures.find(texture->GetId());
+    if(it != textures.end()) {
+        it->second->footprint = std::max(it->second->footprint, footprint);
+    }
+}
+
+void TextureStreamer::Update() {
+    if(!isInitialized || textures.empty()) {
+        return;
+    }
+
+    // the level whose texels are about the size of a pixel. Until something
+    // reports footprints, e.g. a SceneController, everything wants it all.
+    priorities.clear();
+    for(auto& pair : textures) {
+        StreamedTexture* streamed = pair.second;
+
+        streamed->wantedLevel = hasRequests ? streamed->tailLevel : 0;
+        if(streamed->footprint > 0) {
+            const float texelsPerPixel = std::max(streamed->view.width, streamed->view.height) / streamed->footprint;
+            const float level = texelsPerPixel > 1 ? std::log2(texelsPerPixel) : 0.0f;
+            streamed->wantedLevel = static_cast<int>(std::min(level, static_cast<float>(streamed->tailLevel)));
+        }
+
+        priorities.push_back(streamed);
+    }
+
+    std::sort(priorities.begin(), priorities.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->footprint > b->footprint;
+    });
+
+    // what we want fits in the budget, the biggest on screen first
+    size_t plannedBytes = 0;
+    for(StreamedTexture* streamed : priorities) {
+        streamed->targetLevel = streamed->tailLevel;
+        while(streamed->targetLevel > streamed->wantedLevel) {
+            const size_t size = streamed->view.levels[streamed->targetLevel - 1].size;
+            if(size > budget - plannedBytes) {
+                break;
+            }
+
+            plannedBytes += size;
+            streamed->targetLevel--;
+        }
+    }
+
+    // then keep what's already uploaded while there's room, in case it's
+    // wanted again soon
+    for(StreamedTexture* streamed : priorities) {
+        while(streamed->targetLevel > streamed->residentLevel) {
+            const size_t size = streamed->view.levels[streamed->targetLevel - 1].size;
+            if(size > budget - plannedBytes) {
+                break;
+            }
+
+            plannedBytes += size;
+            streamed->targetLevel--;
+        }
+    }
+
+    // evicting first, so we stay within the budget while uploading
+    for(StreamedTexture* streamed : priorities) {
+        while(streamed->residentLevel < streamed->targetLevel) {
+            EvictLevel(streamed);
+        }
+    }
+
+    // a level at a time, so each texture sharpens bit by bit
+    size_t uploadedBytes = 0;
+    for(StreamedTexture* streamed : priorities) {
+        while(streamed->residentLevel > streamed->targetLevel && uploadedBytes < UPLOAD_BYTES_PER_FRAME) {
+            uploadedBytes += streamed->view.levels[streamed->residentLevel - 1].size;
+            UploadLevel(streamed);
+        }
+    }
+}
+
+void TextureStreamer::SetBudget(size_t bytes) {
+    budget = bytes;
+}
+
+void TextureStreamer::UploadLevel(StreamedTexture* streamed) {
+    const int level = streamed->residentLevel - 1;
+    const KTX2View::Level& data = streamed->view.levels[level];
+
+    RenderState::BindTexture(0, GL_TEXTURE_2D, streamed->id);
+
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, streamed->internalFormat,
+        std::max(1, static_cast<int>(streamed->view.width >> level)),
+        std::max(1, static_cast<int>(streamed->view.height >> level)),
+        0, static_cast<GLsizei>(data.size), data.data);
+    glCheckError();
+
+    // only now sample it
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glCheckError();
+
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+    streamed->residentLevel = level;
+    streamedBytes += data.size;
+}
+
+void TextureStreamer::EvictLevel(StreamedTexture* streamed) {
+    const int level = streamed->residentLevel;
+
+    RenderState::BindTexture(0, GL_TEXTURE_2D, streamed->id);
+
+    // stop sampling it first, then redefine it as empty to free its memory
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    glCheckError();
+    glTexImage2D(GL_TEXTURE_2D, level, GL_R8, 0, 0, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glCheckError();
+
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
+
+    streamed->residentLevel = level + 1;
+    streamedBytes -= streamed->view.levels[level].size;
+}
+
+} // namespace gyo
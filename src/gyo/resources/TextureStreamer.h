@@ -0,0 +1,102 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace gyo {
+
+class MappedFile;
+class Texture2D;
+struct KTX2View;
+
+/**
+ * Streams the mip levels of cooked textures on demand. A texture comes up
+ * straight away with its low levels, those no bigger than TAIL_SIZE, which
+ * stay resident. Each frame the scene reports how many pixels every visible
+ * texture covers, and the levels that footprint calls for are read from the
+ * cooked data and uploaded, largest footprint first and a few at a time.
+ *
+ * The streamed levels share a budget. Past it, the textures covering the
+ * fewest pixels are held at, or dropped back to, coarser levels. Which levels
+ * are sampled is clamped with GL_TEXTURE_BASE_LEVEL and GL_TEXTURE_MAX_LEVEL,
+ * and dropped levels are redefined as empty to give their memory back.
+ *
+ * Main thread only.
+ */
+class TextureStreamer {
+public:
+    // levels at most this wide and high are always resident
+    static const unsigned int TAIL_SIZE = 64;
+
+    // about how many bytes of levels Update uploads at most
+    static const size_t UPLOAD_BYTES_PER_FRAME = 4 << 20;
+
+    static void Initialize();
+
+    // stops streaming, textures keep whatever levels they have
+    static void Dispose();
+
+    // whether a cooked texture has levels worth streaming
+    static bool CanStream(const KTX2View& view, bool useMipmaps);
+
+    /**
+     * Uploads only the tail of a cooked texture, and streams the rest from
+     * file as it's needed, which we now own. Null if it couldn't be created.
+     */
+    static Texture2D* CreateTexture(MappedFile* file, const KTX2View& view, int wrapMode);
+
+    // same as above, from a copy of data, e.g. a texture embedded in a model
+    static Texture2D* CreateTexture(const unsigned char* data, size_t size, const KTX2View& view, int wrapMode);
+
+    // called from Texture2D::Dispose, before the texture is deleted
+    static void Remove(unsigned int textureId);
+
+    /**
+     * Starts a new set of footprints, forgetting the last. Textures without
+     * one fall back to their tail, unless the budget has room to keep them.
+     * Until this is first called, every texture streams in completely.
+     */
+    static void BeginRequests();
+
+    // the texture covers about footprint pixels across on screen, the most
+    // of any request this set wins
+    static void Request(const Texture2D* texture, float footprint);
+
+    // evicts what's over budget, then uploads the most wanted levels
+    static void Update();
+
+    // bumped whenever a texture is created, which wants a footprint before
+    // it streams, so scenes know to request again
+    static const uint32_t& GetVersion() { return version; }
+
+    static void SetBudget(size_t bytes);
+    static size_t GetBudget() { return budget; }
+
+    // what the streamed levels take now, not counting the tails
+    static size_t GetStreamedBytes() { return streamedBytes; }
+
+private:
+    struct StreamedTexture;
+
+    static bool isInitialized;
+    static bool hasRequests;    // whether anything has called BeginRequests
+    static uint32_t version;
+    static size_t budget;
+    static size_t streamedBytes;
+
+    static std::unordered_map<unsigned int, StreamedTexture*> textures;
+
+    // scratch for Update, by footprint
+    static std::vector<StreamedTexture*> priorities;
+
+    static Texture2D* Register(StreamedTexture* streamed, int wrapMode);
+    static void UploadLevel(StreamedTexture* streamed);
+    static void EvictLevel(StreamedTexture* streamed);
+};
+
+} // namespace gyo
+
+#endif // TEXTURE_STREAMER_H
@@ -0,0 +1,550 @@
+
+#include <gyo/scene/BVH.h>
+#include <gyo/mesh/ModelNode.h>
+#include <gyo/math/Frustum.h>
+#include <gyo/math/FrustumKernel.h>
+#include <gyo/math/TransformKernel.h>
+#include <gyo/core/ThreadPool.h>
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace gyo {
+
+static AABB EmptyBounds() {
+    return {
+        glm::vec3(std::numeric_limits<float>::max()),
+        glm::vec3(std::numeric_limits<float>::lowest())
+    };
+}
+
+static void GrowBounds(AABB& bounds, const AABB& other) {
+    bounds.min = glm::min(bounds.min, other.min);
+    bounds.max = glm::max(bounds.max, other.max);
+}
+
+static float SurfaceArea(const AABB& bounds) {
+    // half the surface area is enough for comparing SAH costs
+    glm::vec3 e = glm::max(bounds.max - bounds.min, glm::vec3(0.0f));
+    return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+BVH::~BVH() {
+    // the scene owns the models, just detach them from the tree
+    for(ModelNode* modelNode : items) {
+        modelNode->bvh = nullptr;
+        modelNode->bvhLeaf = -1;
+    }
+    items.clear();
+}
+
+void BVH::Insert(ModelNode* modelNode) {
+    modelNode->bvh = this;
+    modelNode->bvhLeaf = -1;
+
+    items.push_back(modelNode);
+
+    // defer the build until the next update, so adding many models at once
+    // only builds the tree a single time
+    needsRebuild = true;
+}
+
+void BVH::MarkDirty(ModelNode* modelNode) {
+    int leaf = modelNode->bvhLeaf;
+
+    if(needsRebuild || leaf < 0 || isLeafDirty[leaf]) {
+        return;
+    }
+
+    isLeafDirty[leaf] = true;
+    dirtyLeaves.push_back(leaf);
+}
+
+void BVH::Update() {
+    if(needsRebuild) {
+        Build();
+    }
+    else if(!dirtyLeaves.empty()) {
+        Refit();
+
+        // refitting keeps the tree valid, but not good. once the tree has
+        // loosened enough start over from scratch
+        if(refitSurfaceAreaGrowth > builtSurfaceArea * REBUILD_THRESHOLD) {
+            Build();
+        }
+    }
+}
+
+void BVH::Build() {
+    nodes.clear();
+    dirtyLeaves.clear();
+    needsRebuild = false;
+    refitSurfaceAreaGrowth = 0.0f;
+    builtSurfaceArea = 0.0f;
+
+    const int itemCount = static_cast<int>(items.size());
+    if(itemCount == 0) {
+        isLeafDirty.clear();
+        itemStream.Resize(0);
+        return;
+    }
+
+    // cache the bounds and centroids, these are partitioned alongside the items
+
+    itemBounds.resize(itemCount);
+    itemCentroids.resize(itemCount);
+
+    AABB rootBounds = EmptyBounds();
+    for(int i = 0; i < itemCount; i++) {
+        itemBounds[i] = items[i]->GetBounds();
+        itemCentroids[i] = (itemBounds[i].min + itemBounds[i].max) * 0.5f;
+
+        GrowBounds(rootBounds, itemBounds[i]);
+    }
+
+    // a binary tree with n leaves has at most 2n - 1 nodes
+    nodes.reserve(2 * itemCount - 1);
+
+    BVHNode root;
+    root.bounds = rootBounds;
+    root.first = 0;
+    root.count = itemCount;
+    nodes.push_back(root);
+
+    buildStack.clear();
+    buildStack.push_back(0);
+
+    while(!buildStack.empty()) {
+        int nodeIndex = buildStack.back();
+        buildStack.pop_back();
+
+        Subdivide(nodeIndex);
+    }
+
+    // the items are in their final order now, stream their bounds for culling
+
+    itemStream.Resize(itemCount);
+    for(int i = 0; i < itemCount; i++) {
+        itemStream.Set(i, itemBounds[i]);
+    }
+
+    // point each model at its leaf so it can flag it for refitting
+
+    for(int i = 0; i < static_cast<int>(nodes.size()); i++) {
+        const BVHNode& node = nodes[i];
+
+        builtSurfaceArea += SurfaceArea(node.bounds);
+
+        if(node.left < 0) {
+            for(int j = node.first; j < node.first + node.count; j++) {
+                items[j]->bvhLeaf = i;
+            }
+        }
+    }
+
+    isLeafDirty.assign(nodes.size(), false);
+}
+
+void BVH::Subdivide(int nodeIndex) {
+    const int first = nodes[nodeIndex].first;
+    const int count = nodes[nodeIndex].count;
+
+    if(count <= MAX_LEAF_SIZE) {
+        return;
+    }
+
+    // bin along each axis of the centroid bounds, keeping the cheapest split
+
+    AABB centroidBounds = EmptyBounds();
+    for(int i = first; i < first + count; i++) {
+        centroidBounds.min = glm::min(centroidBounds.min, itemCentroids[i]);
+        centroidBounds.max = glm::max(centroidBounds.max, itemCentroids[i]);
+    }
+
+    int bestAxis = -1;
+    int bestSplit = 0;
+    float bestCost = std::numeric_limits<float>::max();
+
+    for(int axis = 0; axis < 3; axis++) {
+        const float axisMin = centroidBounds.min[axis];
+        const float extent = centroidBounds.max[axis] - axisMin;
+        if(extent <= 0.0f) {
+            continue;
+        }
+
+        AABB binBounds[SAH_BIN_COUNT];
+        int binCounts[SAH_BIN_COUNT] = {};
+        for(int b = 0; b < SAH_BIN_COUNT; b++) {
+            binBounds[b] = EmptyBounds();
+        }
+
+        const float scale = SAH_BIN_COUNT / extent;
+        for(int i = first; i < first + count; i++) {
+            int b = std::min(SAH_BIN_COUNT - 1, static_cast<int>((itemCentroids[i][axis] - axisMin) * scale));
+            binCounts[b]++;
+            GrowBounds(binBounds[b], itemBounds[i]);
+        }
+
+        // sweep from the right to gather the area of each right hand side
+
+        float rightAreas[SAH_BIN_COUNT - 1];
+        int rightCounts[SAH_BIN_COUNT - 1];
+
+        AABB rightBounds = EmptyBounds();
+        int rightCount = 0;
+        for(int b = SAH_BIN_COUNT - 1; b > 0; b--) {
+            GrowBounds(rightBounds, binBounds[b]);
+            rightCount += binCounts[b];
+
+            rightAreas[b - 1] = SurfaceArea(rightBounds);
+            rightCounts[b - 1] = rightCount;
+        }
+
+        // then sweep from the left, evaluating each split plane
+
+        AABB leftBounds = EmptyBounds();
+        int leftCount = 0;
+        for(int b = 0; b < SAH_BIN_COUNT - 1; b++) {
+            GrowBounds(leftBounds, binBounds[b]);
+            leftCount += binCounts[b];
+
+            if(leftCount == 0 || rightCounts[b] == 0) {
+                continue;
+            }
+
+            float cost = leftCount * SurfaceArea(leftBounds) + rightCounts[b] * rightAreas[b];
+            if(cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b + 1;
+            }
+        }
+    }
+
+    // partition the items in place, so every subtree stays a contiguous range
+
+    int mid = first;
+
+    if(bestAxis >= 0) {
+        const float axisMin = centroidBounds.min[bestAxis];
+        const float scale = SAH_BIN_COUNT / (centroidBounds.max[bestAxis] - axisMin);
+
+        int i = first;
+        int j = first + count - 1;
+        while(i <= j) {
+            int b = std::min(SAH_BIN_COUNT - 1, static_cast<int>((itemCentroids[i][bestAxis] - axisMin) * scale));
+            if(b < bestSplit) {
+                i++;
+            }
+            else {
+                std::swap(items[i], items[j]);
+                std::swap(itemBounds[i], itemBounds[j]);
+                std::swap(itemCentroids[i], itemCentroids[j]);
+                j--;
+            }
+        }
+
+        mid = i;
+    }
+
+    // all centroids coincide; any split is as good as another
+    if(mid == first || mid == first + count) {
+        mid = first + count / 2;
+    }
+
+    BVHNode left;
+    left.parent = nodeIndex;
+    left.first = first;
+    left.count = mid - first;
+    left.bounds = EmptyBounds();
+    for(int i = left.first; i < left.first + left.count; i++) {
+        GrowBounds(left.bounds, itemBounds[i]);
+    }
+
+    BVHNode right;
+    right.parent = nodeIndex;
+    right.first = mid;
+    right.count = first + count - mid;
+    right.bounds = EmptyBounds();
+    for(int i = right.first; i < right.first + right.count; i++) {
+        GrowBounds(right.bounds, itemBounds[i]);
+    }
+
+    const int leftIndex = static_cast<int>(nodes.size());
+    nodes[nodeIndex].left = leftIndex;
+    nodes.push_back(left);
+    nodes.push_back(right);
+
+    buildStack.push_back(leftIndex);
+    buildStack.push_back(leftIndex + 1);
+}
+
+void BVH::Refit() {
+    UpdateDirtyModelBounds();
+
+    // children are always stored after their parents, so when a large share
+    // of the leaves moved a single reverse sweep refits the whole tree
+    const bool refitAll = dirtyLeaves.size() * 4 > nodes.size();
+
+    if(refitAll) {
+        for(int i = static_cast<int>(nodes.size()) - 1; i >= 0; i--) {
+            BVHNode& node = nodes[i];
+            const float oldArea = SurfaceArea(node.bounds);
+
+            if(node.left < 0) {
+                if(!isLeafDirty[i]) {
+                    continue;
+                }
+
+                node.bounds = EmptyBounds();
+                for(int j = node.first; j < node.first + node.count; j++) {
+                    const AABB& bounds = items[j]->GetBounds();
+                    itemStream.Set(j, bounds);
+                    GrowBounds(node.bounds, bounds);
+                }
+            }
+            else {
+                node.bounds = nodes[node.left].bounds;
+                GrowBounds(node.bounds, nodes[node.left + 1].bounds);
+            }
+
+            refitSurfaceAreaGrowth += std::max(0.0f, SurfaceArea(node.bounds) - oldArea);
+        }
+    }
+    else {
+        for(int leaf : dirtyLeaves) {
+            BVHNode& node = nodes[leaf];
+            const float oldArea = SurfaceArea(node.bounds);
+
+            node.bounds = EmptyBounds();
+            for(int j = node.first; j < node.first + node.count; j++) {
+                const AABB& bounds = items[j]->GetBounds();
+                itemStream.Set(j, bounds);
+                GrowBounds(node.bounds, bounds);
+            }
+
+            refitSurfaceAreaGrowth += std::max(0.0f, SurfaceArea(node.bounds) - oldArea);
+
+            // propagate up until a parent's bounds no longer change
+            int parent = node.parent;
+            while(parent >= 0) {
+                BVHNode& parentNode = nodes[parent];
+
+                AABB bounds = nodes[parentNode.left].bounds;
+                GrowBounds(bounds, nodes[parentNode.left + 1].bounds);
+
+                if(bounds.min == parentNode.bounds.min && bounds.max == parentNode.bounds.max) {
+                    break;
+                }
+
+                refitSurfaceAreaGrowth += std::max(0.0f, SurfaceArea(bounds) - SurfaceArea(parentNode.bounds));
+                parentNode.bounds = bounds;
+                parent = parentNode.parent;
+            }
+        }
+    }
+
+    for(int leaf : dirtyLeaves) {
+        isLeafDirty[leaf] = false;
+    }
+    dirtyLeaves.clear();
+}
+
+void BVH::UpdateDirtyModelBounds() {
+    // transform the bounds of every moved model in one batch, rather than
+    // lazily one at a time as the leaves ask for them
+
+    refitModels.clear();
+    refitModelBounds.clear();
+    refitTransforms.clear();
+    refitWorldBounds.clear();
+
+    for(int leaf : dirtyLeaves) {
+        const BVHNode& node = nodes[leaf];
+
+        for(int i = node.first; i < node.first + node.count; i++) {
+            ModelNode* modelNode = items[i];
+            if(!modelNode->isBoundsDirty) {
+                continue;
+            }
+
+            refitModels.push_back(modelNode);
+            refitModelBounds.push_back(&modelNode->model->GetBounds());
+            refitTransforms.push_back(&modelNode->GetTransform());
+            refitWorldBounds.push_back(&modelNode->bounds);
+        }
+    }
+
+    TransformKernel::TransformAABBs(
+        static_cast<int>(refitModels.size()),
+        refitModelBounds.data(),
+        refitTransforms.data(),
+        refitWorldBounds.data());
+
+    for(ModelNode* modelNode : refitModels) {
+        modelNode->UpdateBoundsLUT();
+        modelNode->isBoundsDirty = false;
+    }
+}
+
+void BVH::Cull(const Frustum& frustum, std::vector<ModelNode*>& visibleModels, ThreadPool* threadPool) {
+    visibility.assign((items.size() + 31) / 32, 0);
+
+    if(nodes.empty()) {
+        return;
+    }
+
+    std::array<std::pair<int, int>, 6> frustumLUT = frustum.ComputeAABBTestLUT();
+
+    const unsigned int allPlanes = 0x3F;
+
+    if(threadPool == nullptr || threadPool->GetConcurrency() == 1 || static_cast<int>(items.size()) < PARALLEL_CULL_MIN_ITEMS) {
+        CullSubtree(frustum, frustumLUT, 0, allPlanes, cullStack, visibility.data(), 0);
+    }
+    else {
+        // walk the top of the tree here, a level at a time, until there are
+        // enough straddling subtrees to keep every thread busy
+
+        const size_t targetTaskCount = threadPool->GetConcurrency() * CULL_TASKS_PER_THREAD;
+
+        cullFrontier.clear();
+        cullFrontier.push_back({ 0, allPlanes });
+
+        size_t taskCount = 0;
+        auto addTask = [&](int nodeIndex, unsigned int planeMask) {
+            if(cullTasks.size() <= taskCount) {
+                cullTasks.resize(taskCount + 1);
+            }
+            cullTasks[taskCount].node = nodeIndex;
+            cullTasks[taskCount].planeMask = planeMask;
+            taskCount++;
+        };
+
+        while(!cullFrontier.empty() && taskCount + cullFrontier.size() < targetTaskCount) {
+            cullStack.clear();
+
+            for(auto [nodeIndex, planeMask] : cullFrontier) {
+                const BVHNode& node = nodes[nodeIndex];
+
+                FrustumTestResult result = frustum.TestAABBIntersection(node.bounds, frustumLUT, &planeMask);
+
+                if(result == FrustumTestResult::OUTSIDE) {
+                    continue;
+                }
+
+                if(result == FrustumTestResult::INSIDE) {
+                    SetVisibleRange(visibility.data(), 0, node.first, node.count);
+                }
+                else if(node.left >= 0) {
+                    cullStack.push_back({ node.left, planeMask });
+                    cullStack.push_back({ node.left + 1, planeMask });
+                }
+                else {
+                    // a straddling leaf, nothing left to split
+                    addTask(nodeIndex, planeMask);
+                }
+            }
+
+            std::swap(cullFrontier, cullStack);
+        }
+
+        for(auto [nodeIndex, planeMask] : cullFrontier) {
+            addTask(nodeIndex, planeMask);
+        }
+
+        // each task owns a word aligned slice of the bitmask, so no two
+        // threads ever write the same word
+
+        for(size_t t = 0; t < taskCount; t++) {
+            CullTask& task = cullTasks[t];
+            const BVHNode& node = nodes[task.node];
+
+            task.visibilityOffset = node.first & ~31;
+            task.visibility.assign((node.first + node.count - task.visibilityOffset + 31) / 32, 0);
+        }
+
+        threadPool->ParallelFor(static_cast<int>(taskCount), [&](int t) {
+            CullTask& task = cullTasks[t];
+            CullSubtree(frustum, frustumLUT, task.node, task.planeMask, task.stack, task.visibility.data(), task.visibilityOffset);
+        });
+
+        // merge the slices back into the bitmask
+        for(size_t t = 0; t < taskCount; t++) {
+            const CullTask& task = cullTasks[t];
+            const int firstWord = task.visibilityOffset >> 5;
+
+            for(size_t w = 0; w < task.visibility.size(); w++) {
+                visibility[firstWord + w] |= task.visibility[w];
+            }
+        }
+    }
+
+    // gather the visible models, in item order
+    for(size_t w = 0; w < visibility.size(); w++) {
+        for(uint32_t bits = visibility[w]; bits != 0; bits &= bits - 1) {
+            visibleModels.push_back(items[w * 32 + std::countr_zero(bits)]);
+        }
+    }
+}
+
+void BVH::CullSubtree(
+    const Frustum& frustum,
+    const std::array<std::pair<int, int>, 6>& frustumLUT,
+    int rootIndex,
+    unsigned int planeMask,
+    std::vector<std::pair<int, unsigned int>>& stack,
+    uint32_t* subtreeVisibility,
+    int visibilityOffset)
+{
+    // each entry carries the planes its parent still straddled
+    stack.clear();
+    stack.push_back({ rootIndex, planeMask });
+
+    while(!stack.empty()) {
+        auto [nodeIndex, nodePlaneMask] = stack.back();
+        stack.pop_back();
+
+        const BVHNode& node = nodes[nodeIndex];
+
+        FrustumTestResult result = frustum.TestAABBIntersection(node.bounds, frustumLUT, &nodePlaneMask);
+
+        if(result == FrustumTestResult::OUTSIDE) {
+            continue;
+        }
+
+        // fully inside; accept the entire subtree without testing its children
+        if(result == FrustumTestResult::INSIDE) {
+            SetVisibleRange(subtreeVisibility, visibilityOffset, node.first, node.count);
+            continue;
+        }
+
+        if(node.left >= 0) {
+            // push the right child first so the left subtree is visited first
+            stack.push_back({ node.left + 1, nodePlaneMask });
+            stack.push_back({ node.left, nodePlaneMask });
+            continue;
+        }
+
+        // an intersecting leaf; batch test its models against the remaining planes
+        FrustumKernel::TestAABBs(frustum, itemStream, node.first, node.count, nodePlaneMask, subtreeVisibility, visibilityOffset);
+    }
+}
+
+void BVH::SetVisibleRange(uint32_t* subtreeVisibility, int visibilityOffset, int first, int count) {
+    int i = first - visibilityOffset;
+    const int end = i + count;
+
+    // set the leading bits up to a word boundary, then whole words at a time
+    for(; i < end && (i & 31) != 0; i++) {
+        subtreeVisibility[i >> 5] |= 1U << (i & 31);
+    }
+    for(; i + 32 <= end; i += 32) {
+        subtreeVisibility[i >> 5] = 0xFFFFFFFF;
+    }
+    for(; i < end; i++) {
+        subtreeVisibility[i >> 5] |= 1U << (i & 31);
+    }
+}
+
+} // namespace gyo
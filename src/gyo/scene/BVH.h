@@ -0,0 +1,125 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <gyo/math/AABB.h>
+#include <gyo/math/AABBStream.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace gyo {
+
+class ModelNode;
+class ThreadPool;
+struct Frustum;
+
+/**
+ * A single node in the flattened hierarchy. Every node covers a contiguous
+ * range of the item array, so a subtree fully inside the frustum can be
+ * accepted without visiting its children.
+ */
+struct BVHNode {
+    AABB bounds;
+    int left = -1;      // index of the left child, right is left + 1; -1 for leaves
+    int parent = -1;
+    int first = 0;      // first item covered by this subtree
+    int count = 0;      // number of items covered by this subtree
+};
+
+/**
+ * Bounding volume hierarchy over the world space bounds of our scene models.
+ * Built with a binned surface area heuristic, and refit incrementally as
+ * models move. The tree is rebuilt from scratch when models are added, or
+ * once refitting has degraded it past a threshold.
+ */
+class BVH {
+public:
+    static const int MAX_LEAF_SIZE = 8; // one AVX2 batch, or two SSE2 batches
+    static const int SAH_BIN_COUNT = 12;
+    static constexpr float REBUILD_THRESHOLD = 0.5f; // relative surface area growth from refits
+    static const int PARALLEL_CULL_MIN_ITEMS = 4096; // below this, culling isn't worth splitting up
+    static const int CULL_TASKS_PER_THREAD = 4;
+
+    BVH() {}
+    ~BVH();
+
+    void Insert(ModelNode* modelNode);
+    void MarkDirty(ModelNode* modelNode);
+
+    /**
+     * Rebuilds or refits the tree so its bounds are valid for this frame
+     */
+    void Update();
+
+    /**
+     * Fills the visibility bitmask, then gathers the visible models in tree
+     * order. Given a thread pool, the top of the tree is split into subtree
+     * tasks which are culled in parallel; the result is the same either way.
+     */
+    void Cull(const Frustum& frustum, std::vector<ModelNode*>& visibleModels, ThreadPool* threadPool = nullptr);
+
+    const std::vector<BVHNode>& GetNodes() const { return nodes; }
+    const std::vector<uint32_t>& GetVisibility() const { return visibility; }
+
+private:
+    std::vector<BVHNode> nodes = {};
+    std::vector<ModelNode*> items = {};
+    AABBStream itemStream;                 // item bounds, in the same order as items
+    std::vector<uint32_t> visibility = {}; // one bit per item
+
+    std::vector<int> dirtyLeaves = {};
+    std::vector<bool> isLeafDirty = {};
+
+    bool needsRebuild = false;
+    float builtSurfaceArea = 0.0f;         // summed node surface area after the last build
+    float refitSurfaceAreaGrowth = 0.0f;   // surface area added by refits since
+
+    /**
+     * A subtree culled on a worker, into its own slice of the bitmask
+     */
+    struct CullTask {
+        int node;
+        unsigned int planeMask;
+        int visibilityOffset; // the first item covered, aligned down to a word
+        std::vector<uint32_t> visibility;
+        std::vector<std::pair<int, unsigned int>> stack;
+    };
+
+    // build scratch
+    std::vector<AABB> itemBounds = {};
+    std::vector<glm::vec3> itemCentroids = {};
+    std::vector<int> buildStack = {};
+
+    // refit scratch
+    std::vector<ModelNode*> refitModels = {};
+    std::vector<const AABB*> refitModelBounds = {};
+    std::vector<const glm::mat4*> refitTransforms = {};
+    std::vector<AABB*> refitWorldBounds = {};
+
+    // cull scratch
+    std::vector<std::pair<int, unsigned int>> cullStack = {};
+    std::vector<std::pair<int, unsigned int>> cullFrontier = {};
+    std::vector<CullTask> cullTasks = {};
+
+    void Build();
+    void Subdivide(int nodeIndex);
+    void Refit();
+    void UpdateDirtyModelBounds();
+
+    void CullSubtree(
+        const Frustum& frustum,
+        const std::array<std::pair<int, int>, 6>& frustumLUT,
+        int rootIndex,
+        unsigned int planeMask,
+        std::vector<std::pair<int, unsigned int>>& stack,
+        uint32_t* subtreeVisibility,
+        int visibilityOffset);
+
+    static void SetVisibleRange(uint32_t* subtreeVisibility, int visibilityOffset, int first, int count);
+};
+
+} // namespace gyo
+
+#endif // BVH_H
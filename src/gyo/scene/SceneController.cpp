@@ -4,15 +4,21 @@
 
 #include <gyo/scene/SceneController.h>
 #include <gyo/scene/SceneNode.h>
+#include <gyo/scene/BVH.h>
+#include <gyo/core/ThreadPool.h>
 #include <gyo/renderer/Renderer.h>
 #include <gyo/renderer/DrawCall.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/drawable/IDrawable.h>
 #include <gyo/resources/Resources.h>
+#include <gyo/resources/TextureStreamer.h>
 #include <gyo/shading/Shader.h>
 #include <gyo/lighting/LightNode.h>
 #include <gyo/lighting/LightsUBO.h>
+#include <gyo/mesh/GeometryPool.h>
 #include <gyo/mesh/ModelNode.h>
 #include <gyo/mesh/Skybox.h>
+#include <gyo/math/AABB.h>
 #include <gyo/camera/FlyCamera.h>
 #include <gyo/ui/Text.h>
 #include <gyo/utilities/Clock.h>
@@ -23,13 +29,17 @@
 
 namespace gyo {
 
-SceneController::SceneController(Renderer* r, const int& width, const int& height) {
+SceneController::SceneController(Renderer* r, ThreadPool* pool, const int& width, const int& height) {
     renderer = r;
+    threadPool = pool;
     size = glm::ivec2(width, height);
 
     lightsUBO = new LightsUBO();
     lightsUBO->UpdateValues(ambientLight, lights);
 
+    root = new SceneNode();
+    bvh = new BVH();
+
     // setup our default camera
 
     camera = new FlyCamera(Camera::PerspectiveCamera(60, (float)width / height));
@@ -44,6 +54,7 @@ SceneController::SceneController(Renderer* r, const int& width, const int& heigh
 
 SceneController::~SceneController() {
     renderer = nullptr;
+    threadPool = nullptr;
 
     delete camera;
     camera = nullptr;
@@ -54,9 +65,12 @@ SceneController::~SceneController() {
     delete skybox;
     skybox = nullptr;
 
-    for(const auto& modelNode : models) {
-        delete modelNode;
-    }
+    delete bvh;
+    bvh = nullptr;
+
+    // deletes every model and light node along with it
+    delete root;
+    root = nullptr;
     models.clear();
 
     for(const auto& drawable : drawables) {
@@ -64,36 +78,53 @@ SceneController::~SceneController() {
     }
     drawables.clear();
 
-    for(const auto& lightNode : lights) {
-        delete lightNode;
-    }
     lights.clear();
 
     delete textRenderer;
     textRenderer = nullptr;
 }
 
-void SceneController::AddNode(SceneNode* node) {
+void SceneController::AddNode(SceneNode* node, SceneNode* parent) {
+    if(node == nullptr) {
+        return;
+    }
+
+    if(parent == nullptr) {
+        parent = root;
+    }
+
+    // a node already in the scene is only moved, since its subtree is
+    // already registered
+    const bool isInScene = IsInScene(node);
+    parent->AddChild(node);
+
+    if(isInScene) {
+        return;
+    }
+
+    RegisterNode(node);
+    sceneVersion++;
+}
+
+bool SceneController::IsInScene(const SceneNode* node) const {
+    for(; node != nullptr; node = node->GetParent()) {
+        if(node == root) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void SceneController::RegisterNode(SceneNode* node) {
     ModelNode* modelNode = dynamic_cast<ModelNode*>(node);
     LightNode* lightNode = dynamic_cast<LightNode*>(node);
 
     if(modelNode) {
         models.push_back(modelNode);
+        bvh->Insert(modelNode);
 
-        const std::vector<Mesh*>& meshes = modelNode->GetModel().GetMeshes();
-        for(Mesh* mesh : meshes) {
-            const Material* material = mesh->GetMaterial();
-            const Shader& shader = material->GetShader();
-
-            // bind the Camera uniform block
-            shader.Use();
-            shader.SetUniformBlockBinding("Camera", 0);
-
-            // if the model uses lighting, set the lighting uniforms
-            if(material->usesDirectLighting) {
-                shader.SetUniformBlockBinding("Lights", 1);
-            }
-        }
+        BindSceneBlocks(modelNode);
     }
     else if(lightNode) {
         lights.push_back(lightNode);
@@ -102,6 +133,19 @@ void SceneController::AddNode(SceneNode* node) {
 
         lightsUBO->UpdateValues(ambientLight, lights);
     }
+
+    for(SceneNode* child : node->GetChildren()) {
+        RegisterNode(child);
+    }
+}
+
+void SceneController::BindSceneBlocks(ModelNode* modelNode) {
+    // the node's material overrides, or else the shared model's materials
+    const size_t meshCount = modelNode->GetModel().GetMeshes().size();
+    for(size_t i = 0; i < meshCount; i++) {
+        const VertexArray* vertexArray = modelNode->GetVertexArray(i);
+        modelNode->GetMaterial(i)->BindSceneBlocks(vertexArray != nullptr && vertexArray->IsInstanceable());
+    }
 }
 
 void SceneController::AddDrawable(IDrawable* drawable) {
@@ -147,10 +191,6 @@ void SceneController::Render() {
         return;
     }
 
-    visibleModels.clear();
-    opaqueDrawCalls.clear();
-    alphaDrawCalls.clear();
-
     renderer->BeginFrame(); // set frame buffer, clear
     
     RenderScene(); // opaque geometry, skybox, and transparent geometry passes
@@ -167,43 +207,24 @@ void SceneController::Render() {
 
 void SceneController::RenderScene() {
     CLOCKT(geometry_pass, &renderer->stats.geometryMs);
-    
-    // view frustum culling
 
-    FrustumCull(camera->GetFrustum(), models, visibleModels);
+    UpdateDrawLists();
 
-    // update the camera view matrix for our shaders
-    camera->UpdateViewMatrixUniform();
+    // the renderer counts the draw calls it issues once instanced
+    renderer->stats.tris += visibleTris;
 
-    // separate our visible objects into two vectors - opaque and blended
-    for(const auto& modelNode : visibleModels) {
-        const std::vector<Mesh*>& meshes = modelNode->GetModel().GetMeshes();
-        for(Mesh* mesh : meshes) {
-            if(mesh->GetRenderType() == RenderType::OPAQUE) {
-                opaqueDrawCalls.push_back(DrawCall{
-                    mesh,
-                    mesh->GetMaterial(),
-                    modelNode->GetTransform(),
-                    modelNode->GetNormalMatrix()
-                });
-            }
-            else {
-                alphaDrawCalls.push_back(DrawCall{
-                    mesh,
-                    mesh->GetMaterial(),
-                    modelNode->GetTransform(),
-                    modelNode->GetNormalMatrix()
-                });
-            }
+    renderer->SetObjectData(objectData, objectDataVersion);
 
-            renderer->stats.drawCalls++;
-            renderer->stats.tris += mesh->GetNumTris();
-        }
+    // what's on screen changed, so may what streamed textures need
+    if(objectDataVersion != requestedObjectDataVersion || TextureStreamer::GetVersion() != requestedStreamerVersion) {
+        RequestTextureLevels();
     }
 
     // opaque pass
 
-    renderer->RenderOpaque(opaqueDrawCalls, this->environment);
+    const glm::vec3& camPosition = camera->GetPosition();
+
+    renderer->RenderOpaque(opaqueDrawCalls, drawListVersion, this->environment, camPosition);
 
     if(skybox != nullptr) {
         renderer->RenderSkybox(skybox, camera->GetView(), camera->GetProjection());
@@ -216,48 +237,212 @@ void SceneController::RenderScene() {
         renderer->stats.drawCalls++;
     }
 
-    // transparency pass
-
-    // sort furthest to closest length squared from camera position
+    // transparency pass, sorted furthest to closest by the render queue
     // NOTE this doesn't take rotation or scale into account, and only uses
     // the mesh position for comparison
     // TODO investigate more robust methods for sorting
 
-    const glm::vec3& camPosition = camera->GetPosition();
-    std::sort(alphaDrawCalls.begin(), alphaDrawCalls.end(), [camPosition](const DrawCall& a, const DrawCall& b) {
-        glm::vec3 aPos = { a.transform[3][0], a.transform[3][1], a.transform[3][2] };
-        glm::vec3 bPos = { b.transform[3][0], b.transform[3][1], b.transform[3][2] };
+    renderer->RenderTransparent(alphaDrawCalls, drawListVersion, camPosition);
+}
 
-        return glm::length2(aPos - camPosition) > glm::length2(bPos - camPosition);
-    });
+void SceneController::UpdateDrawLists() {
+    // update the world transforms of anything that moved, before the worker
+    // threads start reading them
+    transformSystem.Update(root);
+
+    const bool hasCameraMoved = camera->GetVersion() != builtCameraVersion;
+    const bool hasBindingChanged = Mesh::GetBindingVersion() != builtBindingVersion;
+    const bool isStale = hasCameraMoved || hasBindingChanged ||
+        sceneVersion != builtSceneVersion ||
+        Material::GetVersion() != builtMaterialVersion;
+
+    if(hasBindingChanged) {
+        // meshes may have been given materials whose shaders haven't had the
+        // scene's blocks bound yet
+        for(ModelNode* modelNode : models) {
+            BindSceneBlocks(modelNode);
+        }
+    }
+
+    if(hasCameraMoved) {
+        // update the camera view matrix for our shaders
+        camera->UpdateViewMatrixUniform();
+    }
+
+    if(isStale) {
+        RebuildDrawLists();
+        return;
+    }
+
+    // nothing moved, so last frame's lists still hold
+    if(transformSystem.GetUpdatedCount() == 0) {
+        return;
+    }
+
+    // moving nodes may have entered or left the frustum. If not, the draw
+    // lists stand, and only the moved nodes' object data needs patching.
+
+    culledModels.clear();
+    FrustumCull(camera->GetFrustum(), *bvh, culledModels);
+
+    if(culledModels != visibleModels) {
+        RebuildDrawLists();
+        return;
+    }
 
-    renderer->RenderTransparent(alphaDrawCalls);
+    PatchObjectData();
 }
 
-void SceneController::FrustumCull(
-    const Frustum& cameraFrustum,
-    const std::vector<ModelNode*>& sceneModels,
-    std::vector<ModelNode*>& visibleSceneModels
-) {
-    std::array<std::pair<int, int>, 6> frustumLUT = cameraFrustum.ComputeAABBTestLUT();
+void SceneController::RebuildDrawLists() {
+    visibleModels.clear();
+    opaqueDrawCalls.clear();
+    alphaDrawCalls.clear();
+    visibleTris = 0;
+
+    // view frustum culling
+
+    FrustumCull(camera->GetFrustum(), *bvh, visibleModels);
+
+    // separate our visible objects into two vectors - opaque and blended.
+    // each job fills its own chunk, which are then merged in order so the
+    // result doesn't depend on how the jobs were scheduled. Every job also
+    // writes its models' object data, which draw calls refer to by index.
+
+    objectData.resize(visibleModels.size());
+    objectVersions.resize(visibleModels.size());
+
+    const size_t chunkCount = (visibleModels.size() + DRAW_CALL_CHUNK_SIZE - 1) / DRAW_CALL_CHUNK_SIZE;
+    if(drawCallChunks.size() < chunkCount) {
+        drawCallChunks.resize(chunkCount);
+    }
+
+    auto generateChunk = [this](int c) {
+        const size_t first = c * DRAW_CALL_CHUNK_SIZE;
+        const size_t count = std::min<size_t>(DRAW_CALL_CHUNK_SIZE, visibleModels.size() - first);
+
+        GenerateDrawCalls(first, count, drawCallChunks[c]);
+    };
+
+    if(threadPool != nullptr) {
+        threadPool->ParallelFor(static_cast<int>(chunkCount), generateChunk);
+    }
+    else {
+        for(size_t c = 0; c < chunkCount; c++) {
+            generateChunk(static_cast<int>(c));
+        }
+    }
+
+    for(size_t c = 0; c < chunkCount; c++) {
+        const DrawCallChunk& chunk = drawCallChunks[c];
+
+        opaqueDrawCalls.insert(opaqueDrawCalls.end(), chunk.opaque.begin(), chunk.opaque.end());
+        alphaDrawCalls.insert(alphaDrawCalls.end(), chunk.alpha.begin(), chunk.alpha.end());
+
+        visibleTris += chunk.tris;
+    }
+
+    builtSceneVersion = sceneVersion;
+    builtCameraVersion = camera->GetVersion();
+    builtMaterialVersion = Material::GetVersion();
+    builtBindingVersion = Mesh::GetBindingVersion();
+
+    drawListVersion++;
+    objectDataVersion++;
+}
+
+void SceneController::PatchObjectData() {
+    bool hasPatched = false;
+
+    for(size_t m = 0; m < visibleModels.size(); m++) {
+        ModelNode* modelNode = visibleModels[m];
+        if(modelNode->GetVersion() == objectVersions[m]) {
+            continue;
+        }
+
+        objectData[m] = { modelNode->GetTransform(), modelNode->GetNormalMatrix() };
+        objectVersions[m] = modelNode->GetVersion();
+        hasPatched = true;
+    }
+
+    if(hasPatched) {
+        objectDataVersion++;
+    }
+}
 
-    // FIXME: this is a niave approach where all models in the scene are
-    // iterated through.
-    // TODO Look into using a BVH to quickly cull large swathes of scene models.
-    for(const auto& modelNode : sceneModels) {
+void SceneController::RequestTextureLevels() {
+    TextureStreamer::BeginRequests();
+
+    // how many pixels a unit spans on screen, at a unit away if perspective
+    const glm::mat4& projection = camera->GetProjection();
+    const bool isPerspective = projection[3][3] == 0.0f;
+    const float pixelsPerUnit = projection[1][1] * size.y * 0.5f;
+    const glm::vec3& camPosition = camera->GetPosition();
+
+    for(ModelNode* modelNode : visibleModels) {
         const AABB& bounds = modelNode->GetBounds();
-        const std::array<glm::vec3, 8>& boundsLUT = modelNode->GetLUT();
+        const glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
+        const float radius = glm::length(bounds.max - bounds.min) * 0.5f;
+
+        // the bounding sphere's size at its nearest, taking the model's
+        // textures to span it once
+        float footprint = 2.0f * radius * pixelsPerUnit;
+        if(isPerspective) {
+            footprint /= std::max(glm::length(center - camPosition) - radius, 0.001f);
+        }
+
+        const size_t meshCount = modelNode->GetModel().GetMeshes().size();
+        for(size_t i = 0; i < meshCount; i++) {
+            modelNode->GetMaterial(i)->RequestTextures(footprint);
+        }
+    }
+
+    requestedObjectDataVersion = objectDataVersion;
+    requestedStreamerVersion = TextureStreamer::GetVersion();
+}
 
-        // FrustumTestResult result = cameraFrustum.TestAABBIntersection(bounds);
-        // FrustumTestResult result = cameraFrustum.TestAABBIntersection(bounds, boundsLUT, frustumLUT);
-        FrustumTestResult result = cameraFrustum.TestAABBIntersection(bounds, boundsLUT, frustumLUT, &modelNode->boundsLastFailedFrustumPlane);
+void SceneController::GenerateDrawCalls(size_t firstModel, size_t count, DrawCallChunk& chunk) {
+    chunk.opaque.clear();
+    chunk.alpha.clear();
+    chunk.tris = 0;
 
-        if(result != FrustumTestResult::OUTSIDE) {
-            visibleSceneModels.push_back(modelNode);
+    for(size_t m = firstModel; m < firstModel + count; m++) {
+        ModelNode* modelNode = visibleModels[m];
+
+        // every mesh of the model shares its transforms
+        const uint32_t objectIndex = static_cast<uint32_t>(m);
+        objectData[m] = { modelNode->GetTransform(), modelNode->GetNormalMatrix() };
+        objectVersions[m] = modelNode->GetVersion();
+
+        const std::vector<Mesh*>& meshes = modelNode->GetModel().GetMeshes();
+        for(size_t i = 0; i < meshes.size(); i++) {
+            Mesh* mesh = meshes[i];
+            const DrawCall dc = { mesh, modelNode->GetMaterial(i), modelNode->GetVertexArray(i), objectIndex };
+
+            if(dc.material->renderType == RenderType::OPAQUE) {
+                chunk.opaque.push_back(dc);
+            }
+            else {
+                chunk.alpha.push_back(dc);
+            }
+
+            chunk.tris += mesh->GetNumTris();
         }
     }
 }
 
+void SceneController::FrustumCull(
+    const Frustum& cameraFrustum,
+    BVH& sceneBVH,
+    std::vector<ModelNode*>& visibleSceneModels
+) {
+    // rebuild or refit the hierarchy for any models that were added or moved
+    sceneBVH.Update();
+
+    // whole subtrees fully inside or outside the frustum are accepted or
+    // rejected at once, only straddling leaves test their models
+    sceneBVH.Cull(cameraFrustum, visibleSceneModels, threadPool);
+}
+
 void SceneController::RenderStats() {
     CLOCKT(render_ui, &renderer->stats.uiMs);
 
@@ -275,7 +460,9 @@ void SceneController::RenderStats() {
         std::format("cpu: {:.1f} ms", renderer->stats.cpuMs.Get()),
         std::format("gpu: {:.1f} ms", renderer->stats.gpuMs.Get()),
         std::format("draw calls: {}", renderer->stats.drawCalls),
-        std::format("tris: {}", renderer->stats.tris)
+        std::format("tris: {}", renderer->stats.tris),
+        std::format("redundant state calls: {}", renderer->stats.redundantStateCalls),
+        std::format("streamed textures: {:.1f} MB", Resources::GetStreamingUsage() / (1024.0 * 1024.0))
     };
 
     // queue the stats strings
@@ -292,15 +479,11 @@ void SceneController::RenderStats() {
 
     // finally, execute the render
 
-    glEnable(GL_BLEND);
-    glCheckError();
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glCheckError();
+    RenderState::SetBlendingEnabled(true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
     textRenderer->ExecuteRender();
 
-    glDisable(GL_BLEND);
-    glCheckError();
+    RenderState::SetBlendingEnabled(false);
 }
 
 void SceneController::OnKeyPressed(int key, float dt) {
@@ -2,6 +2,8 @@
 #define SCENE_CONTROLLER_H
 
 #include <gyo/shading/IBLEnvironment.h>
+#include <gyo/renderer/DrawCall.h>
+#include <gyo/scene/TransformSystem.h>
 
 #include <functional>
 #include <glm/glm.hpp>
@@ -9,9 +11,10 @@
 namespace gyo {
 
 class Renderer;
-class DrawCall;
+class ThreadPool;
 class SceneNode;
 class ModelNode;
+class BVH;
 class AABBWireframe;
 class TangentsRenderer;
 class FlyCamera;
@@ -28,13 +31,21 @@ public:
     static const unsigned int MAX_SPOT_LIGHTS = 4;
 
 public:
-    SceneController(Renderer* renderer, const int& width, const int& height);
+    static const unsigned int DRAW_CALL_CHUNK_SIZE = 1024; // visible models per draw call generation job
+
+public:
+    SceneController(Renderer* renderer, ThreadPool* threadPool, const int& width, const int& height);
     ~SceneController();
 
     void Update(float dt);
     void Render();
 
-    void AddNode(SceneNode* node);
+    /**
+     * Adds the node, along with everything beneath it, to the scene. It's
+     * attached under parent if given, otherwise under the scene root. A node
+     * that's already in the scene is just moved there.
+     */
+    void AddNode(SceneNode* node, SceneNode* parent = nullptr);
     void AddDrawable(IDrawable* drawable);
     void SetSkybox(Skybox* skybox = nullptr);
     void SetEnvironment(const char* hdrFileName);
@@ -46,6 +57,7 @@ public:
 
 private:
     Renderer* renderer = nullptr;
+    ThreadPool* threadPool = nullptr;
     glm::ivec2 size;
 
     std::vector<std::function<void(float)>> updateFunctions;
@@ -59,25 +71,70 @@ private:
     std::vector<LightNode*> lights = {};
     LightsUBO* lightsUBO = nullptr;
 
+    SceneNode* root = nullptr; // owns every node in the scene
+    TransformSystem transformSystem;
+
     std::vector<ModelNode*> models = {};
     std::vector<IDrawable*> drawables = {};
 
+    BVH* bvh = nullptr; // acceleration structure over the model bounds
+
     Text* textRenderer;
 
     float lastMouseX;
     float lastMouseY;
 
-    // per-frame
+    // retained between frames, and only rebuilt or patched when something
+    // they were built from changes
     std::vector<ModelNode*> visibleModels = {};
+    std::vector<ObjectData> objectData = {};    // one per visible model
+    std::vector<uint32_t> objectVersions = {};  // the node version each was written from
     std::vector<DrawCall> opaqueDrawCalls = {};
     std::vector<DrawCall> alphaDrawCalls = {};
-
+    unsigned int visibleTris = 0;
+
+    // bumped whenever nodes are added to the scene
+    uint32_t sceneVersion = 0;
+
+    // what the retained lists were built from, and their own versions
+    uint32_t builtSceneVersion = UINT32_MAX;
+    uint32_t builtCameraVersion = UINT32_MAX;
+    uint32_t builtMaterialVersion = UINT32_MAX;
+    uint32_t builtBindingVersion = UINT32_MAX;
+    uint32_t drawListVersion = 0;
+    uint32_t objectDataVersion = 0;
+
+    // what texture footprints were last requested from
+    uint32_t requestedObjectDataVersion = UINT32_MAX;
+    uint32_t requestedStreamerVersion = UINT32_MAX;
+
+    // scratch for checking whether moving nodes changed what's visible
+    std::vector<ModelNode*> culledModels = {};
+
+    /**
+     * The draw calls built by a single job, merged in chunk order
+     */
+    struct DrawCallChunk {
+        std::vector<DrawCall> opaque;
+        std::vector<DrawCall> alpha;
+        unsigned int tris = 0;
+    };
+    std::vector<DrawCallChunk> drawCallChunks = {};
+
+    void RegisterNode(SceneNode* node);
+    bool IsInScene(const SceneNode* node) const;
+    void BindSceneBlocks(ModelNode* modelNode);
     void RenderScene();
+    void UpdateDrawLists();
+    void RebuildDrawLists();
+    void PatchObjectData();
+    void RequestTextureLevels();
     void FrustumCull(
         const Frustum& cameraFrustum,
-        const std::vector<ModelNode*>& sceneModels,
+        BVH& sceneBVH,
         std::vector<ModelNode*>& visibleSceneModels
     );
+    void GenerateDrawCalls(size_t firstModel, size_t count, DrawCallChunk& chunk);
     void RenderStats();
 };
 
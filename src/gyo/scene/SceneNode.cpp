@@ -1,8 +1,35 @@
 
 #include <gyo/scene/SceneNode.h>
+#include <gyo/math/TransformKernel.h>
+
+#include <algorithm>
 
 namespace gyo {
 
+SceneNode::~SceneNode() {
+    for(SceneNode* child : children) {
+        delete child;
+    }
+    children.clear();
+}
+
+void SceneNode::AddChild(SceneNode* child) {
+    if(child == nullptr || child->parent == this) {
+        return;
+    }
+
+    if(child->parent != nullptr) {
+        std::vector<SceneNode*>& siblings = child->parent->children;
+        siblings.erase(std::remove(siblings.begin(), siblings.end(), child), siblings.end());
+    }
+
+    child->parent = this;
+    children.push_back(child);
+
+    // our transform now applies to the child's entire subtree
+    child->SetLocalDirty();
+}
+
 const glm::mat4& SceneNode::GetTransform() {
     if(isTransformDirty) {
         UpdateMatrices();
@@ -19,18 +46,94 @@ const glm::mat4& SceneNode::GetNormalMatrix() {
     return normalMatrix;
 }
 
+const glm::mat4& SceneNode::GetLocalTransform() {
+    if(isTransformDirty) {
+        UpdateMatrices();
+    }
+
+    return localTransform;
+}
+
 void SceneNode::SetDirty() {
     isTransformDirty = true;
+    version++;
+}
+
+void SceneNode::SetLocalDirty() {
+    isLocalDirty = true;
+
+    // nodes outside the scene, like the camera, may never be updated and so
+    // stay stale, so count every local change too
+    version++;
+
+    PropagateDirty();
+
+    // flag our ancestors, so the breadth-first update can find its way down
+    // to us without visiting every clean subtree along the way
+    for(SceneNode* p = parent; p != nullptr; p = p->parent) {
+        if(p->hasDirtyDescendant || p->isTransformDirty) {
+            break;
+        }
+        p->hasDirtyDescendant = true;
+    }
+}
+
+void SceneNode::PropagateDirty() {
+    // an already stale node means an already stale subtree
+    if(isTransformDirty) {
+        return;
+    }
+
+    SetDirty();
+
+    for(SceneNode* child : children) {
+        child->PropagateDirty();
+    }
 }
 
 inline void SceneNode::UpdateMatrices() {
-    transform = glm::mat4(1.0f);
-    
-    transform = glm::translate(transform, position);
-    transform *= glm::toMat4(rotation);
-    transform = glm::scale(transform, scale);
+    if(isLocalDirty) {
+        localTransform = glm::mat4(1.0f);
+
+        localTransform = glm::translate(localTransform, position);
+        localTransform *= glm::toMat4(rotation);
+        localTransform = glm::scale(localTransform, scale);
+
+        isLocalDirty = false;
+    }
+
+    if(parent != nullptr) {
+        parent->GetTransform(); // updates the parent, if necessary
+    }
+
+    UpdateWorldMatrices();
+
+    // our children were flagged along with us, make sure the breadth-first
+    // update still visits them if we were updated lazily
+    if(!children.empty()) {
+        hasDirtyDescendant = true;
+    }
+}
+
+void SceneNode::UpdateWorldMatrices() {
+    // expects our local transform and our parent's matrices to be up to date
+
+    if(parent != nullptr) {
+        TransformKernel::Multiply(parent->transform, localTransform, transform);
+    }
+    else {
+        transform = localTransform;
+    }
 
-    normalMatrix = glm::transpose(glm::inverse(transform));
+    // a non-uniform scale above us shears our axes, then the normal matrix
+    // needs the full inverse
+    const bool hasOrthogonalAxes = parent == nullptr || parent->hasUniformWorldScale;
+    TransformKernel::NormalMatrix(transform, hasOrthogonalAxes, normalMatrix);
+
+    const bool isUniformScale =
+        glm::abs(scale.x - scale.y) <= 1e-5f * glm::abs(scale.x) &&
+        glm::abs(scale.x - scale.z) <= 1e-5f * glm::abs(scale.x);
+    hasUniformWorldScale = hasOrthogonalAxes && isUniformScale;
     
     isTransformDirty = false;
 }
@@ -49,60 +152,60 @@ glm::vec3 SceneNode::GetUp() const {
 
 void SceneNode::SetPosition(float x, float y, float z) {
     position = glm::vec3(x, y, z);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetPosition(const glm::vec3 &position) {
     this->position = position;
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetRotation(float pitchDeg, float yawDeg, float rollDeg) {
     glm::vec3 angles = glm::radians(glm::vec3(pitchDeg, yawDeg, rollDeg));
     rotation = glm::quat(angles);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetRotation(float angleDeg, const glm::vec3 &axis) {
     rotation = glm::angleAxis(glm::radians(angleDeg), axis);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetRotation(const glm::fquat &rotation) {
     this->rotation = rotation;
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetScale(float scale) {
     this->scale = glm::vec3(scale, scale, scale);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetScale(float x, float y, float z) {
     this->scale = glm::vec3(x, y, z);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::SetScale(const glm::vec3 &scale) {
     this->scale = scale;
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::Translate(float x, float y, float z) {
     position += glm::vec3(x, y, z);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::Translate(const glm::vec3 &translation) {
     position += translation;
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::Rotate(float pitchDeg, float yawDeg, float rollDeg) {
     glm::vec3 angles = glm::radians(glm::vec3(pitchDeg, yawDeg, rollDeg));
     if(glm::length2(angles) > 0.0f) {
         rotation = rotation * glm::quat(angles);
-        SetDirty();
+        SetLocalDirty();
     }
 }
 
@@ -110,23 +213,23 @@ void SceneNode::Rotate(float angleDeg, const glm::vec3 &axis) {
     float angleRad = glm::radians(angleDeg);
     if(angleRad != 0.0f) {
         rotation = rotation * glm::angleAxis(angleRad, axis);
-        SetDirty();
+        SetLocalDirty();
     }
 }
 
 void SceneNode::Scale(float scale) {
     this->scale *= scale;
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::Scale(float x, float y, float z) {
     scale *= glm::vec3(x, y, z);
-    SetDirty();
+    SetLocalDirty();
 }
 
 void SceneNode::Scale(const glm::vec3 &scale) {
     this->scale *= scale;
-    SetDirty();
+    SetLocalDirty();
 }
 
 } // namespace gyo
@@ -7,12 +7,24 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/quaternion.hpp>
 
+#include <cstdint>
+#include <vector>
+
 namespace gyo {
 
 class SceneNode {
 public:
     SceneNode() {}
-    virtual ~SceneNode() {}
+    virtual ~SceneNode();
+
+    /**
+     * Takes ownership of the child, detaching it from any previous parent.
+     * The child's position, rotation, and scale are then relative to us.
+     */
+    void AddChild(SceneNode* child);
+
+    SceneNode* GetParent() const { return parent; }
+    const std::vector<SceneNode*>& GetChildren() const { return children; }
 
     const glm::vec3& GetPosition() const { return position; }
     const glm::fquat& GetRotation() const { return rotation; }
@@ -27,8 +39,14 @@ public:
     void SetScale(float x, float y, float z);
     void SetScale(const glm::vec3 &scale);
 
+    // world space
     const glm::mat4& GetTransform();
     const glm::mat4& GetNormalMatrix();
+    const glm::mat4& GetLocalTransform();
+
+    // bumped whenever our world transform changes, so anything derived from
+    // it can tell when it's stale
+    const uint32_t& GetVersion() const { return version; }
 
     glm::vec3 GetForward() const;
     glm::vec3 GetRight() const;
@@ -49,15 +67,34 @@ protected:
     glm::fquat rotation = glm::quat(1, 0, 0, 0);
     glm::vec3 scale = glm::vec3(1);
     
-    glm::mat4 transform = glm::mat4(1.0f);
+    glm::mat4 localTransform = glm::mat4(1.0f);
+    glm::mat4 transform = glm::mat4(1.0f); // world
     glm::mat4 normalMatrix = glm::mat4(1.0f);
 
+    /**
+     * Called whenever our world transform goes stale, either because we
+     * moved or because one of our ancestors did
+     */
     virtual void SetDirty();
 
 private:
-    bool isTransformDirty = true;
+    friend class TransformSystem;
+
+    SceneNode* parent = nullptr;
+    std::vector<SceneNode*> children = {};
+
+    bool isLocalDirty = true;
+    bool isTransformDirty = true;       // our world matrices are stale
+    bool hasDirtyDescendant = false;    // something beneath us is stale
+    bool hasUniformWorldScale = true;   // we and all our ancestors scale uniformly, so no shear
+
+    uint32_t version = 0;
+
+    void SetLocalDirty();
+    void PropagateDirty();
 
     inline void UpdateMatrices();
+    void UpdateWorldMatrices();
 };
 
 } // namespace gyo
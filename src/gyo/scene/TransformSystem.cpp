@@ -0,0 +1,58 @@
+
+#include <gyo/scene/TransformSystem.h>
+#include <gyo/scene/SceneNode.h>
+#include <gyo/math/TransformKernel.h>
+
+namespace gyo {
+
+void TransformSystem::Update(SceneNode* root) {
+    updatedCount = 0;
+
+    queue.clear();
+    queue.push_back(root);
+
+    size_t levelStart = 0;
+
+    while(levelStart < queue.size()) {
+        const size_t levelEnd = queue.size();
+
+        trs.Clear();
+        batchNodes.clear();
+        batchLocals.clear();
+
+        // gather the stale nodes of this level, and queue up the next
+
+        for(size_t i = levelStart; i < levelEnd; i++) {
+            SceneNode* node = queue[i];
+
+            // once a node is dirty its whole subtree is, so keep descending
+            const bool descend = node->isTransformDirty || node->hasDirtyDescendant;
+
+            if(node->isTransformDirty) {
+                trs.Push(node->position, node->rotation, node->scale);
+                batchNodes.push_back(node);
+                batchLocals.push_back(&node->localTransform);
+            }
+            node->hasDirtyDescendant = false;
+
+            if(descend) {
+                queue.insert(queue.end(), node->children.begin(), node->children.end());
+            }
+        }
+
+        // compose the local matrices together, then concatenate with the
+        // parents, which were all finished on the previous level
+
+        TransformKernel::ComposeTRS(trs, batchLocals.data());
+
+        for(SceneNode* node : batchNodes) {
+            node->isLocalDirty = false;
+            node->UpdateWorldMatrices();
+        }
+
+        updatedCount += batchNodes.size();
+        levelStart = levelEnd;
+    }
+}
+
+} // namespace gyo
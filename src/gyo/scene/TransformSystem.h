@@ -0,0 +1,40 @@
+#ifndef TRANSFORM_SYSTEM_H
+#define TRANSFORM_SYSTEM_H
+
+#include <gyo/math/TRSStream.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace gyo {
+
+class SceneNode;
+
+/**
+ * Updates the world matrices of a scene graph in batches. The hierarchy is
+ * walked breadth-first, skipping clean subtrees, and the stale nodes of each
+ * level are gathered into SoA streams and composed together with SIMD, so
+ * every parent is done before its children.
+ */
+class TransformSystem {
+public:
+    void Update(SceneNode* root);
+
+    // the number of nodes recomposed by the last update
+    size_t GetUpdatedCount() const { return updatedCount; }
+
+private:
+    std::vector<SceneNode*> queue = {};
+
+    // per-level batch
+    TRSStream trs;
+    std::vector<SceneNode*> batchNodes = {};
+    std::vector<glm::mat4*> batchLocals = {};
+
+    size_t updatedCount = 0;
+};
+
+} // namespace gyo
+
+#endif // TRANSFORM_SYSTEM_H
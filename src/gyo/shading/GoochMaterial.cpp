@@ -17,6 +17,19 @@ GoochMaterial::GoochMaterial(glm::vec3 coolColor, glm::vec3 warmColor) {
         { "aPos", SEMANTIC_POSITION },
         { "aNormal", SEMANTIC_NORMAL }
     };
+
+    // layout (std140) uniform GoochMaterial { vec3 coolColor; vec3 warmColor; }
+    // where each vec3 is aligned to 16 bytes
+    const glm::vec4 parameters[2] = {
+        glm::vec4(coolColor, 0.0f),
+        glm::vec4(warmColor, 0.0f)
+    };
+    shader->SetUniformBlockBinding("GoochMaterial", PARAMETERS_BINDING);
+    UploadParameters(parameters, sizeof(parameters));
+
+    BeginInstanceKey();
+    HashParameter(coolColor);
+    HashParameter(warmColor);
 }
 
 GoochMaterial::~GoochMaterial() {
@@ -25,8 +38,7 @@ GoochMaterial::~GoochMaterial() {
 void GoochMaterial::Queue() {
     shader->Use();
 
-    shader->SetVec3("coolColor", coolColor);
-    shader->SetVec3("warmColor", warmColor);
+    BindParameters();
 }
 
 } // namespace gyo
@@ -2,10 +2,65 @@
 #include <gyo/shading/Material.h>
 #include <gyo/shading/Shader.h>
 #include <gyo/shading/ShaderSemantics.h>
+#include <gyo/renderer/RenderState.h>
+#include <gyo/renderer/Renderer.h>
+#include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
 
+#include <glad/glad.h>
+
 namespace gyo {
 
+uint32_t Material::version = 0;
+
+void Material::Release() {
+    if(--refCount <= 0) {
+        delete this;
+    }
+}
+
+Material::~Material() {
+    shader = nullptr;
+
+    if(parameterBuffer != 0) {
+        RenderState::DeleteBuffer(parameterBuffer);
+    }
+}
+
+void Material::UploadParameters(const void* data, size_t size) {
+    version++;
+
+    if(parameterBuffer == 0) {
+        glGenBuffers(1, &parameterBuffer);
+        glCheckError();
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, parameterBuffer);
+    glCheckError();
+    glBufferData(GL_UNIFORM_BUFFER, size, data, GL_STATIC_DRAW);
+    glCheckError();
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glCheckError();
+}
+
+void Material::BindParameters() const {
+    RenderState::BindUniformBuffer(PARAMETERS_BINDING, parameterBuffer);
+}
+
+void Material::BindSceneBlocks(bool isInstanced) const {
+    shader->Use();
+    shader->SetUniformBlockBinding("Camera", 0);
+
+    if(usesDirectLighting) {
+        shader->SetUniformBlockBinding("Lights", 1);
+    }
+
+    // point instanced shaders at the object data
+    if(isInstanced) {
+        shader->SetInt(UNIFORM_OBJECT_DATA, Renderer::OBJECT_DATA_TEXTURE_UNIT);
+    }
+}
+
 bool Material::ValidateShaderAttributes() {
     const std::map<std::string, AttributeInfo>& shaderAttributes = shader->GetAttributes();
 
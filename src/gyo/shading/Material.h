@@ -3,31 +3,93 @@
 
 #include <gyo/shading/Shader.h>
 #include <gyo/renderer/RenderType.h>
+#include <gyo/utilities/Hash.h>
 
 #include <glm/glm.hpp>
 
 namespace gyo {
 
+/**
+ * How a mesh is shaded. Materials can be shared between meshes, e.g. those
+ * of imported models, so they're counted: each mesh using one adds a
+ * reference, and the material deletes itself when the last one is released.
+ */
 class Material {
 public:
-    virtual ~Material() {
-        shader = nullptr;
-    }
+    // the uniform block binding point for material parameters. Camera and
+    // Lights use 0 and 1, see BindSceneBlocks.
+    static const unsigned int PARAMETERS_BINDING = 2;
+
+    virtual ~Material();
 
     virtual void Queue() = 0; // pure virtual
 
+    // tells TextureStreamer how many pixels across our textures cover, on a
+    // mesh about footprint pixels across on screen
+    virtual void RequestTextures(float footprint) const {}
+
+    void AddRef() { refCount++; }
+    void Release();
+    const int& GetRefCount() const { return refCount; }
+
     bool ValidateShaderAttributes();
+
+    // binds our shader's Camera and Lights blocks, and its object data
+    // buffer if it's drawn instanced, to the scene's binding points
+    void BindSceneBlocks(bool isInstanced) const;
     
     const Shader& GetShader() const { return *shader; }
     const std::map<std::string, unsigned int>& GetShaderSemantics() const { return semantics; }
 
+    // materials with equal instance keys render identically, so meshes using
+    // them can be drawn in one instanced draw call
+    const uint64_t& GetInstanceKey() const { return instanceKey; }
+
+    // bumped whenever any material's key or parameters change, so retained
+    // draw lists know to rebuild
+    static const uint32_t& GetVersion() { return version; }
+
     RenderType renderType = RenderType::OPAQUE;
     bool usesDirectLighting = false; // include scene direct lighting
     bool usesIBL = false; // include diffuse irradiance map
 
 protected:
+    static uint32_t version;
+
     Shader* shader = nullptr;
     std::map<std::string, unsigned int> semantics;
+
+    uint64_t instanceKey = 0;
+
+    int refCount = 0;
+
+    // our std140 parameter block, created on the first upload
+    unsigned int parameterBuffer = 0;
+
+    /**
+     * Copies our parameters into our uniform buffer. Materials call this
+     * whenever their parameters change, rather than setting uniforms in Queue.
+     */
+    void UploadParameters(const void* data, size_t size);
+
+    // binds our parameter block to PARAMETERS_BINDING, call from Queue
+    void BindParameters() const;
+
+    // call once the shader is selected, then HashParameter every value Queue
+    // sets, so that equivalent materials end up with the same instance key
+    void BeginInstanceKey() {
+        version++;
+
+        instanceKey = hash_bytes(&shader, sizeof(shader));
+        HashParameter(renderType);
+        HashParameter(usesDirectLighting);
+        HashParameter(usesIBL);
+    }
+
+    template<typename T>
+    void HashParameter(const T& value) {
+        instanceKey = hash_bytes(&value, sizeof(T), instanceKey);
+    }
 };
 
 } // namespace gyo
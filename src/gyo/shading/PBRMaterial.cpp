@@ -4,6 +4,9 @@
 #include <gyo/shading/TextureDefines.h>
 #include <gyo/resources/Resources.h>
 #include <gyo/resources/IBLEnvironmentLoader.h>
+#include <gyo/resources/TextureStreamer.h>
+
+#include <algorithm>
 
 namespace gyo {
 
@@ -14,13 +17,13 @@ PBRMaterial::PBRMaterial(
     float roughness,
     float ao,
     glm::vec3 emissive,
-    Texture2D* albedoMap,
-    Texture2D* normalMap,
-    Texture2D* metallicMap,
-    Texture2D* roughnessMap,
-    Texture2D* metallicRoughnessMap,
-    Texture2D* aoMap,
-    Texture2D* emissiveMap,
+    TextureHandle albedoMap,
+    TextureHandle normalMap,
+    TextureHandle metallicMap,
+    TextureHandle roughnessMap,
+    TextureHandle metallicRoughnessMap,
+    TextureHandle aoMap,
+    TextureHandle emissiveMap,
     glm::vec2 uvTiling,
     glm::vec2 uvOffset
 ) {
@@ -54,46 +57,46 @@ PBRMaterial::PBRMaterial(
 
     // textures
 
-    hasTextures = albedoMap != nullptr ||
-        normalMap != nullptr ||
-        metallicMap != nullptr ||
-        roughnessMap != nullptr ||
-        metallicRoughnessMap != nullptr ||
-        aoMap != nullptr ||
-        emissiveMap != nullptr;
+    hasTextures = albedoMap ||
+        normalMap ||
+        metallicMap ||
+        roughnessMap ||
+        metallicRoughnessMap ||
+        aoMap ||
+        emissiveMap;
     if(hasTextures) {
         semantics["aTexCoord"] = SEMANTIC_TEXCOORD0;
     }
 
-    if(albedoMap != nullptr) {
+    if(albedoMap) {
         defines.insert(TEX_ALBEDO);
         this->albedoMap = albedoMap;
     }
-    if(normalMap != nullptr) {
+    if(normalMap) {
         defines.insert(TEX_NORMAL);
         this->normalMap = normalMap;
 
         semantics["aTangent"] = SEMANTIC_TANGENT;
     }
-    if(metallicRoughnessMap != nullptr) {
+    if(metallicRoughnessMap) {
         defines.insert(TEX_METALLIC_ROUGHNESS);
         this->metallicRoughnessMap = metallicRoughnessMap;
     }
     else {
-        if(metallicMap != nullptr) {
+        if(metallicMap) {
             defines.insert(TEX_METALLIC);
             this->metallicMap = metallicMap;
         }
-        if(roughnessMap != nullptr) {
+        if(roughnessMap) {
             defines.insert(TEX_ROUGHNESS);
             this->roughnessMap = roughnessMap;
         }
     }
-    if(aoMap != nullptr) {
+    if(aoMap) {
         defines.insert(TEX_AO);
         this->aoMap = aoMap;
     }
-    if(emissiveMap != nullptr) {
+    if(emissiveMap) {
         defines.insert(TEX_EMISSIVE);
         this->emissiveMap = emissiveMap;
     }
@@ -111,13 +114,53 @@ PBRMaterial::PBRMaterial(
         shader->SetInt("prefilteredEnvMap", texSlot++);
         shader->SetInt("brdfLUT", texSlot++);
     }
-    if(albedoMap)               shader->SetInt("uMaterial.albedoMap", texSlot++);
-    if(normalMap)               shader->SetInt("uMaterial.normalMap", texSlot++);
-    if(metallicMap)             shader->SetInt("uMaterial.metallicMap", texSlot++);
-    if(roughnessMap)            shader->SetInt("uMaterial.roughnessMap", texSlot++);
-    if(metallicRoughnessMap)    shader->SetInt("uMaterial.metallicRoughnessMap", texSlot++);
-    if(aoMap)                   shader->SetInt("uMaterial.aoMap", texSlot++);
-    if(emissiveMap)             shader->SetInt("uMaterial.emissiveMap", texSlot++);
+    if(albedoMap)               shader->SetInt("albedoMap", texSlot++);
+    if(normalMap)               shader->SetInt("normalMap", texSlot++);
+    if(metallicMap)             shader->SetInt("metallicMap", texSlot++);
+    if(roughnessMap)            shader->SetInt("roughnessMap", texSlot++);
+    if(metallicRoughnessMap)    shader->SetInt("metallicRoughnessMap", texSlot++);
+    if(aoMap)                   shader->SetInt("aoMap", texSlot++);
+    if(emissiveMap)             shader->SetInt("emissiveMap", texSlot++);
+
+    if(hasTextures) {
+        uvTilingOffsetHandle = shader->GetUniformHandle("uvTilingOffset");
+    }
+
+    // layout (std140) uniform PhysicalMaterialParameters {
+    //     vec3 albedo;
+    //     float metallic;
+    //     vec3 emissive;
+    //     float roughness;
+    //     float ao;
+    // }
+    struct {
+        glm::vec3 albedo;
+        float metallic;
+        glm::vec3 emissive;
+        float roughness;
+        float ao;
+        float padding[3];
+    } parameters = { albedo, metallic, emissive, roughness, ao, {} };
+    static_assert(sizeof(parameters) == 48, "PhysicalMaterialParameters block must match std140");
+
+    shader->SetUniformBlockBinding("PhysicalMaterialParameters", PARAMETERS_BINDING);
+    UploadParameters(&parameters, sizeof(parameters));
+
+    BeginInstanceKey();
+    HashParameter(albedo);
+    HashParameter(metallic);
+    HashParameter(roughness);
+    HashParameter(ao);
+    HashParameter(emissive);
+    HashParameter(this->albedoMap.Get());
+    HashParameter(this->normalMap.Get());
+    HashParameter(this->metallicMap.Get());
+    HashParameter(this->roughnessMap.Get());
+    HashParameter(this->metallicRoughnessMap.Get());
+    HashParameter(this->aoMap.Get());
+    HashParameter(this->emissiveMap.Get());
+    HashParameter(uvTiling);
+    HashParameter(uvOffset);
 }
 
 PBRMaterial::~PBRMaterial() {
@@ -126,11 +169,7 @@ PBRMaterial::~PBRMaterial() {
 void PBRMaterial::Queue() {
     shader->Use();
 
-    shader->SetVec3("uMaterial.albedo", albedo);
-    shader->SetFloat("uMaterial.metallic", metallic);
-    shader->SetFloat("uMaterial.roughness", roughness);
-    shader->SetFloat("uMaterial.ao", ao);
-    shader->SetVec3("uMaterial.emissive", emissive);
+    BindParameters();
 
     if(hasTextures) {
         unsigned int texSlot = 0U;
@@ -146,14 +185,22 @@ void PBRMaterial::Queue() {
         if(aoMap)                   aoMap->Bind(texSlot++);
         if(emissiveMap)             emissiveMap->Bind(texSlot++);
 
-        shader->SetVec4("uvTilingOffset",
+        shader->SetVec4(uvTilingOffsetHandle,
             glm::vec4(uvTiling.x, uvTiling.y, uvOffset.x, uvOffset.y));
     }
-    else {
-        for (unsigned int i = 0u; i < 10u; ++i) {
-            Texture2D::UnbindTextureSlot(i);
-        }
-    }
+}
+
+void PBRMaterial::RequestTextures(float footprint) const {
+    // tiled textures repeat across the mesh, each covering less of it
+    footprint /= std::max(uvTiling.x, uvTiling.y);
+
+    TextureStreamer::Request(albedoMap.Get(), footprint);
+    TextureStreamer::Request(normalMap.Get(), footprint);
+    TextureStreamer::Request(metallicMap.Get(), footprint);
+    TextureStreamer::Request(roughnessMap.Get(), footprint);
+    TextureStreamer::Request(metallicRoughnessMap.Get(), footprint);
+    TextureStreamer::Request(aoMap.Get(), footprint);
+    TextureStreamer::Request(emissiveMap.Get(), footprint);
 }
 
 } // namespace gyo
@@ -3,12 +3,12 @@
 
 #include <glm/glm.hpp>
 
+#include <gyo/resources/ResourceHandle.h>
 #include <gyo/shading/Material.h>
+#include <gyo/shading/Texture2D.h>
 
 namespace gyo {
 
-class Texture2D;
-
 class PBRMaterial : public Material {
 public:
     PBRMaterial(
@@ -18,19 +18,20 @@ public:
         float roughness = 0.5f,
         float ao = 1,
         glm::vec3 emissive = glm::vec3(0),
-        Texture2D* albedoMap = nullptr,
-        Texture2D* normalMap = nullptr,
-        Texture2D* metallicMap = nullptr,
-        Texture2D* roughnessMap = nullptr,
-        Texture2D* metallicRoughnessMap = nullptr,
-        Texture2D* aoMap = nullptr,
-        Texture2D* emissiveMap = nullptr,
+        TextureHandle albedoMap = nullptr,
+        TextureHandle normalMap = nullptr,
+        TextureHandle metallicMap = nullptr,
+        TextureHandle roughnessMap = nullptr,
+        TextureHandle metallicRoughnessMap = nullptr,
+        TextureHandle aoMap = nullptr,
+        TextureHandle emissiveMap = nullptr,
         glm::vec2 uvTiling = glm::vec2(1),
         glm::vec2 uvOffset = glm::vec2(0)
     );
     ~PBRMaterial() override;
 
     void Queue() override;
+    void RequestTextures(float footprint) const override;
 
 private:
     glm::vec3 albedo;
@@ -41,15 +42,17 @@ private:
 
     bool hasTextures = false;
 
-    Texture2D* albedoMap = nullptr;
-    Texture2D* normalMap = nullptr;
-    Texture2D* metallicMap = nullptr;
-    Texture2D* roughnessMap = nullptr;
-    Texture2D* metallicRoughnessMap = nullptr;
-    Texture2D* aoMap = nullptr;
-    Texture2D* emissiveMap = nullptr;
+    TextureHandle albedoMap;
+    TextureHandle normalMap;
+    TextureHandle metallicMap;
+    TextureHandle roughnessMap;
+    TextureHandle metallicRoughnessMap;
+    TextureHandle aoMap;
+    TextureHandle emissiveMap;
     glm::vec2 uvTiling;
     glm::vec2 uvOffset;
+
+    GLint uvTilingOffsetHandle = -1;
 };
 
 } // namespace gyo
@@ -1,18 +1,21 @@
 
 #include <gyo/shading/PhongMaterial.h>
 #include <gyo/resources/Resources.h>
+#include <gyo/resources/TextureStreamer.h>
 #include <gyo/shading/Texture2D.h>
 #include <gyo/shading/ShaderSemantics.h>
 
+#include <algorithm>
+
 namespace gyo {
 
 PhongMaterial::PhongMaterial(
     glm::vec4 diffuse,
     glm::vec3 specular,
     float shininess,
-    Texture2D* diffuseMap,
-    Texture2D* specularMap,
-    Texture2D* normalMap,
+    TextureHandle diffuseMap,
+    TextureHandle specularMap,
+    TextureHandle normalMap,
     glm::vec2 uvTiling,
     glm::vec2 uvOffset
 ) {
@@ -30,9 +33,9 @@ PhongMaterial::PhongMaterial(
     bool hasAlpha = false;
     hasAlpha = hasAlpha || diffuse.a < 1.0f;
 
-    hasTextures = diffuseMap != nullptr ||
-        specularMap != nullptr ||
-        normalMap != nullptr;
+    hasTextures = diffuseMap ||
+        specularMap ||
+        normalMap;
 
     semantics = {
         { "aPos", SEMANTIC_POSITION },
@@ -47,22 +50,23 @@ PhongMaterial::PhongMaterial(
         semantics["aTangent"] = SEMANTIC_TANGENT;
 
         // fallback to the built-in white textures from Resources
-        if(diffuseMap == nullptr) {
-            this->diffuseMap = Resources::GetTexture("BUILTIN_white", true);
+        if(!diffuseMap) {
+            this->diffuseMap = Resources::AcquireTexture("BUILTIN_white", true);
         }
-        if(specularMap == nullptr) {
-            this->specularMap = Resources::GetTexture("BUILTIN_white", false);
+        if(!specularMap) {
+            this->specularMap = Resources::AcquireTexture("BUILTIN_white", false);
         }
-        if(normalMap == nullptr) {
-            this->normalMap = Resources::GetTexture("BUILTIN_normal", false);
+        if(!normalMap) {
+            this->normalMap = Resources::AcquireTexture("BUILTIN_normal", false);
         }
         
         hasAlpha = hasAlpha || this->diffuseMap->hasAlpha;
     
         shader->Use();
-        shader->SetInt("material.diffuseMap", 0);
-        shader->SetInt("material.specularMap", 1);
-        shader->SetInt("material.normalMap", 2);
+        shader->SetInt("diffuseMap", 0);
+        shader->SetInt("specularMap", 1);
+        shader->SetInt("normalMap", 2);
+        uvTilingOffsetHandle = shader->GetUniformHandle("uvTilingOffset");
     }
     else {
         shader = Resources::GetShader("default.vert", "phong.frag");
@@ -71,34 +75,64 @@ PhongMaterial::PhongMaterial(
     if(hasAlpha) {
         renderType = RenderType::TRANSPARENT;
     }
+
+    // layout (std140) uniform PhongMaterial {
+    //     vec4 diffuse;
+    //     vec3 specular;
+    //     float shininess;
+    // }
+    struct {
+        glm::vec4 diffuse;
+        glm::vec3 specular;
+        float shininess;
+    } parameters = { diffuse, specular, shininess };
+    static_assert(sizeof(parameters) == 32, "PhongMaterial block must match std140");
+
+    shader->SetUniformBlockBinding("PhongMaterial", PARAMETERS_BINDING);
+    UploadParameters(&parameters, sizeof(parameters));
+
+    BeginInstanceKey();
+    HashParameter(diffuse);
+    HashParameter(specular);
+    HashParameter(shininess);
+    HashParameter(this->diffuseMap.Get());
+    HashParameter(this->specularMap.Get());
+    HashParameter(this->normalMap.Get());
+    HashParameter(uvTiling);
+    HashParameter(uvOffset);
 }
 
 PhongMaterial::~PhongMaterial() {
-    diffuseMap = nullptr;
-    specularMap = nullptr;
-    normalMap = nullptr;
 }
 
 void PhongMaterial::Queue() {
     shader->Use();
 
-    shader->SetVec4("material.diffuse", diffuse);
-    shader->SetVec3("material.specular", specular);
-    shader->SetFloat("material.shininess", shininess);
-    
+    BindParameters();
+
+    // without textures the shader doesn't declare any samplers, so whatever
+    // is left bound doesn't matter
     if(hasTextures) {
         diffuseMap->Bind(0);
         specularMap->Bind(1);
         normalMap->Bind(2);
     
-        shader->SetVec4("uvTilingOffset",
+        shader->SetVec4(uvTilingOffsetHandle,
             glm::vec4(uvTiling.x, uvTiling.y, uvOffset.x, uvOffset.y));
     }
-    else {
-        Texture2D::UnbindTextureSlot(0);
-        Texture2D::UnbindTextureSlot(1);
-        Texture2D::UnbindTextureSlot(2);
+}
+
+void PhongMaterial::RequestTextures(float footprint) const {
+    if(!hasTextures) {
+        return;
     }
+
+    // tiled textures repeat across the mesh, each covering less of it
+    footprint /= std::max(uvTiling.x, uvTiling.y);
+
+    TextureStreamer::Request(diffuseMap.Get(), footprint);
+    TextureStreamer::Request(specularMap.Get(), footprint);
+    TextureStreamer::Request(normalMap.Get(), footprint);
 }
 
 } // namespace gyo
@@ -3,27 +3,28 @@
 
 #include <glm/glm.hpp>
 
+#include <gyo/resources/ResourceHandle.h>
 #include <gyo/shading/Material.h>
+#include <gyo/shading/Texture2D.h>
 
 namespace gyo {
 
-class Texture2D;
-
 class PhongMaterial : public Material {
 public:
     PhongMaterial(
         glm::vec4 diffuse = glm::vec4(1),
         glm::vec3 specular = glm::vec3(1),
         float shininess = 128,
-        Texture2D* diffuseMap = nullptr,
-        Texture2D* specularMap = nullptr,
-        Texture2D* normalMap = nullptr,
+        TextureHandle diffuseMap = nullptr,
+        TextureHandle specularMap = nullptr,
+        TextureHandle normalMap = nullptr,
         glm::vec2 uvTiling = glm::vec2(1),
         glm::vec2 uvOffset = glm::vec2(0)
     );
     ~PhongMaterial() override;
 
     void Queue() override;
+    void RequestTextures(float footprint) const override;
 
 private:
     glm::vec4 diffuse;;
@@ -31,11 +32,13 @@ private:
     float shininess;
     
     bool hasTextures;
-    Texture2D* diffuseMap = nullptr;
-    Texture2D* specularMap = nullptr;
-    Texture2D* normalMap = nullptr;
+    TextureHandle diffuseMap;
+    TextureHandle specularMap;
+    TextureHandle normalMap;
     glm::vec2 uvTiling;
     glm::vec2 uvOffset;
+
+    GLint uvTilingOffsetHandle = -1;
 };
 
 } // namespace gyo
@@ -1,5 +1,6 @@
 
 #include <gyo/shading/Shader.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
 
@@ -20,13 +21,11 @@ Shader::Shader(const unsigned int& shaderProgramId,
 }
 
 void Shader::Dispose() {
-    glDeleteProgram(ID);
-    glCheckError();
+    RenderState::DeleteProgram(ID);
 }
 
 void Shader::Use() const {
-    glUseProgram(ID);
-    glCheckError();
+    RenderState::UseProgram(ID);
 }
 
 void Shader::SetBool(const char* name, bool value) const {
@@ -109,16 +108,53 @@ void Shader::SetUniformBlockBinding(const char* name, int bindingPoint) const {
     glCheckError();
 }
 
-bool Shader::HasUniform(const char* name) const {
-    return uniforms.find(name) != uniforms.end();
-}
-
 GLint Shader::GetUniformLocation(const char* name) const {
-    if(uniforms.find(name) == uniforms.end()) {
+    auto it = uniforms.find(name);
+    if(it == uniforms.end()) {
         return -1;
     }
 
-    return uniforms.at(name).location;
+    return it->second.location;
+}
+
+GLint Shader::GetUniformHandle(const char* name) const {
+    GLint location = GetUniformLocation(name);
+    if(location == -1) {
+        LOGW("Shader uniform '%s' not found", name);
+    }
+    return location;
+}
+
+void Shader::SetInt(GLint handle, int value) const {
+    if(handle == -1) {
+        return;
+    }
+    glUniform1i(handle, value);
+    glCheckError();
+}
+
+void Shader::SetFloat(GLint handle, float value) const {
+    if(handle == -1) {
+        return;
+    }
+    glUniform1f(handle, value);
+    glCheckError();
+}
+
+void Shader::SetVec4(GLint handle, const glm::vec4& value) const {
+    if(handle == -1) {
+        return;
+    }
+    glUniform4f(handle, value.x, value.y, value.z, value.w);
+    glCheckError();
+}
+
+void Shader::SetMat4(GLint handle, const glm::mat4& value) const {
+    if(handle == -1) {
+        return;
+    }
+    glUniformMatrix4fv(handle, 1, GL_FALSE, glm::value_ptr(value));
+    glCheckError();
 }
 
 } // namespace gyo
@@ -29,10 +29,11 @@ public:
     );
 
     const std::map<std::string, AttributeInfo>& GetAttributes() const { return attributes; }
+    const unsigned int& GetID() const { return ID; }
     
     void Dispose();
 
-    // use/activate the shader
+    // use/activate the shader, a no-op if it's already in use
     void Use() const;
     
     // utility uniform functions
@@ -43,6 +44,16 @@ public:
     void SetVec3(const char* name, glm::vec3 value) const;
     void SetVec4(const char* name, glm::vec4 value) const;
     void SetMat4(const char* name, glm::mat4 value) const;
+
+    // resolves a uniform's location once, for the handle setters below.
+    // Returns -1, which the setters ignore, if the uniform isn't found.
+    GLint GetUniformHandle(const char* name) const;
+
+    // the same uniform functions, without the lookup by name
+    void SetInt(GLint handle, int value) const;
+    void SetFloat(GLint handle, float value) const;
+    void SetVec4(GLint handle, const glm::vec4& value) const;
+    void SetMat4(GLint handle, const glm::mat4& value) const;
     // and for uniform blocks
     void SetUniformBlockBinding(const char* name, int bindingPoint) const;
 
@@ -54,7 +65,6 @@ private:
     std::map<std::string, AttributeInfo> attributes;
     std::map<std::string, UniformInfo> uniforms;
 
-    bool HasUniform(const char* name) const;
     GLint GetUniformLocation(const char* name) const;
 };
   
@@ -11,6 +11,9 @@ ShaderMaterial::ShaderMaterial(Shader* shader, const std::map<std::string, unsig
     // TODO make these ctor parameters?
     usesDirectLighting = false;
     usesIBL = false;
+
+    // Queue only binds the shader, so any material sharing it is equivalent
+    BeginInstanceKey();
 }
 
 ShaderMaterial::~ShaderMaterial() {
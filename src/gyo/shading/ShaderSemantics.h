@@ -13,6 +13,15 @@ namespace gyo {
 #define SEMANTIC_TANGENT    0x00000004
 #define SEMANTIC_COLOR      0x00000005
 
+// per-instance attribute, streamed by the renderer rather than read from the
+// geometry. It indexes the object data texture buffer for the transforms.
+#define INSTANCE_ATTRIBUTE_OBJECT_INDEX     "aInstanceObjectIndex"
+#define UNIFORM_OBJECT_DATA                 "uObjectData"
+
+// constant per-draw attribute, set from the mesh's pool allocation. Expands
+// quantized positions, see GeometryAllocation.
+#define ATTRIBUTE_POSITION_BOUNDS           "aPositionBounds"
+
 static const std::unordered_map<unsigned int, GLenum> SEMANTIC_TO_GLTYPE = {
     { SEMANTIC_POSITION,  GL_FLOAT_VEC3 },
     { SEMANTIC_NORMAL,    GL_FLOAT_VEC3 },
@@ -1,6 +1,8 @@
 
 #include <gyo/shading/Texture2D.h>
 
+#include <gyo/renderer/RenderState.h>
+#include <gyo/resources/TextureStreamer.h>
 #include <gyo/utilities/GetError.h>
 
 #include <glad/glad.h>
@@ -15,22 +17,23 @@ Texture2D::Texture2D(const unsigned int& textureId, unsigned int width, unsigned
 {}
 
 void Texture2D::Dispose() {
-    glDeleteTextures(1, &ID);
-    glCheckError();
+    if(isStreamed) {
+        TextureStreamer::Remove(ID);
+    }
+
+    RenderState::DeleteTexture(ID);
 }
 
 void Texture2D::Bind(unsigned int textureUnit) const {
-    glActiveTexture(GL_TEXTURE0 + textureUnit); // activate texture unit 0 before binding
-    glCheckError();
-    glBindTexture(GL_TEXTURE_2D, ID);
-    glCheckError();
+    if(lastUsed != nullptr) {
+        *lastUsed = std::chrono::steady_clock::now();
+    }
+
+    RenderState::BindTexture(textureUnit, GL_TEXTURE_2D, ID);
 }
 
 void Texture2D::UnbindTextureSlot(int textureUnit) {
-    glActiveTexture(GL_TEXTURE0 + textureUnit); // activate texture unit 0 before binding
-    glCheckError();
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+    RenderState::BindTexture(textureUnit, GL_TEXTURE_2D, 0);
 }
 
 } // namespace gyo
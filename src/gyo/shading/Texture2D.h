@@ -1,6 +1,9 @@
 #ifndef TEXTURE2D_H
 #define TEXTURE2D_H
 
+#include <chrono>
+#include <cstddef>
+
 namespace gyo {
 
 class Texture2D {
@@ -15,10 +18,21 @@ public:
 
     void Bind(unsigned int textureUnit = 0) const;
 
+    const unsigned int& GetId() const { return ID; }
+
     unsigned int width;
     unsigned int height;
     bool hasAlpha = false;
 
+    // the exact size of its levels when known, e.g. block compressed, else 0
+    size_t gpuBytes = 0;
+
+    // whether TextureStreamer uploads its larger levels as they're needed
+    bool isStreamed = false;
+
+    // our cache entry's, set by Resources, so what's evicted is what hasn't been bound for longest
+    std::chrono::steady_clock::time_point* lastUsed = nullptr;
+
 private:
     // the texture id
     unsigned int ID;
@@ -1,6 +1,7 @@
 
 #include <gyo/shading/TextureCube.h>
 
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 
 #include <glad/glad.h>
@@ -12,15 +13,11 @@ TextureCube::TextureCube(const unsigned int& textureId, unsigned int width, unsi
 {}
 
 void TextureCube::Dispose() {
-    glDeleteTextures(1, &ID);
-    glCheckError();
+    RenderState::DeleteTexture(ID);
 }
 
 void TextureCube::Bind(unsigned int textureUnit) const {
-    glActiveTexture(GL_TEXTURE0 + textureUnit); // activate texture unit 0 before binding
-    glCheckError();
-    glBindTexture(GL_TEXTURE_CUBE_MAP, ID);
-    glCheckError();
+    RenderState::BindTexture(textureUnit, GL_TEXTURE_CUBE_MAP, ID);
 }
 
 } // namespace gyo
@@ -4,13 +4,16 @@
 #include <gyo/shading/ShaderSemantics.h>
 #include <gyo/shading/Texture2D.h>
 #include <gyo/resources/Resources.h>
+#include <gyo/resources/TextureStreamer.h>
+
+#include <algorithm>
 
 namespace gyo {
 
 UnlitMaterial::UnlitMaterial(
     glm::vec4 color,
     bool additive,
-    Texture2D* texture,
+    TextureHandle texture,
     glm::vec2 uvTiling,
     glm::vec2 uvOffset
 ) {
@@ -28,7 +31,7 @@ UnlitMaterial::UnlitMaterial(
     };
 
     // select our shader depending on whether or not a texture was passed
-    if(texture == nullptr) {
+    if(!texture) {
         shader = Resources::GetShader("default.vert", "solidColor.frag");
     }
     else {
@@ -36,6 +39,7 @@ UnlitMaterial::UnlitMaterial(
 
         shader->Use();
         shader->SetInt("tex", 0);
+        uvTilingOffsetHandle = shader->GetUniformHandle("uvTilingOffset");
 
         semantics["texCoord"] = SEMANTIC_TEXCOORD0;
 
@@ -48,23 +52,37 @@ UnlitMaterial::UnlitMaterial(
     else if(hasAlpha) {
         renderType = RenderType::TRANSPARENT;
     }
+
+    // layout (std140) uniform UnlitMaterial { vec4 color; }
+    shader->SetUniformBlockBinding("UnlitMaterial", PARAMETERS_BINDING);
+    UploadParameters(&this->color, sizeof(glm::vec4));
+
+    BeginInstanceKey();
+    HashParameter(color);
+    HashParameter(this->texture.Get());
+    HashParameter(uvTiling);
+    HashParameter(uvOffset);
 }
 
 UnlitMaterial::~UnlitMaterial() {
-    texture = nullptr;
 }
 
 void UnlitMaterial::Queue() {
     shader->Use();
 
-    shader->SetVec4("color", color);
+    BindParameters();
 
-    if(texture != nullptr) {
+    if(texture) {
         texture->Bind(0);
 
-        shader->SetVec4("uvTilingOffset",
+        shader->SetVec4(uvTilingOffsetHandle,
             glm::vec4(uvTiling.x, uvTiling.y, uvOffset.x, uvOffset.y));
     }
 }
 
+void UnlitMaterial::RequestTextures(float footprint) const {
+    // tiled textures repeat across the mesh, each covering less of it
+    TextureStreamer::Request(texture.Get(), footprint / std::max(uvTiling.x, uvTiling.y));
+}
+
 } // namespace gyo
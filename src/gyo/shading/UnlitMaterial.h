@@ -3,30 +3,33 @@
 
 #include <glm/glm.hpp>
 
+#include <gyo/resources/ResourceHandle.h>
 #include <gyo/shading/Material.h>
+#include <gyo/shading/Texture2D.h>
 
 namespace gyo {
 
-class Texture2D;
-
 class UnlitMaterial : public Material {
 public:
     UnlitMaterial(
         glm::vec4 color = glm::vec4(1),
         bool additive = false,
-        Texture2D* texture = nullptr,
+        TextureHandle texture = nullptr,
         glm::vec2 uvTiling = glm::vec2(1),
         glm::vec2 uvOffset = glm::vec2(0)
     );
     ~UnlitMaterial() override;
 
     void Queue() override;
+    void RequestTextures(float footprint) const override;
 
 private:
     glm::vec4 color = glm::vec4(1);
-    Texture2D* texture = nullptr;
+    TextureHandle texture;
     glm::vec2 uvTiling;
     glm::vec2 uvOffset;
+
+    GLint uvTilingOffsetHandle = -1;
 };
 
 } // namespace gyo
@@ -4,6 +4,7 @@
 #include <gyo/ui/Font.h>
 #include <gyo/shading/Shader.h>
 #include <gyo/resources/Resources.h>
+#include <gyo/renderer/RenderState.h>
 #include <gyo/utilities/GetError.h>
 #include <gyo/utilities/Log.h>
 
@@ -25,8 +26,7 @@ Text::Text(const char* fontName, const glm::ivec2& viewportSize, const float& pi
     glCheckError();
 
     // bind
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
     glCheckError();
     
@@ -56,8 +56,7 @@ Text::Text(const char* fontName, const glm::ivec2& viewportSize, const float& pi
     // unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glCheckError();
-    glBindVertexArray(0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
 
     // set our shader uniforms
     shader->Use();
@@ -68,10 +67,8 @@ Text::Text(const char* fontName, const glm::ivec2& viewportSize, const float& pi
 }
 
 Text::~Text() {
-    glDeleteVertexArrays(1, &VAO);
-    glCheckError();
-    glDeleteBuffers(1, &VBO);
-    glCheckError();
+    RenderState::DeleteVertexArray(VAO);
+    RenderState::DeleteBuffer(VBO);
 
     font = nullptr;
     shader = nullptr;
@@ -144,8 +141,7 @@ void Text::ExecuteRender() {
     shader->Use();
     
     font->BindTexture();
-    glBindVertexArray(VAO);
-    glCheckError();
+    RenderState::BindVertexArray(VAO);
     
     // update content of VBO memory
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
@@ -160,10 +156,8 @@ void Text::ExecuteRender() {
     // deactivate our render state
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glCheckError();
-    glBindVertexArray(0);
-    glCheckError();
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glCheckError();
+    RenderState::BindVertexArray(0);
+    RenderState::BindTexture(0, GL_TEXTURE_2D, 0);
     
     renderQueue.clear();
     pendingGlyphs = 0;
@@ -56,6 +56,7 @@ struct FrameStats {
     
     float geometryMs = 0;
     float uiMs = 0; // previous frame
+    unsigned int redundantStateCalls = 0; // previous frame
     float postProcessMs = 0;
 
     void Reset() {
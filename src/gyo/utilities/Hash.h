@@ -1,32 +1,38 @@
 #ifndef HASH_H
 #define HASH_H
 
-/**
- * Hashing a string into an unsigned integer for quicker comparisons than a
- * string. Borrowed from Jason Gregory's book "Game Engine Architecture", and
- * Joey DeVries from learnopengl.com
- */
-
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace gyo {
 
-#define HASH(string) simple_hash(string)
+// 64-bit FNV-1a over raw bytes, for hashing vertex data and material
+// parameters. Pass a previous result as the seed to combine hashes.
+static const uint64_t FNV1A_64_OFFSET = 0xcbf29ce484222325ULL;
+static const uint64_t FNV1A_64_PRIME = 0x100000001b3ULL;
+
+inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = FNV1A_64_OFFSET) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
 
-// djb2 hashing algorithm
-inline unsigned int simple_hash(const std::string& str) {
-    unsigned long hash = 5381;
-    for(char c : str) {
-        hash = ((hash << 5) + hash) + c;
+    uint64_t hash = seed;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV1A_64_PRIME;
     }
 
     return hash;
 }
 
-// supports c string literals
-inline unsigned int simple_hash(const char* cStr) {
-    std::string str(cStr);
-    return simple_hash(str);
+/**
+ * Hashing a string into a 64-bit id for quicker comparisons than a string.
+ * Ids can still collide, so anything keyed by them should keep the string to
+ * tell colliding keys apart.
+ */
+#define HASH64(string) hash_string(string)
+
+inline uint64_t hash_string(const std::string& str) {
+    return hash_bytes(str.data(), str.size());
 }
 
 } // namespace gyo
@@ -0,0 +1,297 @@
+
+#include <gyo/utilities/Json.h>
+#include <gyo/utilities/Log.h>
+
+#include <charconv>
+#include <cstring>
+
+namespace gyo {
+
+static const JsonValue NullValue;
+
+/**
+ * A recursive descent parser over the whole text, which must outlive it
+ */
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t length) : cursor(text), begin(text), end(text + length) {}
+
+    bool ParseDocument(JsonValue& out) {
+        if(!ParseValue(out, 0)) {
+            return false;
+        }
+
+        SkipWhitespace();
+        if(cursor != end) {
+            return Fail("unexpected trailing characters");
+        }
+
+        return true;
+    }
+
+private:
+    static const int MAX_DEPTH = 256;
+
+    const char* cursor;
+    const char* begin;
+    const char* end;
+
+    bool Fail(const char* reason) {
+        LOGE("JSON parse error at offset %zu: %s", static_cast<size_t>(cursor - begin), reason);
+        return false;
+    }
+
+    void SkipWhitespace() {
+        while(cursor != end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\n' || *cursor == '\r')) {
+            cursor++;
+        }
+    }
+
+    bool Consume(char c) {
+        SkipWhitespace();
+        if(cursor != end && *cursor == c) {
+            cursor++;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ConsumeLiteral(const char* literal) {
+        const size_t length = std::strlen(literal);
+        if(static_cast<size_t>(end - cursor) < length || std::strncmp(cursor, literal, length) != 0) {
+            return Fail("invalid literal");
+        }
+
+        cursor += length;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& out, int depth) {
+        if(depth > MAX_DEPTH) {
+            return Fail("nested too deeply");
+        }
+
+        SkipWhitespace();
+        if(cursor == end) {
+            return Fail("unexpected end of input");
+        }
+
+        switch(*cursor) {
+            case '{': return ParseObject(out, depth);
+            case '[': return ParseArray(out, depth);
+            case '"':
+                out.type = JsonValue::Type::String;
+                return ParseString(out.string);
+            case 't':
+                out.type = JsonValue::Type::Bool;
+                out.boolean = true;
+                return ConsumeLiteral("true");
+            case 'f':
+                out.type = JsonValue::Type::Bool;
+                out.boolean = false;
+                return ConsumeLiteral("false");
+            case 'n':
+                out.type = JsonValue::Type::Null;
+                return ConsumeLiteral("null");
+            default:
+                return ParseNumber(out);
+        }
+    }
+
+    bool ParseObject(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Object;
+        cursor++;
+
+        if(Consume('}')) {
+            return true;
+        }
+
+        do {
+            SkipWhitespace();
+            if(cursor == end || *cursor != '"') {
+                return Fail("expected a member name");
+            }
+
+            out.members.emplace_back();
+            if(!ParseString(out.members.back().first)) {
+                return false;
+            }
+
+            if(!Consume(':')) {
+                return Fail("expected ':'");
+            }
+
+            if(!ParseValue(out.members.back().second, depth + 1)) {
+                return false;
+            }
+        } while(Consume(','));
+
+        if(!Consume('}')) {
+            return Fail("expected ',' or '}'");
+        }
+
+        return true;
+    }
+
+    bool ParseArray(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::Array;
+        cursor++;
+
+        if(Consume(']')) {
+            return true;
+        }
+
+        do {
+            out.elements.emplace_back();
+            if(!ParseValue(out.elements.back(), depth + 1)) {
+                return false;
+            }
+        } while(Consume(','));
+
+        if(!Consume(']')) {
+            return Fail("expected ',' or ']'");
+        }
+
+        return true;
+    }
+
+    bool ParseNumber(JsonValue& out) {
+        out.type = JsonValue::Type::Number;
+
+        // from_chars doesn't take a leading '+', which JSON doesn't allow either
+        auto result = std::from_chars(cursor, end, out.number);
+        if(result.ec != std::errc()) {
+            return Fail("invalid number");
+        }
+
+        cursor = result.ptr;
+        return true;
+    }
+
+    bool ParseHex4(unsigned int& codePoint) {
+        if(end - cursor < 4) {
+            return Fail("truncated unicode escape");
+        }
+
+        codePoint = 0;
+        for(int i = 0; i < 4; i++) {
+            char c = *cursor++;
+            codePoint <<= 4;
+            if(c >= '0' && c <= '9')      codePoint |= c - '0';
+            else if(c >= 'a' && c <= 'f') codePoint |= c - 'a' + 10;
+            else if(c >= 'A' && c <= 'F') codePoint |= c - 'A' + 10;
+            else return Fail("invalid unicode escape");
+        }
+
+        return true;
+    }
+
+    static void AppendUtf8(std::string& out, unsigned int codePoint) {
+        if(codePoint < 0x80) {
+            out += static_cast<char>(codePoint);
+        }
+        else if(codePoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codePoint >> 6));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else if(codePoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codePoint >> 12));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        else {
+            out += static_cast<char>(0xF0 | (codePoint >> 18));
+            out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+    }
+
+    bool ParseString(std::string& out) {
+        cursor++;
+
+        while(cursor != end && *cursor != '"') {
+            char c = *cursor++;
+            if(c != '\\') {
+                out += c;
+                continue;
+            }
+
+            if(cursor == end) {
+                break;
+            }
+
+            switch(*cursor++) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    unsigned int codePoint;
+                    if(!ParseHex4(codePoint)) {
+                        return false;
+                    }
+
+                    // combine surrogate pairs
+                    if(codePoint >= 0xD800 && codePoint < 0xDC00 &&
+                        end - cursor >= 6 && cursor[0] == '\\' && cursor[1] == 'u') {
+                        cursor += 2;
+                        unsigned int low;
+                        if(!ParseHex4(low)) {
+                            return false;
+                        }
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    AppendUtf8(out, codePoint);
+                    break;
+                }
+                default:
+                    return Fail("invalid escape");
+            }
+        }
+
+        if(cursor == end) {
+            return Fail("unterminated string");
+        }
+
+        cursor++;
+        return true;
+    }
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& out) {
+    out = JsonValue();
+
+    JsonParser parser(text, length);
+    return parser.ParseDocument(out);
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    if(type != Type::Array || index >= elements.size()) {
+        return NullValue;
+    }
+
+    return elements[index];
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+    for(const auto& member : members) {
+        if(member.first == key) {
+            return member.second;
+        }
+    }
+
+    return NullValue;
+}
+
+bool JsonValue::Has(const char* key) const {
+    return !(*this)[key].IsNull();
+}
+
+} // namespace gyo
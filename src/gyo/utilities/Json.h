@@ -0,0 +1,73 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace gyo {
+
+/**
+ * A parsed JSON value. Just enough for reading glTF, so objects are kept as
+ * ordered lists of members, and lookups are linear.
+ *
+ * Reads never fail: a missing member or element, or one of the wrong type,
+ * reads as null or the given fallback.
+ */
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    /**
+     * Parses the text into out. Returns false, and logs where, on bad input.
+     */
+    static bool Parse(const char* text, size_t length, JsonValue& out);
+
+    const Type& GetType() const { return type; }
+    bool IsNull() const { return type == Type::Null; }
+    bool IsNumber() const { return type == Type::Number; }
+    bool IsString() const { return type == Type::String; }
+    bool IsArray() const { return type == Type::Array; }
+    bool IsObject() const { return type == Type::Object; }
+
+    bool AsBool(bool fallback = false) const { return type == Type::Bool ? boolean : fallback; }
+    double AsNumber(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+    float AsFloat(float fallback = 0.0f) const { return static_cast<float>(AsNumber(fallback)); }
+    // numbers out of range, e.g. negative sizes, read as the fallback too
+    int AsInt(int fallback = 0) const {
+        return IsNumber() && number >= std::numeric_limits<int>::min() && number <= std::numeric_limits<int>::max() ?
+            static_cast<int>(number) : fallback;
+    }
+    size_t AsSize(size_t fallback = 0) const {
+        // the max rounds up to 2^64 as a double, which is already out of range
+        return IsNumber() && number >= 0.0 && number < static_cast<double>(std::numeric_limits<size_t>::max()) ?
+            static_cast<size_t>(number) : fallback;
+    }
+    const std::string& AsString() const { return string; }
+
+    // elements of an array, or members of an object
+    size_t Size() const { return type == Type::Array ? elements.size() : members.size(); }
+
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](int index) const { return (*this)[static_cast<size_t>(index)]; }
+    const JsonValue& operator[](const char* key) const;
+    bool Has(const char* key) const;
+
+    const std::vector<std::pair<std::string, JsonValue>>& GetMembers() const { return members; }
+
+private:
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> elements;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    friend class JsonParser;
+};
+
+} // namespace gyo
+
+#endif // JSON_H
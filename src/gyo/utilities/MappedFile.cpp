@@ -0,0 +1,127 @@
+
+#include <gyo/utilities/MappedFile.h>
+#include <gyo/utilities/Log.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gyo {
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& filePath) {
+    Close();
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE) {
+        LOGE("Failed to open %s", filePath.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        LOGE("Failed to get the size of %s", filePath.c_str());
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping == NULL) {
+        LOGE("Failed to map %s", filePath.c_str());
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(view == NULL) {
+        LOGE("Failed to map a view of %s", filePath.c_str());
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = static_cast<const unsigned char*>(view);
+    size = static_cast<size_t>(fileSize.QuadPart);
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if(data != nullptr) {
+        UnmapViewOfFile(data);
+    }
+    if(mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if(fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+
+    data = nullptr;
+    size = 0;
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& filePath) {
+    Close();
+
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if(fd == -1) {
+        LOGE("Failed to open %s", filePath.c_str());
+        return false;
+    }
+
+    struct stat info;
+    if(fstat(fd, &info) == -1 || info.st_size == 0) {
+        LOGE("Failed to get the size of %s", filePath.c_str());
+        close(fd);
+        return false;
+    }
+
+    void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping keeps its own reference to the file
+    close(fd);
+
+    if(view == MAP_FAILED) {
+        LOGE("Failed to map %s", filePath.c_str());
+        return false;
+    }
+
+    // we read each buffer view front to back
+    madvise(view, info.st_size, MADV_SEQUENTIAL);
+
+    data = static_cast<const unsigned char*>(view);
+    size = static_cast<size_t>(info.st_size);
+
+    return true;
+}
+
+void MappedFile::Close() {
+    if(data != nullptr) {
+        munmap(const_cast<unsigned char*>(data), size);
+    }
+
+    data = nullptr;
+    size = 0;
+}
+
+#endif
+
+} // namespace gyo
@@ -0,0 +1,40 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace gyo {
+
+/**
+ * A read-only memory mapping of a whole file. Pages are read in by the OS as
+ * they're touched, so nothing is copied up front.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // returns false, and logs why, if the file couldn't be mapped
+    bool Open(const std::string& filePath);
+    void Close();
+
+    const unsigned char* GetData() const { return data; }
+    const size_t& GetSize() const { return size; }
+
+private:
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
+
+} // namespace gyo
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,96 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gyo/resources/MeshCooker.h>
+#include <gyo/resources/TextureCooker.h>
+
+using namespace gyo;
+
+static bool IsImage(const std::filesystem::path& path) {
+    std::string ext = path.extension().string();
+    return ext == ".png" || ext == ".jpg" || ext == ".jpeg" || ext == ".tga" || ext == ".bmp";
+}
+
+// cooks every model given, or every model in each directory given, into a
+// .gyomesh next to it, and every image into a block compressed .ktx2 next to
+// it. Images are compressed as the kind flag before them says, color if none.
+int main(int argc, const char * argv[]) {
+    bool flipUVs = false;
+    TextureCompression compression = TextureCompression::BC;
+    TextureKind kind = TextureKind::COLOR;
+
+    std::vector<std::filesystem::path> sources;
+    std::vector<std::pair<std::filesystem::path, TextureKind>> images;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--flip-uvs") {
+            flipUVs = true;
+            continue;
+        }
+        if(arg == "--bc7") {
+            compression = TextureCompression::BC7;
+            continue;
+        }
+
+        if(arg == "--color") {
+            kind = TextureKind::COLOR;
+            continue;
+        }
+        if(arg == "--linear") {
+            kind = TextureKind::LINEAR_COLOR;
+            continue;
+        }
+        if(arg == "--normal") {
+            kind = TextureKind::NORMAL;
+            continue;
+        }
+        if(arg == "--metallic-roughness") {
+            kind = TextureKind::METALLIC_ROUGHNESS;
+            continue;
+        }
+        if(arg == "--grayscale") {
+            kind = TextureKind::GRAYSCALE;
+            continue;
+        }
+
+        if(std::filesystem::is_directory(arg)) {
+            for(const auto& entry : std::filesystem::directory_iterator(arg)) {
+                std::string ext = entry.path().extension().string();
+                if(ext == ".glb" || ext == ".gltf" || ext == ".fbx") {
+                    sources.push_back(entry.path());
+                }
+            }
+        }
+        else if(IsImage(arg)) {
+            images.emplace_back(arg, kind);
+        }
+        else {
+            sources.push_back(arg);
+        }
+    }
+
+    if(sources.empty() && images.empty()) {
+        std::cerr << "Usage: gyocook [--flip-uvs] [--bc7] <model or directory>... "
+            "[--color | --linear | --normal | --metallic-roughness | --grayscale] <image>..." << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for(const auto& source : sources) {
+        if(!MeshCooker::Cook(source.string(), MeshCooker::GetCookedPath(source.string()), flipUVs, compression)) {
+            failures++;
+        }
+    }
+
+    for(const auto& image : images) {
+        if(!TextureCooker::Cook(image.first.string(), TextureCooker::GetCookedPath(image.first.string()), image.second, compression)) {
+            failures++;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}